@@ -4,12 +4,15 @@
 #include <options>
 #include "moments.h"
 #include "common.h"
+#include "instancing.h"
 
 Texture2D<float4> opacity : DECLARE_TEXTURE;
 
 cbuffer ObjectVariables : DECL_OBJECT_BUFFER
 {
+#if (!INSTANCING)
 	row_major float4x4 worldTransform;
+#endif
 	row_major float4x4 viewProjectionTransform;
 	float4 cameraJitter;
 };
@@ -25,6 +28,10 @@ struct VSOutput
 
 VSOutput vertexMain(VSInput vsIn)
 {
+#if (INSTANCING)
+	float4x4 worldTransform = instances[vsIn.instanceIndex].worldTransform;
+#endif
+
     float4 transformedPosition = mul(float4(vsIn.position, 1.0), worldTransform);
 
 	VSOutput output;
@@ -0,0 +1,16 @@
+#if (INSTANCING)
+
+struct ObjectInstance
+{
+	row_major float4x4 worldTransform;
+	row_major float4x4 worldRotationTransform;
+	row_major float4x4 previousWorldTransform;
+	row_major float4x4 previousWorldRotationTransform;
+};
+
+cbuffer InstanceVariables : DECL_INSTANCE_BUFFER
+{
+	ObjectInstance instances[MAX_INSTANCES_PER_BATCH];
+};
+
+#endif
@@ -3,6 +3,7 @@
 #include <inputlayout>
 #include <options>
 #include "common.h"
+#include "instancing.h"
 
 #define EnableClearCoat 0
 #define EnableIridescence 0
@@ -20,11 +21,13 @@ cbuffer ObjectVariables : DECL_OBJECT_BUFFER
 {
     row_major float4x4 viewProjectionTransform;
     row_major float4x4 previousViewProjectionTransform;
-    
+
+#if (!INSTANCING)
     row_major float4x4 worldTransform;
     row_major float4x4 previousWorldTransform;
-
     row_major float4x4 worldRotationTransform;
+#endif
+
     row_major float4x4 lightViewTransform;
     row_major float4x4 lightProjectionTransform;
 	float4 environmentSphericalHarmonics[9];
@@ -65,6 +68,12 @@ static const float ClearCoatRoughness = 0.05;
 
 VSOutput vertexMain(VSInput vsIn)
 {
+#if (INSTANCING)
+    float4x4 worldTransform = instances[vsIn.instanceIndex].worldTransform;
+    float4x4 previousWorldTransform = instances[vsIn.instanceIndex].previousWorldTransform;
+    float4x4 worldRotationTransform = instances[vsIn.instanceIndex].worldRotationTransform;
+#endif
+
     float4 transformedPosition = mul(float4(vsIn.position, 1.0), worldTransform);
     float4 previousTransformedPosition = mul(float4(vsIn.position, 1.0), previousWorldTransform);
 
@@ -9,6 +9,8 @@
 #pragma once
 
 #include <et/core/et.h>
+#include <et/core/parallel.h>
+#include <et/geometry/vector4-simd.h>
 
 namespace et
 {
@@ -224,5 +226,386 @@ private:
 	bool _autoRenewParticles = true;
 };
 using PointSpriteEmitter = Emitter<PointSprite>;
+
+/*
+ * Structure of arrays storage for point sprites,
+ * capacity is padded to multiple of four, so kernels could process four particles at once
+ */
+struct PointSpriteStreams
+{
+	enum : uint32_t
+	{
+		Lanes = 4
+	};
+
+	Vector<float> position[3];
+	Vector<float> velocity[3];
+	Vector<float> acceleration[3];
+	Vector<float> color[4];
+	Vector<float> size;
+	Vector<float> emitTime;
+	Vector<float> lifeTime;
+
+	void resize(uint32_t capacity)
+	{
+		uint32_t paddedCapacity = Lanes * ((capacity + Lanes - 1) / Lanes);
+		forEachStream([paddedCapacity](Vector<float>& stream) { stream.resize(paddedCapacity, 0.0f); });
+	}
+
+	void move(uint32_t from, uint32_t to)
+	{
+		forEachStream([from, to](Vector<float>& stream) { stream[to] = stream[from]; });
+	}
+
+	void set(uint32_t i, const PointSprite& p)
+	{
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			position[c][i] = p.position[c];
+			velocity[c][i] = p.velocity[c];
+			acceleration[c][i] = p.acceleration[c];
+		}
+		for (uint32_t c = 0; c < 4; ++c)
+			color[c][i] = p.color[c];
+
+		size[i] = p.size;
+		emitTime[i] = p.emitTime;
+		lifeTime[i] = p.lifeTime;
+	}
+
+	PointSprite get(uint32_t i) const
+	{
+		PointSprite p;
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			p.position[c] = position[c][i];
+			p.velocity[c] = velocity[c][i];
+			p.acceleration[c] = acceleration[c][i];
+		}
+		for (uint32_t c = 0; c < 4; ++c)
+			p.color[c] = color[c][i];
+
+		p.size = size[i];
+		p.emitTime = emitTime[i];
+		p.lifeTime = lifeTime[i];
+		return p;
+	}
+
+	template <typename F>
+	void forEachStream(F func)
+	{
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			func(position[c]);
+			func(velocity[c]);
+			func(acceleration[c]);
+		}
+		for (uint32_t c = 0; c < 4; ++c)
+			func(color[c]);
+
+		func(size);
+		func(emitTime);
+		func(lifeTime);
+	}
+};
+
+/*
+ * Emitter of point sprites stored as structure of arrays.
+ * Default movement model is integrated with SIMD kernels on worker threads,
+ * custom update function (if set) replaces it and is called per particle on the calling thread.
+ * Custom variation function (if set) replaces default randomization of the emitted particles.
+ */
+class PointSpriteBatchEmitter
+{
+public:
+	using ParticleUpdateFuction = std::function<void(PointSprite&, float, float)>;
+	using ParticleVariationFuction = std::function<PointSprite(const PointSprite&, const PointSprite&, float)>;
+
+public:
+	PointSpriteBatchEmitter(uint32_t capacity) :
+		_capacity(capacity)
+	{
+		_streams.resize(capacity);
+	}
+
+	template <typename F>
+	void setUpdateFunction(F&& func)
+	{
+		_updateFunction = func;
+	}
+
+	template <typename V>
+	void setVariationFunction(V&& func)
+	{
+		_variationFunction = func;
+	}
+
+	uint32_t capacity() const
+	{
+		return _capacity;
+	}
+
+	uint32_t activeParticlesCount() const
+	{
+		return _activeParticles;
+	}
+
+	PointSprite particle(uint32_t i) const
+	{
+		ET_ASSERT(i < _capacity);
+		return _streams.get(i);
+	}
+
+	const PointSpriteStreams& streams() const
+	{
+		return _streams;
+	}
+
+	void setShouldAutoRenewParticles(bool a)
+	{
+		_autoRenewParticles = a;
+	}
+
+	PointSprite& base()
+	{
+		return _base;
+	}
+
+	const PointSprite& base() const
+	{
+		return _base;
+	}
+
+	PointSprite& variation()
+	{
+		return _variation;
+	}
+
+	const PointSprite& variation() const
+	{
+		return _variation;
+	}
+
+	void setBase(const PointSprite& p)
+	{
+		_base = p;
+	}
+
+	void setVariation(const PointSprite& v)
+	{
+		_variation = v;
+	}
+
+	bool emit(const PointSprite& p)
+	{
+		if (_activeParticles >= _capacity) return false;
+
+		_streams.set(_activeParticles++, p);
+		return true;
+	}
+
+	uint32_t emit(uint32_t count, float t)
+	{
+		uint32_t emitted = std::min(count, _capacity - _activeParticles);
+		for (uint32_t i = _activeParticles, e = _activeParticles + emitted; i < e; ++i)
+			generate(i, t);
+
+		updateRange(_activeParticles, _activeParticles + emitted, t, 0.0f);
+		_activeParticles += emitted;
+		return emitted;
+	}
+
+	uint32_t emit(uint32_t count, float t, const PointSprite& base, const PointSprite& var)
+	{
+		setBase(base);
+		setVariation(var);
+		return emit(count, t);
+	}
+
+	uint32_t emitMissingParticles(float t)
+	{
+		return emit(_capacity - _activeParticles, t);
+	}
+
+	void clear()
+	{
+		_activeParticles = 0;
+	}
+
+	void update(float t)
+	{
+		if (_updateTime == 0.0f)
+			_updateTime = t;
+
+		float dt = t - _updateTime;
+		_updateTime = t;
+
+		if (_updateFunction)
+		{
+			updateRange(0, _activeParticles, t, dt);
+		}
+		else
+		{
+			uint32_t blocks = (_activeParticles + PointSpriteStreams::Lanes - 1) / PointSpriteStreams::Lanes;
+			parallel::forRange(blocks, parallel::suggestedGrain(blocks, 256), [this, t, dt](uint32_t begin, uint32_t end)
+			{
+				integrate(begin * PointSpriteStreams::Lanes, end * PointSpriteStreams::Lanes, t, dt);
+			});
+		}
+
+		if (_autoRenewParticles)
+		{
+			for (uint32_t i = 0; i < _activeParticles; ++i)
+			{
+				if (expired(i, t))
+				{
+					generate(i, t);
+					updateRange(i, i + 1, t, 0.0f);
+				}
+			}
+		}
+		else
+		{
+			uint32_t alive = 0;
+			for (uint32_t i = 0; i < _activeParticles; ++i)
+			{
+				if (expired(i, t))
+					continue;
+
+				if (alive != i)
+					_streams.move(i, alive);
+
+				++alive;
+			}
+			_activeParticles = alive;
+		}
+	}
+
+	/*
+	 * Writes positions and colors of active particles into interleaved vertex data
+	 */
+	void writeVertices(char* data, uint32_t stride, uint32_t positionOffset, uint32_t colorOffset) const
+	{
+		parallel::forRange(_activeParticles, parallel::suggestedGrain(_activeParticles, 1024), [&](uint32_t begin, uint32_t end)
+		{
+			const float* px = _streams.position[0].data();
+			const float* py = _streams.position[1].data();
+			const float* pz = _streams.position[2].data();
+			const float* cr = _streams.color[0].data();
+			const float* cg = _streams.color[1].data();
+			const float* cb = _streams.color[2].data();
+			const float* ca = _streams.color[3].data();
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				float* position = reinterpret_cast<float*>(data + i * stride + positionOffset);
+				position[0] = px[i];
+				position[1] = py[i];
+				position[2] = pz[i];
+
+				float* color = reinterpret_cast<float*>(data + i * stride + colorOffset);
+				color[0] = cr[i];
+				color[1] = cg[i];
+				color[2] = cb[i];
+				color[3] = ca[i];
+			}
+		});
+	}
+
+private:
+	static vec4simd load(const Vector<float>& stream, uint32_t i)
+	{
+		return vec4simd(*reinterpret_cast<const vec4*>(stream.data() + i));
+	}
+
+	static void store(const vec4simd& value, Vector<float>& stream, uint32_t i)
+	{
+		value.loadToFloatsUnaligned(stream.data() + i);
+	}
+
+	void integrate(uint32_t begin, uint32_t end, float t, float dt)
+	{
+		const vec4simd one(1.0f);
+		const vec4simd time(t);
+
+		for (uint32_t i = begin; i < end; i += PointSpriteStreams::Lanes)
+		{
+			vec4simd age = time - load(_streams.emitTime, i);
+			store(one - age / load(_streams.lifeTime, i), _streams.color[3], i);
+
+			float* alpha = _streams.color[3].data() + i;
+			for (uint32_t j = 0; j < PointSpriteStreams::Lanes; ++j)
+				alpha[j] = clamp(alpha[j], 0.0f, 1.0f);
+
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				vec4simd velocity = load(_streams.velocity[c], i);
+				velocity.addMultiplied(load(_streams.acceleration[c], i), dt);
+				store(velocity, _streams.velocity[c], i);
+
+				vec4simd position = load(_streams.position[c], i);
+				position.addMultiplied(velocity, dt);
+				store(position, _streams.position[c], i);
+			}
+		}
+	}
+
+	void updateRange(uint32_t begin, uint32_t end, float t, float dt)
+	{
+		if (_updateFunction)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				PointSprite p = _streams.get(i);
+				_updateFunction(p, t, dt);
+				_streams.set(i, p);
+			}
+		}
+		else
+		{
+			for (uint32_t i = begin; i < end; ++i)
+				_streams.color[3][i] = clamp(1.0f - (t - _streams.emitTime[i]) / _streams.lifeTime[i], 0.0f, 1.0f);
+		}
+	}
+
+	bool expired(uint32_t i, float t) const
+	{
+		return (t - _streams.emitTime[i]) > _streams.lifeTime[i];
+	}
+
+	void generate(uint32_t i, float t)
+	{
+		if (_variationFunction)
+		{
+			_streams.set(i, _variationFunction(_base, _variation, t));
+			return;
+		}
+
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			_streams.position[c][i] = _base.position[c] + randomFloat(-_variation.position[c], _variation.position[c]);
+			_streams.velocity[c][i] = _base.velocity[c] + randomFloat(-_variation.velocity[c], _variation.velocity[c]);
+			_streams.acceleration[c][i] = _base.acceleration[c] + randomFloat(-_variation.acceleration[c], _variation.acceleration[c]);
+		}
+		for (uint32_t c = 0; c < 4; ++c)
+			_streams.color[c][i] = _base.color[c] + randomFloat(-_variation.color[c], _variation.color[c]);
+
+		_streams.size[i] = _base.size + randomFloat(-_variation.size, _variation.size);
+		_streams.emitTime[i] = t + randomFloat(0.0f, _variation.emitTime);
+		_streams.lifeTime[i] = _base.lifeTime + randomFloat(-_variation.lifeTime, _variation.lifeTime);
+	}
+
+private:
+	PointSpriteStreams _streams;
+	ParticleUpdateFuction _updateFunction;
+	ParticleVariationFuction _variationFunction;
+
+	PointSprite _base;
+	PointSprite _variation;
+
+	uint32_t _capacity = 0;
+	uint32_t _activeParticles = 0;
+	float _updateTime = 0.0f;
+	bool _autoRenewParticles = true;
+};
 };
 }
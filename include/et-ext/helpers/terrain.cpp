@@ -5,570 +5,301 @@
  *
  */
 
-#include <et/core/tools.h>
-#include <et/app/application.h>
-#include <et/core/intervaltimer.h>
-#include <et/rendering/rendering.h>
-#include <et/rendering/primitives.h>
+#include <et/core/parallel.h>
 #include <et-ext/helpers/terrain.h>
 
 using namespace et;
 
-#define ET_TERRAIN_CHUNK_SIZE			32
-
-class et::TerrainLODLevels
+Terrain::Terrain(RenderInterface::Pointer& renderer, const TerrainData::Pointer& data) :
+	Terrain(renderer, data, Options())
 {
-public:
-	struct LOD
-	{
-		static const size_t VARIATIONS = 16;
-		uint32_t first[VARIATIONS];
-		uint32_t size[VARIATIONS];
-	};
-
-	LOD lods[Terrain::LodLevel_max];
-
-	enum TriangleType
-	{
-		TT_LeftTop,
-		TT_LeftBottom,
-		TT_RightTop,
-		TT_RightBottom
-	};
-
-	enum LODSide
-	{
-		Side_Left,
-		Side_Right,
-		Side_Bottom,
-		Side_Top
-	};
-
-	enum LODCorner
-	{
-		Corner_LeftTop,
-		Corner_LeftBottom,
-		Corner_RightTop,
-		Corner_RightBottom
-	};
-
-	union LODVariation
-	{ 
-		struct 
-		{
-			bool conjugateLeft : 1;
-			bool conjugateRight : 1;
-			bool conjugateTop : 1;
-			bool conjugateBottom : 1;
-		};
-
-		struct 
-		{
-			int _definition;
-		};
+}
 
-		inline int definition() 
-		{ 
-			return static_cast<int>(conjugateLeft) | static_cast<int>(conjugateRight) << 1 | 
-				static_cast<int>(conjugateTop) << 2 | static_cast<int>(conjugateBottom) << 3;
-		}
-		
-		LODVariation() : 
-			_definition(0) { }
-	};
+Terrain::Terrain(RenderInterface::Pointer& renderer, const TerrainData::Pointer& data, const Options& options) :
+	_renderer(renderer), _data(data), _options(options), _decl(true, VertexAttributeUsage::Position, DataType::Vec3)
+{
+	ET_ASSERT(_data.valid() && _data->valid());
+	ET_ASSERT((_data->leafSize() >= 2) && (_data->leafSize() % 2 == 0));
 
-#define pushIndex(value) _buf->push_back(value)
+	_decl.push_back(VertexAttributeUsage::Normal, DataType::Vec3);
+	_decl.push_back(VertexAttributeUsage::TexCoord0, DataType::Vec2);
+	_decl.push_back(VertexAttributeUsage::TexCoord1, DataType::Float);
 
-	void putTriangle(TriangleType t, uint32_t c_u, uint32_t n_u, uint32_t c_v, uint32_t n_v)
-	{
-		switch (t) 
-		{
-		case TT_LeftTop:
-			{
-				pushIndex(c_u + c_v);
-				pushIndex(c_u + n_v);
-				pushIndex(n_u + c_v);
-				break;
-			}
-		case TT_RightTop:
-			{
-				pushIndex(c_u + c_v);
-				pushIndex(n_u + n_v);
-				pushIndex(n_u + c_v);
-				break;
-			}
-		case TT_LeftBottom:
-			{
-				pushIndex(c_u + c_v);
-				pushIndex(c_u + n_v);
-				pushIndex(n_u + n_v);
-				break;
-			}
-		case TT_RightBottom:
-			{
-				pushIndex(n_u + c_v);
-				pushIndex(c_u + n_v);
-				pushIndex(n_u + n_v);
-				break;
-			}
-		};
-	}
+	buildIndexBuffer();
+}
 
-	void generateSolidLOD(int level, size_t var)
+void Terrain::buildIndexBuffer()
+{
+	uint32_t gridSize = _data->leafSize();
+	uint32_t rowSize = gridSize + 1;
+	uint32_t halfSize = gridSize / 2;
+
+	_indexFormat = (rowSize * rowSize > std::numeric_limits<uint16_t>::max()) ?
+		IndexArrayFormat::Format_32bit : IndexArrayFormat::Format_16bit;
+	_quadrantIndexCount = halfSize * halfSize * 6;
+
+	/*
+	 * indices are grouped by quadrants, so partially selected nodes are drawn with sub-ranges
+	 */
+	IndexArray::Pointer indices = IndexArray::Pointer::create(_indexFormat, 4 * _quadrantIndexCount, PrimitiveType::Triangles);
+	indices->setActualSize(0);
+	for (uint32_t q = 0; q < 4; ++q)
 	{
-		uint32_t scale = static_cast<uint32_t>(intPower(2, level));
-		vector2<uint32_t> terrainDim(static_cast<uint32_t>(_t->terrainData()->dimension().x - 1), 
-									  static_cast<uint32_t>(_t->terrainData()->dimension().y - 1));
-		vector2<uint32_t> dim(ET_TERRAIN_CHUNK_SIZE / scale, ET_TERRAIN_CHUNK_SIZE / scale);
-		vec2i s(_x0, _z0);
-
-		lods[level].first[var] = _buf->actualSize();
-		lods[level].size[var] = dim.square() * 6;
-
-		for (uint32_t v = 0; v < dim.y; ++v)
+		uint32_t u0 = (q & 1) * halfSize;
+		uint32_t v0 = (q >> 1) * halfSize;
+		for (uint32_t v = v0; v < v0 + halfSize; ++v)
 		{
-			uint32_t c_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + v * scale)) * (terrainDim.x + 1);
-			uint32_t n_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + (v + 1) * scale)) * (terrainDim.x + 1);
-
-			for (uint32_t u = 0; u < dim.x; ++u)
+			uint32_t c_v = v * rowSize;
+			uint32_t n_v = (v + 1) * rowSize;
+			for (uint32_t u = u0; u < u0 + halfSize; ++u)
 			{
-				uint32_t c_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + u * scale));
-				uint32_t n_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + (u + 1) * scale));
-
-				pushIndex(c_u + c_v);
-				pushIndex(c_u + n_v);
-				pushIndex(n_u + c_v);
-				pushIndex(c_u + n_v);
-				pushIndex(n_u + n_v);
-				pushIndex(n_u + c_v);
+				uint32_t c_u = u;
+				uint32_t n_u = u + 1;
+				indices->push_back(c_u + c_v);
+				indices->push_back(c_u + n_v);
+				indices->push_back(n_u + c_v);
+				indices->push_back(c_u + n_v);
+				indices->push_back(n_u + n_v);
+				indices->push_back(n_u + c_v);
 			}
 		}
 	}
 
-	void generateLODInterior(const vec2i& lod_dim, int lod_scale_hi, int lod_scale, int& TRI_COUNTER)
-	{
-		vector2<uint32_t> terrainDim(static_cast<uint32_t>(_t->terrainData()->dimension().x - 1), 
-									    static_cast<uint32_t>(_t->terrainData()->dimension().y - 1));
+	_indexBuffer = _renderer->createIndexBuffer("terrain-ib", indices, Buffer::Location::Device);
+}
 
-		for (uint32_t v = 0; v < static_cast<uint32_t>(lod_dim.y - 1); ++v)
-		{
-			uint32_t c_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + lod_scale_hi + v * lod_scale)) * (terrainDim.x + 1);
-			uint32_t n_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + lod_scale_hi + (v + 1) * lod_scale)) * (terrainDim.x + 1);
-			for (uint32_t u = 0; u < static_cast<uint32_t>(lod_dim.x - 1); ++u)
-			{
-				uint32_t c_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + lod_scale_hi + u * lod_scale));
-				uint32_t n_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + lod_scale_hi + (u + 1) * lod_scale ));
-				pushIndex(c_u + c_v);
-				pushIndex(c_u + n_v);
-				pushIndex(n_u + c_v);
-				pushIndex(c_u + n_v);
-				pushIndex(n_u + n_v);
-				pushIndex(n_u + c_v);
-				TRI_COUNTER += 2;
-			}
-		}
-	}
+void Terrain::select(const Camera& camera)
+{
+	select(camera.position(), camera.frustum());
+}
 
-	void putTransitionTriangles(LODSide side, const vec2i& lod_dim_hi, const vec2i& lod_dim, 
-			uint32_t lod_scale_hi, uint32_t lod_scale, int& TRI_COUNTER)
+void Terrain::select(const vec3& viewPoint, const Frustum& frustum)
+{
+	++_frame;
+	_selectedNodes.clear();
+	_viewPoint = viewPoint;
+	_frustum = &frustum;
+
+	uint32_t topLevel = _data->levelsCount() - 1;
+	const vec2i& topCount = _data->nodesCount(topLevel);
+	for (int32_t z = 0; z < topCount.y; ++z)
 	{
-		vector2<uint32_t> terrainDim(static_cast<uint32_t>(_t->terrainData()->dimension().x - 1), 
-									  static_cast<uint32_t>(_t->terrainData()->dimension().y - 1));
-		if ( (side == Side_Top) || (side == Side_Bottom) )
-		{
-			for (uint32_t u = 0; u < static_cast<uint32_t>(lod_dim.x - 1); ++u)
-			{
-				uint32_t v = (side == Side_Top) ? 0 : static_cast<uint32_t>(lod_dim_hi.y - 1);
-				uint32_t c_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + v * lod_scale_hi)) * (terrainDim.x + 1);
-				uint32_t n_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + (v + 1) * lod_scale_hi)) * (terrainDim.x + 1);
-				uint32_t c_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + lod_scale_hi + u * lod_scale));
-				uint32_t m_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + lod_scale_hi + u * lod_scale + lod_scale_hi));
-				uint32_t n_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + lod_scale_hi + (u + 1) * lod_scale));
-				if (side == Side_Top)
-				{
-					pushIndex( m_u + c_v );
-					pushIndex( c_u + n_v );
-					pushIndex( n_u + n_v );
-				}
-				else
-				{
-					pushIndex( c_u + c_v );
-					pushIndex( m_u + n_v );
-					pushIndex( n_u + c_v );
-				}
-				++TRI_COUNTER;
-			}
-		}
-		else
-		{
-			for (int v = 0; v < lod_dim.y - 1; ++v)
-			{
-				uint32_t u = (side == Side_Left) ? 0 : static_cast<uint32_t>((lod_dim.x - 1) * lod_scale + lod_scale_hi);
-				uint32_t c_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + lod_scale_hi + v * lod_scale)) * (terrainDim.x + 1);
-				uint32_t m_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + lod_scale_hi + v * lod_scale + lod_scale_hi)) * (terrainDim.x + 1);
-				uint32_t n_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + lod_scale_hi + (v + 1) * lod_scale)) * (terrainDim.x + 1);
-				uint32_t c_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + u));
-				uint32_t n_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + u + lod_scale_hi));
-				if (side == Side_Left)
-				{
-					pushIndex( n_u + c_v );
-					pushIndex( c_u + m_v );
-					pushIndex( n_u + n_v );
-				}
-				else
-				{
-					pushIndex( c_u + c_v );
-					pushIndex( c_u + n_v );
-					pushIndex( n_u + m_v );
-				}
-				++TRI_COUNTER;
-			}
-		}
+		for (int32_t x = 0; x < topCount.x; ++x)
+			selectNode(topLevel, vec2i(x, z));
 	}
 
-	void putConjugateTriangles(LODSide side, bool large, const vec2i& lod_dim_hi, const vec2i& lod_dim, int lod_scale_hi, int lod_scale, int& TRI_COUNTER)
-	{
-		int currentScale = large ? lod_scale : lod_scale_hi;
-		const vec2i& currentDim = large ? lod_dim : lod_dim_hi;
-		vector2<uint32_t> terrainDim(static_cast<uint32_t>(_t->terrainData()->dimension().x - 1), 
-									  static_cast<uint32_t>(_t->terrainData()->dimension().y - 1));
-
-		if ((side == Side_Top) || (side == Side_Bottom))
-		{
-			int v = (side == Side_Top) ? 0 : lod_dim_hi.y - 1;
-			uint32_t c_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + v * lod_scale_hi)) * (terrainDim.x + 1);
-			uint32_t n_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + (v + 1) * lod_scale_hi)) * (terrainDim.x + 1);
-
-			for (uint32_t u = 0; u < static_cast<uint32_t>(currentDim.x); ++u)
-			{
-				bool odd = u % 2 == 1;
-				uint32_t c_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + u * currentScale));
-				uint32_t n_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + (u + 1) * currentScale));
-
-				if (side == Side_Top)
-				{
-					if (large)
-					{
-						uint32_t m_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + u * currentScale + lod_scale_hi));
-						pushIndex( c_u + c_v );
-						pushIndex( m_u + n_v );
-						pushIndex( n_u + c_v );
-					}
-					else
-						putTriangle( odd ? TT_LeftTop : TT_RightTop, c_u, n_u, c_v, n_v);
-				}
-				else
-				{
-					if (large)
-					{
-						uint32_t m_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + u * currentScale + lod_scale_hi));
-						pushIndex( m_u + c_v );
-						pushIndex( c_u + n_v );
-						pushIndex( n_u + n_v );
-					}
-					else
-						putTriangle( odd ? TT_LeftBottom : TT_RightBottom, c_u, n_u, c_v, n_v);
-				}
-				++TRI_COUNTER;
-			}
-		} 
-		else
-		{
-			uint32_t u = (side == Side_Left) ? 0 : static_cast<uint32_t>(lod_dim_hi.x - 1);
-			uint32_t c_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + u * lod_scale_hi));
-			uint32_t n_u = std::min(terrainDim.x, static_cast<uint32_t>(_x0 + (u + 1) * lod_scale_hi));
+	_frustum = nullptr;
+}
 
-			for (int h = 0; h < currentDim.y; ++h)
-			{
-				bool odd = h % 2 == 1;
-				uint32_t c_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + h * currentScale)) * (terrainDim.x + 1);
-				uint32_t n_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + (h + 1) * currentScale)) * (terrainDim.x + 1);
-
-				if (side == Side_Left)
-				{
-					if (large)
-					{
-						uint32_t m_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + h * currentScale + lod_scale_hi)) * (terrainDim.x + 1);
-						pushIndex(c_u + c_v);
-						pushIndex(c_u + n_v);
-						pushIndex(n_u + m_v);
-					}
-					else
-						putTriangle( odd ? TT_LeftTop : TT_LeftBottom, c_u, n_u, c_v, n_v );
-				}
-				else
-				{
-					if (large)
-					{
-						uint32_t m_v = std::min(terrainDim.y, static_cast<uint32_t>(_z0 + h * currentScale + lod_scale_hi)) * (terrainDim.x + 1);
-						pushIndex(n_u + c_v);
-						pushIndex(c_u + m_v);
-						pushIndex(n_u + n_v);
-					}
-					else
-					{
-						putTriangle( odd ? TT_RightTop : TT_RightBottom, c_u, n_u, c_v, n_v );
-					}
-				}
-			}
-			++TRI_COUNTER;
-		}
-	}
+void Terrain::selectNode(uint32_t level, const vec2i& node)
+{
+	BoundingBox bounds = _data->nodeBounds(level, node);
+	if (!_frustum->containsBoundingBox(bounds))
+		return;
 
-	void generateLODLevel(int level, LODVariation var)
+	if ((level == 0) || (distanceToBounds(bounds) > levelRange(level - 1)))
 	{
-		if (var.definition() == 0)
-		{
-			generateSolidLOD(level, 0);
-			return;
-		}
-
-		int variation = var.definition();
-		uint32_t lod_scale = static_cast<uint32_t>(intPower(2, level));
-		uint32_t lod_scale_hi = lod_scale / 2;
-		vec2i lod_dim = vec2i( ET_TERRAIN_CHUNK_SIZE / lod_scale, ET_TERRAIN_CHUNK_SIZE / lod_scale );
-		vec2i lod_dim_hi = 2 * lod_dim;
-
-		lods[level].first[variation] = _buf->actualSize();
-
-		int TRI_COUNTER = 0;
-
-		putConjugateTriangles(Side_Left, !var.conjugateLeft, lod_dim_hi, lod_dim, lod_scale_hi, lod_scale, TRI_COUNTER);
-		putConjugateTriangles(Side_Top, !var.conjugateTop, lod_dim_hi, lod_dim, lod_scale_hi, lod_scale, TRI_COUNTER);
-		putConjugateTriangles(Side_Right, !var.conjugateRight, lod_dim_hi, lod_dim, lod_scale_hi, lod_scale, TRI_COUNTER);
-		putConjugateTriangles(Side_Bottom, !var.conjugateBottom, lod_dim_hi, lod_dim, lod_scale_hi, lod_scale, TRI_COUNTER);
-
-		putTransitionTriangles(Side_Left, lod_dim_hi, lod_dim, lod_scale_hi, lod_scale, TRI_COUNTER);
-		putTransitionTriangles(Side_Top, lod_dim_hi, lod_dim, lod_scale_hi, lod_scale, TRI_COUNTER);
-		putTransitionTriangles(Side_Bottom, lod_dim_hi, lod_dim, lod_scale_hi, lod_scale, TRI_COUNTER);
-		putTransitionTriangles(Side_Right, lod_dim_hi, lod_dim, lod_scale_hi, lod_scale, TRI_COUNTER);
-
-		generateLODInterior(lod_dim, lod_scale_hi, lod_scale, TRI_COUNTER);
-
-		lods[level].size[variation] = _buf->actualSize() - lods[level].first[variation];
+		addNode(level, node, bounds, Quadrant_All);
+		return;
 	}
 
-	TerrainLODLevels(IndexArray::Pointer buf, Terrain* t) : _buf(buf), _t(t), _x0(0), _z0(0)
+	/*
+	 * children within range of the finer level are refined,
+	 * the rest of the node area is drawn at this level by quadrants
+	 */
+	uint32_t quadrants = 0;
+	const vec2i& childrenCount = _data->nodesCount(level - 1);
+	for (uint32_t q = 0; q < 4; ++q)
 	{
-		int maxLodIndices = ET_TERRAIN_CHUNK_SIZE * ET_TERRAIN_CHUNK_SIZE * 6;
-		int approxIndices = maxLodIndices;
-
-		for (int i = 1; i < Terrain::LodLevel_max; ++i)
-			approxIndices += 16 * maxLodIndices / intPower(2, i);
-
-		_buf->resizeToFit(approxIndices);
-
-		generateSolidLOD(0, 0);
+		vec2i child(2 * node.x + static_cast<int32_t>(q & 1), 2 * node.y + static_cast<int32_t>(q >> 1));
+		if ((child.x >= childrenCount.x) || (child.y >= childrenCount.y))
+			continue;
 
-		for (int level = 1; level < Terrain::LodLevel_max; ++level)
-		{
-			for (int var = 0; var < TerrainLODLevels::LOD::VARIATIONS; ++var)
-			{
-				TerrainLODLevels::LODVariation variation;
-				variation._definition = var;
-				generateLODLevel(level, variation);
-			}
-		}
+		BoundingBox childBounds = _data->nodeBounds(level - 1, child);
+		if (!_frustum->containsBoundingBox(childBounds))
+			continue;
 
-		_buf->compact();
+		if (distanceToBounds(childBounds) > levelRange(level - 1))
+			quadrants |= 1 << q;
+		else
+			selectNode(level - 1, child);
 	}
 
-private:
-	TerrainLODLevels& operator = (const TerrainLODLevels&)
-		{ return *this; }
-
-private:
-	IndexArray::Pointer _buf;
-	Terrain* _t;
-
-	uint32_t _x0;
-	uint32_t _z0;
-	uint32_t _lod0EndIndex;
-};
+	if (quadrants != 0)
+		addNode(level, node, bounds, quadrants);
+}
 
-class et::TerrainChunk
+void Terrain::addNode(uint32_t level, const vec2i& node, const BoundingBox& bounds, uint32_t quadrants)
 {
-public:
-	TerrainChunk(int index, Terrain* t, int x0, int z0) : selectedLod(0), selectedVariation(0), 
-		visible(true), _x0(x0), _z0(z0), _index(index), _t(t)
+	_selectedNodes.emplace_back();
+	SelectedNode& selected = _selectedNodes.back();
+	selected.bounds = bounds;
+	selected.position = node;
+	selected.level = level;
+	selected.quadrants = quadrants;
+
+	if (level + 1 < _data->levelsCount())
 	{
-		VertexDataChunk pos = t->_tdata->vertexData()->chunk(VertexAttributeUsage::Position);
-		RawDataAcessor<vec3> posData = pos.accessData<vec3>(0);
-
-		initialOffset = x0 + z0 * _t->terrainData()->dimension().x;
-		vec3 _minVect = posData[initialOffset];
-		vec3 _maxVect = _minVect;
-
-		for (int z = z0, ze = z0 + ET_TERRAIN_CHUNK_SIZE; z < ze; ++z)
-		{
-			for (int x = x0, xe = x0 + ET_TERRAIN_CHUNK_SIZE; x < xe; ++x)
-			{
-				int e = x + z * _t->terrainData()->dimension().x;
-				_minVect = minv(posData[e], _minVect);
-				_maxVect = maxv(posData[e], _maxVect);
-			}
-		}
-
-		vec3 center = (_minVect + _maxVect) / 2.0f;
-		vec3 dimension = _maxVect - _minVect;
-		_boundingBox = BoundingBox(center, dimension);
+		float start = morphStart(level);
+		float end = levelRange(level);
+		selected.morph = clamp((distanceToBounds(bounds) - start) / (end - start), 0.0f, 1.0f);
 	}
+}
 
-public:
-	int selectedLod;
-	int selectedVariation;
-	int initialOffset;
-	bool visible;
-
-	const int index() const
-		{ return _index; }
-
-	const BoundingBox& boundingBox() const
-		{ return _boundingBox; }
-
-private:
-	int _x0;
-	int _z0;
-	int _index;
-	Terrain* _t;
-	BoundingBox _boundingBox;
-};
-
-Terrain::Terrain(RenderContext* rc, TerrainDelegate* tDelegate) : 
-	_rc(rc), _tdata(0), _delegate(tDelegate), _lods(0)
+float Terrain::levelRange(uint32_t level) const
 {
-
+	return _options.lodDistance * static_cast<float>(1u << level);
 }
 
-Terrain::~Terrain()
-{ 
-	releaseData();
+float Terrain::morphStart(uint32_t level) const
+{
+	float previousRange = (level > 0) ? levelRange(level - 1) : 0.0f;
+	return previousRange + (levelRange(level) - previousRange) * _options.morphStart;
 }
 
-void Terrain::releaseData()
+float Terrain::distanceToBounds(const BoundingBox& bounds) const
 {
-	for (ChunkIterator i = _chunks.begin(), e = _chunks.end(); i != e; ++i)
-		sharedObjectFactory().deleteObject(*i);
-	_chunks.clear();
-
-	sharedObjectFactory().deleteObject(_lods);
-	_lods = nullptr;
+	vec3 closestPoint = minv(maxv(_viewPoint, bounds.minVertex()), bounds.maxVertex());
+	return (closestPoint - _viewPoint).length();
 }
 
-void Terrain::render(RenderContext* rc)
+void Terrain::collectRenderBatches(Material::Pointer material, Vector<RenderBatch::Pointer>& batches)
 {
-	rc->renderState().bindVertexArrayObject(_vao);
-	for (ChunkIterator i = _chunks.begin(), e = _chunks.end(); i != e; ++i)
+	Vector<uint32_t> pending;
+	for (const SelectedNode& node : _selectedNodes)
 	{
-		TerrainChunk* chunk = *i;
-		TerrainLODLevels::LOD& l = _lods->lods[chunk->selectedLod];
-		rc->renderer()->drawElementsBaseIndex(_vao, chunk->initialOffset, 
-			l.first[chunk->selectedVariation], l.size[chunk->selectedVariation]);
+		uint64_t key = nodeKey(node.level, node.position);
+		auto existing = _geometryIndices.find(key);
+		if (existing == _geometryIndices.end())
+		{
+			uint32_t index = acquireGeometry(key);
+			_geometry[index].level = node.level;
+			_geometry[index].position = node.position;
+			pending.emplace_back(index);
+		}
+		else
+		{
+			_geometry[existing->second].lastUsedFrame = _frame;
+		}
 	}
-}
 
-void Terrain::loadFromData(const TerrainDataRef& data)
-{
-	_tdata = data;
-	generateBuffer();
-}
+	uint32_t pendingCount = static_cast<uint32_t>(pending.size());
+	parallel::forRange(pendingCount, 1, [this, &pending](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+			buildGeometry(_geometry[pending[i]]);
+	});
 
-void Terrain::loadFromStream(std::istream& stream, const vec2i& dimension, TerrainData::Format format)
-{
-	loadFromData(TerrainDataRef::create(_delegate, stream, dimension, format));
-}
+	for (uint32_t index : pending)
+		uploadGeometry(_geometry[index]);
 
-void Terrain::loadFromRAWFile(const std::string& fileName, const vec2i& dimension, TerrainData::Format format)
-{
-	std::ifstream rawFile(application().resolveFileName(fileName), std::ios_base::binary);
-	
-	if (rawFile.good())
-		loadFromStream(rawFile, dimension, format);
-}
+	for (const SelectedNode& node : _selectedNodes)
+	{
+		const NodeGeometry& geometry = _geometry[_geometryIndices.at(nodeKey(node.level, node.position))];
 
-void Terrain::generateBuffer()
-{
-	releaseData();
-	
-	IndexArray::Pointer indices = IndexArray::Pointer::create(IndexArrayFormat::Format_16bit, 0, PrimitiveType::Triangles);
-	_lods = sharedObjectFactory().createObject<TerrainLODLevels>(indices, this);
-	generateChunks();
-	indices->compact();
-
-	_vao = _rc->vertexBufferFactory().createVertexArrayObject("terrain-vao");
-	_vertexBuffer = _rc->vertexBufferFactory().createVertexBuffer("terrain-vb", _tdata->vertexData(), BufferDrawType::Static);
-	_indexBuffer = _rc->vertexBufferFactory().createIndexBuffer("terrain-ib", indices, BufferDrawType::Static);
-	_vao->setBuffers(_vertexBuffer, _indexBuffer);
-}
+		MaterialInstance::Pointer instance = material->instance();
+		instance->setVector(MaterialVariable::ExtraParameters, vec4(node.morph, morphStart(node.level),
+			levelRange(node.level), static_cast<float>(node.level)));
 
-void Terrain::generateChunks()
-{ 
-	std::cout << "Generating terrain chunks... ";
-	IntervalTimer timer(true);
+		if (node.quadrants == Quadrant_All)
+		{
+			batches.emplace_back(RenderBatch::Pointer::create(instance, geometry.stream, 0, 4 * _quadrantIndexCount));
+			continue;
+		}
 
-	int totalChunks = 0;
-	_chunkSizes = _tdata->dimension() / ET_TERRAIN_CHUNK_SIZE;
-	for (int z = 0; z < _chunkSizes.y; ++z)
-	{
-		for (int x = 0; x < _chunkSizes.x; ++x, ++totalChunks)
+		for (uint32_t q = 0; q < 4; ++q)
 		{
-			TerrainChunk* c = sharedObjectFactory().createObject<TerrainChunk>(totalChunks, this,
-				x * ET_TERRAIN_CHUNK_SIZE, z * ET_TERRAIN_CHUNK_SIZE);
-			_chunks.push_back(c);
+			if (node.quadrants & (1 << q))
+				batches.emplace_back(RenderBatch::Pointer::create(instance, geometry.stream, q * _quadrantIndexCount, _quadrantIndexCount));
 		}
 	}
-
-	std::cout << "done (" << timer.lap() << " sec) " << std::endl;
 }
 
-void Terrain::recomputeLodLevels()
+uint32_t Terrain::acquireGeometry(uint64_t key)
 {
-	if (_delegate == nullptr)
-		return;
+	uint32_t index = static_cast<uint32_t>(_geometry.size());
+	if (_geometry.size() >= _options.maxResidentNodes)
+	{
+		for (uint32_t i = 0, e = static_cast<uint32_t>(_geometry.size()); i < e; ++i)
+		{
+			if ((_geometry[i].lastUsedFrame < _frame) && ((index == e) || (_geometry[i].lastUsedFrame < _geometry[index].lastUsedFrame)))
+				index = i;
+		}
+	}
 
-	for (auto& i : _chunks)
+	if (index == _geometry.size())
+	{
+		uint32_t rowSize = _data->leafSize() + 1;
+		_geometry.emplace_back();
+		_geometry.back().storage = VertexStorage::Pointer::create(_decl, rowSize * rowSize);
+	}
+	else
 	{
-		bool visible = true;
-		i->selectedLod = clamp<int>(_delegate->computeTerrainLod(this, i->boundingBox(), i->selectedLod, visible), 0, LodLevel4);
-		i->visible = visible;
+		_geometryIndices.erase(_geometry[index].key);
 	}
-	validateLODLevels();
+
+	_geometry[index].key = key;
+	_geometry[index].lastUsedFrame = _frame;
+	_geometryIndices[key] = index;
+	return index;
 }
 
-void Terrain::validateLODLevels()
+void Terrain::buildGeometry(NodeGeometry& geometry)
 {
-	for (ChunkIterator i = _chunks.begin(), e = _chunks.end(); i != e; ++i)
+	int32_t gridSize = static_cast<int32_t>(_data->leafSize());
+	int32_t rowSize = gridSize + 1;
+	int32_t step = 1 << geometry.level;
+	vec2i origin = geometry.position * static_cast<int32_t>(_data->nodeSize(geometry.level));
+	vec2 uvScale(1.0f / static_cast<float>(_data->dimension().x - 1), 1.0f / static_cast<float>(_data->dimension().y - 1));
+
+	auto pos = geometry.storage->accessData<DataType::Vec3>(VertexAttributeUsage::Position, 0);
+	auto nrm = geometry.storage->accessData<DataType::Vec3>(VertexAttributeUsage::Normal, 0);
+	auto uv = geometry.storage->accessData<DataType::Vec2>(VertexAttributeUsage::TexCoord0, 0);
+	auto morph = geometry.storage->accessData<DataType::Float>(VertexAttributeUsage::TexCoord1, 0);
+
+	for (int32_t v = 0, i = 0; v < rowSize; ++v)
 	{
-		TerrainChunk* chunk = *i;
-
-		if (chunk->selectedLod == 0)
+		for (int32_t u = 0; u < rowSize; ++u, ++i)
 		{
-			chunk->selectedVariation = 0;
+			vec2i sample(std::min(origin.x + u * step, _data->dimension().x - 1), std::min(origin.y + v * step, _data->dimension().y - 1));
+			pos[i] = _data->positionAtXZ(sample);
+			nrm[i] = _data->normalAtXZ(sample);
+			uv[i] = vec2(static_cast<float>(sample.x) * uvScale.x, static_cast<float>(sample.y) * uvScale.y);
 		}
-		else
-		{
-			int chunkRow = chunk->index() / _chunkSizes.x;
-			int chunkCol = chunk->index() % _chunkSizes.x;
-
-			int leftCol = std::max(0, chunkCol - 1);
-			int rightCol = std::min(_chunkSizes.x - 1, chunkCol + 1);
-			int topRow = std::max(0, chunkRow - 1);
-			int bottomRow = std::min(_chunkSizes.y - 1, chunkRow + 1);
-
-			int leftChunk = leftCol + chunkRow * _chunkSizes.x;
-			int rightChunk = rightCol + chunkRow * _chunkSizes.x;
-			int topChunk = chunkCol + topRow * _chunkSizes.x;
-			int bottomChunk = chunkCol + bottomRow * _chunkSizes.x;
-
-			int ownLOD = chunk->selectedLod;
-
-			TerrainLODLevels::LODVariation variation;
-			variation.conjugateLeft = ownLOD > _chunks.at(leftChunk)->selectedLod;
-			variation.conjugateRight = ownLOD > _chunks.at(rightChunk)->selectedLod;
-			variation.conjugateTop = ownLOD > _chunks.at(topChunk)->selectedLod;
-			variation.conjugateBottom = ownLOD > _chunks.at(bottomChunk)->selectedLod;
+	}
 
-			chunk->selectedVariation = variation.definition();
+	/*
+	 * odd vertices morph to the middle of the coarser grid edges,
+	 * diagonal matches triangulation from the index buffer
+	 */
+	for (int32_t v = 0, i = 0; v < rowSize; ++v)
+	{
+		for (int32_t u = 0; u < rowSize; ++u, ++i)
+		{
+			bool oddU = (u % 2) == 1;
+			bool oddV = (v % 2) == 1;
+			if (oddU && oddV)
+				morph[i] = 0.5f * (pos[i + 1 - rowSize].y + pos[i - 1 + rowSize].y);
+			else if (oddU)
+				morph[i] = 0.5f * (pos[i - 1].y + pos[i + 1].y);
+			else if (oddV)
+				morph[i] = 0.5f * (pos[i - rowSize].y + pos[i + rowSize].y);
+			else
+				morph[i] = pos[i].y;
 		}
 	}
 }
+
+void Terrain::uploadGeometry(NodeGeometry& geometry)
+{
+	if (geometry.stream.valid())
+	{
+		geometry.stream->vertexBuffer()->updateData(0, geometry.storage->data());
+		return;
+	}
+
+	geometry.stream = VertexStream::Pointer::create();
+	geometry.stream->setVertexBuffer(_renderer->createVertexBuffer("terrain-node-vb", geometry.storage, Buffer::Location::Host), _decl);
+	geometry.stream->setIndexBuffer(_indexBuffer, _indexFormat);
+	geometry.stream->setPrimitiveType(PrimitiveType::Triangles);
+}
@@ -7,77 +7,130 @@
 
 #pragma once
 
-#include <et/core/containers.h>
-#include <et/geometry/collision.h>
-#include <et/rendering/rendercontext.h>
-#include <et/rendering/primitives.h>
+#include <et/camera/camera.h>
+#include <et/rendering/interface/renderer.h>
+#include <et/rendering/base/renderbatch.h>
 #include <et-ext/helpers/terraindata.h>
 
 namespace et
 {
-	class Terrain;
-	class TerrainChunk;
-	class TerrainLODLevels;
-
-	class TerrainDelegate : public TerrainDataDelegate
-	{
-	public: 
-		virtual int computeTerrainLod(Terrain const*, const BoundingBox&/* chunkAABB */, int/* lastLod */, bool& /* visible */)
-			{ return 0; };
-	};
-
+	/*
+	 * Continuous distance-dependent level of detail terrain.
+	 *
+	 * Every quadtree node is rendered with the same grid of leafSize x leafSize cells,
+	 * so one index buffer (with separate range for each quadrant) is shared by all levels.
+	 * Vertex data of the selected nodes is built from the streamed heightmap and kept in
+	 * the bounded cache, memory depends on the view distance rather than on the heightmap size.
+	 *
+	 * Vertex layout: Position (vec3), Normal (vec3), TexCoord0 (vec2, terrain-wide uv),
+	 * TexCoord1 (float, height of the vertex on the coarser level).
+	 * Materials receive ExtraParameters = (morph factor, morph start, morph end, level),
+	 * vertex shader should lerp position.y towards TexCoord1 by the morph factor.
+	 */
 	class Terrain : public Shared
 	{
 	public:
-		enum
+		ET_DECLARE_POINTER(Terrain);
+
+		struct Options
+		{
+			/*
+			 * view range of the level 0, doubled for each next level
+			 */
+			float lodDistance = 64.0f;
+
+			/*
+			 * fraction of the level range where morphing to the next level begins
+			 */
+			float morphStart = 0.66f;
+
+			uint32_t maxResidentNodes = 1024;
+		};
+
+		enum : uint32_t
 		{
-			LodLevel0 = 0, 
-			LodLevel1, 
-			LodLevel2, 
-			LodLevel3, 
-			LodLevel4, 
-			LodLevel_max
+			Quadrant_LeftTop = 1 << 0,
+			Quadrant_RightTop = 1 << 1,
+			Quadrant_LeftBottom = 1 << 2,
+			Quadrant_RightBottom = 1 << 3,
+			Quadrant_All = 0x0f
+		};
+
+		struct SelectedNode
+		{
+			BoundingBox bounds;
+			vec2i position;
+			uint32_t level = 0;
+			uint32_t quadrants = Quadrant_All;
+			float morph = 0.0f;
 		};
 
 	public:
-		Terrain(RenderContext* rc, TerrainDelegate* tDelegate);
-		~Terrain();
+		Terrain(RenderInterface::Pointer& renderer, const TerrainData::Pointer& data);
+		Terrain(RenderInterface::Pointer& renderer, const TerrainData::Pointer& data, const Options& options);
 
-		void loadFromData(const TerrainDataRef& data);
-		void loadFromRAWFile(const std::string& fileName, const vec2i& dimension, TerrainData::Format format);
-		void loadFromStream(std::istream& stream, const vec2i& dimension, TerrainData::Format format);
+		void select(const Camera& camera);
+		void select(const vec3& viewPoint, const Frustum& frustum);
 
-		void recomputeLodLevels();
-		void render(RenderContext* rc);
+		/*
+		 * Builds (or takes from the cache) vertex data of the selected nodes and outputs batches
+		 */
+		void collectRenderBatches(Material::Pointer material, Vector<RenderBatch::Pointer>& batches);
 
-		inline const TerrainDataRef terrainData() const
-			{ return _tdata; }
+		const Vector<SelectedNode>& selectedNodes() const
+			{ return _selectedNodes; }
 
-	private:
-		typedef std::vector<TerrainChunk*> TerrainChunkList;
-		typedef TerrainChunkList::iterator ChunkIterator;
+		uint32_t residentNodesCount() const
+			{ return static_cast<uint32_t>(_geometry.size()); }
 
-		void generateBuffer();
-		void generateChunks();
-		void validateLODLevels();
+		const TerrainData::Pointer& terrainData() const
+			{ return _data; }
 
-		void releaseData();
+		const Buffer::Pointer& indexBuffer() const
+			{ return _indexBuffer; }
 
 	private:
-		friend class TerrainChunk;
+		struct NodeGeometry
+		{
+			VertexStorage::Pointer storage;
+			VertexStream::Pointer stream;
+			uint64_t key = 0;
+			uint64_t lastUsedFrame = 0;
+			uint32_t level = 0;
+			vec2i position;
+		};
 
-		RenderContext* _rc;
-		TerrainDataRef _tdata;
-		TerrainDelegate* _delegate;
-		TerrainLODLevels* _lods;
-		TerrainChunkList _chunks;
+		static uint64_t nodeKey(uint32_t level, const vec2i& node)
+			{ return (static_cast<uint64_t>(level) << 48) | (static_cast<uint64_t>(node.y) << 24) | static_cast<uint64_t>(node.x); }
 
-		VertexBuffer::Pointer _vertexBuffer;
-		IndexBuffer::Pointer _indexBuffer;
-		VertexArrayObject::Pointer _vao;
+		void buildIndexBuffer();
+		void selectNode(uint32_t level, const vec2i& node);
+		void addNode(uint32_t level, const vec2i& node, const BoundingBox& bounds, uint32_t quadrants);
 
-		vec2i _chunkSizes;
-	};
+		float levelRange(uint32_t level) const;
+		float morphStart(uint32_t level) const;
+		float distanceToBounds(const BoundingBox& bounds) const;
+
+		uint32_t acquireGeometry(uint64_t key);
+		void buildGeometry(NodeGeometry& geometry);
+		void uploadGeometry(NodeGeometry& geometry);
 
-	typedef IntrusivePtr<Terrain> TerrainRef;
+	private:
+		RenderInterface::Pointer _renderer;
+		TerrainData::Pointer _data;
+		Options _options;
+
+		VertexDeclaration _decl;
+		Buffer::Pointer _indexBuffer;
+		IndexArrayFormat _indexFormat = IndexArrayFormat::Format_16bit;
+		uint32_t _quadrantIndexCount = 0;
+
+		Vector<SelectedNode> _selectedNodes;
+		Vector<NodeGeometry> _geometry;
+		UnorderedMap<uint64_t, uint32_t> _geometryIndices;
+
+		vec3 _viewPoint;
+		const Frustum* _frustum = nullptr;
+		uint64_t _frame = 0;
+	};
 }
@@ -5,326 +5,826 @@
  *
  */
 
+#include <et/core/parallel.h>
 #include <et/geometry/collision.h>
-#include <et/core/intervaltimer.h>
-#include <et/rendering/primitives.h>
+#include <et/geometry/vector4-simd.h>
 #include <et-ext/helpers/terraindata.h>
 
 using namespace et;
 
-TerrainData::TerrainData(TerrainDataDelegate* aDelegate) : _delegate(aDelegate)
-{
-}
-
-TerrainData::TerrainData(TerrainDataDelegate* aDelegate, std::istream& stream, const vec2i& dimension, Format format) : _delegate(aDelegate)
+namespace
 {
-	loadFromStream(stream, dimension, format);
-}
-
-void TerrainData::loadFromStream(std::istream& stream, const vec2i& dimension, Format format)
-{
-	_dimension = dimension;
-	_dimensionf.x = static_cast<float>(dimension.x - 1);
-	_dimensionf.y = static_cast<float>(dimension.y - 1);
-
-	int size = dimension.square();
+	uint32_t buildNodesCount(const vec2i& dimension, uint32_t leafSize, vec2i* nodesCount)
+	{
+		vec2i count((dimension.x - 2) / static_cast<int>(leafSize) + 1, (dimension.y - 2) / static_cast<int>(leafSize) + 1);
 
-	FloatDataStorage heightmap(size);
+		uint32_t levels = 0;
+		while (levels < TerrainData::MaxLevels)
+		{
+			nodesCount[levels++] = count;
+			if ((count.x == 1) && (count.y == 1))
+				break;
 
-	if (format == TerrainData::Format_8bit)
-	{
-		DataStorage<unsigned char> buffer(size);
-		stream.read(buffer.binary(), size);
-		for (int i = 0; i < size; ++i)
-			heightmap.push_back(static_cast<float>(buffer[i]) / 255.0f);
+			count = vec2i((count.x + 1) / 2, (count.y + 1) / 2);
+		}
+		return levels;
 	}
-	else
+
+	uint64_t tilesDataSize(const vec2i& tilesCount, uint32_t tileSize)
 	{
-		DataStorage<unsigned short> buffer(size);
-		stream.read(buffer.binary(), size * sizeof(unsigned short));
-		for (int i = 0; i < size; ++i)
-			heightmap.push_back(static_cast<float>(buffer[i]) / 65535.0f);
+		return static_cast<uint64_t>(tilesCount.square()) * tileSize * tileSize * sizeof(uint16_t);
 	}
-
-	generateVertexData(heightmap);
 }
 
-void TerrainData::generateVertexData(const FloatDataStorage& hm)
+bool TerrainData::convertRAWFile(const std::string& rawFile, const vec2i& dimension, Format format,
+	const std::string& tiledFile, uint32_t tileSize, uint32_t leafSize)
 {
-	vec2i gridPos(0);
+	if ((dimension.x < 2) || (dimension.y < 2) || (tileSize == 0) || (leafSize == 0))
+	{
+		log::error("Invalid terrain dimensions for %s", rawFile.c_str());
+		return false;
+	}
 
-	float x = 0.0f;
-	float z = 0.0f;
+	uint64_t bytesPerSample = (format == Format_8bit) ? 1 : 2;
+	MappedFile source(rawFile);
+	if (!source.valid() || (source.size() < static_cast<uint64_t>(dimension.square()) * bytesPerSample))
+	{
+		log::error("Unable to read terrain heightmap from %s", rawFile.c_str());
+		return false;
+	}
+
+	const uint8_t* sourceData = source.data();
+	auto sampleAt = [sourceData, &dimension, format](int32_t x, int32_t z) -> uint16_t
+	{
+		uint64_t index = static_cast<uint64_t>(clamp(x, 0, dimension.x - 1)) +
+			static_cast<uint64_t>(clamp(z, 0, dimension.y - 1)) * static_cast<uint64_t>(dimension.x);
 
-	VertexDeclaration decl(true);
-	decl.push_back(VertexAttributeUsage::Position, DataType::Vec3);
-	decl.push_back(VertexAttributeUsage::Normal, DataType::Vec3);
-	decl.push_back(VertexAttributeUsage::TexCoord0, DataType::Vec2);
-	decl.push_back(VertexAttributeUsage::Tangent, DataType::Vec3);
+		if (format == Format_8bit)
+			return static_cast<uint16_t>(sourceData[index] * 257);
 
-	_vertexData = VertexArray::Pointer::create(decl, _dimension.square());
+		uint16_t value = 0;
+		memcpy(&value, sourceData + 2 * index, sizeof(value));
+		return value;
+	};
 
-	RawDataAcessor<vec3> pos = _vertexData->chunk(VertexAttributeUsage::Position).accessData<vec3>(0);
-	RawDataAcessor<vec3> nrm = _vertexData->chunk(VertexAttributeUsage::Normal).accessData<vec3>(0);
-	RawDataAcessor<vec3> tan = _vertexData->chunk(VertexAttributeUsage::Tangent).accessData<vec3>(0);
-	RawDataAcessor<vec2> texc = _vertexData->chunk(VertexAttributeUsage::TexCoord0).accessData<vec2>(0);
+	Header header;
+	header.width = static_cast<uint32_t>(dimension.x);
+	header.height = static_cast<uint32_t>(dimension.y);
+	header.tileSize = tileSize;
+	header.leafSize = leafSize;
 
-	_positions.resize(hm.size());
-	_positions.setOffset(0);
+	vec2i nodesCount[MaxLevels];
+	header.levelsCount = buildNodesCount(dimension, leafSize, nodesCount);
 
-	bool firstMinVertex = true;
-	bool firstMaxVertex = true;
-	for (uint32_t i = 0; i < hm.size(); ++i)
+	std::ofstream output(tiledFile, std::ios::out | std::ios::binary);
+	if (output.fail())
 	{
-		float dx = x / static_cast<float>(_dimension.x - 1);
-		float dz = z / static_cast<float>(_dimension.y - 1);
+		log::error("Unable to create tiled terrain file %s", tiledFile.c_str());
+		return false;
+	}
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
 
-		pos[i] = vec3(dx, hm[i], dz);
-		texc[i] = vec2(dx, dz);
-		if (_delegate)
+	int32_t ts = static_cast<int32_t>(tileSize);
+	vec2i tilesCount((dimension.x + ts - 1) / ts, (dimension.y + ts - 1) / ts);
+	Vector<uint16_t> tile(tileSize * tileSize);
+	for (int32_t tz = 0; tz < tilesCount.y; ++tz)
+	{
+		for (int32_t tx = 0; tx < tilesCount.x; ++tx)
 		{
-			pos[i] = _delegate->processTerrainVertex(this, pos[i], gridPos);
-			texc[i] = _delegate->processTerrainTexCoord(this, texc[i], gridPos);
+			parallel::forRange(tileSize, parallel::suggestedGrain(tileSize, 16), [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t z = begin; z < end; ++z)
+				{
+					uint16_t* row = tile.data() + z * tileSize;
+					for (int32_t x = 0; x < ts; ++x)
+						row[x] = sampleAt(tx * ts + x, tz * ts + static_cast<int32_t>(z));
+				}
+			});
+			output.write(reinterpret_cast<const char*>(tile.data()), tile.size() * sizeof(uint16_t));
 		}
-		_positions.push_back(pos[i]);
+	}
 
-		_minVertex = firstMinVertex ? pos[i] : minv(pos[i], _minVertex);
-		_maxVertex = firstMaxVertex ? pos[i] : maxv(pos[i], _maxVertex);
+	Vector<HeightRange> levelRanges(nodesCount[0].square());
+	parallel::forRange(static_cast<uint32_t>(levelRanges.size()), parallel::suggestedGrain(static_cast<uint32_t>(levelRanges.size()), 64),
+		[&](uint32_t begin, uint32_t end)
+	{
+		int32_t ls = static_cast<int32_t>(leafSize);
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			int32_t x0 = static_cast<int32_t>(i % nodesCount[0].x) * ls;
+			int32_t z0 = static_cast<int32_t>(i / nodesCount[0].x) * ls;
+			int32_t x1 = std::min(x0 + ls, dimension.x - 1);
+			int32_t z1 = std::min(z0 + ls, dimension.y - 1);
+
+			HeightRange range;
+			range.minValue = std::numeric_limits<uint16_t>::max();
+			for (int32_t z = z0; z <= z1; ++z)
+			{
+				for (int32_t x = x0; x <= x1; ++x)
+				{
+					uint16_t value = sampleAt(x, z);
+					range.minValue = std::min(range.minValue, value);
+					range.maxValue = std::max(range.maxValue, value);
+				}
+			}
+			levelRanges[i] = range;
+		}
+	});
+	output.write(reinterpret_cast<const char*>(levelRanges.data()), levelRanges.size() * sizeof(HeightRange));
 
-		firstMinVertex = false;
-		firstMaxVertex = false;
+	for (uint32_t level = 1; level < header.levelsCount; ++level)
+	{
+		const vec2i& childrenCount = nodesCount[level - 1];
+		const vec2i& count = nodesCount[level];
 
-		x += 1.0f;
-		++gridPos.x;
-		if (gridPos.x >= _dimension.x)
+		Vector<HeightRange> ranges(count.square());
+		for (int32_t z = 0; z < count.y; ++z)
 		{
-			gridPos.x = 0;
-			x = 0.0f;
-			z += 1.0f;
-			++gridPos.y;
+			for (int32_t x = 0; x < count.x; ++x)
+			{
+				HeightRange& range = ranges[x + z * count.x];
+				range.minValue = std::numeric_limits<uint16_t>::max();
+				for (int32_t cz = 2 * z, cze = std::min(2 * z + 2, childrenCount.y); cz < cze; ++cz)
+				{
+					for (int32_t cx = 2 * x, cxe = std::min(2 * x + 2, childrenCount.x); cx < cxe; ++cx)
+					{
+						const HeightRange& child = levelRanges[cx + cz * childrenCount.x];
+						range.minValue = std::min(range.minValue, child.minValue);
+						range.maxValue = std::max(range.maxValue, child.maxValue);
+					}
+				}
+			}
 		}
-
-		nrm[i] = vec3(0.0f);
-		tan[i] = vec3(0.0f);
+		output.write(reinterpret_cast<const char*>(ranges.data()), ranges.size() * sizeof(HeightRange));
+		levelRanges.swap(ranges);
 	}
 
-	_bounds = BoundingBox(0.5f * (_minVertex + _maxVertex), _maxVertex - _minVertex);
-
-	uint32_t numTriangles = primitives::indexCountForRegularMesh(_dimension, PrimitiveType::Triangles);
-	IndexArray::Pointer tempIB = IndexArray::Pointer::create(IndexArrayFormat::Format_32bit, numTriangles, PrimitiveType::Triangles);
-	
-	primitives::buildTrianglesIndexes(tempIB, _dimension, 0, 0);
-	primitives::calculateNormals(_vertexData, tempIB, 0, numTriangles);
-	primitives::calculateTangents(_vertexData, tempIB, 0, numTriangles);
+	return output.good();
+}
 
-	_normals.resize(hm.size());
-	_normals.setOffset(0);
-	
-	for (uint32_t i = 0; i < hm.size(); ++i)
-		_normals.push_back(nrm[i]);
+TerrainData::TerrainData(TerrainDataDelegate* aDelegate) : _delegate(aDelegate)
+{
 }
 
-vec3 TerrainData::normalAtNormalizedPoint(const vec2& normalized) const
+bool TerrainData::open(const std::string& tiledFile)
 {
-	vec2i p00(static_cast<int>(normalized.x), static_cast<int>(normalized.y));
-	vec2i p11(std::min(p00.x + 1, _dimension.x - 1), std::min(p00.y + 1, _dimension.y - 1));
+	close();
 
-	vec2 dp(normalized.x - static_cast<float>(p00.x), normalized.y - static_cast<float>(p00.y));
+	if (!_file.open(tiledFile))
+	{
+		log::error("Unable to open tiled terrain file %s", tiledFile.c_str());
+		return false;
+	}
 
-	vec3 n00 = normalAtXZ(p00);
-	vec3 n11 = normalAtXZ(p00);
+	if (_file.size() >= sizeof(Header))
+		memcpy(&_header, _file.data(), sizeof(Header));
 
-	if (dp.y > dp.x)
+	bool headerValid = (_header.magic == FileMagic) && (_header.version == FileVersion) &&
+		(_header.width >= 2) && (_header.height >= 2) && (_header.tileSize > 0) && (_header.leafSize > 0);
+
+	if (headerValid)
 	{
-		vec3 n10 = normalAtXZ(vec2i(p00.x, p11.y));
-		return normalize( n10 + (1.0f - dp.y) * (n00 - n10) + dp.x * (n11 - n10) );
+		_dimension = vec2i(static_cast<int32_t>(_header.width), static_cast<int32_t>(_header.height));
+		int32_t ts = static_cast<int32_t>(_header.tileSize);
+		_tilesCount = vec2i((_dimension.x + ts - 1) / ts, (_dimension.y + ts - 1) / ts);
+		headerValid = buildNodesCount(_dimension, _header.leafSize, _nodesCount) == _header.levelsCount;
 	}
-	else
+
+	uint64_t rangesCount = 0;
+	if (headerValid)
+	{
+		for (uint32_t level = 0; level < _header.levelsCount; ++level)
+		{
+			_nodeRangesOffset[level] = static_cast<uint32_t>(rangesCount);
+			rangesCount += static_cast<uint64_t>(_nodesCount[level].square());
+		}
+	}
+
+	uint64_t tilesSize = tilesDataSize(_tilesCount, _header.tileSize);
+	if (!headerValid || (_file.size() < sizeof(Header) + tilesSize + rangesCount * sizeof(HeightRange)))
 	{
-		vec3 n01 = normalAtXZ(vec2i(p11.x, p00.y));
-		return normalize( n01 + dp.y * (n11 - n01) + (1.0f - dp.x) * (n00 - n01) );
+		log::error("Invalid tiled terrain file %s", tiledFile.c_str());
+		close();
+		return false;
 	}
+
+	_tiles = reinterpret_cast<const uint16_t*>(_file.data() + sizeof(Header));
+	_nodeRanges = reinterpret_cast<const HeightRange*>(_file.data() + sizeof(Header) + tilesSize);
+	updateBounds();
+	return true;
 }
 
-vec3 TerrainData::normalAtPoint(const vec3& pt) const
+void TerrainData::close()
 {
-	return normalAtNormalizedPoint(normalizePoint(pt));
+	_file.close();
+	_header = Header();
+	_tiles = nullptr;
+	_nodeRanges = nullptr;
+	_dimension = vec2i(0);
+	_tilesCount = vec2i(0);
 }
 
-float TerrainData::heightAtNormalizedPoint(const vec2& normalized) const
+void TerrainData::setScale(const vec3& s)
 {
-	vec2i p00(static_cast<int>(normalized.x), static_cast<int>(normalized.y));
-	vec2i p11(std::min(p00.x + 1, _dimension.x - 1), std::min(p00.y + 1, _dimension.y - 1));
+	_scale = s;
+	updateBounds();
+}
 
-	vec2 dp(normalized.x - static_cast<float>(p00.x), normalized.y - static_cast<float>(p00.y));
+void TerrainData::updateBounds()
+{
+	if (!valid())
+		return;
 
-	float h00 = heightAtXZ(p00);
-	float h11 = heightAtXZ(p00);
+	_cellSize = vec2(_scale.x / static_cast<float>(_dimension.x - 1), _scale.z / static_cast<float>(_dimension.y - 1));
 
-	if (dp.y > dp.x)
-	{
-		float h10 = heightAtXZ(vec2i(p00.x, p11.y));
-		return h10 + (1.0f - dp.y) * (h00 - h10) + dp.x * (h11 - h10);
-	}
-	else
+	uint32_t topLevel = _header.levelsCount - 1;
+	const vec2i& topCount = _nodesCount[topLevel];
+
+	vec3 minVertex(0.0f, std::numeric_limits<float>::max(), 0.0f);
+	vec3 maxVertex(_scale.x, -std::numeric_limits<float>::max(), _scale.z);
+	for (int32_t z = 0; z < topCount.y; ++z)
 	{
-		float h01 = heightAtXZ(vec2i(p11.x, p00.y));
-		return h01 + dp.y * (h11 - h01) + (1.0f - dp.x) * (h00 - h01);
+		for (int32_t x = 0; x < topCount.x; ++x)
+		{
+			BoundingBox node = nodeBounds(topLevel, vec2i(x, z));
+			minVertex.y = std::min(minVertex.y, node.minVertex().y);
+			maxVertex.y = std::max(maxVertex.y, node.maxVertex().y);
+		}
 	}
+	_bounds = BoundingBox(0.5f * (minVertex + maxVertex), 0.5f * (maxVertex - minVertex));
 }
 
-float TerrainData::heightAtPoint(const vec3& pt) const
+const TerrainData::HeightRange& TerrainData::nodeHeightRange(uint32_t level, const vec2i& node) const
 {
-	return heightAtNormalizedPoint(normalizePoint(pt));
+	ET_ASSERT(level < _header.levelsCount);
+	return _nodeRanges[_nodeRangesOffset[level] + node.x + node.y * _nodesCount[level].x];
 }
 
-const vec3& TerrainData::normalAtIndex(int index) const
+BoundingBox TerrainData::nodeBounds(uint32_t level, const vec2i& node) const
 {
-	return _normals[index];
-}
+	const HeightRange& range = nodeHeightRange(level, node);
+	int32_t size = static_cast<int32_t>(nodeSize(level));
 
-const vec3& TerrainData::normalAtXZ(const vec2i& xy) const
-{
-	return _normals[xy.x + _dimension.x * xy.y];
+	float heightScale = _scale.y / 65535.0f;
+	vec3 minVertex(static_cast<float>(node.x * size) * _cellSize.x, static_cast<float>(range.minValue) * heightScale,
+		static_cast<float>(node.y * size) * _cellSize.y);
+	vec3 maxVertex(static_cast<float>(std::min((node.x + 1) * size, _dimension.x - 1)) * _cellSize.x,
+		static_cast<float>(range.maxValue) * heightScale,
+		static_cast<float>(std::min((node.y + 1) * size, _dimension.y - 1)) * _cellSize.y);
+
+	return BoundingBox(0.5f * (minVertex + maxVertex), 0.5f * (maxVertex - minVertex));
 }
 
-float TerrainData::heightAtIndex(int index) const
+uint16_t TerrainData::sampleAtXZ(const vec2i& xz) const
 {
-	return _positions[index].y;
+	ET_ASSERT(valid());
+
+	uint32_t x = static_cast<uint32_t>(clamp(xz.x, 0, _dimension.x - 1));
+	uint32_t z = static_cast<uint32_t>(clamp(xz.y, 0, _dimension.y - 1));
+	uint32_t ts = _header.tileSize;
+
+	uint64_t tileIndex = (x / ts) + static_cast<uint64_t>(z / ts) * static_cast<uint64_t>(_tilesCount.x);
+	return _tiles[tileIndex * ts * ts + (z % ts) * ts + (x % ts)];
 }
 
-float TerrainData::heightAtXZ(const vec2i& xy) const
+float TerrainData::heightAtXZ(const vec2i& xz) const
 {
-	return _positions[xy.x + _dimension.x * xy.y].y;
+	return static_cast<float>(sampleAtXZ(xz)) * (_scale.y / 65535.0f);
 }
 
-const vec3& TerrainData::positionAtIndex(int index) const
+vec3 TerrainData::positionAtXZ(const vec2i& xz) const
 {
-	return _positions[index];
+	vec2i clamped(clamp(xz.x, 0, _dimension.x - 1), clamp(xz.y, 0, _dimension.y - 1));
+	return vec3(static_cast<float>(clamped.x) * _cellSize.x, heightAtXZ(clamped), static_cast<float>(clamped.y) * _cellSize.y);
 }
 
-const vec3& TerrainData::positionAtXZ(const vec2i& xy) const
+vec3 TerrainData::normalAtXZ(const vec2i& xz) const
 {
-	return _positions[xy.x + _dimension.x * xy.y];
+	float hl = heightAtXZ(vec2i(xz.x - 1, xz.y));
+	float hr = heightAtXZ(vec2i(xz.x + 1, xz.y));
+	float hd = heightAtXZ(vec2i(xz.x, xz.y - 1));
+	float hu = heightAtXZ(vec2i(xz.x, xz.y + 1));
+	return normalize(vec3((hl - hr) * _cellSize.y, 2.0f * _cellSize.x * _cellSize.y, (hd - hu) * _cellSize.x));
 }
 
 vec2 TerrainData::normalizePoint(const vec3& pt) const
 {
-	float nx = _dimensionf.x * clamp((pt.x - _minVertex.x) / _bounds.halfDimension.x, 0.0f, 1.0f);
-	float nz = _dimensionf.y * clamp((pt.z - _minVertex.z) / _bounds.halfDimension.z, 0.0f, 1.0f);
+	float nx = clamp(pt.x / _cellSize.x, 0.0f, static_cast<float>(_dimension.x - 1));
+	float nz = clamp(pt.z / _cellSize.y, 0.0f, static_cast<float>(_dimension.y - 1));
 	return vec2(nx, nz);
 }
 
-triangle TerrainData::triangleForXZ(const vec2i& pt0, int side) const
+float TerrainData::heightAtPoint(const vec3& pt) const
 {
-	vec3 v1 = positionAtXZ(pt0);
-	vec3 v2;
-	vec3 v3;
-
-	vec2i pt1;
-	vec2i pt2 = pt0 + vec2i(1);
-	if (pt2.x >= _dimension.x) 
-		pt2.x = _dimension.x - 1;
-	if (pt2.y >= _dimension.y) 
-		pt2.y = _dimension.y - 1;
-
-	if (side == 0)
+	vec2 normalized = normalizePoint(pt);
+	vec2i p00(std::min(static_cast<int32_t>(normalized.x), _dimension.x - 2), std::min(static_cast<int32_t>(normalized.y), _dimension.y - 2));
+	vec2 dp(normalized.x - static_cast<float>(p00.x), normalized.y - static_cast<float>(p00.y));
+
+	/*
+	 * cells are split by diagonal from (1, 0) to (0, 1), same as rendered grid
+	 */
+	float h01 = heightAtXZ(vec2i(p00.x, p00.y + 1));
+	float h10 = heightAtXZ(vec2i(p00.x + 1, p00.y));
+	if (dp.x + dp.y <= 1.0f)
 	{
-		pt1 = vec2i(pt0.x, pt0.y + 1);
-		if (pt1.y >= _dimension.y) 
-			pt1.y = _dimension.y - 1;
-		v2 = positionAtXZ(pt1);
-		v3 = positionAtXZ(pt2);
+		float h00 = heightAtXZ(p00);
+		return h00 + dp.x * (h10 - h00) + dp.y * (h01 - h00);
 	}
-	else 
+	else
 	{
-		pt1 = vec2i(pt0.x + 1, pt0.y);
-		if (pt1.x >= _dimension.x) 
-			pt1.x = _dimension.x - 1;
-		v2 = positionAtXZ(pt2);
-		v3 = positionAtXZ(pt1);
+		float h11 = heightAtXZ(p00 + vec2i(1));
+		return h11 + (1.0f - dp.x) * (h01 - h11) + (1.0f - dp.y) * (h10 - h11);
 	}
+}
 
-	return triangle(v1, v2, v3);
+vec3 TerrainData::normalAtPoint(const vec3& pt) const
+{
+	vec2 normalized = normalizePoint(pt);
+	vec2i p00(std::min(static_cast<int32_t>(normalized.x), _dimension.x - 2), std::min(static_cast<int32_t>(normalized.y), _dimension.y - 2));
+	vec2 dp(normalized.x - static_cast<float>(p00.x), normalized.y - static_cast<float>(p00.y));
+
+	vec3 n0 = mix(normalAtXZ(p00), normalAtXZ(vec2i(p00.x + 1, p00.y)), dp.x);
+	vec3 n1 = mix(normalAtXZ(vec2i(p00.x, p00.y + 1)), normalAtXZ(p00 + vec2i(1)), dp.x);
+	return normalize(mix(n0, n1, dp.y));
 }
 
 TerrainContact TerrainData::contactForSphere(const Sphere& s) const
 {
-	vec3 radiusVector(s.radius(), 0.0f, s.radius());
-	vec2 leftTopProj = normalizePoint(s.center() - radiusVector);
-	vec2 rightBottomProj = normalizePoint(s.center() + radiusVector);
+	TerrainContact result;
+	contactsForSpheres(&s, 1, &result);
+	return result;
+}
+
+void TerrainData::gatherContactsForSphere(const Sphere& s, TerrainDataDelegate* contactDelegate) const
+{
+	if (contactDelegate == nullptr)
+		contactDelegate = _delegate;
 
-	vec2i leftTopIndex(static_cast<int>(leftTopProj.x), static_cast<int>(leftTopProj.y));
-	vec2i rightBottomIndex(static_cast<int>(rightBottomProj.x), static_cast<int>(rightBottomProj.y));
+	if (contactDelegate == nullptr)
+		return;
 
-	TerrainContact t;
+	Vector<TerrainContact> contacts;
+	gatherContactsForSphere(s, contacts);
 
-	float squareRadius = sqr(s.radius());
-	int numPoints = 0;
+	for (const TerrainContact& contact : contacts)
+		contactDelegate->terrainDataDidFindContact(contact);
+}
 
-	for (int y = leftTopIndex.y; y <= rightBottomIndex.y; ++y)
+uint32_t TerrainData::gatherContactsForSphere(const Sphere& s, Vector<TerrainContact>& contacts) const
+{
+	size_t initialSize = contacts.size();
+	gatherSegmentContacts(s.center(), s.center(), s.radius(), contacts);
+	return static_cast<uint32_t>(contacts.size() - initialSize);
+}
+
+uint32_t TerrainData::gatherContactsForCapsule(const TerrainCapsule& c, Vector<TerrainContact>& contacts) const
+{
+	size_t initialSize = contacts.size();
+	gatherSegmentContacts(c.axis.start, c.axis.end, c.radius, contacts);
+	return static_cast<uint32_t>(contacts.size() - initialSize);
+}
+
+void TerrainData::gatherContactsForSpheres(const Sphere* spheres, uint32_t count, Vector<TerrainContact>& contacts, Vector<uint32_t>& offsets) const
+{
+	Vector<Vector<TerrainContact>> perQuery(count);
+	parallel::forRange(count, parallel::suggestedGrain(count, 16), [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+			gatherSegmentContacts(spheres[i].center(), spheres[i].center(), spheres[i].radius(), perQuery[i]);
+	});
+
+	offsets.resize(count + 1);
+	offsets[0] = 0;
+	for (uint32_t i = 0; i < count; ++i)
+		offsets[i + 1] = offsets[i] + static_cast<uint32_t>(perQuery[i].size());
+
+	contacts.resize(offsets[count]);
+	for (uint32_t i = 0; i < count; ++i)
+		std::copy(perQuery[i].begin(), perQuery[i].end(), contacts.begin() + offsets[i]);
+}
+
+void TerrainData::gatherContactsForCapsules(const TerrainCapsule* capsules, uint32_t count, Vector<TerrainContact>& contacts, Vector<uint32_t>& offsets) const
+{
+	Vector<Vector<TerrainContact>> perQuery(count);
+	parallel::forRange(count, parallel::suggestedGrain(count, 16), [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+			gatherSegmentContacts(capsules[i].axis.start, capsules[i].axis.end, capsules[i].radius, perQuery[i]);
+	});
+
+	offsets.resize(count + 1);
+	offsets[0] = 0;
+	for (uint32_t i = 0; i < count; ++i)
+		offsets[i + 1] = offsets[i] + static_cast<uint32_t>(perQuery[i].size());
+
+	contacts.resize(offsets[count]);
+	for (uint32_t i = 0; i < count; ++i)
+		std::copy(perQuery[i].begin(), perQuery[i].end(), contacts.begin() + offsets[i]);
+}
+
+void TerrainData::contactsForSpheres(const Sphere* spheres, uint32_t count, TerrainContact* results) const
+{
+	parallel::forRange(count, parallel::suggestedGrain(count, 16), [&](uint32_t begin, uint32_t end)
+	{
+		Vector<TerrainContact> contacts;
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			contacts.clear();
+			gatherSegmentContacts(spheres[i].center(), spheres[i].center(), spheres[i].radius(), contacts);
+
+			TerrainContact& t = results[i];
+			t = TerrainContact();
+			for (const TerrainContact& contact : contacts)
+			{
+				t.point += contact.point;
+				t.normal += contact.normal;
+			}
+
+			t.contacted = !contacts.empty();
+			if (t.contacted)
+			{
+				t.point /= static_cast<float>(contacts.size());
+				t.normal = normalize(t.normal);
+			}
+		}
+	});
+}
+
+void TerrainData::gatherSegmentContacts(const vec3& a, const vec3& b, float radius, Vector<TerrainContact>& contacts) const
+{
+	vec3 queryMin = minv(a, b) - vec3(radius);
+	vec3 queryMax = maxv(a, b) + vec3(radius);
+
+	vec2i cellMin(static_cast<int32_t>(std::floor(queryMin.x / _cellSize.x)), static_cast<int32_t>(std::floor(queryMin.z / _cellSize.y)));
+	vec2i cellMax(static_cast<int32_t>(std::floor(queryMax.x / _cellSize.x)), static_cast<int32_t>(std::floor(queryMax.z / _cellSize.y)));
+	cellMin = vec2i(std::max(cellMin.x, 0), std::max(cellMin.y, 0));
+	cellMax = vec2i(std::min(cellMax.x, _dimension.x - 2), std::min(cellMax.y, _dimension.y - 2));
+	if ((cellMin.x > cellMax.x) || (cellMin.y > cellMax.y))
+		return;
+
+	/*
+	 * terrain node can't touch the query when it is entirely below or above it
+	 */
+	float heightScale = _scale.y / 65535.0f;
+	auto nodeOverlaps = [&](uint32_t level, const vec2i& node, vec2i& nodeCellMin, vec2i& nodeCellMax) -> bool
+	{
+		int32_t size = static_cast<int32_t>(nodeSize(level));
+		nodeCellMin = vec2i(std::max(node.x * size, cellMin.x), std::max(node.y * size, cellMin.y));
+		nodeCellMax = vec2i(std::min((node.x + 1) * size - 1, cellMax.x), std::min((node.y + 1) * size - 1, cellMax.y));
+		if ((nodeCellMin.x > nodeCellMax.x) || (nodeCellMin.y > nodeCellMax.y))
+			return false;
+
+		const HeightRange& range = nodeHeightRange(level, node);
+		return (static_cast<float>(range.maxValue) * heightScale >= queryMin.y) &&
+			(static_cast<float>(range.minValue) * heightScale <= queryMax.y);
+	};
+
+	struct NodeEntry
+	{
+		vec2i node;
+		uint32_t level;
+	};
+	StaticDataStorage<NodeEntry, 4 * MaxLevels> stack;
+	uint32_t stackSize = 0;
+
+	uint32_t topLevel = _header.levelsCount - 1;
+	int32_t topSize = static_cast<int32_t>(nodeSize(topLevel));
+	vec2i nodeCellMin;
+	vec2i nodeCellMax;
+	for (int32_t z = cellMin.y / topSize, ze = cellMax.y / topSize; z <= ze; ++z)
+	{
+		for (int32_t x = cellMin.x / topSize, xe = cellMax.x / topSize; x <= xe; ++x)
+		{
+			stack[stackSize++] = { vec2i(x, z), topLevel };
+
+			while (stackSize > 0)
+			{
+				NodeEntry entry = stack[--stackSize];
+				if (!nodeOverlaps(entry.level, entry.node, nodeCellMin, nodeCellMax))
+					continue;
+
+				if (entry.level == 0)
+				{
+					gatherSegmentContactsInCells(a, b, radius, nodeCellMin, nodeCellMax, contacts);
+					continue;
+				}
+
+				const vec2i& childrenCount = _nodesCount[entry.level - 1];
+				for (int32_t q = 0; q < 4; ++q)
+				{
+					vec2i child(2 * entry.node.x + (q & 1), 2 * entry.node.y + (q >> 1));
+					if ((child.x < childrenCount.x) && (child.y < childrenCount.y))
+						stack[stackSize++] = { child, entry.level - 1 };
+				}
+			}
+		}
+	}
+}
+
+void TerrainData::gatherSegmentContactsInCells(const vec3& a, const vec3& b, float radius, const vec2i& cellMin, const vec2i& cellMax,
+	Vector<TerrainContact>& contacts) const
+{
+	const vec4simd one(1.0f);
+	const vec4simd cellX(_cellSize.x);
+	const vec4simd cellZ(_cellSize.y);
+	const vec4simd invCellX(1.0f / _cellSize.x);
+	const vec4simd invCellZ(1.0f / _cellSize.y);
+
+	StaticDataStorage<float, 5> row0;
+	StaticDataStorage<float, 5> row1;
+	ET_ALIGNED(16) float da[2][4];
+	ET_ALIGNED(16) float db[2][4];
+	ET_ALIGNED(16) float slopeX[2][4];
+	ET_ALIGNED(16) float slopeZ[2][4];
+	ET_ALIGNED(16) float invLength[2][4];
+
+	for (int32_t z = cellMin.y; z <= cellMax.y; ++z)
 	{
-		for (int x = leftTopIndex.x; x <= rightBottomIndex.x; ++x)
+		float z0 = static_cast<float>(z) * _cellSize.y;
+		vec4simd cellOriginZ(z0);
+		vec4simd offsetAZ = vec4simd(a.z) - cellOriginZ;
+		vec4simd offsetBZ = vec4simd(b.z) - cellOriginZ;
+
+		for (int32_t x = cellMin.x; x <= cellMax.x; x += 4)
 		{
-			triangle t1 = triangleForXZ(vec2i(x, y), 0);
-			triangle t2 = triangleForXZ(vec2i(x, y), 1);
-			vec3 projCtoP1 = plane(t1).projectionOfPoint(s.center());
-			vec3 projCtoP2 = plane(t2).projectionOfPoint(s.center());
-			float d1 = (projCtoP1 - s.center()).dotSelf();
-			float d2 = (projCtoP1 - s.center()).dotSelf();
-
-			if ((d1 <= squareRadius) && (pointInsideTriangle(projCtoP1, t1)))
+			for (int32_t i = 0; i < 5; ++i)
 			{
-				++numPoints;
-				t.normal += t1.normalizedNormal();
-				t.point += projCtoP1;
+				row0[i] = heightAtXZ(vec2i(x + i, z));
+				row1[i] = heightAtXZ(vec2i(x + i, z + 1));
 			}
 
-			if ((d2 <= squareRadius) && (pointInsideTriangle(projCtoP2, t2)))
+			vec4simd h00(row0[0], row0[1], row0[2], row0[3]);
+			vec4simd h10(row0[1], row0[2], row0[3], row0[4]);
+			vec4simd h01(row1[0], row1[1], row1[2], row1[3]);
+			vec4simd h11(row1[1], row1[2], row1[3], row1[4]);
+
+			float x0 = static_cast<float>(x) * _cellSize.x;
+			vec4simd cellOriginX(x0, x0 + _cellSize.x, x0 + 2.0f * _cellSize.x, x0 + 3.0f * _cellSize.x);
+			vec4simd offsetAX = vec4simd(a.x) - cellOriginX;
+			vec4simd offsetBX = vec4simd(b.x) - cellOriginX;
+
+			/*
+			 * planes of both triangles of the cell, as height = base + sx * dx + sz * dz
+			 */
+			vec4simd sx[2] = { (h10 - h00) * invCellX, (h11 - h01) * invCellX };
+			vec4simd sz[2] = { (h01 - h00) * invCellZ, (h11 - h10) * invCellZ };
+			vec4simd base[2] = { h00, h11 - sx[1] * cellX - sz[1] * cellZ };
+
+			for (uint32_t t = 0; t < 2; ++t)
 			{
-				++numPoints;
-				t.normal += t2.normalizedNormal();
-				t.point += projCtoP2;
+				vec4simd il = one / (one + sx[t] * sx[t] + sz[t] * sz[t]).sqrt();
+				vec4simd distanceA = (vec4simd(a.y) - (base[t] + sx[t] * offsetAX + sz[t] * offsetAZ)) * il;
+				vec4simd distanceB = (vec4simd(b.y) - (base[t] + sx[t] * offsetBX + sz[t] * offsetBZ)) * il;
+				distanceA.loadToFloats(da[t]);
+				distanceB.loadToFloats(db[t]);
+				sx[t].loadToFloats(slopeX[t]);
+				sz[t].loadToFloats(slopeZ[t]);
+				il.loadToFloats(invLength[t]);
 			}
 
+			for (int32_t lane = 0, lanes = std::min(4, cellMax.x - x + 1); lane < lanes; ++lane)
+			{
+				float laneX0 = x0 + static_cast<float>(lane) * _cellSize.x;
+				for (uint32_t t = 0; t < 2; ++t)
+				{
+					/*
+					 * closest point of the segment to the plane is one of the ends,
+					 * or the point where segment crosses the plane
+					 */
+					vec3 q = a;
+					float d = da[t][lane];
+					if (da[t][lane] * db[t][lane] < 0.0f)
+					{
+						q = a + (b - a) * (da[t][lane] / (da[t][lane] - db[t][lane]));
+						d = 0.0f;
+					}
+					else if (std::abs(db[t][lane]) < std::abs(da[t][lane]))
+					{
+						q = b;
+						d = db[t][lane];
+					}
+
+					if (std::abs(d) > radius)
+						continue;
+
+					vec3 n = vec3(-slopeX[t][lane], 1.0f, -slopeZ[t][lane]) * invLength[t][lane];
+					vec3 projection = q - n * d;
+					float u = (projection.x - laneX0) / _cellSize.x;
+					float v = (projection.z - z0) / _cellSize.y;
+
+					bool inside = (t == 0) ?
+						((u >= 0.0f) && (v >= 0.0f) && (u + v <= 1.0f)) :
+						((u <= 1.0f) && (v <= 1.0f) && (u + v >= 1.0f));
+
+					if (inside)
+						contacts.emplace_back(projection, n, true);
+				}
+			}
 		}
 	}
+}
 
-	t.contacted = numPoints > 0;
-	if (t.contacted)
+namespace
+{
+	bool intersectRayBox(const ray3d& r, const vec3& invDirection, const BoundingBox& box, float& tEnter, float& tExit)
 	{
-		t.point /= static_cast<float>(numPoints);
-		t.normal = normalize(t.normal);
+		vec3 t0 = (box.minVertex() - r.origin) * invDirection;
+		vec3 t1 = (box.maxVertex() - r.origin) * invDirection;
+		vec3 tMin = minv(t0, t1);
+		vec3 tMax = maxv(t0, t1);
+		tEnter = std::max(tEnter, std::max(tMin.x, std::max(tMin.y, tMin.z)));
+		tExit = std::min(tExit, std::min(tMax.x, std::min(tMax.y, tMax.z)));
+		return tEnter <= tExit;
 	}
 
-	return t;
+	vec3 safeInverse(const vec3& v)
+	{
+		const float maxValue = std::numeric_limits<float>::max();
+		return vec3((v.x == 0.0f) ? maxValue : 1.0f / v.x, (v.y == 0.0f) ? maxValue : 1.0f / v.y, (v.z == 0.0f) ? maxValue : 1.0f / v.z);
+	}
 }
 
-void TerrainData::gatherContactsForSphere(const Sphere& s, TerrainDataDelegate* contactDelegate) const
+TerrainRayHit TerrainData::raycast(const ray3d& r, float maxDistance) const
 {
-	vec3 radiusVector(s.radius(), 0.0f, s.radius());
-	vec2 leftTopProj = normalizePoint(s.center() - radiusVector);
-	vec2 rightBottomProj = normalizePoint(s.center() + radiusVector);
-	vec2i leftTopIndex(static_cast<int>(leftTopProj.x), static_cast<int>(leftTopProj.y));
-	vec2i rightBottomIndex(static_cast<int>(rightBottomProj.x), static_cast<int>(rightBottomProj.y));
+	TerrainRayHit hit;
+	hit.distance = maxDistance;
+
+	vec3 invDirection = safeInverse(r.direction);
+
+	struct NodeEntry
+	{
+		vec2i node;
+		uint32_t level;
+		float tEnter;
+	};
+	StaticDataStorage<NodeEntry, 4 * MaxLevels> stack;
+	uint32_t stackSize = 0;
+
+	uint32_t topLevel = _header.levelsCount - 1;
+	const vec2i& topCount = _nodesCount[topLevel];
+	for (int32_t z = 0; z < topCount.y; ++z)
+	{
+		for (int32_t x = 0; x < topCount.x; ++x)
+		{
+			float tEnter = 0.0f;
+			float tExit = hit.distance;
+			if (intersectRayBox(r, invDirection, nodeBounds(topLevel, vec2i(x, z)), tEnter, tExit))
+				stack[stackSize++] = { vec2i(x, z), topLevel, tEnter };
+
+			while (stackSize > 0)
+			{
+				NodeEntry entry = stack[--stackSize];
+				if (entry.tEnter > hit.distance)
+					continue;
+
+				if (entry.level == 0)
+				{
+					float tEnter = 0.0f;
+					float tExit = hit.distance;
+					if (intersectRayBox(r, invDirection, nodeBounds(0, entry.node), tEnter, tExit))
+						raycastLeaf(r, entry.node, tEnter, tExit, hit);
+					continue;
+				}
+
+				/*
+				 * children are pushed farthest first, so the nearest one is processed next
+				 */
+				NodeEntry children[4];
+				uint32_t childrenCount = 0;
+				const vec2i& levelCount = _nodesCount[entry.level - 1];
+				for (int32_t q = 0; q < 4; ++q)
+				{
+					vec2i child(2 * entry.node.x + (q & 1), 2 * entry.node.y + (q >> 1));
+					if ((child.x >= levelCount.x) || (child.y >= levelCount.y))
+						continue;
+
+					float tEnter = 0.0f;
+					float tExit = hit.distance;
+					if (intersectRayBox(r, invDirection, nodeBounds(entry.level - 1, child), tEnter, tExit))
+						children[childrenCount++] = { child, entry.level - 1, tEnter };
+				}
+
+				std::sort(children, children + childrenCount, [](const NodeEntry& l, const NodeEntry& r)
+					{ return l.tEnter > r.tEnter; });
+
+				for (uint32_t i = 0; i < childrenCount; ++i)
+					stack[stackSize++] = children[i];
+			}
+		}
+	}
+
+	if (!hit.hit)
+		hit.distance = 0.0f;
 
-	float squareRadius = sqr(s.radius());
+	return hit;
+}
 
-	for (int y = leftTopIndex.y; y <= rightBottomIndex.y; ++y)
+void TerrainData::raycastLeaf(const ray3d& r, const vec2i& node, float tEnter, float tExit, TerrainRayHit& hit) const
+{
+	int32_t size = static_cast<int32_t>(_header.leafSize);
+	vec2i leafMin = node * size;
+	vec2i leafMax(std::min((node.x + 1) * size, _dimension.x - 1) - 1, std::min((node.y + 1) * size, _dimension.y - 1) - 1);
+
+	vec3 start = r.origin + r.direction * tEnter;
+	vec2i cell(clamp(static_cast<int32_t>(std::floor(start.x / _cellSize.x)), leafMin.x, leafMax.x),
+		clamp(static_cast<int32_t>(std::floor(start.z / _cellSize.y)), leafMin.y, leafMax.y));
+
+	/*
+	 * 2D DDA over the cells of the leaf
+	 */
+	vec2i step(r.direction.x >= 0.0f ? 1 : -1, r.direction.z >= 0.0f ? 1 : -1);
+	const float maxValue = std::numeric_limits<float>::max();
+	vec2 tDelta((r.direction.x == 0.0f) ? maxValue : _cellSize.x / std::abs(r.direction.x),
+		(r.direction.z == 0.0f) ? maxValue : _cellSize.y / std::abs(r.direction.z));
+
+	auto boundaryT = [&](int32_t index, int32_t s, float origin, float direction, float cellSize) -> float
+	{
+		if (direction == 0.0f)
+			return maxValue;
+		float boundary = static_cast<float>(index + (s > 0 ? 1 : 0)) * cellSize;
+		return (boundary - origin) / direction;
+	};
+	vec2 tMax(boundaryT(cell.x, step.x, r.origin.x, r.direction.x, _cellSize.x),
+		boundaryT(cell.y, step.y, r.origin.z, r.direction.z, _cellSize.y));
+
+	for (;;)
 	{
-		for (int x = leftTopIndex.x; x <= rightBottomIndex.x; ++x)
+		float x0 = static_cast<float>(cell.x) * _cellSize.x;
+		float z0 = static_cast<float>(cell.y) * _cellSize.y;
+		float h00 = heightAtXZ(cell);
+		float h10 = heightAtXZ(vec2i(cell.x + 1, cell.y));
+		float h01 = heightAtXZ(vec2i(cell.x, cell.y + 1));
+		float h11 = heightAtXZ(vec2i(cell.x + 1, cell.y + 1));
+
+		float sx[2] = { (h10 - h00) / _cellSize.x, (h11 - h01) / _cellSize.x };
+		float sz[2] = { (h01 - h00) / _cellSize.y, (h11 - h10) / _cellSize.y };
+		float base[2] = { h00, h11 - sx[1] * _cellSize.x - sz[1] * _cellSize.y };
+
+		for (uint32_t t = 0; t < 2; ++t)
+		{
+			float f0 = r.origin.y - (base[t] + sx[t] * (r.origin.x - x0) + sz[t] * (r.origin.z - z0));
+			float f1 = r.direction.y - (sx[t] * r.direction.x + sz[t] * r.direction.z);
+			if (f1 == 0.0f)
+				continue;
+
+			float distance = -f0 / f1;
+			if ((distance < 0.0f) || (distance > hit.distance))
+				continue;
+
+			vec3 point = r.origin + r.direction * distance;
+			float u = (point.x - x0) / _cellSize.x;
+			float v = (point.z - z0) / _cellSize.y;
+			bool inside = (t == 0) ?
+				((u >= 0.0f) && (v >= 0.0f) && (u + v <= 1.0f)) :
+				((u <= 1.0f) && (v <= 1.0f) && (u + v >= 1.0f));
+
+			if (inside)
+			{
+				hit.hit = true;
+				hit.distance = distance;
+				hit.point = point;
+				hit.normal = normalize(vec3(-sx[t], 1.0f, -sz[t]));
+			}
+		}
+
+		if (hit.hit && (hit.distance <= std::min(tMax.x, tMax.y)))
+			break;
+
+		if (tMax.x < tMax.y)
+		{
+			if (tMax.x > tExit)
+				break;
+			cell.x += step.x;
+			tMax.x += tDelta.x;
+		}
+		else
 		{
-			triangle t1 = triangleForXZ(vec2i(x, y), 0);
-			vec3 projCtoP1 = plane(t1).projectionOfPoint(s.center());
-			float d1 = (projCtoP1 - s.center()).dotSelf();
-			if ((d1 <= squareRadius) && (pointInsideTriangle(projCtoP1, t1)))
-				contactDelegate->terrainDataDidFindContact(TerrainContact(projCtoP1, normalize(t1.normalizedNormal()), true));
-
-			triangle t2 = triangleForXZ(vec2i(x, y), 1);
-			vec3 projCtoP2 = plane(t2).projectionOfPoint(s.center());
-			float d2 = (projCtoP1 - s.center()).dotSelf();
-			if ((d2 <= squareRadius) && (pointInsideTriangle(projCtoP2, t2)))
-				contactDelegate->terrainDataDidFindContact(TerrainContact(projCtoP2, normalize(t2.normalizedNormal()), true));
+			if (tMax.y > tExit)
+				break;
+			cell.y += step.y;
+			tMax.y += tDelta.y;
 		}
+
+		if ((cell.x < leafMin.x) || (cell.x > leafMax.x) || (cell.y < leafMin.y) || (cell.y > leafMax.y))
+			break;
 	}
 }
+
+void TerrainData::raycast(const ray3d* rays, uint32_t count, float maxDistance, TerrainRayHit* results) const
+{
+	parallel::forRange(count, parallel::suggestedGrain(count, 16), [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+			results[i] = raycast(rays[i], maxDistance);
+	});
+}
+
+bool TerrainData::lineOfSight(const vec3& from, const vec3& to) const
+{
+	vec3 direction = to - from;
+	float distance = direction.length();
+	if (distance == 0.0f)
+		return true;
+
+	return !raycast(ray3d(from, direction / distance), distance).hit;
+}
@@ -8,8 +8,8 @@
 #pragma once
 
 #include <et/core/containers.h>
+#include <et/core/mappedfile.h>
 #include <et/geometry/collision.h>
-#include <et/rendering/vertexarray.h>
 
 namespace et
 {
@@ -25,45 +25,138 @@ namespace et
 		TerrainContact(const vec3& pt, const vec3& n, bool c) : point(pt), normal(n), contacted(c) { }
 	};
 
-	class TerrainDataDelegate
+	struct TerrainCapsule
 	{
-	public:
-		virtual vec3 processTerrainVertex(TerrainData const*, const vec3& input, const vec2i&/* gridPosition */) 
-			{ return input; }
+		segment3d axis;
+		float radius;
 
-		virtual vec2 processTerrainTexCoord(TerrainData const*, const vec2& input, const vec2i&/* gridPosition */) 
-			{ return input; }
+		TerrainCapsule() : axis(vec3(0.0f), vec3(0.0f)), radius(0.0f) { }
+		TerrainCapsule(const segment3d& a, float r) : axis(a), radius(r) { }
+	};
 
+	struct TerrainRayHit
+	{
+		vec3 point;
+		vec3 normal;
+		float distance;
+		bool hit;
+
+		TerrainRayHit() : distance(0.0f), hit(false) { }
+	};
+
+	class TerrainDataDelegate
+	{
+	public:
 		virtual void terrainDataDidFindContact(const TerrainContact&)
 			{ }
 	};
 
+	/*
+	 * Heightmap stored in tiled file, which is memory mapped and never loaded as a whole:
+	 * only pages of the tiles being sampled become resident.
+	 *
+	 * File layout:
+	 *   Header
+	 *   tiles - tilesCount.x * tilesCount.y tiles of tileSize * tileSize 16-bit samples, row by row
+	 *   node bounds - min/max pairs of 16-bit samples for each quadtree node, level 0 (leaves) first
+	 *
+	 * Quadtree node at level L covers (leafSize << L) cells of the heightmap.
+	 */
 	class TerrainData : public Shared
 	{
 	public:
+		ET_DECLARE_POINTER(TerrainData);
+
 		enum Format
 		{
 			Format_8bit,
 			Format_16bit
 		};
 
+		enum : uint32_t
+		{
+			FileMagic = ET_COMPOSE_UINT32('E', 'T', 'H', 'M'),
+			FileVersion = 1,
+			MaxLevels = 16
+		};
+
+		struct Header
+		{
+			uint32_t magic = FileMagic;
+			uint32_t version = FileVersion;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t tileSize = 0;
+			uint32_t leafSize = 0;
+			uint32_t levelsCount = 0;
+			uint32_t reserved = 0;
+		};
+
+		struct HeightRange
+		{
+			uint16_t minValue = 0;
+			uint16_t maxValue = 0;
+		};
+
+	public:
+		/*
+		 * Converts RAW heightmap (row by row 8 or 16 bit samples) into tiled file,
+		 * source is memory mapped and processed tile by tile
+		 */
+		static bool convertRAWFile(const std::string& rawFile, const vec2i& dimension, Format format,
+			const std::string& tiledFile, uint32_t tileSize = 256, uint32_t leafSize = 32);
+
 	public:
 		TerrainData(TerrainDataDelegate* aDelegate);
-		TerrainData(TerrainDataDelegate* aDelegate, std::istream& stream, const vec2i& dimension, Format format);
 
-		void loadFromStream(std::istream& stream, const vec2i& dimension, Format format);
+		bool open(const std::string& tiledFile);
+		void close();
+
+		bool valid() const
+			{ return _file.valid(); }
+
+		/*
+		 * World space size of the terrain: x and z - extents, y - height of the maximal sample
+		 */
+		void setScale(const vec3& scale);
 
-		inline const vec2i& dimension() const 
+		const vec3& scale() const
+			{ return _scale; }
+
+		const vec2i& dimension() const
 			{ return _dimension; }
 
 		const BoundingBox& bounds() const
 			{ return _bounds; }
 
-		const VertexArray::Pointer& vertexData() const
-			{ return _vertexData; }
+		uint32_t tileSize() const
+			{ return _header.tileSize; }
+
+		uint32_t leafSize() const
+			{ return _header.leafSize; }
+
+		uint32_t levelsCount() const
+			{ return _header.levelsCount; }
+
+		/*
+		 * Quadtree nodes
+		 */
+		vec2i nodesCount(uint32_t level) const
+			{ return _nodesCount[level]; }
+
+		uint32_t nodeSize(uint32_t level) const
+			{ return _header.leafSize << level; }
 
-		VertexArray::Pointer& vertexData()
-			{ return _vertexData; }
+		const HeightRange& nodeHeightRange(uint32_t level, const vec2i& node) const;
+		BoundingBox nodeBounds(uint32_t level, const vec2i& node) const;
+
+		/*
+		 * Samples, coordinates are clamped to the heightmap
+		 */
+		uint16_t sampleAtXZ(const vec2i& xz) const;
+		float heightAtXZ(const vec2i& xz) const;
+		vec3 positionAtXZ(const vec2i& xz) const;
+		vec3 normalAtXZ(const vec2i& xz) const;
 
 		vec3 normalAtPoint(const vec3& pt) const;
 		float heightAtPoint(const vec3& pt) const;
@@ -71,39 +164,56 @@ namespace et
 		TerrainContact contactForSphere(const Sphere& s) const;
 		void gatherContactsForSphere(const Sphere& s, TerrainDataDelegate* contactDelegate) const;
 
+		/*
+		 * Queries skip quadtree nodes by their min/max heights,
+		 * remaining cells are tested four at a time, contacts are appended to the output
+		 */
+		uint32_t gatherContactsForSphere(const Sphere& s, Vector<TerrainContact>& contacts) const;
+		uint32_t gatherContactsForCapsule(const TerrainCapsule& c, Vector<TerrainContact>& contacts) const;
+
+		/*
+		 * Batched queries, executed on worker threads.
+		 * Contacts of the query i are stored in range [offsets[i], offsets[i + 1])
+		 */
+		void gatherContactsForSpheres(const Sphere* spheres, uint32_t count, Vector<TerrainContact>& contacts, Vector<uint32_t>& offsets) const;
+		void gatherContactsForCapsules(const TerrainCapsule* capsules, uint32_t count, Vector<TerrainContact>& contacts, Vector<uint32_t>& offsets) const;
+
+		/*
+		 * Same as contactForSphere for each sphere
+		 */
+		void contactsForSpheres(const Sphere* spheres, uint32_t count, TerrainContact* results) const;
+
+		/*
+		 * Marches ray through the quadtree (nearest nodes first) and cells of the leaves
+		 */
+		TerrainRayHit raycast(const ray3d& r, float maxDistance) const;
+		void raycast(const ray3d* rays, uint32_t count, float maxDistance, TerrainRayHit* results) const;
+		bool lineOfSight(const vec3& from, const vec3& to) const;
+
 	private:
-		void generateVertexData(const FloatDataStorage& hm);
+		void updateBounds();
 
-		triangle triangleForXZ(const vec2i& pt, int side) const;
+		void gatherSegmentContacts(const vec3& a, const vec3& b, float radius, Vector<TerrainContact>& contacts) const;
+		void gatherSegmentContactsInCells(const vec3& a, const vec3& b, float radius, const vec2i& cellMin, const vec2i& cellMax,
+			Vector<TerrainContact>& contacts) const;
+		void raycastLeaf(const ray3d& r, const vec2i& node, float tEnter, float tExit, TerrainRayHit& hit) const;
 
 		vec2 normalizePoint(const vec3& pt) const;
 
-		vec3 normalAtNormalizedPoint(const vec2& pt) const;
-		const vec3& normalAtIndex(int index) const;
-		const vec3& normalAtXZ(const vec2i& xy) const;
-
-		float heightAtNormalizedPoint(const vec2& pt) const;
-		float heightAtIndex(int index) const;
-		float heightAtXZ(const vec2i& xy) const;
-
-		const vec3& positionAtIndex(int index) const;
-		const vec3& positionAtXZ(const vec2i& xy) const;
-
 	private:
 		TerrainDataDelegate* _delegate;
+		MappedFile _file;
+		Header _header;
 
-		vec2i _dimension;
-		vec2 _dimensionf;
+		const uint16_t* _tiles = nullptr;
+		const HeightRange* _nodeRanges = nullptr;
+		vec2i _nodesCount[MaxLevels];
+		uint32_t _nodeRangesOffset[MaxLevels] { };
 
-		vec3 _minVertex;
-		vec3 _maxVertex;
+		vec2i _dimension;
+		vec2i _tilesCount;
+		vec3 _scale = vec3(1.0f);
+		vec2 _cellSize = vec2(1.0f);
 		BoundingBox _bounds;
-
-		DataStorage<vec3> _positions;
-		DataStorage<vec3> _normals;
-
-		VertexArray::Pointer _vertexData;
 	};
-
-	typedef IntrusivePtr<TerrainData> TerrainDataRef;
 }
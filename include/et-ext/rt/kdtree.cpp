@@ -7,6 +7,7 @@
 
 #include <et-ext/rt/kdtree.h>
 #include <et/core/tools.h>
+#include <et/core/profiler.h>
 
 namespace et
 {
@@ -66,6 +67,9 @@ rt::KDTree::Node KDTree::buildRootNode()
 
 void KDTree::build(const TriangleList& triangles, size_t maxDepth)
 {
+	ET_PROFILE_SCOPE("KDTree::build");
+	MemoryTagScope memoryTag(MemoryTag::KDTree);
+
 	cleanUp();
 	
 	_maxBuildDepth = 0;
@@ -13,6 +13,7 @@
 #include <et-ext/rt/sampler.h>
 #include <et/app/application.h>
 #include <et/camera/camera.h>
+#include <et/core/profiler.h>
 
 #include <et/pbr/pbr.h>
 
@@ -254,21 +255,16 @@ void RaytracePrivate::buildScene(const s3d::Scene::Pointer& input)
 	Vector<Scene::SceneEntry> geometry;
 	geometry.reserve(256);
 
-	s3d::BaseElement::List objects = input->childrenOfType(s3d::ElementType::DontCare);
-	for (s3d::BaseElement::Pointer obj : objects)
+	s3d::Scene::Pointer source = input;
+	for (s3d::BaseElement* obj : source->elementsOfType(s3d::ElementType::Mesh))
 	{
-		if (obj->type() == s3d::ElementType::Mesh)
-		{
-			s3d::Mesh::Pointer mesh = obj;
-			for (const RenderBatch::Pointer& rb : mesh->renderBatches())
-				geometry.emplace_back(rb, mesh->transform());
-		}
-		else if (obj->type() == s3d::ElementType::Light)
-		{
-			s3d::LightElement::Pointer light = obj;
-			geometry.emplace_back(light->light());
-		}
+		s3d::Mesh* mesh = static_cast<s3d::Mesh*>(obj);
+		for (const RenderBatch::Pointer& rb : mesh->renderBatches())
+			geometry.emplace_back(rb, mesh->transform());
 	}
+
+	for (s3d::BaseElement* obj : source->elementsOfType(s3d::ElementType::Light))
+		geometry.emplace_back(static_cast<s3d::LightElement*>(obj)->light());
 	scene.build(geometry, input->renderCamera());
 }
 
@@ -537,6 +533,8 @@ void RaytracePrivate::forwardPathTraceThreadFunction(uint32_t threadId)
 	float4 cameraDir(-camera.direction(), 0.0f);
 	vec3 viewport = vector3ToFloat(vec3i(viewportSize, 0));
 
+	ET_PROFILE_THREAD_NAME("et::raytrace");
+
 	auto projectToCamera = [&](const Ray& inRay, const KDTree::TraverseResult& hit,
 		const float4& color, const float4& nrm)
 	{
@@ -581,6 +579,7 @@ void RaytracePrivate::forwardPathTraceThreadFunction(uint32_t threadId)
 
 	while (running)
 	{
+		ET_PROFILE_SCOPE("Raytrace::forwardIteration");
 		for (uint32_t ir = 0; running && (ir < raysPerIteration); ++ir)
 		{
 			uint32_t emitterIndex = rand() % lightTriangles.size();
@@ -645,6 +644,8 @@ void RaytracePrivate::forwardPathTraceThreadFunction(uint32_t threadId)
 
 void RaytracePrivate::backwardPathTraceThreadFunction(uint32_t threadId)
 {
+	ET_PROFILE_THREAD_NAME("et::raytrace");
+
 	DataStorage<vec4> localData(sqr(scene.options.renderRegionSize), 0);
 
 	while (running)
@@ -653,6 +654,7 @@ void RaytracePrivate::backwardPathTraceThreadFunction(uint32_t threadId)
 		if (region.sampled == false)
 			break;
 
+		ET_PROFILE_SCOPE("Raytrace::region");
 		uint64_t runTime = queryContinuousTimeInMilliSeconds();
 
 		vec2i pixel;
@@ -712,6 +714,7 @@ void RaytracePrivate::backwardPathTraceThreadFunction(uint32_t threadId)
 		maxTimePerRegion = std::max(maxTimePerRegion.load(), regionTime);
 		totalTimePerRegions += regionTime;
 		++processedRegions;
+		ET_PROFILE_COUNTER("Raytrace processed regions", processedRegions.load());
 	}
 
 	--threadCounter;
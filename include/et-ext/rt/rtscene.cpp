@@ -6,6 +6,7 @@
  */
 
 #include <et-ext/rt/rtscene.h>
+#include <et/core/profiler.h>
 
 namespace et
 {
@@ -19,6 +20,8 @@ inline float4 gammaCorrectedInput(const vec4& c)
 
 void Scene::build(const Vector<SceneEntry>& geometry, const Camera::Pointer& camera)
 {
+	ET_PROFILE_SCOPE("rt::Scene::build");
+
 	materials.clear();
 	emitters.clear();
 
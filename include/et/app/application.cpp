@@ -70,6 +70,12 @@ void Application::exitRunLoop() {
 }
 
 bool Application::shouldPerformRendering() {
+	if (_parameters.fixedTimeStepMSec > 0)
+	{
+		_lastQueuedTimeMSec += _parameters.fixedTimeStepMSec;
+		return !_suspended;
+	}
+
 	uint64_t currentTime = queryContinuousTimeInMilliSeconds();
 	uint64_t elapsedTime = currentTime - _lastQueuedTimeMSec;
 
@@ -89,10 +95,13 @@ bool Application::shouldPerformRendering() {
 
 void Application::performUpdateAndRender() {
 	ET_ASSERT(_running && !_suspended);
+	ET_PROFILE_FRAME(_profiler.framesCount);
 
 	uint64_t startTime = queryCurrentTimeInMicroSeconds();
 	if (_renderContext.beginRender())
 	{
+		ET_PROFILE_SCOPE("Application::performUpdateAndRender");
+
 		if (_scheduleResize)
 		{
 			_renderContext.performResizing(_scheduledSize);
@@ -101,10 +110,59 @@ void Application::performUpdateAndRender() {
 		}
 
 		_runLoop.update(_lastQueuedTimeMSec);
-		_delegate->update();
-		_renderContext.endRender();
+		{
+			ET_PROFILE_SCOPE("IApplicationDelegate::update");
+			_delegate->update();
+		}
+		{
+			ET_PROFILE_SCOPE("RenderContext::endRender");
+			_renderContext.endRender();
+		}
 	}
 	_profiler.frameTime = queryCurrentTimeInMicroSeconds() - startTime;
+	++_profiler.framesCount;
+	ET_PROFILE_COUNTER("CPU frame time, us", _profiler.frameTime);
+
+	if ((_parameters.framesToRun > 0) || !_parameters.frameTimesFile.empty())
+		_frameTimes.emplace_back(_profiler.frameTime);
+
+	if ((_parameters.framesToRun > 0) && (_profiler.framesCount >= _parameters.framesToRun))
+	{
+		reportFrameTimes();
+		quit(0);
+	}
+}
+
+void Application::reportFrameTimes() {
+	if (_frameTimes.empty())
+		return;
+
+	if (!_parameters.frameTimesFile.empty())
+	{
+		std::ofstream fOut(_parameters.frameTimesFile, std::ios::out);
+		fOut << "frame,cpu_time_us" << std::endl;
+		for (size_t i = 0, e = _frameTimes.size(); i < e; ++i)
+			fOut << i << "," << _frameTimes[i] << std::endl;
+	}
+
+	Vector<uint64_t> sorted(_frameTimes);
+	std::sort(sorted.begin(), sorted.end());
+
+	uint64_t totalTime = 0;
+	for (uint64_t t : sorted)
+		totalTime += t;
+
+	auto percentile = [&sorted](size_t p) {
+		return static_cast<unsigned long long>(sorted[std::min(sorted.size() - 1, sorted.size() * p / 100)]);
+	};
+
+	log::info("[et-engine] %llu frames, CPU time (us): total %llu, average %llu, min %llu, "
+		"median %llu, 95%% %llu, 99%% %llu, max %llu", static_cast<unsigned long long>(sorted.size()),
+		static_cast<unsigned long long>(totalTime), static_cast<unsigned long long>(totalTime / sorted.size()),
+		static_cast<unsigned long long>(sorted.front()), percentile(50), percentile(95), percentile(99),
+		static_cast<unsigned long long>(sorted.back()));
+
+	_frameTimes.clear();
 }
 
 void Application::setFrameRateLimit(size_t value) {
@@ -27,6 +27,7 @@ extern const std::string kSystemEventOpenURL;
 struct ProfilerInfo
 {
 	uint64_t frameTime = 0;
+	uint64_t framesCount = 0;
 };
 
 class Application : public Singleton<Application>
@@ -107,6 +108,8 @@ private:
 	void enterRunLoop();
 	void exitRunLoop();
 
+	void reportFrameTimes();
+
 private:
 	Application();
 	~Application();
@@ -136,6 +139,7 @@ private:
 
 	std::string _emptyParamter;
 	StringList _launchParameters;
+	Vector<uint64_t> _frameTimes;
 
 	std::atomic<bool> _running{ false };
 	std::atomic<bool> _active{ false };
@@ -50,6 +50,26 @@ void BackgroundThread::BackgroundRunLoop::addTask(Task* t, float delay) {
 		owner->resume();
 }
 
+void BackgroundThread::BackgroundRunLoop::post(RunLoopMessage* m, float delay) {
+	if (delay > 0.0f)
+		updateTime(queryContinuousTimeInMilliSeconds());
+
+	RunLoop::post(m, delay);
+
+	if (owner->suspended())
+		owner->resume();
+}
+
+void BackgroundThread::BackgroundRunLoop::enqueue(const Function& f, float delay) {
+	if (delay > 0.0f)
+		updateTime(queryContinuousTimeInMilliSeconds());
+
+	RunLoop::enqueue(f, delay);
+
+	if (owner->suspended())
+		owner->resume();
+}
+
 BackgroundThread::BackgroundThread()
 	: Thread("et-background-thread") {
 	_runLoop.owner = this;
@@ -43,6 +43,8 @@ private:
 	struct BackgroundRunLoop : public RunLoop
 	{
 		void addTask(Task* t, float);
+		void post(RunLoopMessage*, float);
+		void enqueue(const Function&, float);
 		BackgroundThread* owner = nullptr;
 	} _runLoop;
 };
@@ -43,8 +43,23 @@ struct ApplicationParameters
 	RenderingAPI renderingAPI = RenderingAPI::Vulkan;
 #elif (ET_PLATFORM_MAC)
 	RenderingAPI renderingAPI = RenderingAPI::Metal;
+#elif (ET_PLATFORM_LINUX)
+	RenderingAPI renderingAPI = RenderingAPI::Null;
 #endif
 	bool shouldSuspendOnDeactivate = false;
+
+	/*
+	 * Benchmark runs: application quits after framesToRun frames (0 - runs until quit),
+	 * time advances by fixedTimeStepMSec each frame without waiting (0 - real time),
+	 * CPU time of every frame is written to frameTimesFile (if set) and summarized in log,
+	 * profiler events are captured for the whole run and exported to traceFile (if set),
+	 * per-tag memory statistics are written to memorySnapshotFile (if set) before shutdown
+	 */
+	uint32_t framesToRun = 0;
+	uint32_t fixedTimeStepMSec = 0;
+	std::string frameTimesFile;
+	std::string traceFile;
+	std::string memorySnapshotFile;
 };
 
 struct PlatformDependentContext
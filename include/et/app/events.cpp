@@ -14,14 +14,14 @@ using namespace et;
  */
 EventReceiver::~EventReceiver() 
 {
-	for (Event* i : _events)
-		i->receiverDisconnected(this);
+	for (auto& i : _events)
+		i.first->receiverDisconnected(this);
 }
 
-void EventReceiver::eventConnected(Event* e)
+void EventReceiver::eventConnected(Event* e, const EventConnection& c)
 {
 	ET_ASSERT(_events.count(e) == 0);
-	_events.insert(e);
+	_events.emplace(e, c);
 }
 
 void EventReceiver::eventDisconnected(Event* e)
@@ -29,78 +29,28 @@ void EventReceiver::eventDisconnected(Event* e)
 	_events.erase(e);
 }
 
+EventConnection EventReceiver::connection(Event* e) const
+{
+	auto i = _events.find(e);
+	return (i == _events.end()) ? EventConnection() : i->second;
+}
+
 /**
  *
  * Event0
  *
  */
-Event0::~Event0()
-{
-	for (auto& connection : _connections)
-	{
-		if ((connection->receiver() != nullptr) && !connection->removed())
-			connection->receiver()->eventDisconnected(this);
-		etDestroyObject(connection);
-	}
-}
-
-void Event0::cleanup()
-{
-    auto i = remove_if(_connections.begin(), _connections.end(), [](EventConnectionBase* b) { return (b == nullptr) || b->removed(); });
-    _connections.erase(i, _connections.end());
-}
-
-void Event0::invoke()
-{
-	cleanup();
-
-	_invoking = true;
-	for (auto& conn : _connections)
-		conn->invoke();
-	_invoking = false;
-}
-
 void Event0::invokeInMainRunLoop(float delay)
 {
-	cleanup();
-	
-	_invoking = true;
-	for (auto& i : _connections)
-		i->invokeInMainRunLoop(delay);
-	_invoking = false;
+	invokeInRunLoop(mainRunLoop(), delay);
 }
 
-void Event0::invokeInBackground(float delay)
+void Event0::invokeInCurrentRunLoop(float delay)
 {
-	cleanup();
-	
-	_invoking = true;
-	for (auto& i : _connections)
-		i->invokeInBackground(delay);
-	_invoking = false;
+	invokeInRunLoop(currentRunLoop(), delay);
 }
 
-void Event0::receiverDisconnected(EventReceiver* r)
+void Event0::invokeInBackground(float delay)
 {
-	auto i = _connections.begin();
-	while (i != _connections.end())
-	{
-		if (r == (*i)->receiver())
-		{
-			if (_invoking)
-			{
-				(*i)->remove();
-				++i;
-			}
-			else
-			{
-				etDestroyObject(*i);
-				i = _connections.erase(i);
-			}
-		}
-		else 
-		{
-			++i;
-		}
-	}
+	invokeInRunLoop(backgroundRunLoop(), delay);
 }
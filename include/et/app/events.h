@@ -1,485 +1,253 @@
-/*
- * This file is part of `et engine`
- * Copyright 2009-2016 by Sergey Reznik
- * Please, modify content only if you know what are you doing.
- *
- */
-
-#pragma once
-
-#include <type_traits>
-#include <et/app/invocation.h>
-
-namespace et
-{
-
-#define ET_DECLARE_EVENT0(name)									et::Event0 name
-#define ET_DECLARE_EVENT1(name, argtype)						et::Event1<argtype> name
-#define ET_DECLARE_EVENT2(name, arg1type, arg2type)				et::Event2<arg1type, arg2type> name
-
-#define ET_CONNECT_EVENT(name, methodName)						name.connect(this, &methodName)
-
-class Event;
-
-class EventReceiver
-{
-public:
-	EventReceiver() = default;
-	~EventReceiver();
-	
-	void eventConnected(Event* e);
-	void eventDisconnected(Event* e);
-
-private:
-	Set<Event*> _events;
-};
-
-class Event
-{
-public:
-	virtual ~Event() {}
-	virtual void receiverDisconnected(EventReceiver* receiver) = 0;
-
-protected:
-	std::atomic<bool> _invoking{ false };
-};
-
-class EventConnectionBase
-{
-public:
-	virtual ~EventConnectionBase() {}
-
-	bool removed() const
-	{
-		return _removed;
-	}
-
-	void remove()
-	{
-		_removed = true;
-	}
-
-	void setRemoved(bool value)
-	{
-		_removed = value;
-	}
-
-	virtual EventReceiver* receiver()
-	{
-		return nullptr;
-	}
-
-	virtual bool hasConnections()
-	{
-		return false;
-	}
-
-protected:
-	std::atomic<bool> _removed{ false };
-};
-
-/*
-* Event 0
-*/
-
-class Event0ConnectionBase : public EventConnectionBase
-{
-public:
-	virtual void invoke() = 0;
-	virtual void invokeInMainRunLoop(float delay) = 0;
-	virtual void invokeInBackground(float delay) = 0;
-};
-
-template <typename RecevierType>
-class Event0Connection : public Event0ConnectionBase
-{
-public:
-	Event0Connection(RecevierType* receiver, void(RecevierType::*func)());
-
-	EventReceiver* receiver()
-	{
-		return _receiver;
-	}
-
-	void invoke()
-	{
-		(_receiver->*_receiverMethod)();
-	}
-
-	void invokeInMainRunLoop(float delay = 0.0f)
-	{
-		Invocation i;
-		i.setTarget(_receiver, _receiverMethod);
-		i.invokeInMainRunLoop(delay);
-	}
-
-	void invokeInCurrentRunLoop(float delay = 0.0f)
-	{
-		Invocation i;
-		i.setTarget(_receiver, _receiverMethod);
-		i.invokeInCurrentRunLoop(delay);
-	}
-
-	void invokeInBackground(float delay = 0.0f)
-	{
-		Invocation i;
-		i.setTarget(_receiver, _receiverMethod);
-		i.invokeInBackground(delay);
-	}
-
-private:
-	void (RecevierType::*_receiverMethod)() = nullptr;
-	RecevierType* _receiver = nullptr;
-};
-
-template <typename C>
-class Event0DirectConnection : public Event0ConnectionBase
-{
-public:
-	Event0DirectConnection(C func) :
-		_func(func)
-	{
-	}
-
-	EventReceiver* receiver()
-	{
-		return nullptr;
-	}
-
-	void invoke()
-	{
-		_func();
-	}
-
-	void invokeInMainRunLoop(float delay = 0.0f)
-	{
-		Invocation i;
-		i.setTarget(_func);
-		i.invokeInMainRunLoop(delay);
-	}
-
-	void invokeInCurrentRunLoop(float delay = 0.0f)
-	{
-		Invocation i;
-		i.setTarget(_func);
-		i.invokeInCurrentRunLoop(delay);
-	}
-
-	void invokeInBackground(float delay = 0.0f)
-	{
-		Invocation i;
-		i.setTarget(_func);
-		i.invokeInBackground(delay);
-	}
-
-private:
-	C _func;
-};
-
-class Event0 : public Event, public Event0ConnectionBase
-{
-public:
-	~Event0();
-
-	template <typename R>
-	void connect(R* receiver, void (R::*receiverMethod)());
-
-	template <typename F>
-	void connect(F func);
-
-	template <typename R>
-	void disconnect(R* receiver);
-
-	void receiverDisconnected(EventReceiver* r);
-	void invoke();
-	void invokeInMainRunLoop(float delay = 0.0f);
-	void invokeInBackground(float delay = 0.0f);
-
-	bool hasConnections()
-	{
-		return !_connections.empty();
-	}
-
-private:
-	EventReceiver* receiver()
-	{
-		return nullptr;
-	}
-
-	void cleanup();
-
-private:
-	using ConnectionList = Vector<Event0ConnectionBase*>;
-	ConnectionList _connections;
-};
-
-/*
- * Event 1
- */
-template <typename ArgType>
-class Event1ConnectionBase : public EventConnectionBase
-{
-public:
-	virtual void invoke(ArgType arg) = 0;
-	virtual void invokeInMainRunLoop(ArgType arg, float delay) = 0;
-};
-
-template <typename ReceiverType, typename ArgType, typename ReturnType = void>
-class Event1Connection : public Event1ConnectionBase<ArgType>
-{
-public:
-	Event1Connection(ReceiverType* receiver, ReturnType(ReceiverType::*func)(ArgType));
-
-	EventReceiver* receiver()
-	{
-		return _receiver;
-	}
-
-	void invoke(ArgType arg)
-	{
-		(_receiver->*_receiverMethod)(arg);
-	}
-
-	void invokeInMainRunLoop(ArgType arg, float delay)
-	{
-		Invocation1 i;
-		i.setTarget<ReceiverType, ArgType, ReturnType>(_receiver, _receiverMethod, arg);
-		i.invokeInMainRunLoop(delay);
-	}
-
-	void invokeInCurrentRunLoop(ArgType arg, float delay)
-	{
-		Invocation1 i;
-		i.setTarget<ReceiverType, ArgType, ReturnType>(_receiver, _receiverMethod, arg);
-		i.invokeInCurrentRunLoop(delay);
-	}
-
-	void invokeInBackground(ArgType arg, float delay)
-	{
-		Invocation1 i;
-		i.setTarget<ReceiverType, ArgType, ReturnType>(_receiver, _receiverMethod, arg);
-		i.invokeInBackground(delay);
-	}
-
-private:
-	ReturnType(ReceiverType::*_receiverMethod)(ArgType) = nullptr;
-	ReceiverType* _receiver = nullptr;
-};
-
-template <typename F, typename ArgType>
-class Event1DirectConnection : public Event1ConnectionBase<ArgType>
-{
-public:
-	Event1DirectConnection(F f) :
-		_func(f)
-	{
-	};
-
-	EventReceiver* receiver()
-	{
-		return nullptr;
-	}
-
-	void invoke(ArgType arg)
-	{
-		_func(arg);
-	}
-
-	void invokeInMainRunLoop(ArgType arg, float delay)
-	{
-		Invocation1 i;
-		i.setTarget<F, ArgType>(_func, arg);
-		i.invokeInMainRunLoop(delay);
-	}
-
-	void invokeInCurrentRunLoop(ArgType arg, float delay)
-	{
-		Invocation1 i;
-		i.setTarget<F, ArgType>(_func, arg);
-		i.invokeInCurrentRunLoop(delay);
-	}
-
-	void invokeInBackground(ArgType arg, float delay)
-	{
-		Invocation1 i;
-		i.setTarget<F, ArgType>(_func, arg);
-		i.invokeInBackground(delay);
-	}
-
-private:
-	F _func;
-};
-
-template <typename ArgType>
-class Event1 : public Event, public Event1ConnectionBase<ArgType>
-{
-public:
-	~Event1();
-
-	template <typename ReceiverType, typename ReturnType = void>
-	void connect(ReceiverType* receiver, ReturnType(ReceiverType::*receiverMethod)(ArgType));
-
-	template <typename F>
-	void connect(F);
-
-	template <typename ReceiverType>
-	void disconnect(ReceiverType* receiver);
-
-	void receiverDisconnected(EventReceiver* r);
-	void invoke(ArgType arg);
-	void invokeInMainRunLoop(ArgType arg, float delay = 0.0f);
-	void invokeInCurrentRunLoop(ArgType arg, float delay = 0.0f);
-
-	bool hasConnections()
-	{
-		return !_connections.empty();
-	}
-
-private:
-	void cleanup();
-
-	EventReceiver* receiver()
-	{
-		return nullptr;
-	}
-
-private:
-	using ConnectionList = Vector<Event1ConnectionBase<ArgType>*>;
-	ConnectionList _connections;
-};
-
-/*
- * Event 2
- */
-template <typename Arg1Type, typename Arg2Type>
-class Event2ConnectionBase : public EventConnectionBase
-{
-public:
-	virtual void invoke(Arg1Type a1, Arg2Type a2) = 0;
-	virtual void invokeInMainRunLoop(Arg1Type a1, Arg2Type a2, float delay) = 0;
-};
-
-template <typename ReceiverType, typename Arg1Type, typename Arg2Type>
-class Event2Connection : public Event2ConnectionBase<Arg1Type, Arg2Type>
-{
-public:
-	Event2Connection(ReceiverType* receiver, void(ReceiverType::*func)(Arg1Type, Arg2Type));
-
-	EventReceiver* receiver()
-	{
-		return _receiver;
-	}
-
-	void invoke(Arg1Type a1, Arg2Type a2)
-	{
-		(_receiver->*_receiverMethod)(a1, a2);
-	}
-
-	void invokeInMainRunLoop(Arg1Type a1, Arg2Type a2, float delay)
-	{
-		Invocation2 i;
-		i.setTarget<ReceiverType, Arg1Type, Arg2Type>(_receiver, _receiverMethod, a1, a2);
-		i.invokeInMainRunLoop(delay);
-	}
-
-	void invokeInCurrentRunLoop(Arg1Type a1, Arg2Type a2, float delay)
-	{
-		Invocation2 i;
-		i.setTarget<ReceiverType, Arg1Type, Arg2Type>(_receiver, _receiverMethod, a1, a2);
-		i.invokeInCurrentRunLoop(delay);
-	}
-
-	void invokeInBackground(Arg1Type a1, Arg2Type a2, float delay)
-	{
-		Invocation2 i;
-		i.setTarget<ReceiverType, Arg1Type, Arg2Type>(_receiver, _receiverMethod, a1, a2);
-		i.invokeInBackground(delay);
-	}
-
-private:
-	void (ReceiverType::*_receiverMethod)(Arg1Type, Arg2Type);
-	ReceiverType* _receiver = nullptr;
-};
-
-template <typename F, typename ArgType1, typename ArgType2>
-class Event2DirectConnection : public Event2ConnectionBase<ArgType1, ArgType2>
-{
-public:
-	Event2DirectConnection(F f) :
-		_func(f)
-	{
-	};
-
-	EventReceiver* receiver()
-	{
-		return nullptr;
-	}
-
-	void invoke(ArgType1 arg1, ArgType2 arg2)
-	{
-		_func(arg1, arg2);
-	}
-
-	void invokeInMainRunLoop(ArgType1 arg1, ArgType2 arg2, float delay)
-	{
-		Invocation2 i;
-		i.setTarget<F, ArgType1, ArgType2>(_func, arg1, arg2);
-		i.invokeInMainRunLoop(delay);
-	}
-
-	void invokeInCurrentRunLoop(ArgType1 arg1, ArgType2 arg2, float delay)
-	{
-		Invocation2 i;
-		i.setTarget<F, ArgType1, ArgType2>(_func, arg1, arg2);
-		i.invokeInCurrentRunLoop(delay);
-	}
-
-	void invokeInBackground(ArgType1 arg1, ArgType2 arg2, float delay)
-	{
-		Invocation2 i;
-		i.setTarget<F, ArgType1, ArgType2>(_func, arg1, arg2);
-		i.invokeInBackground(delay);
-	}
-
-private:
-	F _func;
-};
-
-template <typename Arg1Type, typename Arg2Type>
-class Event2 : public Event, public Event2ConnectionBase<Arg1Type, Arg2Type>
-{
-public:
-	~Event2();
-
-	template <typename ReceiverType>
-	void connect(ReceiverType* receiver, void (ReceiverType::*receiverMethod)(Arg1Type, Arg2Type));
-
-	template <typename F>
-	void connect(F);
-
-	template <typename ReceiverType>
-	void disconnect(ReceiverType* receiver);
-
-	void receiverDisconnected(EventReceiver* r);
-	void invoke(Arg1Type a1, Arg2Type a2);
-	void invokeInMainRunLoop(Arg1Type a1, Arg2Type a2, float delay = 0.0f);
-	void invokeInCurrentRunLoop(Arg1Type a1, Arg2Type a2, float delay = 0.0f);
-
-	bool hasConnections()
-	{
-		return !_connections.empty();
-	}
-
-private:
-	EventReceiver* receiver()
-	{
-		return nullptr;
-	}
-
-private:
-	using ConnectionList = Vector<Event2ConnectionBase<Arg1Type, Arg2Type>*>;
-	ConnectionList _connections;
-};
-
-#	include <et/app/events.inl.h>
-}
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <type_traits>
+#include <tuple>
+#include <et/core/inlinedelegate.h>
+#include <et/app/invocation.h>
+
+namespace et
+{
+
+#define ET_DECLARE_EVENT0(name)									et::Event0 name
+#define ET_DECLARE_EVENT1(name, argtype)						et::Event1<argtype> name
+#define ET_DECLARE_EVENT2(name, arg1type, arg2type)				et::Event2<arg1type, arg2type> name
+
+#define ET_CONNECT_EVENT(name, methodName)						name.connect(this, &methodName)
+
+class Event;
+
+RunLoop& mainRunLoop();
+RunLoop& currentRunLoop();
+RunLoop& backgroundRunLoop();
+
+/*
+ * Handle of the connection, returned from connect and used for O(1) disconnect.
+ * Handle becomes stale after disconnect, slot could be reused by another connection.
+ */
+struct EventConnection
+{
+	enum : uint32_t
+	{
+		InvalidIndex = static_cast<uint32_t>(-1)
+	};
+
+	uint32_t index = InvalidIndex;
+	uint32_t generation = 0;
+
+	EventConnection() = default;
+
+	EventConnection(uint32_t i, uint32_t g) :
+		index(i), generation(g) { }
+
+	bool valid() const
+	{
+		return index != InvalidIndex;
+	}
+};
+
+class EventReceiver
+{
+public:
+	EventReceiver() = default;
+	~EventReceiver();
+
+	void eventConnected(Event* e, const EventConnection& c);
+	void eventDisconnected(Event* e);
+
+	EventConnection connection(Event* e) const;
+
+private:
+	Map<Event*, EventConnection> _events;
+};
+
+class Event
+{
+public:
+	virtual ~Event() {}
+	virtual void receiverDisconnected(EventReceiver* receiver) = 0;
+};
+
+/*
+ * Connections are stored contiguously, together with inline delegates.
+ * Slots released while event is being invoked are reused only after invocation is finished,
+ * connections added while invoking are not called until the next invoke.
+ */
+template <typename... Args>
+class EventBase : public Event
+{
+public:
+	using DelegateType = InlineDelegate<Args...>;
+
+public:
+	EventBase() = default;
+	~EventBase();
+
+	void disconnect(const EventConnection&);
+
+	void receiverDisconnected(EventReceiver* r) override;
+
+	bool hasConnections() const
+	{
+		return _connectionsCount > 0;
+	}
+
+	uint32_t connectionsCount() const
+	{
+		return _connectionsCount;
+	}
+
+	/*
+	 * Posts single message with copy of arguments and connected delegates
+	 */
+	void invokeInRunLoop(RunLoop& rl, float delay, Args... args);
+
+protected:
+	EventConnection addConnection(DelegateType&& delegate, EventReceiver* receiver);
+	void invokeDirectly(Args... args);
+
+private:
+	ET_DENY_COPY(EventBase);
+
+	struct Slot
+	{
+		DelegateType delegate;
+		EventReceiver* receiver = nullptr;
+		uint32_t generation = 0;
+		bool active = false;
+	};
+
+	Slot* slotForConnection(const EventConnection&);
+	void releaseSlot(uint32_t index);
+	void finishInvoke();
+
+private:
+	Vector<Slot> _slots;
+	Vector<Slot> _pendingSlots;
+	Vector<uint32_t> _freeSlots;
+	Vector<uint32_t> _releasedSlots;
+	uint32_t _connectionsCount = 0;
+	uint32_t _invokeDepth = 0;
+};
+
+template <size_t...>
+struct EventArgumentIndices { };
+
+template <size_t N, size_t... I>
+struct MakeEventArgumentIndices : MakeEventArgumentIndices<N - 1, N - 1, I...> { };
+
+template <size_t... I>
+struct MakeEventArgumentIndices<0, I...>
+{
+	using Type = EventArgumentIndices<I...>;
+};
+
+/*
+ * Delivers single invocation to all receivers, connected at the moment of posting
+ */
+template <typename... Args>
+class EventDispatch : public RunLoopMessage
+{
+public:
+	EventDispatch(Args... args) :
+		_arguments(args...) { }
+
+	void deliver() override
+	{
+		deliver(typename MakeEventArgumentIndices<sizeof...(Args)>::Type());
+	}
+
+public:
+	Vector<InlineDelegate<Args...>> delegates;
+
+private:
+	template <size_t... I>
+	void deliver(EventArgumentIndices<I...>)
+	{
+		for (const InlineDelegate<Args...>& d : delegates)
+			d(std::get<I>(_arguments)...);
+	}
+
+private:
+	std::tuple<typename std::decay<Args>::type...> _arguments;
+};
+
+/*
+ * Event 0
+ */
+class Event0 : public EventBase<>
+{
+public:
+	using EventBase<>::disconnect;
+
+	template <typename R>
+	EventConnection connect(R* receiver, void (R::*receiverMethod)());
+
+	template <typename F>
+	EventConnection connect(F func);
+
+	template <typename R>
+	void disconnect(R* receiver);
+
+	void invoke();
+	void invokeInMainRunLoop(float delay = 0.0f);
+	void invokeInCurrentRunLoop(float delay = 0.0f);
+	void invokeInBackground(float delay = 0.0f);
+};
+
+/*
+ * Event 1
+ */
+template <typename ArgType>
+class Event1 : public EventBase<ArgType>
+{
+public:
+	using EventBase<ArgType>::disconnect;
+
+	template <typename ReceiverType, typename ReturnType = void>
+	EventConnection connect(ReceiverType* receiver, ReturnType(ReceiverType::*receiverMethod)(ArgType));
+
+	template <typename F>
+	EventConnection connect(F);
+
+	template <typename ReceiverType>
+	void disconnect(ReceiverType* receiver);
+
+	void invoke(ArgType arg);
+	void invokeInMainRunLoop(ArgType arg, float delay = 0.0f);
+	void invokeInCurrentRunLoop(ArgType arg, float delay = 0.0f);
+	void invokeInBackground(ArgType arg, float delay = 0.0f);
+};
+
+/*
+ * Event 2
+ */
+template <typename Arg1Type, typename Arg2Type>
+class Event2 : public EventBase<Arg1Type, Arg2Type>
+{
+public:
+	using EventBase<Arg1Type, Arg2Type>::disconnect;
+
+	template <typename ReceiverType>
+	EventConnection connect(ReceiverType* receiver, void (ReceiverType::*receiverMethod)(Arg1Type, Arg2Type));
+
+	template <typename F>
+	EventConnection connect(F);
+
+	template <typename ReceiverType>
+	void disconnect(ReceiverType* receiver);
+
+	void invoke(Arg1Type a1, Arg2Type a2);
+	void invokeInMainRunLoop(Arg1Type a1, Arg2Type a2, float delay = 0.0f);
+	void invokeInCurrentRunLoop(Arg1Type a1, Arg2Type a2, float delay = 0.0f);
+	void invokeInBackground(Arg1Type a1, Arg2Type a2, float delay = 0.0f);
+};
+
+#	include <et/app/events.inl.h>
+}
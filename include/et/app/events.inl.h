@@ -1,304 +1,326 @@
-/*
- * This file is part of `et engine`
- * Copyright 2009-2016 by Sergey Reznik
- * Please, modify content only if you know what are you doing.
- *
- */
-
- /*
-  * Event0Connection
-  */
-
-template <typename T>
-Event0Connection<T>::Event0Connection(T* receiver, void(T::*func)()) :
-	_receiverMethod(func), _receiver(receiver)
-{
-}
-
-/*
- * Event0
- */
-
-template <typename R>
-inline void Event0::connect(R* receiver, void (R::*receiverMethod)())
-{
-	ET_ASSERT(receiver != nullptr);
-
-	for (auto& connection : _connections)
-	{
-		if (connection->receiver() == receiver)
-		{
-			connection->setRemoved(false);
-			return;
-		}
-	}
-
-	_connections.push_back(etCreateObject<Event0Connection<R>>(receiver, receiverMethod));
-	receiver->eventConnected(this);
-}
-
-template <typename F>
-inline void Event0::connect(F func)
-{
-	_connections.push_back(etCreateObject<Event0DirectConnection<F>>(func));
-}
-
-template <typename R>
-void Event0::disconnect(R* receiver)
-{
-	receiverDisconnected(receiver);
-	receiver->eventDisconnected(this);
-}
-
-/*
- * Event1Connection
- */
-
-template <typename ReceiverType, typename ArgType, typename ReturnType>
-Event1Connection<ReceiverType, ArgType, ReturnType>::Event1Connection(ReceiverType* receiver,
-	ReturnType(ReceiverType::*func)(ArgType)) : _receiverMethod(func), _receiver(receiver)
-{
-}
-
-/*
- * Event1
- */
-template <typename ArgType>
-Event1<ArgType>::~Event1()
-{
-	for (auto& connection : _connections)
-	{
-		if ((connection->receiver() != nullptr) && !connection->removed())
-			connection->receiver()->eventDisconnected(this);
-		etDestroyObject(connection);
-	}
-}
-
-template <typename ArgType>
-template <typename ReceiverType, typename ReturnType>
-inline void Event1<ArgType>::connect(ReceiverType* receiver, ReturnType(ReceiverType::*receiverMethod)(ArgType))
-{
-	ET_ASSERT(receiver != nullptr);
-
-	static_assert(std::is_base_of<EventReceiver, ReceiverType>::value,
-		"Receiver object should be derived from et::EventReceiver");
-
-	for (auto& connection : _connections)
-	{
-		if (connection->receiver() == receiver)
-		{
-			connection->setRemoved(false);
-			return;
-		}
-	}
-
-	using ConnectionClass = Event1Connection<ReceiverType, ArgType, ReturnType>;
-	_connections.push_back(etCreateObject<ConnectionClass>(receiver, receiverMethod));
-	receiver->eventConnected(this);
-}
-
-template <typename ArgType>
-template <typename F>
-inline void Event1<ArgType>::connect(F func)
-{
-	_connections.push_back(etCreateObject<Event1DirectConnection<F, ArgType>>(func));
-}
-
-template <typename ArgType>
-template <typename ReceiverType>
-inline void Event1<ArgType>::disconnect(ReceiverType* receiver)
-{
-	receiverDisconnected(receiver);
-	receiver->eventDisconnected(this);
-}
-
-template <typename ArgType>
-inline void Event1<ArgType>::receiverDisconnected(EventReceiver* r)
-{
-	auto i = _connections.begin();
-	while (i != _connections.end())
-	{
-		if (r == (*i)->receiver())
-		{
-			if (_invoking)
-			{
-				(*i)->remove();
-				++i;
-			}
-			else
-			{
-				etDestroyObject(*i);
-				i = _connections.erase(i);
-			}
-		}
-		else
-		{
-			++i;
-		}
-	}
-}
-
-template <typename ArgType>
-inline void Event1<ArgType>::cleanup()
-{
-	auto i = std::remove_if(_connections.begin(), _connections.end(), [](EventConnectionBase* b) { return (b == nullptr) || b->removed(); });
-	_connections.erase(i, _connections.end());
-}
-
-template <typename ArgType>
-inline void Event1<ArgType>::invoke(ArgType arg)
-{
-	cleanup();
-
-	_invoking = true;
-	for (auto& conn : _connections)
-		conn->invoke(arg);
-	_invoking = false;
-}
-
-template <typename ArgType>
-inline void Event1<ArgType>::invokeInMainRunLoop(ArgType arg, float delay)
-{
-	cleanup();
-
-	_invoking = true;
-	for (auto& conn : _connections)
-		conn->invokeInMainRunLoop(arg, delay);
-	_invoking = false;
-}
-
-template <typename ArgType>
-inline void Event1<ArgType>::invokeInCurrentRunLoop(ArgType arg, float delay)
-{
-	cleanup();
-
-	_invoking = true;
-	for (auto& conn : _connections)
-		conn->invokeInCurrentRunLoop(arg, delay);
-	_invoking = false;
-}
-
-/*
-* Event2Connection
-*/
-
-template <typename ReceiverType, typename Arg1Type, typename Arg2Type>
-Event2Connection<ReceiverType, Arg1Type, Arg2Type>::Event2Connection(ReceiverType* receiver,
-	void(ReceiverType::*func)(Arg1Type, Arg2Type)) : _receiverMethod(func), _receiver(receiver)
-{
-}
-
-/*
-* Event2
-*/
-template <typename Arg1Type, typename Arg2Type>
-Event2<Arg1Type, Arg2Type>::~Event2()
-{
-	for (auto& connection : _connections)
-	{
-		if ((connection->receiver() != nullptr) && !connection->removed())
-			connection->receiver()->eventDisconnected(this);
-
-		etDestroyObject(connection);
-	}
-}
-
-template <typename Arg1Type, typename Arg2Type>
-template <typename ReceiverType>
-inline void Event2<Arg1Type, Arg2Type>::connect(ReceiverType* receiver, void (ReceiverType::*receiverMethod)(Arg1Type, Arg2Type))
-{
-	ET_ASSERT(receiver != nullptr);
-
-	for (auto& i : _connections)
-	{
-		if (i->receiver() == receiver)
-		{
-			i->setRemoved(false);
-			return;
-		}
-	}
-
-	_connections.push_back(etCreateObject
-		<Event2Connection<ReceiverType, Arg1Type, Arg2Type>>(receiver, receiverMethod));
-
-	receiver->eventConnected(this);
-}
-
-template <typename ArgType1, typename ArgType2>
-template <typename F>
-inline void Event2<ArgType1, ArgType2>::connect(F func)
-{
-	_connections.push_back(etCreateObject<Event2DirectConnection<F, ArgType1, ArgType2>>(func));
-}
-
-template <typename Arg1Type, typename Arg2Type>
-template <typename ReceiverType>
-inline void Event2<Arg1Type, Arg2Type>::disconnect(ReceiverType* receiver)
-{
-	receiverDisconnected(receiver);
-	receiver->eventDisconnected(this);
-}
-
-template <typename Arg1Type, typename Arg2Type>
-inline void Event2<Arg1Type, Arg2Type>::receiverDisconnected(EventReceiver* r)
-{
-	auto i = _connections.begin();
-	while (i != _connections.end())
-	{
-		if (r == (*i)->receiver())
-		{
-			if (_invoking)
-			{
-				(*i)->remove();
-				++i;
-			}
-			else
-			{
-				etDestroyObject(*i);
-				i = _connections.erase(i);
-			}
-		}
-		else
-		{
-			++i;
-		}
-	}
-}
-
-template <typename Arg1Type, typename Arg2Type>
-inline void Event2<Arg1Type, Arg2Type>::invoke(Arg1Type a1, Arg2Type a2)
-{
-	auto i = remove_if(_connections.begin(), _connections.end(), [](EventConnectionBase* b) { return (b == nullptr) || b->removed(); });
-	_connections.erase(i, _connections.end());
-
-	_invoking = true;
-	for (auto& conn : _connections)
-		conn->invoke(a1, a2);
-	_invoking = false;
-}
-
-template <typename Arg1Type, typename Arg2Type>
-inline void Event2<Arg1Type, Arg2Type>::invokeInMainRunLoop(Arg1Type a1, Arg2Type a2, float delay)
-{
-	auto i = remove_if(_connections.begin(), _connections.end(), [](EventConnectionBase* b) { return (b == nullptr) || b->removed(); });
-	_connections.erase(i, _connections.end());
-
-	_invoking = true;
-	for (auto& conn : _connections)
-		conn->invokeInMainRunLoop(a1, a2, delay);
-	_invoking = false;
-
-}
-
-template <typename Arg1Type, typename Arg2Type>
-inline void Event2<Arg1Type, Arg2Type>::invokeInCurrentRunLoop(Arg1Type a1, Arg2Type a2, float delay)
-{
-	auto i = remove_if(_connections.begin(), _connections.end(), [](EventConnectionBase* b) { return (b == nullptr) || b->removed(); });
-	_connections.erase(i, _connections.end());
-
-	_invoking = true;
-	for (auto& conn : _connections)
-		conn->invokeInCurrentRunLoop(a1, a2, delay);
-	_invoking = false;
-
-}
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+/*
+ * EventBase
+ */
+template <typename... Args>
+EventBase<Args...>::~EventBase()
+{
+	ET_ASSERT(_invokeDepth == 0);
+
+	for (Slot& slot : _slots)
+	{
+		if (slot.active && (slot.receiver != nullptr))
+			slot.receiver->eventDisconnected(this);
+	}
+}
+
+template <typename... Args>
+EventConnection EventBase<Args...>::addConnection(DelegateType&& delegate, EventReceiver* receiver)
+{
+	uint32_t index = 0;
+	Slot* slot = nullptr;
+
+	if (_invokeDepth > 0)
+	{
+		/*
+		 * _slots should not be modified while delegates from it are executed
+		 */
+		index = static_cast<uint32_t>(_slots.size() + _pendingSlots.size());
+		_pendingSlots.emplace_back();
+		slot = &_pendingSlots.back();
+	}
+	else if (_freeSlots.empty())
+	{
+		index = static_cast<uint32_t>(_slots.size());
+		_slots.emplace_back();
+		slot = &_slots.back();
+	}
+	else
+	{
+		index = _freeSlots.back();
+		_freeSlots.pop_back();
+		slot = &_slots[index];
+	}
+
+	slot->delegate = std::move(delegate);
+	slot->receiver = receiver;
+	slot->active = true;
+	++_connectionsCount;
+
+	return EventConnection(index, slot->generation);
+}
+
+template <typename... Args>
+typename EventBase<Args...>::Slot* EventBase<Args...>::slotForConnection(const EventConnection& c)
+{
+	Slot* slot = nullptr;
+
+	if (c.index < _slots.size())
+		slot = &_slots[c.index];
+	else if (c.valid() && (c.index - _slots.size() < _pendingSlots.size()))
+		slot = &_pendingSlots[c.index - _slots.size()];
+
+	return ((slot != nullptr) && slot->active && (slot->generation == c.generation)) ? slot : nullptr;
+}
+
+template <typename... Args>
+void EventBase<Args...>::disconnect(const EventConnection& c)
+{
+	Slot* slot = slotForConnection(c);
+	if (slot == nullptr)
+		return;
+
+	if (slot->receiver != nullptr)
+		slot->receiver->eventDisconnected(this);
+
+	releaseSlot(c.index);
+}
+
+template <typename... Args>
+void EventBase<Args...>::receiverDisconnected(EventReceiver* r)
+{
+	EventConnection c = r->connection(this);
+	if (slotForConnection(c) != nullptr)
+		releaseSlot(c.index);
+}
+
+template <typename... Args>
+void EventBase<Args...>::releaseSlot(uint32_t index)
+{
+	Slot& slot = (index < _slots.size()) ? _slots[index] : _pendingSlots[index - _slots.size()];
+	slot.receiver = nullptr;
+	slot.active = false;
+	++slot.generation;
+	--_connectionsCount;
+
+	if (_invokeDepth > 0)
+	{
+		/*
+		 * delegate could be the one which is executing right now
+		 */
+		_releasedSlots.push_back(index);
+	}
+	else
+	{
+		slot.delegate.reset();
+		_freeSlots.push_back(index);
+	}
+}
+
+template <typename... Args>
+void EventBase<Args...>::finishInvoke()
+{
+	if (!_pendingSlots.empty())
+	{
+		for (Slot& slot : _pendingSlots)
+			_slots.emplace_back(std::move(slot));
+		_pendingSlots.clear();
+	}
+
+	for (uint32_t index : _releasedSlots)
+	{
+		_slots[index].delegate.reset();
+		_freeSlots.push_back(index);
+	}
+	_releasedSlots.clear();
+}
+
+template <typename... Args>
+void EventBase<Args...>::invokeDirectly(Args... args)
+{
+	++_invokeDepth;
+
+	const size_t slotsCount = _slots.size();
+	for (size_t i = 0; i < slotsCount; ++i)
+	{
+		const Slot& slot = _slots[i];
+		if (slot.active)
+			slot.delegate(args...);
+	}
+
+	if (--_invokeDepth == 0)
+		finishInvoke();
+}
+
+template <typename... Args>
+void EventBase<Args...>::invokeInRunLoop(RunLoop& rl, float delay, Args... args)
+{
+	if (_connectionsCount == 0)
+		return;
+
+	EventDispatch<Args...>* dispatch = etCreateObject<EventDispatch<Args...>>(args...);
+	dispatch->delegates.reserve(_connectionsCount);
+
+	for (const Slot& slot : _slots)
+	{
+		if (slot.active)
+			dispatch->delegates.push_back(slot.delegate);
+	}
+
+	for (const Slot& slot : _pendingSlots)
+	{
+		if (slot.active)
+			dispatch->delegates.push_back(slot.delegate);
+	}
+
+	rl.post(dispatch, delay);
+}
+
+/*
+ * Event0
+ */
+template <typename R>
+inline EventConnection Event0::connect(R* receiver, void (R::*receiverMethod)())
+{
+	ET_ASSERT(receiver != nullptr);
+
+	EventConnection existing = receiver->connection(this);
+	if (existing.valid())
+		return existing;
+
+	EventConnection result = addConnection(DelegateType(receiver, receiverMethod), receiver);
+	receiver->eventConnected(this, result);
+	return result;
+}
+
+template <typename F>
+inline EventConnection Event0::connect(F func)
+{
+	return addConnection(DelegateType(func), nullptr);
+}
+
+template <typename R>
+inline void Event0::disconnect(R* receiver)
+{
+	disconnect(receiver->connection(this));
+}
+
+inline void Event0::invoke()
+{
+	invokeDirectly();
+}
+
+/*
+ * Event1
+ */
+template <typename ArgType>
+template <typename ReceiverType, typename ReturnType>
+inline EventConnection Event1<ArgType>::connect(ReceiverType* receiver, ReturnType(ReceiverType::*receiverMethod)(ArgType))
+{
+	ET_ASSERT(receiver != nullptr);
+
+	static_assert(std::is_base_of<EventReceiver, ReceiverType>::value,
+		"Receiver object should be derived from et::EventReceiver");
+
+	EventConnection existing = receiver->connection(this);
+	if (existing.valid())
+		return existing;
+
+	using DelegateType = typename EventBase<ArgType>::DelegateType;
+	EventConnection result = this->addConnection(DelegateType(receiver, receiverMethod), receiver);
+	receiver->eventConnected(this, result);
+	return result;
+}
+
+template <typename ArgType>
+template <typename F>
+inline EventConnection Event1<ArgType>::connect(F func)
+{
+	using DelegateType = typename EventBase<ArgType>::DelegateType;
+	return this->addConnection(DelegateType(func), nullptr);
+}
+
+template <typename ArgType>
+template <typename ReceiverType>
+inline void Event1<ArgType>::disconnect(ReceiverType* receiver)
+{
+	disconnect(receiver->connection(this));
+}
+
+template <typename ArgType>
+inline void Event1<ArgType>::invoke(ArgType arg)
+{
+	this->invokeDirectly(arg);
+}
+
+template <typename ArgType>
+inline void Event1<ArgType>::invokeInMainRunLoop(ArgType arg, float delay)
+{
+	this->invokeInRunLoop(mainRunLoop(), delay, arg);
+}
+
+template <typename ArgType>
+inline void Event1<ArgType>::invokeInCurrentRunLoop(ArgType arg, float delay)
+{
+	this->invokeInRunLoop(currentRunLoop(), delay, arg);
+}
+
+template <typename ArgType>
+inline void Event1<ArgType>::invokeInBackground(ArgType arg, float delay)
+{
+	this->invokeInRunLoop(backgroundRunLoop(), delay, arg);
+}
+
+/*
+ * Event2
+ */
+template <typename Arg1Type, typename Arg2Type>
+template <typename ReceiverType>
+inline EventConnection Event2<Arg1Type, Arg2Type>::connect(ReceiverType* receiver, void (ReceiverType::*receiverMethod)(Arg1Type, Arg2Type))
+{
+	ET_ASSERT(receiver != nullptr);
+
+	EventConnection existing = receiver->connection(this);
+	if (existing.valid())
+		return existing;
+
+	using DelegateType = typename EventBase<Arg1Type, Arg2Type>::DelegateType;
+	EventConnection result = this->addConnection(DelegateType(receiver, receiverMethod), receiver);
+	receiver->eventConnected(this, result);
+	return result;
+}
+
+template <typename Arg1Type, typename Arg2Type>
+template <typename F>
+inline EventConnection Event2<Arg1Type, Arg2Type>::connect(F func)
+{
+	using DelegateType = typename EventBase<Arg1Type, Arg2Type>::DelegateType;
+	return this->addConnection(DelegateType(func), nullptr);
+}
+
+template <typename Arg1Type, typename Arg2Type>
+template <typename ReceiverType>
+inline void Event2<Arg1Type, Arg2Type>::disconnect(ReceiverType* receiver)
+{
+	disconnect(receiver->connection(this));
+}
+
+template <typename Arg1Type, typename Arg2Type>
+inline void Event2<Arg1Type, Arg2Type>::invoke(Arg1Type a1, Arg2Type a2)
+{
+	this->invokeDirectly(a1, a2);
+}
+
+template <typename Arg1Type, typename Arg2Type>
+inline void Event2<Arg1Type, Arg2Type>::invokeInMainRunLoop(Arg1Type a1, Arg2Type a2, float delay)
+{
+	this->invokeInRunLoop(mainRunLoop(), delay, a1, a2);
+}
+
+template <typename Arg1Type, typename Arg2Type>
+inline void Event2<Arg1Type, Arg2Type>::invokeInCurrentRunLoop(Arg1Type a1, Arg2Type a2, float delay)
+{
+	this->invokeInRunLoop(currentRunLoop(), delay, a1, a2);
+}
+
+template <typename Arg1Type, typename Arg2Type>
+inline void Event2<Arg1Type, Arg2Type>::invokeInBackground(Arg1Type a1, Arg2Type a2, float delay)
+{
+	this->invokeInRunLoop(backgroundRunLoop(), delay, a1, a2);
+}
@@ -10,108 +10,27 @@
 
 using namespace et;
 
-/*
- * Invocation Task
- */
-
-InvocationTask::InvocationTask(PureInvocationTarget* invocation) :
-	_invocation(invocation)
-{
-}
-
-InvocationTask::~InvocationTask()
-{
-	etDestroyObject(_invocation);
-}
-
-void InvocationTask::execute() 
-{
-	_invocation->invoke(); 
-}
-
-/*
- * Invocation (0)
- */
-
-void Invocation::invoke()
-{
-	_target->invoke();	 
-}
-
-void Invocation::invokeInMainRunLoop(float delay)
-{
-	invokeInRunLoop(mainRunLoop(), delay);
-}
-
-void Invocation::invokeInCurrentRunLoop(float delay)
+void PureInvocation::invoke()
 {
-	invokeInRunLoop(currentRunLoop(), delay);
-}
-
-void Invocation::invokeInBackground(float delay)
-{
-	invokeInRunLoop(backgroundRunLoop(), delay);
-}
-
-void Invocation::invokeInRunLoop(RunLoop& rl, float delay)
-{
-	rl.addTask(etCreateObject<InvocationTask>(_target->copy()), delay);
-}
-
-/*
- * Invocation (1)
- */
-
-void Invocation1::invoke()
-{ 
-	_target->invoke();	 
-}
-
-void Invocation1::invokeInMainRunLoop(float delay)
-{
-	invokeInRunLoop(mainRunLoop(), delay);
-}
-
-void Invocation1::invokeInCurrentRunLoop(float delay)
-{
-	invokeInRunLoop(currentRunLoop(), delay);
-}
-
-void Invocation1::invokeInBackground(float delay)
-{
-	invokeInRunLoop(backgroundRunLoop(), delay);
-}
-
-void Invocation1::invokeInRunLoop(RunLoop& rl, float delay)
-{
-	rl.addTask(etCreateObject<InvocationTask>(_target->copy()), delay);
-}
-
-/*
- * Invocation (2)
- */
-
-void Invocation2::invoke()
-{ 
-	_target->invoke();	 
+	_target();
 }
 
-void Invocation2::invokeInMainRunLoop(float delay)
+void PureInvocation::invokeInMainRunLoop(float delay)
 {
 	invokeInRunLoop(mainRunLoop(), delay);
 }
 
-void Invocation2::invokeInCurrentRunLoop(float delay)
+void PureInvocation::invokeInCurrentRunLoop(float delay)
 {
 	invokeInRunLoop(currentRunLoop(), delay);
 }
 
-void Invocation2::invokeInBackground(float delay)
+void PureInvocation::invokeInBackground(float delay)
 {
 	invokeInRunLoop(backgroundRunLoop(), delay);
 }
 
-void Invocation2::invokeInRunLoop(RunLoop& rl, float delay)
+void PureInvocation::invokeInRunLoop(RunLoop& rl, float delay)
 {
-	rl.addTask(etCreateObject<InvocationTask>(_target->copy()), delay);
+	rl.enqueue(_target, delay);
 }
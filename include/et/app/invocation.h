@@ -12,229 +12,99 @@
 
 namespace et
 {
-class PureInvocationTarget
-{
-public:
-	PureInvocationTarget() {}
-	virtual ~PureInvocationTarget() {};
-
-	virtual void invoke() = 0;
-	virtual PureInvocationTarget* copy() = 0;
-};
-
-class PureInvocation
-{
-public:
-	PureInvocation() :
-		_target(nullptr)
-	{
-	};
-
-	virtual ~PureInvocation() {};
-
-	virtual void invoke() = 0;
-	virtual void invokeInMainRunLoop(float delay) = 0;
-
-protected:
-	UniquePtr<PureInvocationTarget> _target;
-};
-
-class InvocationTask : public Task
-{
-public:
-	InvocationTask(PureInvocationTarget* invocation);
-	~InvocationTask();
-
-	void execute();
-
-private:
-	PureInvocationTarget* _invocation = nullptr;
-};
-
-template <typename T>
-class InvocationTarget : public PureInvocationTarget
+/*
+ * Targets are plain functors, stored inline in RunLoop::Function
+ */
+template <typename T, typename A1, typename RET>
+struct Invocation1Target
 {
-public:
-	InvocationTarget(T* o, void(T::*m)()) : _object(o), _method(m) {}
+	T* object = nullptr;
+	RET(T::*method)(A1) = nullptr;
+	typename std::decay<A1>::type param;
 
-	void invoke()
-	{
-		(_object->*_method)();
-	}
+	Invocation1Target(T* o, RET(T::*m)(A1), A1 p1) :
+		object(o), method(m), param(p1) { }
 
-	PureInvocationTarget* copy()
+	void operator () ()
 	{
-		return etCreateObject<InvocationTarget>(_object, _method);
+		(object->*method)(param);
 	}
-
-private:
-	ET_DENY_COPY(InvocationTarget);
-
-private:
-	T* _object = nullptr;
-	void (T::*_method)();
 };
 
-template <typename F>
-class DirectInvocationTarget : public PureInvocationTarget
+template <typename F, typename A1>
+struct DirectInvocation1Target
 {
-public:
-	DirectInvocationTarget(F f) :
-		_func(f)
-	{
-	}
+	F func;
+	typename std::decay<A1>::type param;
 
-	void invoke()
-	{
-		_func();
-	}
+	DirectInvocation1Target(F f, A1 p1) :
+		func(f), param(p1) { }
 
-	PureInvocationTarget* copy()
+	void operator () ()
 	{
-		return etCreateObject<DirectInvocationTarget<F>>(_func);
+		func(param);
 	}
-
-private:
-	ET_DENY_COPY(DirectInvocationTarget);
-
-private:
-	F _func;
 };
 
-template <typename T, typename A1, typename RET>
-class Invocation1Target : public PureInvocationTarget
+template <typename T, typename A1, typename A2>
+struct Invocation2Target
 {
-public:
-	Invocation1Target(T* o, RET(T::*m)(A1), A1 p1) :
-		_object(o), _method(m), _param(p1)
-	{
-	}
-
-	void invoke()
-	{
-		(_object->*_method)(_param);
-	}
+	T* object = nullptr;
+	void (T::*method)(A1, A2) = nullptr;
+	typename std::decay<A1>::type p1;
+	typename std::decay<A2>::type p2;
 
-	void setParameter(const A1& p1)
-	{
-		_param = p1;
-	}
+	Invocation2Target(T* o, void(T::*m)(A1, A2), A1 a1, A2 a2) :
+		object(o), method(m), p1(a1), p2(a2) { }
 
-	PureInvocationTarget* copy()
+	void operator () ()
 	{
-		return etCreateObject<Invocation1Target>(_object, _method, _param);
+		(object->*method)(p1, p2);
 	}
-
-private:
-	ET_DENY_COPY(Invocation1Target);
-
-private:
-	T* _object = nullptr;
-	RET(T::*_method)(A1) = nullptr;
-	A1 _param;
 };
 
-template <typename F, typename A1>
-class DirectInvocation1Target : public PureInvocationTarget
+template <typename F, typename A1, typename A2>
+struct DirectInvocation2Target
 {
-public:
-	DirectInvocation1Target(F func, A1 p1) :
-		_func(func), _param(p1)
-	{
-	}
+	F func;
+	typename std::decay<A1>::type p1;
+	typename std::decay<A2>::type p2;
 
-	void invoke()
-	{
-		_func(_param);
-	}
+	DirectInvocation2Target(F f, A1 a1, A2 a2) :
+		func(f), p1(a1), p2(a2) { }
 
-	void setParameter(const A1& p1)
+	void operator () ()
 	{
-		_param = p1;
+		func(p1, p2);
 	}
-
-	PureInvocationTarget* copy()
-	{
-		return etCreateObject<DirectInvocation1Target>(_func, _param);
-	}
-
-private:
-	ET_DENY_COPY(DirectInvocation1Target);
-
-private:
-	F _func;
-	A1 _param;
 };
 
-template <typename T, typename A1, typename A2>
-class Invocation2Target : public PureInvocationTarget
+class InvocationTask : public Task
 {
 public:
-	Invocation2Target(T* o, void(T::*m)(A1, A2), A1 p1, A2 p2) :
-		_object(o), _method(m), _p1(p1), _p2(p2)
-	{
-	}
-
-	void invoke()
-	{
-		(_object->*_method)(_p1, _p2);
-	}
+	InvocationTask(const RunLoop::Function& func) :
+		_func(func) { }
 
-	void setParameters(const A1& p1, const A2& p2)
+	void execute()
 	{
-		_p1 = p1;
-		_p2 = p2;
-	}
-
-	PureInvocationTarget* copy()
-	{
-		return etCreateObject<Invocation2Target>(_object, _method, _p1, _p2);
-	}
-
-private:
-	Invocation2Target operator = (const Invocation2Target&)
-	{
-		return *this;
+		_func();
 	}
 
 private:
-	T* _object = nullptr;
-	void (T::*_method)(A1, A2);
-	A1 _p1;
-	A2 _p2;
+	RunLoop::Function _func;
 };
 
-template <typename F, typename A1, typename A2>
-class DirectInvocation2Target : public PureInvocationTarget
+class PureInvocation
 {
 public:
-	DirectInvocation2Target(F func, A1 p1, A2 p2) :
-		_func(func), _param1(p1), _param2(p2)
-	{
-	}
-
-	void invoke()
-	{
-		_func(_param1, _param2);
-	}
-
-	void setParameters(const A1& p1, const A2& p2)
-	{
-		_param1 = p1; _param2 = p2;
-	}
-
-	PureInvocationTarget* copy()
-	{
-		return etCreateObject<DirectInvocation2Target>(_func, _param1, _param2);
-	}
-
-private:
-	ET_DENY_COPY(DirectInvocation2Target);
+	void invoke();
+	void invokeInMainRunLoop(float delay = 0.0f);
+	void invokeInCurrentRunLoop(float delay = 0.0f);
+	void invokeInBackground(float delay = 0.0f);
+	void invokeInRunLoop(RunLoop& rl, float delay = 0.0f);
 
-private:
-	F _func;
-	A1 _param1;
-	A2 _param2;
+protected:
+	RunLoop::Function _target;
 };
 
 class Invocation : public PureInvocation
@@ -254,82 +124,68 @@ public:
 		setTarget<T>(o, m);
 	}
 
-	void invoke();
-	void invokeInMainRunLoop(float delay = 0.0f);
-	void invokeInCurrentRunLoop(float delay = 0.0f);
-	void invokeInBackground(float delay = 0.0f);
-	void invokeInRunLoop(RunLoop& rl, float delay = 0.0f);
-
 	template <typename T>
 	void setTarget(T* o, void(T::*m)())
 	{
 		ET_ASSERT(o != nullptr);
-		_target = UniquePtr<PureInvocationTarget>(etCreateObject<InvocationTarget<T>>(o, m));
+		_target = RunLoop::Function(o, m);
 	}
 
 	template <typename F>
 	void setTarget(F func)
 	{
-		_target = UniquePtr<PureInvocationTarget>(etCreateObject<DirectInvocationTarget<F>>(func));
+		_target = RunLoop::Function(func);
 	}
 };
 
 class Invocation1 : public PureInvocation
 {
 public:
-	void invoke();
-	void invokeInMainRunLoop(float delay = 0.0f);
-	void invokeInCurrentRunLoop(float delay = 0.0f);
-	void invokeInBackground(float delay = 0.0f);
-	void invokeInRunLoop(RunLoop& rl, float delay = 0.0f);
-
 	template <typename T, typename A1, typename RET>
 	void setTarget(T* o, RET(T::*m)(A1), A1 param)
 	{
 		ET_ASSERT(o != nullptr);
-		_target = UniquePtr<PureInvocationTarget>(etCreateObject<Invocation1Target<T, A1, RET>>(o, m, param));
+		_target = RunLoop::Function(Invocation1Target<T, A1, RET>(o, m, param));
 	}
 
 	template <typename F, typename A1>
 	void setTarget(F func, A1 param)
 	{
-		_target = UniquePtr<PureInvocationTarget>(etCreateObject<DirectInvocation1Target<F, A1>>(func, param));
+		_target = RunLoop::Function(DirectInvocation1Target<F, A1>(func, param));
 	}
 
 	template <typename T, typename A1, typename RET>
 	void setParameter(const A1& p)
 	{
-		ET_ASSERT(_target.get() != nullptr);
-		(static_cast<Invocation1Target<T, A1, RET>*>(_target.get()))->setParameter(p);
+		auto target = _target.target<Invocation1Target<T, A1, RET>>();
+		ET_ASSERT(target != nullptr);
+		target->param = p;
 	}
 };
 
 class Invocation2 : public PureInvocation
 {
 public:
-	void invoke();
-	void invokeInMainRunLoop(float delay = 0.0f);
-	void invokeInCurrentRunLoop(float delay = 0.0f);
-	void invokeInBackground(float delay = 0.0f);
-	void invokeInRunLoop(RunLoop& rl, float delay = 0.0f);
-
 	template <typename T, typename A1, typename A2>
 	void setTarget(T* o, void(T::*m)(A1, A2), A1 p1, A2 p2)
 	{
 		ET_ASSERT(o != nullptr);
-		_target = UniquePtr<PureInvocationTarget>(etCreateObject<Invocation2Target<T, A1, A2>>(o, m, p1, p2));
+		_target = RunLoop::Function(Invocation2Target<T, A1, A2>(o, m, p1, p2));
 	}
 
 	template <typename F, typename A1, typename A2>
 	void setTarget(F func, A1 param1, A2 param2)
 	{
-		_target = UniquePtr<PureInvocationTarget>(etCreateObject<DirectInvocation2Target<F, A1, A2>>(func, param1, param2));
+		_target = RunLoop::Function(DirectInvocation2Target<F, A1, A2>(func, param1, param2));
 	}
 
 	template <typename T, typename A1, typename A2>
 	void setParameters(const A1& p1, const A2& p2)
 	{
-		(static_cast<Invocation2Target<T, A1, A2>*>(_target.get()))->setParameters(p1, p2);
+		auto target = _target.target<Invocation2Target<T, A1, A2>>();
+		ET_ASSERT(target != nullptr);
+		target->p1 = p1;
+		target->p2 = p2;
 	}
 };
 }
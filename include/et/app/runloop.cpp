@@ -6,21 +6,77 @@
  */
 
 #include <et/app/runloop.h>
+#include <et/app/invocation.h>
 #include <et/core/tasks.h>
+#include <et/core/profiler.h>
+#include <thread>
 
 using namespace et;
 
-RunLoop::RunLoop() 
+namespace et
+{
+class DelayedRunLoopMessage : public Task
+{
+public:
+	DelayedRunLoopMessage(RunLoopMessage* message) :
+		_message(message) { }
+
+	~DelayedRunLoopMessage()
+	{
+		etDestroyObject(_message);
+	}
+
+	void execute()
+	{
+		_message->deliver();
+	}
+
+private:
+	RunLoopMessage* _message = nullptr;
+};
+
+class FunctionMessage : public RunLoopMessage
+{
+public:
+	FunctionMessage(const RunLoop::Function& func) :
+		_func(func) { }
+
+	void deliver() override
+	{
+		_func();
+	}
+
+private:
+	RunLoop::Function _func;
+};
+}
+
+RunLoop::RunLoop() :
+	_invocations(InvocationQueueCapacity)
 {
 	attachTimerPool(TimerPool::Pointer::create(this));
 }
 
+RunLoop::~RunLoop()
+{
+	MPSCQueueNode* node = _messages.takeAll();
+	while (node != nullptr)
+	{
+		MPSCQueueNode* next = node->next;
+		etDestroyObject(static_cast<RunLoopMessage*>(node));
+		node = next;
+	}
+}
+
 void RunLoop::update(uint64_t t)
 {
+	ET_PROFILE_SCOPE("RunLoop::update");
+
 	updateTime(t);
 
 	if (_active) 
 	{
+		deliverMessages();
 		_taskPool.update(_time);
 		for (auto& tp : _timerPools)
 			tp->update(_time);
@@ -32,6 +88,61 @@ void RunLoop::addTask(Task* t, float delay)
 	_taskPool.addTask(t, delay);
 }
 
+void RunLoop::post(RunLoopMessage* message, float delay)
+{
+	if (delay > 0.0f)
+		_taskPool.addTask(etCreateObject<DelayedRunLoopMessage>(message), delay);
+	else
+	{
+		message->_invocationsPosition = _invocations.enqueuePosition();
+		_messages.push(message);
+	}
+}
+
+void RunLoop::enqueue(const Function& func, float delay)
+{
+	if (delay > 0.0f)
+		_taskPool.addTask(etCreateObject<InvocationTask>(func), delay);
+	else if (!_invocations.push(func))
+		RunLoop::post(etCreateObject<FunctionMessage>(func), 0.0f);
+}
+
+/*
+ * Only functions and messages posted before this call are delivered,
+ * ones posted from receivers will be delivered on the next update.
+ * Each message is delivered after functions enqueued before it was posted.
+ */
+void RunLoop::deliverMessages()
+{
+	// end position is read first: functions enqueued later could follow a message which is not taken yet
+	size_t endPosition = _invocations.enqueuePosition();
+	MPSCQueueNode* node = _messages.takeAll();
+
+	while (node != nullptr)
+	{
+		MPSCQueueNode* next = node->next;
+		RunLoopMessage* message = static_cast<RunLoopMessage*>(node);
+		deliverInvocations(message->_invocationsPosition);
+		message->deliver();
+		etDestroyObject(message);
+		node = next;
+	}
+
+	deliverInvocations(endPosition);
+}
+
+void RunLoop::deliverInvocations(size_t endPosition)
+{
+	Function func;
+	while (_invocations.dequeuePosition() < endPosition)
+	{
+		if (_invocations.pop(func))
+			func();
+		else
+			std::this_thread::yield(); // position is claimed, but function is still being copied by producer
+	}
+}
+
 void RunLoop::attachTimerPool(const TimerPool::Pointer& pool)
 {
 	if (std::find(_timerPools.begin(), _timerPools.end(), pool) == _timerPools.end())
@@ -9,16 +9,41 @@
 
 #include <et/core/timerpool.h>
 #include <et/core/taskpool.h>
+#include <et/core/mpscqueue.h>
+#include <et/core/inlinedelegate.h>
 
 namespace et
 {
+class RunLoopMessage : public MPSCQueueNode
+{
+public:
+	virtual ~RunLoopMessage() { }
+	virtual void deliver() = 0;
+
+private:
+	friend class RunLoop;
+
+	/*
+	 * Functions enqueued before the message are delivered before it
+	 */
+	size_t _invocationsPosition = 0;
+};
+
 class RunLoop : public Object
 {
 public:
 	ET_DECLARE_POINTER(RunLoop);
 
+	using Function = InlineDelegate<>;
+
+	enum : size_t
+	{
+		InvocationQueueCapacity = 256
+	};
+
 public:
 	RunLoop();
+	~RunLoop();
 
 	float time() const { return _time; }
 	float lastFrameTime() const { return _lastFrameTime; }
@@ -35,12 +60,33 @@ public:
 	void detachTimerPool(const TimerPool::Pointer&);
 	void detachAllTimerPools();
 
-	bool hasTasks() { return _taskPool.hasTasks(); }
+	bool hasTasks() { return _taskPool.hasTasks() || !_messages.empty() || !_invocations.empty(); }
 
 	virtual void addTask(Task*, float);
 
+	/*
+	 * Could be called from any thread without locking,
+	 * messages are delivered (and destroyed) on the next update
+	 */
+	virtual void post(RunLoopMessage*, float delay);
+
+	/*
+	 * Same as post, but function is copied into preallocated queue, so small functions are posted
+	 * without allocations. Falls back to messages when queue is full.
+	 *
+	 * Messages and functions posted without delay from one thread (using any of the methods)
+	 * are delivered in order of posting. There is no order between posts from different threads.
+	 */
+	virtual void enqueue(const Function&, float delay);
+
+private:
+	void deliverMessages();
+	void deliverInvocations(size_t endPosition);
+
 private:
 	std::vector<TimerPool::Pointer> _timerPools;
+	BoundedMPSCQueue<Function> _invocations;
+	MPSCQueue _messages;
 	TaskPool _taskPool;
 	uint64_t _actualTimeMSec = 0;
 	uint64_t _activityTimeMSec = 0;
@@ -1,13 +1,16 @@
 #include <et/core/et.h>
 
 #include "../core/base64.cpp"
+#include "../core/binarydictionary.cpp"
 #include "../core/constants.cpp"
 #include "../core/conversion.cpp"
 #include "../core/debug.cpp"
 #include "../core/dictionary.cpp"
 #include "../core/et.cpp"
+#include "../core/filewatcher.cpp"
 #include "../core/json.cpp"
 #include "../core/locale.cpp"
+#include "../core/mappedfile.cpp"
 #include "../core/memoryallocator.cpp"
 #include "../core/notifytimer.cpp"
 #include "../core/objectscache.cpp"
@@ -21,3 +24,5 @@
 #include "../core/tools.cpp"
 #include "../core/transformable.cpp"
 #include "../core/remoteheap.cpp"
+#include "../core/parallel.cpp"
+#include "../core/profiler.cpp"
@@ -1,5 +1,7 @@
 #include <et/core/et.h>
 
+#include "../geometry/broadphase.cpp"
 #include "../geometry/collision.cpp"
+#include "../geometry/collisionbatch.cpp"
 #include "../geometry/geometry.cpp"
 #include "../geometry/rectplacer.cpp"
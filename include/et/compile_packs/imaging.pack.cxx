@@ -1,13 +1,16 @@
 #include <et/core/et.h>
 
+#include "../imaging/blockcompression.cpp"
 #include "../imaging/bmploader.cpp"
 #include "../imaging/ddsloader.cpp"
 #include "../imaging/hdrloader.cpp"
 #include "../imaging/imageoperations.cpp"
 #include "../imaging/imagewriter.cpp"
 #include "../imaging/jpegloader.cpp"
+#include "../imaging/mipgenerator.cpp"
 #include "../imaging/pngloader.cpp"
 #include "../imaging/pvrdecompressor.cpp"
 #include "../imaging/pvrloader.cpp"
 #include "../imaging/texturedescription.cpp"
+#include "../imaging/textureloader.cpp"
 #include "../imaging/tgaloader.cpp"
@@ -0,0 +1,9 @@
+#include <et/core/et.h>
+
+#include "../platform-linux/application.linux.cpp"
+#include "../platform-linux/input.linux.cpp"
+#include "../platform-linux/locale.linux.cpp"
+#include "../platform-linux/log.linux.cpp"
+#include "../platform-linux/memory.linux.cpp"
+#include "../platform-linux/rendercontext.linux.cpp"
+#include "../platform-linux/tools.linux.cpp"
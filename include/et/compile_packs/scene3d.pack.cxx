@@ -12,6 +12,7 @@
 #include "../scene3d/renderableelement.cpp"
 #include "../scene3d/scene3d.cpp"
 #include "../scene3d/skeletonelement.cpp"
+#include "../scene3d/skinning.cpp"
 #include "../scene3d/storage.cpp"
 
 #include "../scene3d/drawer/common.cpp"
@@ -53,13 +53,18 @@ inline float linearFunction(float t)
 	return t;
 }
 
+template <typename T>
+class AnimationManager;
+
+/*
+ * Handle of the animation stored in the AnimationManager<T> of the timer pool
+ */
 template <typename T>
 class Animator : public BaseAnimator
 {
 public:
 	Animator() :
-		BaseAnimator(0, nullptr), _from(), _to(), _value(), _valuePointer(nullptr),
-		_startTime(0.0f), _duration(0.0f)
+		BaseAnimator(0, nullptr)
 	{
 		initDefaultInterpolators();
 	}
@@ -68,15 +73,13 @@ public:
 	 * Just Timer Pool
 	 */
 	Animator(TimerPool* tp) :
-		BaseAnimator(0, tp), _from(), _to(), _value(), _valuePointer(nullptr),
-		_startTime(0.0f), _duration(0.0f)
+		BaseAnimator(0, tp)
 	{
 		initDefaultInterpolators();
 	}
 
 	Animator(TimerPool::Pointer tp) :
-		BaseAnimator(0, tp.pointer()), _from(), _to(), _value(), _valuePointer(nullptr),
-		_startTime(0.0f), _duration(0.0f)
+		BaseAnimator(0, tp.pointer())
 	{
 		initDefaultInterpolators();
 	}
@@ -85,15 +88,13 @@ public:
 	 * Tag and Timer Pool
 	 */
 	Animator(int64_t tag, TimerPool* tp) :
-		BaseAnimator(tag, tp), _from(), _to(), _value(), _valuePointer(nullptr),
-		_startTime(0.0f), _duration(0.0f)
+		BaseAnimator(tag, tp)
 	{
 		initDefaultInterpolators();
 	}
 
 	Animator(int64_t tag, TimerPool::Pointer tp) :
-		BaseAnimator(tag, tp.pointer()), _from(), _to(), _value(), _valuePointer(nullptr),
-		_startTime(0.0f), _duration(0.0f)
+		BaseAnimator(tag, tp.pointer())
 	{
 		initDefaultInterpolators();
 	}
@@ -102,15 +103,13 @@ public:
 	 * Value and Timer Pool
 	 */
 	Animator(const T& value, TimerPool* tp) :
-		BaseAnimator(0, tp), _from(), _to(), _value(value), _valuePointer(nullptr),
-		_startTime(0.0f), _duration(0.0f)
+		BaseAnimator(0, tp), _value(value)
 	{
 		initDefaultInterpolators();
 	}
 
 	Animator(const T& value, TimerPool::Pointer tp) :
-		BaseAnimator(0, tp.pointer()), _from(), _to(), _value(value), _valuePointer(nullptr),
-		_startTime(0.0f), _duration(0.0f)
+		BaseAnimator(0, tp.pointer()), _value(value)
 	{
 		initDefaultInterpolators();
 	}
@@ -119,19 +118,24 @@ public:
 	 * All properties
 	 */
 	Animator(T* value, const T& from, const T& to, float duration, int tag, TimerPool* tp) :
-		BaseAnimator(tag, tp), _from(), _to(), _value(), _valuePointer(nullptr), _startTime(0.0f), _duration(0.0f)
+		BaseAnimator(tag, tp)
 	{
 		initDefaultInterpolators();
 		animate(value, from, to, duration);
 	}
 
 	Animator(T* value, const T& from, const T& to, float duration, int tag, TimerPool::Pointer tp) :
-		BaseAnimator(tag, tp.pointer()), _from(), _to(), _value(), _valuePointer(nullptr), _startTime(0.0f), _duration(0.0f)
+		BaseAnimator(tag, tp.pointer())
 	{
 		initDefaultInterpolators();
 		animate(value, from, to, duration);
 	}
 
+	~Animator()
+	{
+		cancelUpdates();
+	}
+
 	const T& value() const
 	{
 		return _value;
@@ -142,18 +146,29 @@ public:
 		_value = v;
 	}
 
+	bool running() const override
+	{
+		return _manager != nullptr;
+	}
+
+	void cancelUpdates() override
+	{
+		if (_manager != nullptr)
+			_manager->remove(this);
+	}
+
 	void animate(T* value, const T& from, const T& to, float duration)
 	{
 		if (duration == 0.0f)
 		{
+			cancelUpdates();
+
 			_value = to;
 
 			if (value != nullptr)
 				*value = _value;
 
 			updated.invoke();
-			cancelUpdates();
-
 			finished.invoke();
 		}
 		else
@@ -162,12 +177,9 @@ public:
 
 			_valuePointer = value;
 			_value = from;
-			_from = from;
-			_to = to;
-			_duration = duration;
 
-			startUpdates(timerPool());
-			_startTime = actualTime();
+			cancelUpdates();
+			AnimationManager<T>::forPool(timerPool()).add(this, from, to, actualTime(), duration);
 		}
 	};
 
@@ -185,64 +197,275 @@ public:
 	void setTimeInterpolationFunction(F func)
 	{
 		_timeInterpolationFunction = func;
+		_customInterpolation = true;
 	}
 
 	template <typename F>
 	void setValueInterpolationFunction(F func)
 	{
 		_valueInterpolationFunction = func;
+		_customInterpolation = true;
 	}
 
 	ET_DECLARE_EVENT0(updated);
 	ET_DECLARE_EVENT0(finished);
 
 private:
+	ET_DENY_COPY(Animator);
+
+	friend class AnimationManager<T>;
+
 	void initDefaultInterpolators()
 	{
 		_timeInterpolationFunction = linearFunction;
 		_valueInterpolationFunction = linearInterpolationFunction<T>;
 	}
 
-	void update(float t)
+	void applyValue(const T& v)
 	{
-		float dt = (t - _startTime) / _duration;
-		if (dt >= 1.0f)
-		{
-			_value = _to;
+		_value = v;
 
-			if (_valuePointer)
-				*_valuePointer = _value;
+		if (_valuePointer)
+			*_valuePointer = _value;
 
-			updated.invoke();
+		updated.invoke();
+	}
 
-			cancelUpdates();
+private:
+	std::function<float(float)> _timeInterpolationFunction;
+	std::function<T(const T&, const T&, float)> _valueInterpolationFunction;
 
-			finished.invoke();
+	T _value = T();
+	T* _valuePointer = nullptr;
+
+	AnimationManager<T>* _manager = nullptr;
+	uint32_t _managerIndex = 0;
+	bool _finishing = false;
+	bool _customInterpolation = false;
+};
+
+/*
+ * Active animations of one value type, stored as arrays and evaluated in one pass per frame.
+ * Manager is owned by the timer pool and attached to it only while there are active animations.
+ *
+ * Animations added during the update are appended and evaluated from the next frame,
+ * removed ones are replaced with null and compacted after the pass.
+ * Finished animations are removed first, then their finished events are invoked,
+ * so handlers could restart or destroy any animator.
+ * Animations could be added and removed from any thread, arrays are guarded by the timer pool lock.
+ */
+template <typename T>
+class AnimationManager : public TimedObject
+{
+public:
+	static AnimationManager<T>& forPool(TimerPool* tp)
+	{
+		return tp->sharedObject<AnimationManager<T>>(tp);
+	}
+
+	AnimationManager(TimerPool* tp) :
+		TimedObject(tp)
+	{
+	}
+
+	~AnimationManager()
+	{
+		for (Animator<T>* animator : _animators)
+		{
+			if (animator != nullptr)
+				animator->_manager = nullptr;
 		}
+	}
+
+	uint32_t activeAnimationsCount() const
+	{
+		return _activeCount;
+	}
+
+	void add(Animator<T>* animator, const T& from, const T& to, float startTime, float duration);
+	void remove(Animator<T>* animator);
+
+protected:
+	void update(float t) override;
+
+private:
+	void compact();
+
+private:
+	Vector<Animator<T>*> _animators;
+	Vector<T> _from;
+	Vector<T> _to;
+	Vector<T> _values;
+	Vector<float> _startTime;
+	Vector<float> _inverseDuration;
+	Vector<float> _progress;
+	Vector<Animator<T>*> _finished;
+	uint32_t _activeCount = 0;
+	bool _updating = false;
+};
+
+template <typename T>
+inline void AnimationManager<T>::add(Animator<T>* animator, const T& from, const T& to, float startTime, float duration)
+{
+	CriticalSectionScope lock(timerPool()->criticalSection());
+	ET_ASSERT(animator->_manager == nullptr);
+
+	animator->_manager = this;
+	animator->_managerIndex = static_cast<uint32_t>(_animators.size());
+	animator->_finishing = false;
+
+	_animators.emplace_back(animator);
+	_from.emplace_back(from);
+	_to.emplace_back(to);
+	_values.emplace_back(from);
+	_startTime.emplace_back(startTime);
+	_inverseDuration.emplace_back(1.0f / duration);
+	_progress.emplace_back(0.0f);
+	++_activeCount;
+
+	if (!TimedObject::running())
+		startUpdates(timerPool());
+}
+
+template <typename T>
+inline void AnimationManager<T>::remove(Animator<T>* animator)
+{
+	CriticalSectionScope lock(timerPool()->criticalSection());
+
+	// animation could be finished on the pool thread after animator checked its manager
+	if (animator->_manager != this)
+		return;
+
+	uint32_t index = animator->_managerIndex;
+	animator->_manager = nullptr;
+
+	if (animator->_finishing)
+	{
+		_finished[index] = nullptr;
+		animator->_finishing = false;
+		return;
+	}
+
+	--_activeCount;
+	if (_updating)
+	{
+		_animators[index] = nullptr;
+		return;
+	}
+
+	uint32_t last = static_cast<uint32_t>(_animators.size() - 1);
+	if (index != last)
+	{
+		_animators[index] = _animators[last];
+		_animators[index]->_managerIndex = index;
+		_from[index] = _from[last];
+		_to[index] = _to[last];
+		_values[index] = _values[last];
+		_startTime[index] = _startTime[last];
+		_inverseDuration[index] = _inverseDuration[last];
+	}
+	_animators.pop_back();
+	_from.pop_back();
+	_to.pop_back();
+	_values.pop_back();
+	_startTime.pop_back();
+	_inverseDuration.pop_back();
+	_progress.pop_back();
+}
+
+template <typename T>
+inline void AnimationManager<T>::update(float t)
+{
+	uint32_t count = static_cast<uint32_t>(_animators.size());
+
+	/*
+	 * progress and values with default interpolators are evaluated for all animations at once
+	 */
+	float* progress = _progress.data();
+	const float* startTime = _startTime.data();
+	const float* inverseDuration = _inverseDuration.data();
+	for (uint32_t i = 0; i < count; ++i)
+		progress[i] = std::min(std::max((t - startTime[i]) * inverseDuration[i], 0.0f), 1.0f);
+
+	T* values = _values.data();
+	const T* from = _from.data();
+	const T* to = _to.data();
+	for (uint32_t i = 0; i < count; ++i)
+		values[i] = from[i] * (1.0f - progress[i]) + to[i] * progress[i];
+
+	_updating = true;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Animator<T>* animator = _animators[i];
+		if (animator == nullptr)
+			continue;
+
+		if (_progress[i] >= 1.0f)
+			animator->applyValue(_to[i]);
+		else if (animator->_customInterpolation)
+			animator->applyValue(animator->_valueInterpolationFunction(_from[i], _to[i], animator->_timeInterpolationFunction(_progress[i])));
 		else
+			animator->applyValue(_values[i]);
+
+		if ((_progress[i] >= 1.0f) && (_animators[i] == animator))
 		{
-			_value = _valueInterpolationFunction(_from, _to, _timeInterpolationFunction(dt));
+			_animators[i] = nullptr;
+			animator->_managerIndex = static_cast<uint32_t>(_finished.size());
+			animator->_finishing = true;
+			_finished.emplace_back(animator);
+			--_activeCount;
+		}
+	}
+	_updating = false;
 
-			if (_valuePointer)
-				*_valuePointer = _value;
+	compact();
 
-			updated.invoke();
-		}
+	for (size_t i = 0; i < _finished.size(); ++i)
+	{
+		Animator<T>* animator = _finished[i];
+		if (animator == nullptr)
+			continue;
+
+		animator->_manager = nullptr;
+		animator->_finishing = false;
+		animator->finished.invoke();
 	}
+	_finished.clear();
 
-private:
-	std::function<float(float)> _timeInterpolationFunction;
-	std::function<T(const T&, const T&, float)> _valueInterpolationFunction;
+	if (_activeCount == 0)
+		TimedObject::cancelUpdates();
+}
 
-	T _from = T(0);
-	T _to = T(0);
-	T _value = T(0);
+template <typename T>
+inline void AnimationManager<T>::compact()
+{
+	uint32_t activeCount = 0;
+	for (uint32_t i = 0, e = static_cast<uint32_t>(_animators.size()); i < e; ++i)
+	{
+		if (_animators[i] == nullptr)
+			continue;
 
-	T* _valuePointer = nullptr;
+		if (i != activeCount)
+		{
+			_animators[activeCount] = _animators[i];
+			_from[activeCount] = _from[i];
+			_to[activeCount] = _to[i];
+			_values[activeCount] = _values[i];
+			_startTime[activeCount] = _startTime[i];
+			_inverseDuration[activeCount] = _inverseDuration[i];
+			_animators[activeCount]->_managerIndex = activeCount;
+		}
+		++activeCount;
+	}
 
-	float _startTime = 0.0f;
-	float _duration = 0.0f;
-};
+	_animators.resize(activeCount);
+	_from.resize(activeCount);
+	_to.resize(activeCount);
+	_values.resize(activeCount);
+	_startTime.resize(activeCount);
+	_inverseDuration.resize(activeCount);
+	_progress.resize(activeCount);
+}
 
 typedef Animator<float> FloatAnimator;
 typedef Animator<vec2> Vector2Animator;
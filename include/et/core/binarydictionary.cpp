@@ -0,0 +1,697 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <external/zlib/zlib.h>
+#include <et/core/binarydictionary.h>
+
+namespace et
+{
+namespace binary
+{
+
+namespace
+{
+
+enum ValueType : uint32_t
+{
+	ValueType_Float = 1,
+	ValueType_Integer,
+	ValueType_Boolean,
+	ValueType_String,
+	ValueType_Array,
+	ValueType_Dictionary,
+	ValueType_FloatArray,
+	ValueType_IntegerArray,
+};
+
+const uint32_t InvalidIndex = static_cast<uint32_t>(-1);
+const uint32_t MaxNestingDepth = 1024;
+
+inline uint32_t alignedSize(uint64_t size)
+{
+	return static_cast<uint32_t>((size + 3) & ~uint64_t(3));
+}
+
+class Writer
+{
+public:
+	BinaryDataStorage write(const VariantBase::Pointer& root, size_t flags)
+	{
+		StringList keys;
+		collectKeys(root, keys);
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+		_keyIndices.reserve(keys.size());
+		uint32_t keyStringsOffset = static_cast<uint32_t>(2 * sizeof(uint32_t) * keys.size());
+		uint32_t keyStringsSize = 0;
+		for (const std::string& key : keys)
+		{
+			_keyIndices.emplace(key, static_cast<uint32_t>(_keyIndices.size()));
+			keyStringsSize += static_cast<uint32_t>(key.size() + 1);
+		}
+
+		_data.reserve(keyStringsOffset + alignedSize(keyStringsSize));
+		for (const std::string& key : keys)
+		{
+			appendUInt32(keyStringsOffset);
+			appendUInt32(static_cast<uint32_t>(key.size()));
+			keyStringsOffset += static_cast<uint32_t>(key.size() + 1);
+		}
+		for (const std::string& key : keys)
+			_data.insert(_data.end(), key.c_str(), key.c_str() + key.size() + 1);
+		_data.resize(alignedSize(_data.size()));
+
+		Header header;
+		header.keysCount = static_cast<uint32_t>(keys.size());
+		header.rootOffset = writeValue(root);
+		header.bodySize = _data.size();
+
+		if (flags & SerializationFlag_Compress)
+		{
+			uLongf compressedSize = compressBound(static_cast<uLong>(_data.size()));
+			BinaryDataStorage result(sizeof(Header) + compressedSize);
+			int status = compress2(result.data() + sizeof(Header), &compressedSize, _data.data(),
+				static_cast<uLong>(_data.size()), Z_DEFAULT_COMPRESSION);
+
+			if (status == Z_OK)
+			{
+				header.flags |= Flag_Compressed;
+				header.storedSize = compressedSize;
+				result.resize(sizeof(Header) + compressedSize);
+				memcpy(result.data(), &header, sizeof(Header));
+				return result;
+			}
+			log::warning("[binary] Failed to compress data (%d), storing uncompressed", status);
+		}
+
+		header.storedSize = header.bodySize;
+		BinaryDataStorage result(sizeof(Header) + _data.size());
+		memcpy(result.data(), &header, sizeof(Header));
+		memcpy(result.data() + sizeof(Header), _data.data(), _data.size());
+		return result;
+	}
+
+private:
+	void collectKeys(const VariantBase::Pointer& value, StringList& keys)
+	{
+		if (value->variantClass() == VariantClass::Dictionary)
+		{
+			for (const auto& kv : Dictionary(value)->content)
+			{
+				keys.push_back(kv.first);
+				collectKeys(kv.second, keys);
+			}
+		}
+		else if (value->variantClass() == VariantClass::Array)
+		{
+			for (const auto& v : ArrayValue(value)->content)
+				collectKeys(v, keys);
+		}
+	}
+
+	void appendUInt32(uint32_t value)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		_data.insert(_data.end(), bytes, bytes + sizeof(value));
+	}
+
+	void append(const void* data, size_t size)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+		_data.insert(_data.end(), bytes, bytes + size);
+	}
+
+	void setUInt32(size_t offset, uint32_t value)
+	{
+		memcpy(_data.data() + offset, &value, sizeof(value));
+	}
+
+	static ValueType arrayType(const ArrayValue::ValueType& content)
+	{
+		if (content.empty())
+			return ValueType_Array;
+
+		VariantClass elementClass = content.front()->variantClass();
+		if ((elementClass != VariantClass::Float) && (elementClass != VariantClass::Integer))
+			return ValueType_Array;
+
+		for (const auto& v : content)
+		{
+			if (v->variantClass() != elementClass)
+				return ValueType_Array;
+		}
+
+		return (elementClass == VariantClass::Float) ? ValueType_FloatArray : ValueType_IntegerArray;
+	}
+
+	uint32_t writeValue(const VariantBase::Pointer& value)
+	{
+		uint32_t offset = static_cast<uint32_t>(_data.size());
+
+		switch (value->variantClass())
+		{
+		case VariantClass::Float:
+		{
+			appendUInt32(ValueType_Float);
+			append(&FloatValue(value)->content, sizeof(float));
+			break;
+		}
+
+		case VariantClass::Integer:
+		{
+			appendUInt32(ValueType_Integer);
+			append(&IntegerValue(value)->content, sizeof(int64_t));
+			break;
+		}
+
+		case VariantClass::Boolean:
+		{
+			appendUInt32(ValueType_Boolean);
+			appendUInt32(BooleanValue(value)->content ? 1 : 0);
+			break;
+		}
+
+		case VariantClass::String:
+		{
+			const std::string& content = StringValue(value)->content;
+			appendUInt32(ValueType_String);
+			appendUInt32(static_cast<uint32_t>(content.size()));
+			append(content.c_str(), content.size() + 1);
+			_data.resize(alignedSize(_data.size()));
+			break;
+		}
+
+		case VariantClass::Array:
+		{
+			writeArray(ArrayValue(value)->content);
+			break;
+		}
+
+		case VariantClass::Dictionary:
+		{
+			writeDictionary(Dictionary(value)->content);
+			break;
+		}
+
+		default:
+			ET_FAIL_FMT("Unsupported variant class: %d", static_cast<int>(value->variantClass()));
+		}
+
+		return offset;
+	}
+
+	void writeArray(const ArrayValue::ValueType& content)
+	{
+		ValueType type = arrayType(content);
+		appendUInt32(type);
+		appendUInt32(static_cast<uint32_t>(content.size()));
+
+		if (type == ValueType_FloatArray)
+		{
+			for (const auto& v : content)
+				append(&FloatValue(v)->content, sizeof(float));
+		}
+		else if (type == ValueType_IntegerArray)
+		{
+			for (const auto& v : content)
+				append(&IntegerValue(v)->content, sizeof(int64_t));
+		}
+		else
+		{
+			size_t table = _data.size();
+			_data.resize(table + sizeof(uint32_t) * content.size());
+			for (size_t i = 0, e = content.size(); i < e; ++i)
+				setUInt32(table + sizeof(uint32_t) * i, writeValue(content[i]));
+		}
+	}
+
+	void writeDictionary(const Dictionary::ValueType& content)
+	{
+		Vector<std::pair<uint32_t, const VariantBase::Pointer*>> members;
+		members.reserve(content.size());
+		for (const auto& kv : content)
+			members.emplace_back(_keyIndices.at(kv.first), &kv.second);
+
+		std::sort(members.begin(), members.end(),
+			[](const std::pair<uint32_t, const VariantBase::Pointer*>& l, const std::pair<uint32_t, const VariantBase::Pointer*>& r)
+			{ return l.first < r.first; });
+
+		appendUInt32(ValueType_Dictionary);
+		appendUInt32(static_cast<uint32_t>(members.size()));
+
+		size_t table = _data.size();
+		_data.resize(table + 2 * sizeof(uint32_t) * members.size());
+		for (size_t i = 0, e = members.size(); i < e; ++i)
+		{
+			setUInt32(table + 2 * sizeof(uint32_t) * i, members[i].first);
+			setUInt32(table + 2 * sizeof(uint32_t) * i + sizeof(uint32_t), writeValue(*members[i].second));
+		}
+	}
+
+private:
+	Vector<uint8_t> _data;
+	UnorderedMap<std::string, uint32_t> _keyIndices;
+};
+
+VariantBase::Pointer convertValue(const Document::Value& value, uint32_t depth)
+{
+	if (depth > MaxNestingDepth)
+		return VariantBase::Pointer();
+
+	switch (value.variantClass())
+	{
+	case VariantClass::Float:
+		return FloatValue(value.floatValue());
+
+	case VariantClass::Integer:
+		return IntegerValue(value.integerValue());
+
+	case VariantClass::Boolean:
+		return BooleanValue(value.boolValue() ? 1 : 0);
+
+	case VariantClass::String:
+	{
+		const char* string = value.stringValue();
+		if (string == nullptr)
+			return VariantBase::Pointer();
+
+		return StringValue(std::string(string, value.size()));
+	}
+
+	case VariantClass::Array:
+	{
+		ArrayValue result;
+		uint32_t size = value.size();
+		result->content.reserve(size);
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			VariantBase::Pointer element = convertValue(value.at(i), depth + 1);
+			if (element.invalid())
+				return element;
+
+			result->content.emplace_back(element);
+		}
+		return result;
+	}
+
+	case VariantClass::Dictionary:
+	{
+		Dictionary result;
+		uint32_t size = value.size();
+		result->content.reserve(size);
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			const char* key = value.keyAt(i);
+			VariantBase::Pointer member = convertValue(value.valueAt(i), depth + 1);
+			if ((key == nullptr) || member.invalid())
+				return VariantBase::Pointer();
+
+			result->content.emplace(key, member);
+		}
+		return result;
+	}
+
+	default:
+		return VariantBase::Pointer();
+	}
+}
+
+}
+
+BinaryDataStorage serialize(const Dictionary& value, size_t flags)
+{
+	Writer writer;
+	return writer.write(value, flags);
+}
+
+BinaryDataStorage serialize(const ArrayValue& value, size_t flags)
+{
+	Writer writer;
+	return writer.write(value, flags);
+}
+
+VariantBase::Pointer deserialize(const uint8_t* data, size_t size, VariantClass& c, bool printErrors)
+{
+	c = VariantClass::Invalid;
+
+	Document document;
+	if (!document.open(data, size))
+	{
+		if (printErrors)
+			log::error("[binary] Invalid or corrupted data");
+		return Dictionary();
+	}
+
+	VariantBase::Pointer result = convertValue(document.root(), 0);
+	if (result.invalid())
+	{
+		if (printErrors)
+			log::error("[binary] Corrupted data");
+		return Dictionary();
+	}
+
+	c = result->variantClass();
+	return result;
+}
+
+VariantBase::Pointer deserialize(const BinaryDataStorage& data, VariantClass& c, bool printErrors)
+{
+	return deserialize(data.data(), static_cast<size_t>(data.size()), c, printErrors);
+}
+
+/*
+ * Document
+ */
+bool Document::open(const std::string& fileName)
+{
+	close();
+
+	if (!_file.open(fileName))
+		return false;
+
+	if (!open(_file.data(), static_cast<size_t>(_file.size())))
+		return false;
+
+	if (!_inflated.empty())
+		_file.close();
+
+	return true;
+}
+
+bool Document::open(const uint8_t* data, size_t size)
+{
+	_inflated.clear();
+	_body = nullptr;
+	_bodySize = 0;
+
+	Header header;
+	if ((data == nullptr) || (size < sizeof(Header)))
+		return false;
+
+	memcpy(&header, data, sizeof(Header));
+	if ((header.magic != FileMagic) || (header.version != FileVersion) || (header.storedSize > size - sizeof(Header)))
+		return false;
+
+	const uint8_t* body = data + sizeof(Header);
+	if (header.flags & Flag_Compressed)
+	{
+		/*
+		 * deflate can not compress better than ~1032:1
+		 */
+		const uint64_t maxCompressionRatio = 1032;
+		if ((header.bodySize > std::numeric_limits<uLongf>::max()) || (header.bodySize > header.storedSize * maxCompressionRatio))
+			return false;
+
+		_inflated.resize(static_cast<size_t>(header.bodySize));
+		uLongf inflatedSize = static_cast<uLongf>(header.bodySize);
+		int status = uncompress(_inflated.data(), &inflatedSize, body, static_cast<uLong>(header.storedSize));
+		if ((status != Z_OK) || (inflatedSize != header.bodySize))
+		{
+			_inflated.clear();
+			return false;
+		}
+		body = _inflated.data();
+	}
+	else if (header.bodySize != header.storedSize)
+	{
+		return false;
+	}
+
+	_body = body;
+	_bodySize = header.bodySize;
+	_keysCount = header.keysCount;
+	_rootOffset = header.rootOffset;
+
+	if (!contains(0, 2 * sizeof(uint32_t) * static_cast<uint64_t>(_keysCount)) || (valueType(_rootOffset) == 0))
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void Document::close()
+{
+	_file.close();
+	_inflated.clear();
+	_body = nullptr;
+	_bodySize = 0;
+	_keysCount = 0;
+	_rootOffset = 0;
+}
+
+Document::Value Document::root() const
+{
+	return valid() ? Value(this, _rootOffset, InvalidIndex) : Value();
+}
+
+uint32_t Document::readUInt32(uint64_t offset) const
+{
+	uint32_t result = 0;
+	if (contains(offset, sizeof(result)))
+		memcpy(&result, _body + offset, sizeof(result));
+	return result;
+}
+
+uint32_t Document::valueType(uint32_t offset) const
+{
+	uint32_t type = ((offset & 3) == 0) ? readUInt32(offset) : 0;
+	return ((type >= ValueType_Float) && (type <= ValueType_IntegerArray)) ? type : 0;
+}
+
+const char* Document::key(uint32_t index, uint32_t& length) const
+{
+	if (index >= _keysCount)
+		return nullptr;
+
+	uint32_t offset = readUInt32(2 * sizeof(uint32_t) * index);
+	length = readUInt32(2 * sizeof(uint32_t) * index + sizeof(uint32_t));
+	if (!contains(offset, static_cast<uint64_t>(length) + 1) || (_body[offset + length] != 0))
+		return nullptr;
+
+	return reinterpret_cast<const char*>(_body + offset);
+}
+
+uint32_t Document::findKey(const std::string& k) const
+{
+	uint32_t first = 0;
+	uint32_t last = _keysCount;
+	while (first < last)
+	{
+		uint32_t middle = first + (last - first) / 2;
+
+		uint32_t length = 0;
+		const char* middleKey = key(middle, length);
+		if (middleKey == nullptr)
+			return InvalidIndex;
+
+		int result = memcmp(middleKey, k.data(), std::min<size_t>(length, k.size()));
+		if (result == 0)
+		{
+			if (length == k.size())
+				return middle;
+
+			result = (length < k.size()) ? -1 : 1;
+		}
+
+		if (result < 0)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+	return InvalidIndex;
+}
+
+/*
+ * Document::Value
+ */
+Document::Value::Value(const Document* document, uint32_t offset, uint32_t element) :
+	_document(document), _offset(offset), _element(element)
+{
+}
+
+VariantClass Document::Value::variantClass() const
+{
+	if (_document == nullptr)
+		return VariantClass::Invalid;
+
+	uint32_t type = _document->valueType(_offset);
+	if (_element != InvalidIndex)
+		return (type == ValueType_FloatArray) ? VariantClass::Float : VariantClass::Integer;
+
+	switch (type)
+	{
+	case ValueType_Float:
+		return VariantClass::Float;
+	case ValueType_Integer:
+		return VariantClass::Integer;
+	case ValueType_Boolean:
+		return VariantClass::Boolean;
+	case ValueType_String:
+		return VariantClass::String;
+	case ValueType_Array:
+	case ValueType_FloatArray:
+	case ValueType_IntegerArray:
+		return VariantClass::Array;
+	case ValueType_Dictionary:
+		return VariantClass::Dictionary;
+	default:
+		return VariantClass::Invalid;
+	}
+}
+
+uint32_t Document::Value::size() const
+{
+	if ((_document == nullptr) || (_element != InvalidIndex))
+		return 0;
+
+	uint32_t type = _document->valueType(_offset);
+	if ((type != ValueType_String) && (type != ValueType_Array) && (type != ValueType_Dictionary) &&
+		(type != ValueType_FloatArray) && (type != ValueType_IntegerArray))
+	{
+		return 0;
+	}
+
+	uint64_t elementSize = sizeof(uint32_t);
+	if (type == ValueType_String)
+		elementSize = 1;
+	else if ((type == ValueType_Dictionary) || (type == ValueType_IntegerArray))
+		elementSize = 2 * sizeof(uint32_t);
+
+	/*
+	 * size is validated against the data, so accessors below only check the element offsets
+	 */
+	uint32_t count = _document->readUInt32(_offset + sizeof(uint32_t));
+	return _document->contains(_offset + 2 * sizeof(uint32_t), elementSize * count + ((type == ValueType_String) ? 1 : 0)) ? count : 0;
+}
+
+Document::Value Document::Value::at(uint32_t index) const
+{
+	if (index >= size())
+		return Value();
+
+	uint32_t type = _document->valueType(_offset);
+	if ((type == ValueType_FloatArray) || (type == ValueType_IntegerArray))
+		return Value(_document, _offset, index);
+
+	if (type != ValueType_Array)
+		return Value();
+
+	uint32_t elementOffset = _document->readUInt32(_offset + 2 * sizeof(uint32_t) + sizeof(uint32_t) * static_cast<uint64_t>(index));
+	return (_document->valueType(elementOffset) == 0) ? Value() : Value(_document, elementOffset, InvalidIndex);
+}
+
+Document::Value Document::Value::find(const std::string& key) const
+{
+	uint32_t count = size();
+	if ((count == 0) || (_document->valueType(_offset) != ValueType_Dictionary))
+		return Value();
+
+	uint32_t keyIndex = _document->findKey(key);
+	if (keyIndex == InvalidIndex)
+		return Value();
+
+	uint32_t first = 0;
+	uint32_t last = count;
+	while (first < last)
+	{
+		uint32_t middle = first + (last - first) / 2;
+		uint32_t middleKey = _document->readUInt32(_offset + 2 * sizeof(uint32_t) + 2 * sizeof(uint32_t) * static_cast<uint64_t>(middle));
+		if (middleKey == keyIndex)
+			return valueAt(middle);
+
+		if (middleKey < keyIndex)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+	return Value();
+}
+
+const char* Document::Value::keyAt(uint32_t index) const
+{
+	if ((index >= size()) || (_document->valueType(_offset) != ValueType_Dictionary))
+		return nullptr;
+
+	uint32_t length = 0;
+	uint32_t keyIndex = _document->readUInt32(_offset + 2 * sizeof(uint32_t) + 2 * sizeof(uint32_t) * static_cast<uint64_t>(index));
+	return _document->key(keyIndex, length);
+}
+
+Document::Value Document::Value::valueAt(uint32_t index) const
+{
+	if ((index >= size()) || (_document->valueType(_offset) != ValueType_Dictionary))
+		return Value();
+
+	uint32_t valueOffset = _document->readUInt32(_offset + 3 * sizeof(uint32_t) + 2 * sizeof(uint32_t) * static_cast<uint64_t>(index));
+	return (_document->valueType(valueOffset) == 0) ? Value() : Value(_document, valueOffset, InvalidIndex);
+}
+
+float Document::Value::floatValue(float def) const
+{
+	VariantClass c = variantClass();
+	if (c == VariantClass::Integer)
+		return static_cast<float>(integerValue());
+
+	if (c != VariantClass::Float)
+		return def;
+
+	uint64_t offset = (_element == InvalidIndex) ? (_offset + sizeof(uint32_t)) :
+		(_offset + 2 * sizeof(uint32_t) + sizeof(float) * static_cast<uint64_t>(_element));
+
+	float result = def;
+	if (_document->contains(offset, sizeof(result)))
+		memcpy(&result, _document->_body + offset, sizeof(result));
+	return result;
+}
+
+int64_t Document::Value::integerValue(int64_t def) const
+{
+	if (variantClass() != VariantClass::Integer)
+		return def;
+
+	uint64_t offset = (_element == InvalidIndex) ? (_offset + sizeof(uint32_t)) :
+		(_offset + 2 * sizeof(uint32_t) + sizeof(int64_t) * static_cast<uint64_t>(_element));
+
+	int64_t result = def;
+	if (_document->contains(offset, sizeof(result)))
+		memcpy(&result, _document->_body + offset, sizeof(result));
+	return result;
+}
+
+bool Document::Value::boolValue(bool def) const
+{
+	return (variantClass() == VariantClass::Boolean) ? (_document->readUInt32(_offset + sizeof(uint32_t)) != 0) : def;
+}
+
+const char* Document::Value::stringValue() const
+{
+	if (variantClass() != VariantClass::String)
+		return nullptr;
+
+	uint32_t length = size();
+	const char* result = reinterpret_cast<const char*>(_document->_body + _offset + 2 * sizeof(uint32_t));
+	return ((length > 0) || _document->contains(_offset + 2 * sizeof(uint32_t), 1)) && (result[length] == 0) ? result : nullptr;
+}
+
+const float* Document::Value::floats() const
+{
+	if ((_element != InvalidIndex) || (_document == nullptr) || (_document->valueType(_offset) != ValueType_FloatArray) || (size() == 0))
+		return nullptr;
+
+	return reinterpret_cast<const float*>(_document->_body + _offset + 2 * sizeof(uint32_t));
+}
+
+VariantBase::Pointer Document::Value::toVariant() const
+{
+	return convertValue(*this, 0);
+}
+
+}
+}
@@ -0,0 +1,156 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/containers.h>
+#include <et/core/mappedfile.h>
+
+namespace et
+{
+namespace binary
+{
+
+/*
+ * Binary encoding of Dictionary / ArrayValue trees.
+ *
+ * Layout: Header, then body (deflated with zlib if Flag_Compressed is set):
+ *   key table - keysCount pairs of (offset, length), keys are sorted and null-terminated
+ *   values - 4-byte aligned, each starts with uint32 type:
+ *     Float: float
+ *     Integer: int64
+ *     Boolean: uint32
+ *     String: uint32 length, characters, terminating zero
+ *     Array: uint32 count, offsets of elements, elements
+ *     Dictionary: uint32 count, (key index, offset of value) pairs sorted by key index, values
+ *     FloatArray / IntegerArray: uint32 count, values (arrays of numbers only, e.g. vectors and matrix rows)
+ * All offsets are relative to the beginning of the body.
+ */
+enum : uint32_t
+{
+	FileMagic = ET_COMPOSE_UINT32('E', 'T', 'B', 'D'),
+	FileVersion = 1,
+	Flag_Compressed = 0x01,
+};
+
+struct Header
+{
+	uint32_t magic = FileMagic;
+	uint32_t version = FileVersion;
+	uint32_t flags = 0;
+	uint32_t keysCount = 0;
+	uint32_t rootOffset = 0;
+	uint32_t reserved = 0;
+	uint64_t bodySize = 0;
+	uint64_t storedSize = 0;
+};
+
+enum SerializationFlags
+{
+	SerializationFlag_Compress = 0x01
+};
+
+BinaryDataStorage serialize(const Dictionary&, size_t = 0);
+BinaryDataStorage serialize(const ArrayValue&, size_t = 0);
+
+et::VariantBase::Pointer deserialize(const uint8_t*, size_t, et::VariantClass&, bool printErrors = true);
+et::VariantBase::Pointer deserialize(const BinaryDataStorage&, et::VariantClass&, bool printErrors = true);
+
+/*
+ * Lazy read-only access to the encoded data: nothing is converted until requested,
+ * uncompressed files are memory mapped, so opening does not depend on the file size.
+ */
+class Document
+{
+public:
+	class Value
+	{
+	public:
+		Value() = default;
+
+		bool valid() const
+			{ return _document != nullptr; }
+
+		/*
+		 * typed numeric arrays are reported as Array
+		 */
+		VariantClass variantClass() const;
+
+		/*
+		 * number of elements of the array, members of the dictionary, length of the string
+		 */
+		uint32_t size() const;
+
+		Value at(uint32_t index) const;
+		Value find(const std::string& key) const;
+
+		Value operator [] (const std::string& key) const
+			{ return find(key); }
+
+		/*
+		 * Dictionary members, in order of keys
+		 */
+		const char* keyAt(uint32_t index) const;
+		Value valueAt(uint32_t index) const;
+
+		float floatValue(float def = 0.0f) const;
+		int64_t integerValue(int64_t def = 0) const;
+		bool boolValue(bool def = false) const;
+		const char* stringValue() const;
+
+		/*
+		 * Contents of the float array, nullptr for other values
+		 */
+		const float* floats() const;
+
+		VariantBase::Pointer toVariant() const;
+
+	private:
+		friend class Document;
+
+		Value(const Document* document, uint32_t offset, uint32_t element);
+
+	private:
+		const Document* _document = nullptr;
+		uint32_t _offset = 0;
+		uint32_t _element = 0;
+	};
+
+public:
+	bool open(const std::string& fileName);
+
+	/*
+	 * Data should be valid while document is used, unless it is compressed
+	 */
+	bool open(const uint8_t* data, size_t size);
+	void close();
+
+	bool valid() const
+		{ return _body != nullptr; }
+
+	Value root() const;
+
+private:
+	bool contains(uint64_t offset, uint64_t size) const
+		{ return (offset <= _bodySize) && (size <= _bodySize - offset); }
+
+	uint32_t readUInt32(uint64_t offset) const;
+	uint32_t valueType(uint32_t offset) const;
+	const char* key(uint32_t index, uint32_t& length) const;
+	uint32_t findKey(const std::string& key) const;
+
+private:
+	MappedFile _file;
+	Vector<uint8_t> _inflated;
+	const uint8_t* _body = nullptr;
+	uint64_t _bodySize = 0;
+	uint32_t _keysCount = 0;
+	uint32_t _rootOffset = 0;
+};
+
+}
+}
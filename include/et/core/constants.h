@@ -112,6 +112,44 @@
 #	define ET_KEY_F8					119
 #	define ET_KEY_F9					120
 #
+#elif (ET_PLATFORM_LINUX)
+#
+#	define ET_KEY_RETURN				0xFF0D
+#	define ET_KEY_TAB					0xFF09
+#	define ET_KEY_SPACE					0x20
+#	define ET_KEY_ESCAPE				0xFF1B
+#	define ET_KEY_BACKSPACE				0xFF08
+#	define ET_KEY_SHIFT					0xFFE1
+#	define ET_KEY_CONTROL				0xFFE3
+#
+#	define ET_KEY_LEFT					0xFF51
+#	define ET_KEY_RIGHT					0xFF53
+#	define ET_KEY_DOWN					0xFF54
+#	define ET_KEY_UP					0xFF52
+#
+#	define ET_KEY_A						'a'
+#	define ET_KEY_S						's'
+#	define ET_KEY_D						'd'
+#	define ET_KEY_W						'w'
+#	define ET_KEY_H						'h'
+#	define ET_KEY_1						'1'
+#	define ET_KEY_2						'2'
+#	define ET_KEY_3						'3'
+#	define ET_KEY_4						'4'
+#	define ET_KEY_GRAY_PLUS				0xFFAB
+#	define ET_KEY_GRAY_MINUS			0xFFAD
+#	define ET_KEY_GRAY_MULTIPLY			0xFFAA
+#	define ET_KEY_GRAY_DIVIDE			0xFFAF
+#	define ET_KEY_F1					0xFFBE
+#	define ET_KEY_F2					0xFFBF
+#	define ET_KEY_F3					0xFFC0
+#	define ET_KEY_F4					0xFFC1
+#	define ET_KEY_F5					0xFFC2
+#	define ET_KEY_F6					0xFFC3
+#	define ET_KEY_F7					0xFFC4
+#	define ET_KEY_F8					0xFFC5
+#	define ET_KEY_F9					0xFFC6
+#
 #endif
 
 #define ET_DEFAULT_DELIMITER			';'
@@ -23,12 +23,14 @@ namespace et
 		return buffer;
 	}
 
+#if !(ET_PLATFORM_LINUX) // unsigned long is uint64_t there
 	inline std::string intToStr(unsigned long value)
 	{
 		char buffer[32] = { };
 		sprintf(buffer, "%lu", value);
 		return buffer;
 	}
+#endif
 	
 	inline std::string intToStr(unsigned int value)
 	{
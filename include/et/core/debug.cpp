@@ -7,7 +7,7 @@
 
 #if (ET_PLATFORM_WIN)
 #   include <Windows.h>
-#elif (ET_PLATFORM_MAC)
+#elif (ET_PLATFORM_MAC || ET_PLATFORM_LINUX)
 #	include <signal.h>
 #endif
 
@@ -22,6 +22,8 @@ void debugBreak()
 	::DebugBreak();
 #elif (ET_PLATFORM_MAC)
 	__asm { int 3 };
+#elif (ET_PLATFORM_LINUX)
+	raise(SIGTRAP);
 #else
 #	error Define breakpoint for current platform
 #endif
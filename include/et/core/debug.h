@@ -44,6 +44,19 @@
 #	define ET_FORMAT_FUNCTION_IN_CLASS		__attribute__((format(printf, 2, 3)))
 #	define ET_ALIGNED(A)					__attribute__((aligned(A)))
 #
+#elif (ET_PLATFORM_LINUX)
+#
+#	define ET_CALL_FUNCTION					__PRETTY_FUNCTION__
+#
+#	define ET_SUPPORT_RANGE_BASED_FOR		1
+#	define ET_SUPPORT_INITIALIZER_LIST		1
+#	define ET_SUPPORT_VARIADIC_TEMPLATES	1
+#
+#	define ET_DEPRECATED					__attribute__((deprecated))
+#	define ET_FORMAT_FUNCTION				__attribute__((format(printf, 1, 2)))
+#	define ET_FORMAT_FUNCTION_IN_CLASS		__attribute__((format(printf, 2, 3)))
+#	define ET_ALIGNED(A)					__attribute__((aligned(A)))
+#
 #else
 #
 #	error Platform is not defined
@@ -119,6 +119,11 @@ C* etCreateObject(args&&... a) {
 	return sharedObjectFactory().createObject<C>(std::forward<args>(a)...);
 }
 
+template <class C, typename ... args>
+C* etCreateTaggedObject(MemoryTag tag, args&&... a) {
+	return sharedObjectFactory().createTaggedObject<C>(tag, std::forward<args>(a)...);
+}
+
 template <class C>
 void etDestroyObject(C* c) {
 	sharedObjectFactory().deleteObject(c);
@@ -0,0 +1,196 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/filewatcher.h>
+
+#if (ET_PLATFORM_LINUX)
+#	define ET_FILE_WATCHER_INOTIFY	1
+#	include <sys/inotify.h>
+#	include <unistd.h>
+#	include <errno.h>
+#else
+#	define ET_FILE_WATCHER_INOTIFY	0
+#endif
+
+namespace et {
+
+FileWatcher::FileWatcher() {
+#if (ET_FILE_WATCHER_INOTIFY)
+	_notifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_notifyHandle < 0)
+		log::warning("[FileWatcher] inotify is not available, falling back to polling");
+	else
+		_eventsBuffer.resize(64 * 1024);
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+	clear();
+
+#if (ET_FILE_WATCHER_INOTIFY)
+	if (_notifyHandle >= 0)
+		::close(_notifyHandle);
+#endif
+}
+
+void FileWatcher::watch(const std::string& fileName) {
+	CriticalSectionScope lock(_lock);
+	WatchedFile& file = _files[fileName];
+	if (file.references++ > 0)
+		return;
+
+	if (eventDriven())
+		watchDirectory(getFilePath(fileName));
+	else
+		file.identifier = getFileUniqueIdentifier(fileName);
+}
+
+void FileWatcher::unwatch(const std::string& fileName) {
+	CriticalSectionScope lock(_lock);
+	auto i = _files.find(fileName);
+	if ((i == _files.end()) || (--i->second.references > 0))
+		return;
+
+	_files.erase(i);
+
+	if (eventDriven())
+		unwatchDirectory(getFilePath(fileName));
+}
+
+void FileWatcher::clear() {
+	CriticalSectionScope lock(_lock);
+#if (ET_FILE_WATCHER_INOTIFY)
+	for (const auto& dir : _directories)
+	{
+		if (dir.second.handle >= 0)
+			inotify_rm_watch(_notifyHandle, dir.second.handle);
+	}
+#endif
+	_files.clear();
+	_directories.clear();
+	_directoryHandles.clear();
+}
+
+void FileWatcher::watchDirectory(const std::string& path) {
+	WatchedDirectory& dir = _directories[path];
+	if (dir.references++ > 0)
+		return;
+
+#if (ET_FILE_WATCHER_INOTIFY)
+	const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB;
+	dir.handle = inotify_add_watch(_notifyHandle, path.empty() ? "." : path.c_str(), mask);
+	if (dir.handle >= 0)
+		_directoryHandles[dir.handle] = path;
+	else
+		log::warning("[FileWatcher] Unable to watch directory %s", path.c_str());
+#endif
+}
+
+void FileWatcher::unwatchDirectory(const std::string& path) {
+	auto i = _directories.find(path);
+	if ((i == _directories.end()) || (--i->second.references > 0))
+		return;
+
+#if (ET_FILE_WATCHER_INOTIFY)
+	if (i->second.handle >= 0)
+	{
+		inotify_rm_watch(_notifyHandle, i->second.handle);
+		_directoryHandles.erase(i->second.handle);
+	}
+#endif
+	_directories.erase(i);
+}
+
+void FileWatcher::poll(Vector<std::string>& changedFiles) {
+	if (!eventDriven())
+	{
+		pollIdentifiers(changedFiles);
+		return;
+	}
+
+#if (ET_FILE_WATCHER_INOTIFY)
+	CriticalSectionScope lock(_lock);
+	size_t firstChanged = changedFiles.size();
+	for (;;)
+	{
+		ssize_t bytesRead = read(_notifyHandle, _eventsBuffer.data(), _eventsBuffer.size());
+		if (bytesRead <= 0)
+		{
+			if ((bytesRead < 0) && (errno != EAGAIN) && (errno != EINTR))
+				log::warning("[FileWatcher] Failed to read file events: %d", errno);
+			break;
+		}
+
+		for (ssize_t offset = 0; offset < bytesRead; )
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(_eventsBuffer.data() + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				for (const auto& file : _files)
+					changedFiles.push_back(file.first);
+				continue;
+			}
+
+			if (event->len == 0)
+				continue;
+
+			auto dir = _directoryHandles.find(event->wd);
+			if (dir == _directoryHandles.end())
+				continue;
+
+			std::string fileName = dir->second + event->name;
+			if (_files.count(fileName) > 0)
+				changedFiles.push_back(fileName);
+		}
+	}
+
+	/*
+	 * several events are usually generated for one save
+	 */
+	std::sort(changedFiles.begin() + firstChanged, changedFiles.end());
+	changedFiles.erase(std::unique(changedFiles.begin() + firstChanged, changedFiles.end()), changedFiles.end());
+#endif
+}
+
+void FileWatcher::pollIdentifiers(Vector<std::string>& changedFiles) {
+	/*
+	 * files are queried from a snapshot, so watch / unwatch are not blocked by file system calls
+	 */
+	Vector<std::pair<std::string, uint64_t>> files;
+	{
+		CriticalSectionScope lock(_lock);
+		files.reserve(_files.size());
+		for (const auto& file : _files)
+			files.emplace_back(file.first, file.second.identifier);
+	}
+
+	size_t firstChanged = changedFiles.size();
+	for (auto& file : files)
+	{
+		uint64_t identifier = getFileUniqueIdentifier(file.first);
+		if (identifier != file.second)
+		{
+			file.second = identifier;
+			changedFiles.push_back(file.first);
+		}
+	}
+
+	if (changedFiles.size() == firstChanged)
+		return;
+
+	CriticalSectionScope lock(_lock);
+	for (const auto& file : files)
+	{
+		auto i = _files.find(file.first);
+		if (i != _files.end())
+			i->second.identifier = file.second;
+	}
+}
+
+}
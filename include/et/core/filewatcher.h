@@ -0,0 +1,77 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/et.h>
+#include <et/core/criticalsection.h>
+
+namespace et {
+
+/*
+ * Reports changes of the watched files.
+ * On Linux directories of the files are watched with inotify (so files replaced by rename are reported too),
+ * on other platforms or if inotify is not available identifiers of all watched files are compared on each poll.
+ *
+ * Thread-safe, file identifiers are queried outside of the internal lock.
+ */
+class FileWatcher
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	/*
+	 * Files are reference counted, each watch should be balanced with unwatch
+	 */
+	void watch(const std::string& fileName);
+	void unwatch(const std::string& fileName);
+	void clear();
+
+	/*
+	 * Appends files changed since the previous poll, does not block
+	 */
+	void poll(Vector<std::string>& changedFiles);
+
+	bool eventDriven() const {
+		return _notifyHandle >= 0;
+	}
+
+	uint32_t watchedFilesCount() const {
+		CriticalSectionScope lock(_lock);
+		return static_cast<uint32_t>(_files.size());
+	}
+
+private:
+	ET_DENY_COPY(FileWatcher);
+
+	struct WatchedFile
+	{
+		uint64_t identifier = 0;
+		uint32_t references = 0;
+	};
+
+	struct WatchedDirectory
+	{
+		int handle = -1;
+		uint32_t references = 0;
+	};
+
+	void watchDirectory(const std::string&);
+	void unwatchDirectory(const std::string&);
+	void pollIdentifiers(Vector<std::string>& changedFiles);
+
+private:
+	mutable CriticalSection _lock;
+	UnorderedMap<std::string, WatchedFile> _files;
+	UnorderedMap<std::string, WatchedDirectory> _directories;
+	UnorderedMap<int, std::string> _directoryHandles;
+	Vector<char> _eventsBuffer;
+	int _notifyHandle = -1;
+};
+
+}
@@ -0,0 +1,267 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/et.h>
+
+namespace et
+{
+	/*
+	 * Type-erased callable with void result.
+	 * Method pointers and small functors are stored inline, larger ones are created using object factory.
+	 * Calling delegate is a single call through function pointer, no virtual dispatch involved.
+	 */
+	template <typename... Args>
+	class InlineDelegate
+	{
+	public:
+		enum : size_t
+		{
+			InlineStorageSize = 6 * sizeof(void*)
+		};
+
+	public:
+		InlineDelegate() = default;
+
+		template <typename F, typename = typename std::enable_if<
+			!std::is_same<typename std::decay<F>::type, InlineDelegate>::value>::type>
+		InlineDelegate(F&& func)
+		{
+			assign(std::forward<F>(func));
+		}
+
+		template <typename R, typename ReturnType, typename... MethodArgs>
+		InlineDelegate(R* object, ReturnType(R::*method)(MethodArgs...))
+		{
+			assign(MethodCall<R, ReturnType(R::*)(MethodArgs...)>(object, method));
+		}
+
+		InlineDelegate(const InlineDelegate& r)
+		{
+			copyFrom(r);
+		}
+
+		InlineDelegate(InlineDelegate&& r) noexcept
+		{
+			moveFrom(r);
+		}
+
+		~InlineDelegate()
+		{
+			reset();
+		}
+
+		InlineDelegate& operator = (const InlineDelegate& r)
+		{
+			if (this != &r)
+			{
+				reset();
+				copyFrom(r);
+			}
+			return *this;
+		}
+
+		InlineDelegate& operator = (InlineDelegate&& r) noexcept
+		{
+			if (this != &r)
+			{
+				reset();
+				moveFrom(r);
+			}
+			return *this;
+		}
+
+		void operator () (Args... args) const
+		{
+			ET_ASSERT(_invoke != nullptr);
+			_invoke(const_cast<Storage*>(&_storage), std::forward<Args>(args)...);
+		}
+
+		bool valid() const
+		{
+			return _invoke != nullptr;
+		}
+
+		/*
+		 * Returns stored functor if it has type F, nullptr otherwise
+		 */
+		template <typename F>
+		F* target()
+		{
+			if (_invoke == &InlineCallable<F>::invoke)
+				return reinterpret_cast<F*>(&_storage);
+
+			if (_invoke == &HeapCallable<F>::invoke)
+				return *reinterpret_cast<F**>(&_storage);
+
+			return nullptr;
+		}
+
+		void reset()
+		{
+			if (_manage != nullptr)
+				_manage(Operation::Destroy, &_storage, nullptr);
+
+			_invoke = nullptr;
+			_manage = nullptr;
+		}
+
+	private:
+		enum class Operation : uint32_t
+		{
+			Copy,
+			Move,
+			Destroy
+		};
+
+		using Storage = typename std::aligned_storage<InlineStorageSize, alignof(std::max_align_t)>::type;
+		using InvokeFunction = void(*)(void*, Args&&...);
+		using ManageFunction = void(*)(Operation, void*, void*);
+
+		template <typename R, typename M>
+		struct MethodCall
+		{
+			R* object = nullptr;
+			M method = nullptr;
+
+			MethodCall(R* o, M m) :
+				object(o), method(m) { }
+
+			void operator () (Args... args) const
+			{
+				(object->*method)(std::forward<Args>(args)...);
+			}
+		};
+
+		/*
+		 * Trivial functors (method calls, lambdas capturing pointers and PODs)
+		 * are copied together with storage and don't need manage function
+		 */
+		template <typename F>
+		struct InlineCallable
+		{
+			template <typename T>
+			static void construct(void* storage, T&& func)
+			{
+				new (storage) F(std::forward<T>(func));
+			}
+
+			static void invoke(void* storage, Args&&... args)
+			{
+				(*reinterpret_cast<F*>(storage))(std::forward<Args>(args)...);
+			}
+
+			static void manage(Operation op, void* dst, void* src)
+			{
+				switch (op)
+				{
+				case Operation::Copy:
+					new (dst) F(*reinterpret_cast<const F*>(src));
+					break;
+
+				case Operation::Move:
+					new (dst) F(std::move(*reinterpret_cast<F*>(src)));
+					reinterpret_cast<F*>(src)->~F();
+					break;
+
+				case Operation::Destroy:
+					reinterpret_cast<F*>(dst)->~F();
+					break;
+				}
+			}
+
+			static ManageFunction manageFunction()
+			{
+				return (std::is_trivially_copyable<F>::value && std::is_trivially_destructible<F>::value) ? nullptr : &manage;
+			}
+		};
+
+		template <typename F>
+		struct HeapCallable
+		{
+			template <typename T>
+			static void construct(void* storage, T&& func)
+			{
+				*reinterpret_cast<F**>(storage) = etCreateObject<F>(std::forward<T>(func));
+			}
+
+			static void invoke(void* storage, Args&&... args)
+			{
+				(**reinterpret_cast<F**>(storage))(std::forward<Args>(args)...);
+			}
+
+			static void manage(Operation op, void* dst, void* src)
+			{
+				switch (op)
+				{
+				case Operation::Copy:
+					*reinterpret_cast<F**>(dst) = etCreateObject<F>(**reinterpret_cast<F**>(src));
+					break;
+
+				case Operation::Move:
+					*reinterpret_cast<F**>(dst) = *reinterpret_cast<F**>(src);
+					break;
+
+				case Operation::Destroy:
+					etDestroyObject(*reinterpret_cast<F**>(dst));
+					break;
+				}
+			}
+
+			static ManageFunction manageFunction()
+			{
+				return &manage;
+			}
+		};
+
+		template <typename F>
+		struct StoredInline : std::integral_constant<bool, (sizeof(F) <= InlineStorageSize) &&
+			(alignof(F) <= alignof(Storage)) && std::is_nothrow_move_constructible<F>::value> { };
+
+		template <typename F>
+		void assign(F&& func)
+		{
+			using Callable = typename std::decay<F>::type;
+			using Holder = typename std::conditional<StoredInline<Callable>::value,
+				InlineCallable<Callable>, HeapCallable<Callable>>::type;
+
+			Holder::construct(&_storage, std::forward<F>(func));
+			_invoke = &Holder::invoke;
+			_manage = Holder::manageFunction();
+		}
+
+		void copyFrom(const InlineDelegate& r)
+		{
+			if (r._manage == nullptr)
+				_storage = r._storage;
+			else
+				r._manage(Operation::Copy, &_storage, const_cast<Storage*>(&r._storage));
+
+			_invoke = r._invoke;
+			_manage = r._manage;
+		}
+
+		void moveFrom(InlineDelegate& r)
+		{
+			if (r._manage == nullptr)
+				_storage = r._storage;
+			else
+				r._manage(Operation::Move, &_storage, &r._storage);
+
+			_invoke = r._invoke;
+			_manage = r._manage;
+			r._invoke = nullptr;
+			r._manage = nullptr;
+		}
+
+	private:
+		Storage _storage;
+		InvokeFunction _invoke = nullptr;
+		ManageFunction _manage = nullptr;
+	};
+}
@@ -8,17 +8,22 @@
 #include <external/jansson/jansson.h>
 #include <et/core/json.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#	define ET_JSON_SSE	1
+#	include <emmintrin.h>
+#else
+#	define ET_JSON_SSE	0
+#endif
+
+#if (ET_PLATFORM_WIN)
+#	include <intrin.h>
+#endif
+
 using namespace et;
 using namespace et::json;
 
 et::VariantBase::Pointer deserializeJson(const char*, size_t, VariantClass&, bool);
 
-ArrayValue deserializeArray(json_t* json);
-Dictionary deserializeDictionary(json_t* json);
-StringValue deserializeString(json_t* json);
-IntegerValue deserializeInteger(json_t* json);
-FloatValue deserializeFloat(json_t* json);
-
 json_t* serializeFloat(const FloatValue&);
 json_t* serializeArray(const ArrayValue&);
 json_t* serializeString(const StringValue&);
@@ -72,133 +77,1026 @@ et::VariantBase::Pointer et::json::deserialize(const char* input, VariantClass&
 et::VariantBase::Pointer  et::json::deserialize(const std::string& s, VariantClass& c, bool printErrors)
 	{ return deserializeJson(s.c_str(), s.length(), c, printErrors); }
 
-et::VariantBase::Pointer deserializeJson(const char* buffer, size_t len, VariantClass& c, bool printErrors)
+namespace et
 {
-	c = VariantClass::Invalid;
-	
-	if ((buffer == nullptr) || (len == 0))
-		return Dictionary();
-	
-	json_error_t error = { };
-	json_t* root = json_loadb(buffer, len, 0, &error);
-	
-	if (error.line != -1)
+namespace json
+{
+
+namespace
+{
+
+const uint32_t MaxParsingDepth = 1024;
+
+inline uint32_t firstSetBit(uint32_t value)
+{
+#if (ET_PLATFORM_WIN)
+	unsigned long index = 0;
+	_BitScanForward(&index, value);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+}
+
+inline bool isWhitespace(char c)
+{
+	return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t');
+}
+
+inline bool isDigit(char c)
+{
+	return (c >= '0') && (c <= '9');
+}
+
+inline bool isStringSpecial(char c)
+{
+	return (c == '"') || (c == '\\') || (static_cast<uint8_t>(c) < 0x20);
+}
+
+inline int hexDigitValue(char c)
+{
+	if ((c >= '0') && (c <= '9'))
+		return c - '0';
+	if ((c >= 'a') && (c <= 'f'))
+		return c - 'a' + 10;
+	if ((c >= 'A') && (c <= 'F'))
+		return c - 'A' + 10;
+	return -1;
+}
+
+/*
+ * Same rules as jansson: no overlong forms, surrogates or code points above U+10FFFF,
+ * ASCII runs are skipped 16 bytes at a time where SSE2 is available
+ */
+inline bool isValidUtf8(const char* p, const char* end)
+{
+	while (p < end)
 	{
-		if (printErrors)
+#if (ET_JSON_SSE)
+		while ((end - p >= 16) && (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) == 0))
+			p += 16;
+
+		if (p >= end)
+			break;
+#endif
+		uint8_t c = static_cast<uint8_t>(*p);
+		if (c < 0x80)
 		{
-			log::error("JSON parsing error (%d,%d): %s %s", error.line, error.column, error.source, error.text);
-			log::error("%s", buffer);
+			++p;
+			continue;
 		}
-		json_decref(root);
-		return Dictionary();
+
+		uint32_t length = 0;
+		uint32_t codePoint = 0;
+		if ((c >= 0xC2) && (c <= 0xDF))
+		{
+			length = 2;
+			codePoint = c & 0x1F;
+		}
+		else if ((c >= 0xE0) && (c <= 0xEF))
+		{
+			length = 3;
+			codePoint = c & 0x0F;
+		}
+		else if ((c >= 0xF0) && (c <= 0xF4))
+		{
+			length = 4;
+			codePoint = c & 0x07;
+		}
+		else
+		{
+			return false;
+		}
+
+		if (static_cast<size_t>(end - p) < length)
+			return false;
+
+		for (uint32_t i = 1; i < length; ++i)
+		{
+			uint8_t continuation = static_cast<uint8_t>(p[i]);
+			if ((continuation & 0xC0) != 0x80)
+				return false;
+
+			codePoint = (codePoint << 6) | (continuation & 0x3F);
+		}
+
+		if ((length == 3) && ((codePoint < 0x800) || ((codePoint >= 0xD800) && (codePoint <= 0xDFFF))))
+			return false;
+
+		if ((length == 4) && ((codePoint < 0x10000) || (codePoint > 0x10FFFF)))
+			return false;
+
+		p += length;
 	}
-	
-	et::VariantBase::Pointer result;
-	
-	if (json_is_object(root))
+	return true;
+}
+
+/*
+ * Recursive descent parser, reports values to the handler as they are parsed.
+ * Whitespace and string contents are scanned 16 bytes at a time where SSE2 is available.
+ * Strings without escapes are reported as ranges of the input, others are unescaped
+ * into the scratch buffer, so handler should copy them.
+ */
+template <class Handler>
+class Parser
+{
+public:
+	Parser(const char* data, size_t size, Handler& handler) :
+		_begin(data), _pos(data), _end(data + size), _handler(handler)
 	{
-		c = VariantClass::Dictionary;
-		result = deserializeDictionary(root);
 	}
-	else if (json_is_array(root))
+
+	bool parse()
 	{
-		c = VariantClass::Array;
-		result = deserializeArray(root);
+		skipWhitespace();
+		if ((_pos >= _end) || ((*_pos != '{') && (*_pos != '[')))
+			return fail("'[' or '{' expected");
+
+		if (!parseValue(0))
+			return false;
+
+		while ((_pos < _end) && (isWhitespace(*_pos) || (*_pos == 0)))
+			++_pos;
+
+		return (_pos == _end) || fail("end of file expected");
 	}
-	else
+
+	const std::string& error() const
+		{ return _error; }
+
+	int errorLine() const
+		{ return _errorLine; }
+
+	int errorColumn() const
+		{ return _errorColumn; }
+
+private:
+	bool fail(const char* message)
 	{
-		ET_FAIL("Unsupported root object type.");
+		_error = message;
+		_errorLine = 1;
+		_errorColumn = 1;
+		for (const char* p = _begin, *e = std::min(_pos, _end); p < e; ++p)
+		{
+			if (*p == '\n')
+			{
+				++_errorLine;
+				_errorColumn = 1;
+			}
+			else
+			{
+				++_errorColumn;
+			}
+		}
+		return false;
 	}
-	
-	json_decref(root);
-	return result;
+
+	void skipWhitespace()
+	{
+		if ((_pos < _end) && !isWhitespace(*_pos))
+			return;
+
+#if (ET_JSON_SSE)
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i newLine = _mm_set1_epi8('\n');
+		const __m128i carriageReturn = _mm_set1_epi8('\r');
+		const __m128i tab = _mm_set1_epi8('\t');
+		while (_end - _pos >= 16)
+		{
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_pos));
+			__m128i whitespace = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newLine)),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, carriageReturn), _mm_cmpeq_epi8(chunk, tab)));
+
+			uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(whitespace)) & 0xffff;
+			if (mask != 0)
+			{
+				_pos += firstSetBit(mask);
+				return;
+			}
+			_pos += 16;
+		}
+#endif
+		while ((_pos < _end) && isWhitespace(*_pos))
+			++_pos;
+	}
+
+	/*
+	 * first quote, backslash or control character starting from p, or end of input
+	 */
+	const char* scanString(const char* p) const
+	{
+#if (ET_JSON_SSE)
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i lastControl = _mm_set1_epi8(0x1f);
+		while (_end - p >= 16)
+		{
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			__m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+			special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(chunk, lastControl), chunk));
+
+			uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+			if (mask != 0)
+				return p + firstSetBit(mask);
+
+			p += 16;
+		}
+#endif
+		while ((p < _end) && !isStringSpecial(*p))
+			++p;
+
+		return p;
+	}
+
+	bool parseValue(uint32_t depth)
+	{
+		if (_pos >= _end)
+			return fail("unexpected end of input");
+
+		switch (*_pos)
+		{
+		case '{':
+			return parseObject(depth + 1);
+
+		case '[':
+			return parseArray(depth + 1);
+
+		case '"':
+		{
+			const char* value = nullptr;
+			size_t length = 0;
+			if (!parseString(value, length))
+				return false;
+
+			_handler.onString(value, length);
+			return true;
+		}
+
+		case 't':
+		{
+			if (!parseLiteral("true", 4))
+				return false;
+
+			_handler.onBoolean(true);
+			return true;
+		}
+
+		case 'f':
+		{
+			if (!parseLiteral("false", 5))
+				return false;
+
+			_handler.onBoolean(false);
+			return true;
+		}
+
+		case 'n':
+		{
+			if (!parseLiteral("null", 4))
+				return false;
+
+			_handler.onNull();
+			return true;
+		}
+
+		default:
+			return parseNumber();
+		}
+	}
+
+	bool parseLiteral(const char* literal, size_t length)
+	{
+		if ((static_cast<size_t>(_end - _pos) < length) || (memcmp(_pos, literal, length) != 0))
+			return fail("invalid token");
+
+		_pos += length;
+		return true;
+	}
+
+	bool parseObject(uint32_t depth)
+	{
+		if (depth > MaxParsingDepth)
+			return fail("maximum parsing depth reached");
+
+		++_pos;
+		_handler.beginObject();
+
+		skipWhitespace();
+		if ((_pos < _end) && (*_pos == '}'))
+		{
+			++_pos;
+			_handler.endObject();
+			return true;
+		}
+
+		for (;;)
+		{
+			if ((_pos >= _end) || (*_pos != '"'))
+				return fail("string or '}' expected");
+
+			const char* key = nullptr;
+			size_t keyLength = 0;
+			if (!parseString(key, keyLength))
+				return false;
+
+			_handler.onKey(key, keyLength);
+
+			skipWhitespace();
+			if ((_pos >= _end) || (*_pos != ':'))
+				return fail("':' expected");
+
+			++_pos;
+			skipWhitespace();
+
+			if (!parseValue(depth))
+				return false;
+
+			skipWhitespace();
+			if ((_pos < _end) && (*_pos == ','))
+			{
+				++_pos;
+				skipWhitespace();
+			}
+			else if ((_pos < _end) && (*_pos == '}'))
+			{
+				++_pos;
+				break;
+			}
+			else
+			{
+				return fail("',' or '}' expected");
+			}
+		}
+
+		_handler.endObject();
+		return true;
+	}
+
+	bool parseArray(uint32_t depth)
+	{
+		if (depth > MaxParsingDepth)
+			return fail("maximum parsing depth reached");
+
+		++_pos;
+		_handler.beginArray();
+
+		skipWhitespace();
+		if ((_pos < _end) && (*_pos == ']'))
+		{
+			++_pos;
+			_handler.endArray();
+			return true;
+		}
+
+		for (;;)
+		{
+			if (!parseValue(depth))
+				return false;
+
+			skipWhitespace();
+			if ((_pos < _end) && (*_pos == ','))
+			{
+				++_pos;
+				skipWhitespace();
+			}
+			else if ((_pos < _end) && (*_pos == ']'))
+			{
+				++_pos;
+				break;
+			}
+			else
+			{
+				return fail("',' or ']' expected");
+			}
+		}
+
+		_handler.endArray();
+		return true;
+	}
+
+	bool parseString(const char*& result, size_t& length)
+	{
+		const char* start = ++_pos;
+		const char* p = scanString(start);
+
+		if (!isValidUtf8(start, p))
+		{
+			_pos = start;
+			return fail("invalid UTF-8 in string");
+		}
+
+		if ((p < _end) && (*p == '"'))
+		{
+			result = start;
+			length = static_cast<size_t>(p - start);
+			_pos = p + 1;
+			return true;
+		}
+
+		_scratch.assign(start, p);
+		for (;;)
+		{
+			if (p >= _end)
+			{
+				_pos = p;
+				return fail("premature end of input in string");
+			}
+
+			char c = *p;
+			if (c == '"')
+			{
+				break;
+			}
+			else if (c == '\\')
+			{
+				if (!parseEscape(p))
+					return false;
+			}
+			else if (static_cast<uint8_t>(c) < 0x20)
+			{
+				_pos = p;
+				return fail("control character in string");
+			}
+			else
+			{
+				const char* runEnd = scanString(p);
+				if (!isValidUtf8(p, runEnd))
+				{
+					_pos = p;
+					return fail("invalid UTF-8 in string");
+				}
+				_scratch.append(p, runEnd);
+				p = runEnd;
+			}
+		}
+
+		result = _scratch.data();
+		length = _scratch.size();
+		_pos = p + 1;
+		return true;
+	}
+
+	bool parseEscape(const char*& p)
+	{
+		if (_end - p < 2)
+		{
+			_pos = p;
+			return fail("premature end of input in string");
+		}
+
+		char c = p[1];
+		p += 2;
+
+		switch (c)
+		{
+		case '"':
+		case '\\':
+		case '/':
+			_scratch.push_back(c);
+			return true;
+		case 'b':
+			_scratch.push_back('\b');
+			return true;
+		case 'f':
+			_scratch.push_back('\f');
+			return true;
+		case 'n':
+			_scratch.push_back('\n');
+			return true;
+		case 'r':
+			_scratch.push_back('\r');
+			return true;
+		case 't':
+			_scratch.push_back('\t');
+			return true;
+		case 'u':
+			return parseUnicodeEscape(p);
+		default:
+		{
+			_pos = p - 2;
+			return fail("invalid escape");
+		}
+		}
+	}
+
+	bool parseHex4(const char*& p, uint32_t& value)
+	{
+		if (_end - p < 4)
+		{
+			_pos = p;
+			return fail("invalid \\u escape");
+		}
+
+		value = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			int digit = hexDigitValue(p[i]);
+			if (digit < 0)
+			{
+				_pos = p;
+				return fail("invalid \\u escape");
+			}
+			value = (value << 4) | static_cast<uint32_t>(digit);
+		}
+		p += 4;
+		return true;
+	}
+
+	bool parseUnicodeEscape(const char*& p)
+	{
+		uint32_t codePoint = 0;
+		if (!parseHex4(p, codePoint))
+			return false;
+
+		if ((codePoint >= 0xD800) && (codePoint <= 0xDBFF))
+		{
+			uint32_t low = 0;
+			if ((_end - p < 2) || (p[0] != '\\') || (p[1] != 'u'))
+			{
+				_pos = p;
+				return fail("invalid Unicode surrogate pair");
+			}
+
+			p += 2;
+			if (!parseHex4(p, low))
+				return false;
+
+			if ((low < 0xDC00) || (low > 0xDFFF))
+			{
+				_pos = p;
+				return fail("invalid Unicode surrogate pair");
+			}
+
+			codePoint = 0x10000 + (((codePoint - 0xD800) << 10) | (low - 0xDC00));
+		}
+		else if (((codePoint >= 0xDC00) && (codePoint <= 0xDFFF)) || (codePoint == 0))
+		{
+			_pos = p;
+			return fail("invalid Unicode code point");
+		}
+
+		if (codePoint < 0x80)
+		{
+			_scratch.push_back(static_cast<char>(codePoint));
+		}
+		else if (codePoint < 0x800)
+		{
+			_scratch.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+			_scratch.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else if (codePoint < 0x10000)
+		{
+			_scratch.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+			_scratch.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			_scratch.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else
+		{
+			_scratch.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+			_scratch.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+			_scratch.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			_scratch.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		return true;
+	}
+
+	/*
+	 * Integers which do not fit int64_t are reported as floats.
+	 * Floats with up to 19 significant digits and small exponents are computed exactly
+	 * from the integer mantissa, the rest are converted with strtod.
+	 */
+	bool parseNumber()
+	{
+		static const double powersOf10[] =
+		{
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		const char* start = _pos;
+		const char* p = _pos;
+
+		bool negative = (*p == '-');
+		if (negative)
+			++p;
+
+		if ((p >= _end) || !isDigit(*p))
+			return fail("invalid token");
+
+		uint64_t mantissa = 0;
+		int32_t significantDigits = 0;
+		int32_t exponent = 0;
+		bool isInteger = true;
+		bool truncated = false;
+
+		if (*p == '0')
+		{
+			++p;
+			if ((p < _end) && isDigit(*p))
+			{
+				_pos = p;
+				return fail("invalid number");
+			}
+		}
+		else
+		{
+			for (; (p < _end) && isDigit(*p); ++p)
+			{
+				if (significantDigits < 19)
+				{
+					mantissa = 10 * mantissa + static_cast<uint64_t>(*p - '0');
+					++significantDigits;
+				}
+				else
+				{
+					++exponent;
+					isInteger = false;
+					truncated = true;
+				}
+			}
+		}
+
+		if ((p < _end) && (*p == '.'))
+		{
+			isInteger = false;
+			++p;
+
+			if ((p >= _end) || !isDigit(*p))
+			{
+				_pos = p;
+				return fail("invalid number");
+			}
+
+			for (; (p < _end) && isDigit(*p); ++p)
+			{
+				if ((mantissa == 0) && (*p == '0'))
+				{
+					--exponent;
+				}
+				else if (significantDigits < 19)
+				{
+					mantissa = 10 * mantissa + static_cast<uint64_t>(*p - '0');
+					++significantDigits;
+					--exponent;
+				}
+				else
+				{
+					truncated = true;
+				}
+			}
+		}
+
+		if ((p < _end) && ((*p == 'e') || (*p == 'E')))
+		{
+			isInteger = false;
+			++p;
+
+			bool negativeExponent = false;
+			if ((p < _end) && ((*p == '+') || (*p == '-')))
+				negativeExponent = (*p++ == '-');
+
+			if ((p >= _end) || !isDigit(*p))
+			{
+				_pos = p;
+				return fail("invalid number");
+			}
+
+			int32_t explicitExponent = 0;
+			for (; (p < _end) && isDigit(*p); ++p)
+			{
+				if (explicitExponent < 100000)
+					explicitExponent = 10 * explicitExponent + (*p - '0');
+			}
+			exponent += negativeExponent ? -explicitExponent : explicitExponent;
+		}
+
+		_pos = p;
+
+		if (isInteger)
+		{
+			const uint64_t maxPositive = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+			if (!negative && (mantissa <= maxPositive))
+			{
+				_handler.onInteger(static_cast<int64_t>(mantissa));
+				return true;
+			}
+			else if (negative && (mantissa <= maxPositive + 1))
+			{
+				_handler.onInteger(static_cast<int64_t>(0 - mantissa));
+				return true;
+			}
+		}
+
+		double value = 0.0;
+		if (!truncated && (mantissa < (1ull << 53)) && (exponent >= -22) && (exponent <= 22))
+		{
+			value = static_cast<double>(mantissa);
+			value = (exponent < 0) ? value / powersOf10[-exponent] : value * powersOf10[exponent];
+			if (negative)
+				value = -value;
+		}
+		else
+		{
+			_number.assign(start, p);
+			value = strtod(_number.c_str(), nullptr);
+			if (std::isinf(value))
+				return fail("real number overflow");
+		}
+
+		_handler.onFloat(value);
+		return true;
+	}
+
+private:
+	const char* _begin = nullptr;
+	const char* _pos = nullptr;
+	const char* _end = nullptr;
+	Handler& _handler;
+	std::string _scratch;
+	std::string _number;
+	std::string _error;
+	int _errorLine = 0;
+	int _errorColumn = 0;
+};
+
+/*
+ * Builds Dictionary / ArrayValue tree while parsing,
+ * null values are stored as empty dictionaries, as before
+ */
+class VariantBuilder
+{
+public:
+	VariantBase::Pointer root;
+
+	void beginObject()
+	{
+		Dictionary value;
+		add(value);
+
+		Frame& frame = push();
+		frame.dictionary = &value->content;
+	}
+
+	void beginArray()
+	{
+		ArrayValue value;
+		add(value);
+
+		Frame& frame = push();
+		frame.array = &value->content;
+	}
+
+	void endObject()
+		{ --_depth; }
+
+	void endArray()
+		{ --_depth; }
+
+	void onKey(const char* key, size_t length)
+		{ _frames[_depth - 1].key.assign(key, length); }
+
+	void onString(const char* value, size_t length)
+		{ add(StringValue(std::string(value, length))); }
+
+	void onInteger(int64_t value)
+		{ add(IntegerValue(value)); }
+
+	void onFloat(double value)
+		{ add(FloatValue(static_cast<float>(value))); }
+
+	void onBoolean(bool value)
+		{ add(BooleanValue(value ? 1 : 0)); }
+
+	void onNull()
+		{ add(Dictionary()); }
+
+private:
+	struct Frame
+	{
+		Dictionary::ValueType* dictionary = nullptr;
+		ArrayValue::ValueType* array = nullptr;
+		std::string key;
+	};
+
+	Frame& push()
+	{
+		if (_depth == _frames.size())
+			_frames.emplace_back();
+
+		Frame& frame = _frames[_depth++];
+		frame.dictionary = nullptr;
+		frame.array = nullptr;
+		return frame;
+	}
+
+	void add(const VariantBase::Pointer& value)
+	{
+		if (_depth == 0)
+		{
+			root = value;
+			return;
+		}
+
+		Frame& frame = _frames[_depth - 1];
+		if (frame.array != nullptr)
+			frame.array->push_back(value);
+		else
+			(*frame.dictionary)[frame.key] = value;
+	}
+
+private:
+	Vector<Frame> _frames;
+	size_t _depth = 0;
+};
+
 }
 
-StringValue deserializeString(json_t* json)
+/*
+ * Appends values to the document, string values store offsets in the strings buffer
+ * until parsing is finished
+ */
+class DocumentBuilder
 {
-	ET_ASSERT(json_is_string(json));
-	return StringValue(std::string(json_string_value(json)));
+public:
+	DocumentBuilder(Document& document) :
+		_values(document._values), _strings(document._strings)
+	{
+	}
+
+	void beginObject()
+		{ beginContainer(Document::Type::Object); }
+
+	void beginArray()
+		{ beginContainer(Document::Type::Array); }
+
+	void endObject()
+		{ endContainer(); }
+
+	void endArray()
+		{ endContainer(); }
+
+	void onKey(const char* key, size_t length)
+		{ addString(key, length); }
+
+	void onString(const char* value, size_t length)
+	{
+		addString(value, length);
+		countValue();
+	}
+
+	void onInteger(int64_t value)
+	{
+		add(Document::Type::Integer).integer = value;
+		countValue();
+	}
+
+	void onFloat(double value)
+	{
+		add(Document::Type::Float).real = value;
+		countValue();
+	}
+
+	void onBoolean(bool value)
+	{
+		add(Document::Type::Boolean).integer = value ? 1 : 0;
+		countValue();
+	}
+
+	void onNull()
+	{
+		add(Document::Type::Null);
+		countValue();
+	}
+
+	void finish()
+	{
+		for (Document::Value& value : _values)
+		{
+			if (value.type == Document::Type::String)
+				value.string = _strings.data() + value.integer;
+		}
+	}
+
+private:
+	Document::Value& add(Document::Type type)
+	{
+		_values.emplace_back();
+
+		Document::Value& value = _values.back();
+		value.type = type;
+		value.end = static_cast<uint32_t>(_values.size());
+		return value;
+	}
+
+	void addString(const char* s, size_t length)
+	{
+		Document::Value& value = add(Document::Type::String);
+		value.integer = static_cast<int64_t>(_strings.size());
+		value.size = static_cast<uint32_t>(length);
+		_strings.insert(_strings.end(), s, s + length);
+		_strings.push_back(0);
+	}
+
+	void beginContainer(Document::Type type)
+	{
+		countValue();
+		add(type);
+		_containers.push_back(static_cast<uint32_t>(_values.size() - 1));
+	}
+
+	void endContainer()
+	{
+		_values[_containers.back()].end = static_cast<uint32_t>(_values.size());
+		_containers.pop_back();
+	}
+
+	void countValue()
+	{
+		if (!_containers.empty())
+			++_values[_containers.back()].size;
+	}
+
+private:
+	Vector<Document::Value>& _values;
+	Vector<char>& _strings;
+	Vector<uint32_t> _containers;
+};
+
+}
 }
 
-IntegerValue deserializeInteger(json_t* json)
+et::VariantBase::Pointer deserializeJson(const char* buffer, size_t len, VariantClass& c, bool printErrors)
 {
-	ET_ASSERT(json_is_integer(json));
-	return IntegerValue(json_integer_value(json));
+	c = VariantClass::Invalid;
+	
+	if ((buffer == nullptr) || (len == 0))
+		return Dictionary();
+
+	VariantBuilder builder;
+	Parser<VariantBuilder> parser(buffer, len, builder);
+
+	if (!parser.parse())
+	{
+		if (printErrors)
+		{
+			log::error("JSON parsing error (%d,%d): %s", parser.errorLine(), parser.errorColumn(), parser.error().c_str());
+			log::error("%s", std::string(buffer, len).c_str());
+		}
+		return Dictionary();
+	}
+
+	c = builder.root->variantClass();
+	return builder.root;
 }
 
-FloatValue deserializeFloat(json_t* json)
+bool Document::parse(const char* data, size_t size)
 {
-	ET_ASSERT(json_is_real(json));
-	return FloatValue(static_cast<float>(json_real_value(json)));
+	clear();
+
+	if ((data == nullptr) || (size == 0))
+	{
+		_error = "empty input";
+		return false;
+	}
+
+	DocumentBuilder builder(*this);
+	Parser<DocumentBuilder> parser(data, size, builder);
+
+	if (!parser.parse())
+	{
+		_error = parser.error() + " at line " + intToStr(parser.errorLine()) + ", column " + intToStr(parser.errorColumn());
+		_values.clear();
+		_strings.clear();
+		return false;
+	}
+
+	builder.finish();
+	return true;
 }
 
-ArrayValue deserializeArray(json_t* json)
+void Document::clear()
 {
-	ET_ASSERT(json_is_array(json));
-	
-	size_t size = json_array_size(json);
-	
-	ArrayValue result;
-	result->content.reserve(size);
-	for (size_t i = 0; i < size; ++i)
-	{
-		json_t* value = json_array_get(json, i);
-		if (json_is_string(value))
-			result->content.emplace_back(deserializeString(value));
-		else if (json_is_integer(value))
-			result->content.emplace_back(deserializeInteger(value));
-		else if (json_is_real(value))
-			result->content.emplace_back(deserializeFloat(value));
-		else if (json_is_array(value))
-			result->content.emplace_back(deserializeArray(value));
-		else if (json_is_object(value))
-			result->content.emplace_back(deserializeDictionary(value));
-		else if (json_is_null(value))
-			result->content.emplace_back(Dictionary());
-		else if (value)
-		{
-			ET_FAIL_FMT("Unsupported JSON type: %d", value->type);
-		}
-	}
-	return result;
+	_values.clear();
+	_strings.clear();
+	_error.clear();
 }
 
-Dictionary deserializeDictionary(json_t* root)
+const Document::Value* Document::find(const Value& object, const char* key) const
 {
-	ET_ASSERT(json_is_object(root));
-	
-	Dictionary result;
-	
-	void* child = json_object_iter(root);
-	while (child)
+	ET_ASSERT(object.type == Type::Object);
+
+	size_t keyLength = strlen(key);
+	for (const Value* member = firstChild(object), *e = childrenEnd(object); member != e; )
 	{
-		const std::string& key = json_object_iter_key(child);
-		json_t* value = json_object_iter_value(child);
-		
-		if (json_is_string(value))
-			result.setStringForKey(key, deserializeString(value));
-		else if (json_is_integer(value))
-			result.setIntegerForKey(key, deserializeInteger(value));
-		else if (json_is_real(value))
-			result.setFloatForKey(key, deserializeFloat(value));
-		else if (json_is_array(value))
-			result.setArrayForKey(key, deserializeArray(value));
-		else if (json_is_object(value))
-			result.setDictionaryForKey(key, deserializeDictionary(value));
-		else if (json_is_null(value))
-			result.setDictionaryForKey(key, Dictionary());
-		else if (json_is_true(value))
-			result.setBooleanForKey(key, 1);
-		else if (json_is_false(value))
-			result.setBooleanForKey(key, 0);
-		else if (value != nullptr)
-		{
-			ET_FAIL_FMT("Unsupported JSON type: %d", value->type);
-		}
-		child = json_object_iter_next(root, child);
+		const Value* value = member + 1;
+		if ((member->size == keyLength) && (memcmp(member->string, key, keyLength) == 0))
+			return value;
+
+		member = next(*value);
 	}
-	
-	return result;
+
+	return nullptr;
 }
 
 json_t* serializeArray(const ArrayValue& value)
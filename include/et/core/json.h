@@ -23,9 +23,95 @@ enum SerializationFlags
 std::string serialize(const et::Dictionary&, size_t = 0);
 std::string serialize(const et::ArrayValue&, size_t = 0);
 
+/*
+ * Root should be an object or an array, strings should be valid UTF-8, null values are stored as empty dictionaries.
+ * Unlike jansson, integers which do not fit int64_t are stored as floats instead of being rejected.
+ */
 et::VariantBase::Pointer deserialize(const char*, size_t, et::VariantClass&, bool printErrors = true);
 et::VariantBase::Pointer deserialize(const char*, et::VariantClass&, bool printErrors = true);
 et::VariantBase::Pointer deserialize(const std::string&, et::VariantClass&, bool printErrors = true);
 
+/*
+ * Read-only document for bulk loads, values are not converted to Dictionary / ArrayValue.
+ * All values are stored in one array, unescaped null-terminated strings are stored
+ * in one buffer owned by the document, so parsing takes a few allocations in total.
+ *
+ * Children of the array or object are stored right after it, Value::end is the index
+ * of the value following the whole subtree. Object members are pairs of values: key (String) and value.
+ */
+class Document
+{
+public:
+	enum class Type : uint32_t
+	{
+		Null,
+		Boolean,
+		Integer,
+		Float,
+		String,
+		Array,
+		Object
+	};
+
+	struct Value
+	{
+		Type type = Type::Null;
+
+		/*
+		 * length of the string, number of elements of the array, number of members of the object
+		 */
+		uint32_t size = 0;
+		uint32_t end = 0;
+
+		union
+		{
+			int64_t integer = 0;
+			double real;
+			const char* string;
+		};
+	};
+
+public:
+	bool parse(const char* data, size_t size);
+	bool parse(const std::string& s)
+		{ return parse(s.data(), s.size()); }
+
+	void clear();
+
+	bool valid() const
+		{ return !_values.empty(); }
+
+	const Value& root() const
+		{ return _values.front(); }
+
+	const Value* firstChild(const Value& v) const
+		{ return &v + 1; }
+
+	const Value* childrenEnd(const Value& v) const
+		{ return _values.data() + v.end; }
+
+	const Value* next(const Value& v) const
+		{ return _values.data() + v.end; }
+
+	/*
+	 * Value of the object member or nullptr
+	 */
+	const Value* find(const Value& object, const char* key) const;
+
+	uint32_t valuesCount() const
+		{ return static_cast<uint32_t>(_values.size()); }
+
+	const std::string& error() const
+		{ return _error; }
+
+private:
+	friend class DocumentBuilder;
+
+	Vector<Value> _values;
+	Vector<char> _strings;
+	std::string _error;
+};
+
+
 }
 }
@@ -116,12 +116,12 @@ et::Dictionary Locale::parseLanguageFile(const std::string& fileName)
 	
 	StringDataStorage fileContent;
 	{
-		InputStream file(fileName, StreamMode_Binary);
-		if (file.valid())
+		InputStream file(fileName, StreamMode_Mapped);
+		if (file.mapped())
 		{
-			fileContent.resize(static_cast<uint32_t>(streamSize(file.stream()) + 1));
-			fileContent.fill(0);
-			file.stream().read(fileContent.data(), fileContent.size());
+			fileContent.resize(static_cast<uint32_t>(file.size() + 1));
+			etCopyMemory(fileContent.data(), file.data(), file.size());
+			fileContent[fileContent.size() - 1] = 0;
 		}
 	}
 	
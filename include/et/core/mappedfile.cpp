@@ -0,0 +1,115 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/mappedfile.h>
+
+#if (ET_PLATFORM_WIN)
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace et {
+
+MappedFile::MappedFile(const std::string& fileName) {
+	open(fileName);
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+#if (ET_PLATFORM_WIN)
+
+bool MappedFile::open(const std::string& fileName) {
+	close();
+
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	_fileHandle = file;
+
+	LARGE_INTEGER fileSize = { };
+	if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart == 0)) {
+		close();
+		return false;
+	}
+
+	_mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mappingHandle == nullptr) {
+		close();
+		return false;
+	}
+
+	_data = reinterpret_cast<const uint8_t*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (_data == nullptr) {
+		close();
+		return false;
+	}
+
+	_size = static_cast<uint64_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::close() {
+	if (_data != nullptr)
+		UnmapViewOfFile(_data);
+
+	if (_mappingHandle != nullptr)
+		CloseHandle(_mappingHandle);
+
+	if (_fileHandle != nullptr)
+		CloseHandle(_fileHandle);
+
+	_data = nullptr;
+	_size = 0;
+	_fileHandle = nullptr;
+	_mappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& fileName) {
+	close();
+
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat fileStat = { };
+	if ((fstat(fd, &fileStat) != 0) || (fileStat.st_size == 0)) {
+		::close(fd);
+		return false;
+	}
+
+	void* mapped = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+
+	if (mapped == MAP_FAILED)
+		return false;
+
+	_data = reinterpret_cast<const uint8_t*>(mapped);
+	_size = static_cast<uint64_t>(fileStat.st_size);
+	return true;
+}
+
+void MappedFile::close() {
+	if (_data != nullptr)
+		munmap(const_cast<uint8_t*>(_data), static_cast<size_t>(_size));
+
+	_data = nullptr;
+	_size = 0;
+}
+
+#endif
+
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/et.h>
+
+namespace et {
+
+/*
+ * Read-only memory mapping of the whole file
+ */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const std::string& fileName);
+	~MappedFile();
+
+	bool open(const std::string& fileName);
+	void close();
+
+	bool valid() const {
+		return _data != nullptr;
+	}
+
+	const uint8_t* data() const {
+		return _data;
+	}
+
+	uint64_t size() const {
+		return _size;
+	}
+
+private:
+	ET_DENY_COPY(MappedFile);
+
+private:
+	const uint8_t* _data = nullptr;
+	uint64_t _size = 0;
+	void* _fileHandle = nullptr;
+	void* _mappingHandle = nullptr;
+};
+
+}
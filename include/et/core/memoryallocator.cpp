@@ -7,6 +7,7 @@
 
 #include <et/core/criticalsection.h>
 #include <et/core/staticdatastorage.h>
+#include <et/core/json.h>
 
 namespace et
 {
@@ -30,8 +31,27 @@ enum : uint64_t
 	minimumAllocationSize = 128,
 	smallBlockSize = 156,
 	mediumBlockSize = 284,
+	memoryTagsCount = static_cast<uint64_t>(MemoryTag::MaxCount),
 };
 
+static thread_local MemoryTag localMemoryTag = MemoryTag::General;
+
+MemoryTag currentMemoryTag()
+{
+	return localMemoryTag;
+}
+
+MemoryTagScope::MemoryTagScope(MemoryTag tag) :
+	_previousTag(localMemoryTag)
+{
+	localMemoryTag = tag;
+}
+
+MemoryTagScope::~MemoryTagScope()
+{
+	localMemoryTag = _previousTag;
+}
+
 class MemoryChunk
 {
 public:
@@ -39,9 +59,9 @@ public:
 
 	~MemoryChunk();
 
-	bool allocate(uint64_t size, void*& result);
+	bool allocate(uint64_t size, uint32_t tag, void*& result);
 	bool containsPointer(char*);
-	bool free(char*);
+	bool free(char*, uint32_t& tag, uint64_t& releasedSize);
 
 private:
 	MemoryChunk(const MemoryChunk&) = delete;
@@ -52,6 +72,7 @@ public:
 	char* allocatedMemoryBegin = nullptr;
 	char* allocatedMemoryEnd = nullptr;
 	char* actualDataMemory = nullptr;
+	uint8_t* tags = nullptr;
 };
 
 
@@ -70,6 +91,10 @@ public:
 	
 	#if (ET_PLATFORM_WIN)
 		 blocks = reinterpret_cast<SmallMemoryBlock*>(_aligned_malloc(sizeToAllocate, 32));
+	#elif (ET_PLATFORM_LINUX)
+		void* allocatedBlocks = nullptr;
+		posix_memalign(&allocatedBlocks, 32, sizeToAllocate);
+		blocks = reinterpret_cast<SmallMemoryBlock*>(allocatedBlocks);
 	#else
 		#error Implement allocation
 	#endif
@@ -116,12 +141,14 @@ public:
 #endif
 	#if (ET_PLATFORM_WIN)
 		_aligned_free(blocks);
+	#elif (ET_PLATFORM_LINUX)
+		::free(blocks);
 	#else
 		#error Implement deallocation
 	#endif
 	}
 
-	bool allocate(void*& result)
+	bool allocate(uint32_t tag, void*& result)
 	{
 		auto startBlock = currentBlock;
 
@@ -141,6 +168,7 @@ public:
 		}
 
 		currentBlock->blockAllocated = 1;
+		currentBlock->tag = tag;
 #	if (ET_DEBUG)
 		currentBlock->allocIndex = BlockMemoryAllocator::allocationIndex++;
 		if (_breakOnAllocations.count(currentBlock->allocIndex))
@@ -154,7 +182,7 @@ public:
 		return true;
 	}
 
-	void free(void* ptr)
+	uint32_t free(void* ptr)
 	{
 		SmallMemoryBlock* block = reinterpret_cast<SmallMemoryBlock*>(ptr);
 
@@ -167,6 +195,7 @@ public:
 			currentBlock = block;
 
 		_haveFreeBlocks = true;
+		return block->tag;
 	}
 
 	bool containsPointer(void* ptr)
@@ -190,9 +219,12 @@ private:
 	{
 		char data[blockSize];
 		uint32_t blockAllocated : 1;
-		uint32_t allocIndex : 31;
+		uint32_t tag : 5;
+		uint32_t allocIndex : 26;
 	};
 
+	static_assert(memoryTagsCount <= 32, "Memory tag does not fit into block header");
+
 	static_assert(sizeof(SmallMemoryBlock) % 32 == 0,
 		"Invalid block size will cause troubles allocating aligned objects");
 
@@ -217,7 +249,7 @@ public:
 	BlockMemoryAllocatorPrivate();
 	~BlockMemoryAllocatorPrivate();
 
-	void* alloc(uint64_t);
+	void* alloc(uint64_t, MemoryTag);
 	void free(void*);
 
 	bool validate(void*, bool abortOnFail = true);
@@ -226,6 +258,18 @@ public:
 
 	void printInfo();
 
+	Dictionary snapshot();
+
+	void setBudget(MemoryTag, uint64_t);
+	void setTagName(MemoryTag, const std::string&);
+	const std::string& tagName(MemoryTag);
+	MemoryTagStatistics tagStatistics(MemoryTag);
+
+private:
+	void* allocInternal(uint64_t, uint32_t tag, uint64_t& allocatedSize);
+	bool trackAllocation(uint32_t tag, uint64_t size);
+	void trackRelease(uint32_t tag, uint64_t size);
+
 private:
 	CriticalSection _csLock;
 	std::list<MemoryChunk> _chunks;
@@ -237,6 +281,9 @@ private:
 	uint64_t _largeAllocations = 0;
 	uint64_t _minAllocSize = std::numeric_limits<uint64_t>::max();
 	uint64_t _maxAllocSize = 0;
+
+	MemoryTagStatistics _tagStatistics[memoryTagsCount];
+	std::string _tagNames[memoryTagsCount];
 };
 
 BlockMemoryAllocator::BlockMemoryAllocator()
@@ -251,7 +298,12 @@ BlockMemoryAllocator::~BlockMemoryAllocator()
 
 void* BlockMemoryAllocator::allocate(uint64_t sz)
 {
-	return _private->alloc(alignUpTo(sz, uint64_t(minimumAllocationSize)));
+	return _private->alloc(alignUpTo(sz, uint64_t(minimumAllocationSize)), localMemoryTag);
+}
+
+void* BlockMemoryAllocator::allocate(uint64_t sz, MemoryTag tag)
+{
+	return _private->alloc(alignUpTo(sz, uint64_t(minimumAllocationSize)), tag);
 }
 
 void BlockMemoryAllocator::release(void* ptr)
@@ -274,11 +326,57 @@ void BlockMemoryAllocator::flushUnusedBlocks()
 	_private->flushUnusedBlocks();
 }
 
+void BlockMemoryAllocator::setBudget(MemoryTag tag, uint64_t budget)
+{
+	_private->setBudget(tag, budget);
+}
+
+void BlockMemoryAllocator::setTagName(MemoryTag tag, const std::string& name)
+{
+	_private->setTagName(tag, name);
+}
+
+const std::string& BlockMemoryAllocator::tagName(MemoryTag tag) const
+{
+	return _private->tagName(tag);
+}
+
+MemoryTagStatistics BlockMemoryAllocator::tagStatistics(MemoryTag tag) const
+{
+	return _private->tagStatistics(tag);
+}
+
+Dictionary BlockMemoryAllocator::snapshot() const
+{
+	return _private->snapshot();
+}
+
+bool BlockMemoryAllocator::saveSnapshot(const std::string& fileName) const
+{
+	std::ofstream fOut(fileName, std::ios::out | std::ios::trunc);
+	if (fOut.fail())
+	{
+		log::error("Unable to save memory snapshot to %s", fileName.c_str());
+		return false;
+	}
+
+	fOut << json::serialize(snapshot(), json::SerializationFlag_ReadableFormat);
+	return !fOut.fail();
+}
+
 /*
  * Private
  */
 BlockMemoryAllocatorPrivate::BlockMemoryAllocatorPrivate()
 {
+	const char* defaultTagNames[] = { "general", "scene", "textures", "constant-buffers", "rendering", "kd-tree" };
+	static_assert(sizeof(defaultTagNames) / sizeof(defaultTagNames[0]) == static_cast<size_t>(MemoryTag::Custom),
+		"Default name should be provided for each predefined memory tag");
+
+	const uint32_t firstCustomTag = static_cast<uint32_t>(MemoryTag::Custom);
+	for (uint32_t i = 0; i < memoryTagsCount; ++i)
+		_tagNames[i] = (i < firstCustomTag) ? std::string(defaultTagNames[i]) : ("custom-" + intToStr(i - firstCustomTag));
+
 	_chunks.emplace_back(defaultChunkSize);
 }
 
@@ -290,37 +388,67 @@ BlockMemoryAllocatorPrivate::~BlockMemoryAllocatorPrivate()
 		_minAllocSize, _maxAllocSize);
 }
 
-void* BlockMemoryAllocatorPrivate::alloc(uint64_t allocSize)
+void* BlockMemoryAllocatorPrivate::alloc(uint64_t allocSize, MemoryTag memoryTag)
 {
-	CriticalSectionScope lock(_csLock);
+	uint32_t tag = static_cast<uint32_t>(memoryTag);
+	ET_ASSERT(tag < memoryTagsCount);
+
+	void* result = nullptr;
+	bool budgetExceeded = false;
+	MemoryTagStatistics stats;
+	{
+		CriticalSectionScope lock(_csLock);
+
+		uint64_t allocatedSize = 0;
+		result = allocInternal(allocSize, tag, allocatedSize);
+		budgetExceeded = trackAllocation(tag, allocatedSize);
+		stats = _tagStatistics[tag];
+	}
+
+	/*
+	 * reported outside of the lock, log outputs could allocate memory
+	 */
+	if (budgetExceeded)
+	{
+		log::warning("[BlockMemoryAllocator] Memory budget exceeded for `%s`: %llu of %llu bytes used",
+			_tagNames[tag].c_str(), static_cast<unsigned long long>(stats.allocatedSize), static_cast<unsigned long long>(stats.budget));
+	}
+
+	return result;
+}
 
+void* BlockMemoryAllocatorPrivate::allocInternal(uint64_t allocSize, uint32_t tag, uint64_t& allocatedSize)
+{
 	void* result = nullptr;
 
 	_minAllocSize = std::min(_minAllocSize, allocSize);
 	_maxAllocSize = std::max(_maxAllocSize, allocSize);
 	
-	if ((allocSize <= smallBlockSize) && _allocatorSmall.haveFreeBlocks() && _allocatorSmall.allocate(result))
+	if ((allocSize <= smallBlockSize) && _allocatorSmall.haveFreeBlocks() && _allocatorSmall.allocate(tag, result))
 	{
 		++_smallAllocations;
+		allocatedSize = smallBlockSize;
 		return result;
 	}
 	
-	if ((allocSize <= mediumBlockSize) && _allocatorMedium.haveFreeBlocks() && _allocatorMedium.allocate(result))
+	if ((allocSize <= mediumBlockSize) && _allocatorMedium.haveFreeBlocks() && _allocatorMedium.allocate(tag, result))
 	{
 		++_mediumAllocations;
+		allocatedSize = mediumBlockSize;
 		return result;
 	}
 
+	allocatedSize = allocSize;
 	for (MemoryChunk& chunk : _chunks)
 	{
-		if (chunk.allocate(allocSize, result))
+		if (chunk.allocate(allocSize, tag, result))
 			return result;
 	}
 
 	_chunks.emplace_back(alignUpTo(std::max(allocSize, uint64_t(defaultChunkSize)), uint64_t(allocGranularity)));
 
 	MemoryChunk& lastChunk = _chunks.back();
-	if (lastChunk.allocate(allocSize, result))
+	if (lastChunk.allocate(allocSize, tag, result))
 	{
 		++_largeAllocations;
 		return result;
@@ -330,6 +458,37 @@ void* BlockMemoryAllocatorPrivate::alloc(uint64_t allocSize)
 	return nullptr;
 }
 
+/*
+ * Returns true when live size of the tag crosses its budget
+ */
+bool BlockMemoryAllocatorPrivate::trackAllocation(uint32_t tag, uint64_t size)
+{
+	MemoryTagStatistics& stats = _tagStatistics[tag];
+	stats.allocatedSize += size;
+	stats.highWaterMark = std::max(stats.highWaterMark, stats.allocatedSize);
+	++stats.allocationsCount;
+	++stats.totalAllocations;
+
+	if ((stats.budget == 0) || stats.budgetExceeded || (stats.allocatedSize <= stats.budget))
+		return false;
+
+	stats.budgetExceeded = true;
+	return true;
+}
+
+void BlockMemoryAllocatorPrivate::trackRelease(uint32_t tag, uint64_t size)
+{
+	MemoryTagStatistics& stats = _tagStatistics[tag];
+	ET_ASSERT(stats.allocatedSize >= size);
+	ET_ASSERT(stats.allocationsCount > 0);
+
+	stats.allocatedSize -= size;
+	--stats.allocationsCount;
+
+	if (stats.allocatedSize <= stats.budget)
+		stats.budgetExceeded = false;
+}
+
 bool BlockMemoryAllocatorPrivate::validate(void* ptr, bool abortOnFail)
 {
 	if (ptr == nullptr)
@@ -396,19 +555,24 @@ void BlockMemoryAllocatorPrivate::free(void* ptr)
 
 	if (_allocatorSmall.containsPointer(ptr))
 	{
-		_allocatorSmall.free(ptr);
+		trackRelease(_allocatorSmall.free(ptr), smallBlockSize);
 	}
 	else if (_allocatorMedium.containsPointer(ptr))
 	{
-		_allocatorMedium.free(ptr);
+		trackRelease(_allocatorMedium.free(ptr), mediumBlockSize);
 	}
 	else
 	{
+		uint32_t tag = 0;
+		uint64_t releasedSize = 0;
 		char* charPtr = static_cast<char*>(ptr);
 		for (MemoryChunk& chunk : _chunks)
 		{
-			if (chunk.free(charPtr))
+			if (chunk.free(charPtr, tag, releasedSize))
+			{
+				trackRelease(tag, releasedSize);
 				return;
+			}
 		}
 
 		ET_FAIL_FMT("Pointer being freed (0x%016llx) was not allocated via this allocator.", (int64_t)ptr);
@@ -449,6 +613,91 @@ void BlockMemoryAllocatorPrivate::printInfo()
 	log::info("\t}");
 
 	log::info("}");
+
+	for (uint32_t i = 0; i < memoryTagsCount; ++i)
+	{
+		const MemoryTagStatistics& stats = _tagStatistics[i];
+		if (stats.totalAllocations == 0)
+			continue;
+
+		log::info("%s: %llu bytes in %llu allocations, high-water mark: %llu, budget: %llu", _tagNames[i].c_str(),
+			static_cast<unsigned long long>(stats.allocatedSize), static_cast<unsigned long long>(stats.allocationsCount),
+			static_cast<unsigned long long>(stats.highWaterMark), static_cast<unsigned long long>(stats.budget));
+	}
+}
+
+void BlockMemoryAllocatorPrivate::setBudget(MemoryTag tag, uint64_t budget)
+{
+	CriticalSectionScope lock(_csLock);
+	MemoryTagStatistics& stats = _tagStatistics[static_cast<uint32_t>(tag)];
+	stats.budget = budget;
+	stats.budgetExceeded = (budget > 0) && (stats.allocatedSize > budget);
+}
+
+void BlockMemoryAllocatorPrivate::setTagName(MemoryTag tag, const std::string& name)
+{
+	CriticalSectionScope lock(_csLock);
+	_tagNames[static_cast<uint32_t>(tag)] = name;
+}
+
+const std::string& BlockMemoryAllocatorPrivate::tagName(MemoryTag tag)
+{
+	return _tagNames[static_cast<uint32_t>(tag)];
+}
+
+MemoryTagStatistics BlockMemoryAllocatorPrivate::tagStatistics(MemoryTag tag)
+{
+	CriticalSectionScope lock(_csLock);
+	return _tagStatistics[static_cast<uint32_t>(tag)];
+}
+
+/*
+ * Counters are copied under the lock, dictionary is built outside of it
+ * since it allocates memory from this allocator
+ */
+Dictionary BlockMemoryAllocatorPrivate::snapshot()
+{
+	MemoryTagStatistics stats[memoryTagsCount];
+	uint64_t chunksCount = 0;
+	uint64_t chunksCapacity = 0;
+	uint64_t chunksAllocated = 0;
+	{
+		CriticalSectionScope lock(_csLock);
+		std::copy(std::begin(_tagStatistics), std::end(_tagStatistics), std::begin(stats));
+		for (const MemoryChunk& chunk : _chunks)
+		{
+			++chunksCount;
+			chunksCapacity += chunk.heap.capacity();
+			chunksAllocated += chunk.heap.allocatedSize();
+		}
+	}
+
+	ArrayValue tags;
+	for (uint32_t i = 0; i < memoryTagsCount; ++i)
+	{
+		if ((stats[i].totalAllocations == 0) && (stats[i].budget == 0))
+			continue;
+
+		Dictionary tag;
+		tag.setStringForKey("name", _tagNames[i]);
+		tag.setIntegerForKey("allocated_size", static_cast<int64_t>(stats[i].allocatedSize));
+		tag.setIntegerForKey("high_water_mark", static_cast<int64_t>(stats[i].highWaterMark));
+		tag.setIntegerForKey("allocations", static_cast<int64_t>(stats[i].allocationsCount));
+		tag.setIntegerForKey("total_allocations", static_cast<int64_t>(stats[i].totalAllocations));
+		tag.setIntegerForKey("budget", static_cast<int64_t>(stats[i].budget));
+		tag.setBooleanForKey("budget_exceeded", stats[i].budgetExceeded ? 1 : 0);
+		tags->content.push_back(tag);
+	}
+
+	Dictionary chunks;
+	chunks.setIntegerForKey("count", static_cast<int64_t>(chunksCount));
+	chunks.setIntegerForKey("capacity", static_cast<int64_t>(chunksCapacity));
+	chunks.setIntegerForKey("allocated_size", static_cast<int64_t>(chunksAllocated));
+
+	Dictionary result;
+	result.setArrayForKey("tags", tags);
+	result.setDictionaryForKey("chunks", chunks);
+	return result;
 }
 
 /*
@@ -457,10 +706,10 @@ void BlockMemoryAllocatorPrivate::printInfo()
 MemoryChunk::MemoryChunk(uint64_t capacity) :
 	heap(capacity, minimumAllocationSize)
 {
-	uint64_t actualDataOffset = heap.requiredInfoSize();
+	uint64_t actualDataOffset = 2 * heap.requiredInfoSize();
 	uint64_t totalSize = alignUpTo(actualDataOffset + capacity, uint64_t(minimumAllocationSize));
 
-#if (ET_PLATFORM_APPLE)
+#if (ET_PLATFORM_APPLE || ET_PLATFORM_LINUX)
 
 	void* allocatedPtr = nullptr;
 	posix_memalign(&allocatedPtr, minimumAllocationSize, totalSize);
@@ -481,8 +730,12 @@ MemoryChunk::MemoryChunk(uint64_t capacity) :
 		ET_FAIL_FMT("Failed to allocate %u bytes (%u requested + %u info)", totalSize, capacity, actualDataOffset);
 	}
 
+	/*
+	 * [heap info][allocation tags][data], one byte of info and one byte of tag per granule
+	 */
 	actualDataMemory = allocatedMemoryBegin + actualDataOffset;
 	allocatedMemoryEnd = allocatedMemoryBegin + totalSize;
+	tags = reinterpret_cast<uint8_t*>(allocatedMemoryBegin + heap.requiredInfoSize());
 	heap.setInfoStorage(allocatedMemoryBegin);
 }
 
@@ -504,11 +757,12 @@ MemoryChunk::~MemoryChunk()
 #endif
 }
 
-bool MemoryChunk::allocate(uint64_t sizeToAllocate, void*& result)
+bool MemoryChunk::allocate(uint64_t sizeToAllocate, uint32_t tag, void*& result)
 {
 	uint64_t offset = 0;
 	if (heap.allocate(sizeToAllocate, offset))
 	{
+		tags[offset / minimumAllocationSize] = static_cast<uint8_t>(tag);
 		result = actualDataMemory + offset;
 		return true;
 	}
@@ -523,10 +777,18 @@ bool MemoryChunk::containsPointer(char* ptr)
 	return heap.containsAllocationWithOffset(static_cast<uint64_t>(ptr - actualDataMemory));
 }
 
-bool MemoryChunk::free(char* ptr)
+bool MemoryChunk::free(char* ptr, uint32_t& tag, uint64_t& releasedSize)
 {
 	if ((ptr < actualDataMemory) || (ptr >= allocatedMemoryEnd)) return false;
-	return heap.release(static_cast<uint64_t>(ptr - actualDataMemory));
+
+	uint64_t offset = static_cast<uint64_t>(ptr - actualDataMemory);
+	uint64_t allocatedBefore = heap.allocatedSize();
+	if (!heap.release(offset))
+		return false;
+
+	tag = tags[offset / minimumAllocationSize];
+	releasedSize = allocatedBefore - heap.allocatedSize();
+	return true;
 }
 
 }
@@ -14,6 +14,48 @@
 
 namespace et
 {
+/*
+ * Allocations are accounted per subsystem tag, tag is taken from the innermost
+ * MemoryTagScope of the current thread unless passed explicitly.
+ * Values starting from Custom are free for application use.
+ */
+enum class MemoryTag : uint32_t
+{
+	General,
+	Scene,
+	Textures,
+	ConstantBuffers,
+	Rendering,
+	KDTree,
+	Custom,
+
+	MaxCount = 32
+};
+
+struct MemoryTagStatistics
+{
+	uint64_t allocatedSize = 0;
+	uint64_t highWaterMark = 0;
+	uint64_t allocationsCount = 0;
+	uint64_t totalAllocations = 0;
+	uint64_t budget = 0;
+	bool budgetExceeded = false;
+};
+
+MemoryTag currentMemoryTag();
+
+class MemoryTagScope
+{
+public:
+	MemoryTagScope(MemoryTag);
+	~MemoryTagScope();
+
+private:
+	ET_DENY_COPY(MemoryTagScope);
+	MemoryTag _previousTag = MemoryTag::General;
+};
+
+class Dictionary;
 class BlockMemoryAllocator;
 class ObjectFactory
 {
@@ -26,6 +68,9 @@ public:
 	
 	template <typename O, typename ... args>
 	O* createObject(args&&...a);
+
+	template <typename O, typename ... args>
+	O* createTaggedObject(MemoryTag, args&&...a);
 	
 	template <typename O>
 	void deleteObject(O* obj);
@@ -49,14 +94,29 @@ public:
 	~BlockMemoryAllocator();
 	
 	void* allocate(uint64_t);
+	void* allocate(uint64_t, MemoryTag);
 	bool validatePointer(void*, bool = true);
 	void release(void* ptr);
 
 	void printInfo() const;
 	void flushUnusedBlocks();
+
+	/*
+	 * Warning is printed once each time live size of the tag grows above budget (0 - no budget)
+	 */
+	void setBudget(MemoryTag, uint64_t);
+	void setTagName(MemoryTag, const std::string&);
+	const std::string& tagName(MemoryTag) const;
+	MemoryTagStatistics tagStatistics(MemoryTag) const;
+
+	/*
+	 * Per-tag counters and high-water marks, could be written with json::serialize
+	 */
+	Dictionary snapshot() const;
+	bool saveSnapshot(const std::string& fileName) const;
 			
 private:
-	ET_DECLARE_PIMPL(BlockMemoryAllocator, 256);
+	ET_DECLARE_PIMPL(BlockMemoryAllocator, 4096);
 };
 
 /*
@@ -84,6 +144,13 @@ inline O* ObjectFactory::createObject(args&&...a)
 	return new (_allocator->allocate(sizeof(O))) O(std::forward<args>(a)...); \
 }
 
+template <typename O, typename ... args>
+inline O* ObjectFactory::createTaggedObject(MemoryTag tag, args&&...a)
+{
+	ET_ASSERT(_allocator != nullptr);
+	return new (_allocator->allocate(sizeof(O), tag)) O(std::forward<args>(a)...);
+}
+
 template <typename O>
 inline void ObjectFactory::deleteObject(O* obj)
 {
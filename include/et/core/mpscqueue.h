@@ -0,0 +1,194 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/et.h>
+
+namespace et
+{
+	struct MPSCQueueNode
+	{
+		MPSCQueueNode* next = nullptr;
+	};
+
+	/*
+	 * Intrusive lock-free queue: any thread can push, only one thread takes nodes.
+	 * Consumer takes everything pushed so far in one atomic exchange,
+	 * so it is processed in batches and nodes are never shared between consumer and producers.
+	 */
+	class MPSCQueue
+	{
+	public:
+		MPSCQueue() = default;
+
+		/*
+		 * Returns true if queue was empty before the push
+		 */
+		bool push(MPSCQueueNode* node)
+		{
+			MPSCQueueNode* head = _head.load(std::memory_order_relaxed);
+			do
+			{
+				node->next = head;
+			}
+			while (!_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+
+			return head == nullptr;
+		}
+
+		/*
+		 * Returns linked list of nodes in the order they were pushed
+		 */
+		MPSCQueueNode* takeAll()
+		{
+			MPSCQueueNode* node = _head.exchange(nullptr, std::memory_order_acquire);
+
+			MPSCQueueNode* result = nullptr;
+			while (node != nullptr)
+			{
+				MPSCQueueNode* next = node->next;
+				node->next = result;
+				result = node;
+				node = next;
+			}
+			return result;
+		}
+
+		bool empty() const
+		{
+			return _head.load(std::memory_order_relaxed) == nullptr;
+		}
+
+	private:
+		ET_DENY_COPY(MPSCQueue);
+
+	private:
+		std::atomic<MPSCQueueNode*> _head{ nullptr };
+	};
+
+	/*
+	 * Bounded queue with preallocated cells (D. Vyukov's algorithm):
+	 * producers only compete for the position, values are copied in place and nothing is allocated.
+	 * push returns false when queue is full.
+	 */
+	template <typename T>
+	class BoundedMPSCQueue
+	{
+	public:
+		BoundedMPSCQueue(size_t capacity) :
+			_cells(capacity), _mask(capacity - 1)
+		{
+			ET_ASSERT((capacity > 0) && ((capacity & _mask) == 0));
+
+			for (size_t i = 0; i < capacity; ++i)
+				_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		bool push(const T& value)
+		{
+			Cell* cell = nullptr;
+			size_t position = _enqueuePosition.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				cell = _cells.data() + (position & _mask);
+				size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+				if (difference == 0)
+				{
+					if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_release, std::memory_order_relaxed))
+						break;
+				}
+				else if (difference < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = _enqueuePosition.load(std::memory_order_relaxed);
+				}
+			}
+
+			cell->value = value;
+			cell->sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		/*
+		 * Should be called from consumer thread only
+		 */
+		bool pop(T& value)
+		{
+			size_t position = _dequeuePosition.load(std::memory_order_relaxed);
+			Cell* cell = _cells.data() + (position & _mask);
+			if (cell->sequence.load(std::memory_order_acquire) != position + 1)
+				return false;
+
+			value = std::move(cell->value);
+			cell->sequence.store(position + _mask + 1, std::memory_order_release);
+			_dequeuePosition.store(position + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		/*
+		 * Number of claimed cells, some of them could be still filled by producers
+		 */
+		size_t size() const
+		{
+			size_t dequeuePosition = _dequeuePosition.load(std::memory_order_relaxed);
+			return _enqueuePosition.load(std::memory_order_acquire) - dequeuePosition;
+		}
+
+		bool empty() const
+		{
+			return size() == 0;
+		}
+
+		/*
+		 * Values pushed before this call (from the calling thread) have smaller positions
+		 */
+		size_t enqueuePosition() const
+		{
+			return _enqueuePosition.load(std::memory_order_acquire);
+		}
+
+		/*
+		 * Position of the next value to pop, should be called from consumer thread only
+		 */
+		size_t dequeuePosition() const
+		{
+			return _dequeuePosition.load(std::memory_order_relaxed);
+		}
+
+		size_t capacity() const
+		{
+			return _mask + 1;
+		}
+
+	private:
+		ET_DENY_COPY(BoundedMPSCQueue);
+
+		struct Cell
+		{
+			std::atomic<size_t> sequence{ 0 };
+			T value;
+		};
+
+		enum : size_t
+		{
+			CacheLineSize = 64
+		};
+
+	private:
+		Vector<Cell> _cells;
+		const size_t _mask = 0;
+		char _producerPadding[CacheLineSize];
+		std::atomic<size_t> _enqueuePosition{ 0 };
+		char _consumerPadding[CacheLineSize];
+		std::atomic<size_t> _dequeuePosition{ 0 };
+	};
+}
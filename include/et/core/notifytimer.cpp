@@ -21,6 +21,7 @@ void NotifyTimer::start(TimerPool* tp, float period, int64_t repeatCount)
 	_period = period;
 	_repeatCount = repeatCount;
 	_endTime = actualTime() + period;
+	scheduleUpdate(_endTime);
 }
 
 void NotifyTimer::start(TimerPool::Pointer tp, float period, int64_t repeatCount)
@@ -35,9 +36,14 @@ void NotifyTimer::update(float t)
 		_repeatCount--;
 
 		if (_repeatCount == -1)
+		{
 			cancelUpdates();
-		else 
+		}
+		else
+		{
 			_endTime = t + _period;
+			scheduleUpdate(_endTime);
+		}
 
 		expired.invoke(this);
 	}
@@ -5,17 +5,23 @@
  *
  */
 
+#include <et/app/application.h>
 #include <et/core/objectscache.h>
 
 using namespace et;
 
 ObjectsCache::ObjectsCache() :
-	_updateTime(0.0f)
+	_monitoringState(std::make_shared<MonitoringState>()), _updateTime(0.0f)
 {
+	_monitoringState->owner = this;
 }
 
 ObjectsCache::~ObjectsCache()
 {
+	{
+		CriticalSectionScope lock(_monitoringState->lock);
+		_monitoringState->owner = nullptr;
+	}
 	clear();
 }
 
@@ -25,24 +31,15 @@ void ObjectsCache::manage(const LoadableObject::Pointer& o, const ObjectLoader::
 	{
 		CriticalSectionScope lock(_lock);
 
-		if (_objects.count(o->origin()) > 0)
-		{
-			ObjectPropertyList& list = _objects[o->origin()];
-			list.push_back(ObjectProperty(o, loader));
-			ObjectProperty& newObject = list.back();
-			newObject.identifiers[o->origin()] = getFileProperty(o->origin());
-			for (auto& s : o->distributedOrigins())
-				newObject.identifiers[s] = getFileProperty(s);
-		}
-		else
-		{
-			ObjectPropertyList newList(1, ObjectProperty(o, loader));
-			ObjectProperty& newObject = newList.back();
-			newObject.identifiers[o->origin()] = getFileProperty(o->origin());
-			for (auto& s : o->distributedOrigins())
-				newObject.identifiers[s] = getFileProperty(s);
-			_objects.insert(std::make_pair(o->origin(), newList));
-		}
+		ObjectPropertyList& list = _objects[o->origin()];
+		list.push_back(ObjectProperty(o, loader));
+		ObjectProperty& newObject = list.back();
+		newObject.identifiers[o->origin()] = getFileProperty(o->origin());
+		for (auto& s : o->distributedOrigins())
+			newObject.identifiers[s] = getFileProperty(s);
+
+		_objectOrigins[o.pointer()] = o->origin();
+		addFileObjects(newObject);
 	}
 	else
 	{
@@ -93,20 +90,26 @@ void ObjectsCache::discard(const LoadableObject::Pointer& o)
 	if (o.valid())
 	{
 		CriticalSectionScope lock(_lock);
-		if (_objects.count(o->origin()) == 0) return;
 
-		ObjectPropertyList& list = _objects[o->origin()];
+		auto origin = _objectOrigins.find(o.pointer());
+		if (origin == _objectOrigins.end()) return;
+
+		auto entry = _objects.find(origin->second);
+		ObjectPropertyList& list = entry->second;
 		for (auto i = list.begin(), e = list.end(); i != e; ++i)
 		{
 			if (i->object == o)
 			{
+				removeFileObjects(*i);
 				list.erase(i);
 				break;
 			}
 		}
 
 		if (list.empty())
-			_objects.erase(o->origin());
+			_objects.erase(entry);
+
+		_objectOrigins.erase(origin);
 	}
 }
 
@@ -114,6 +117,10 @@ void ObjectsCache::clear()
 {
 	CriticalSectionScope lock(_lock);
 	_objects.clear();
+	_objectOrigins.clear();
+	_fileObjects.clear();
+	_pendingReloads.clear();
+	_watcher.clear();
 }
 
 void ObjectsCache::flush()
@@ -129,6 +136,8 @@ void ObjectsCache::flush()
 		{
 			if (obj->object->retainCount() == 1)
 			{
+				removeFileObjects(*obj);
+				_objectOrigins.erase(obj->object.pointer());
 				obj = lv.second.erase(obj);
 				++objectsErased;
 			}
@@ -170,14 +179,25 @@ void ObjectsCache::update(float t)
 {
 	static const float updateInterval = 0.5f;
 
+	reloadChangedObjects();
+
 	if (_updateTime == 0.0f)
 		_updateTime = t;
 
 	float dt = t - _updateTime;
 
-	if (dt > updateInterval)
+	if ((dt > updateInterval) && !_checkInProgress)
 	{
-		performUpdate();
+		_checkInProgress = true;
+
+		std::shared_ptr<MonitoringState> state = _monitoringState;
+		Invocation([state]()
+		{
+			CriticalSectionScope lock(state->lock);
+			if (state->owner != nullptr)
+				state->owner->checkChangedFiles();
+		}).invokeInBackground();
+
 		_updateTime = t;
 	}
 }
@@ -191,56 +211,114 @@ uint64_t ObjectsCache::getObjectProperty(LoadableObject::Pointer ptr)
 {
 	CriticalSectionScope lock(_lock);
 
-	for (auto& entry : _objects)
+	ObjectProperty* prop = findProperty(ptr.pointer());
+	return (prop == nullptr) ? 0 : prop->identifiers[ptr->origin()];
+}
+
+ObjectsCache::ObjectProperty* ObjectsCache::findProperty(const LoadableObject* object)
+{
+	auto origin = _objectOrigins.find(object);
+	if (origin == _objectOrigins.end())
+		return nullptr;
+
+	auto entry = _objects.find(origin->second);
+	if (entry == _objects.end())
+		return nullptr;
+
+	for (ObjectProperty& p : entry->second)
 	{
-		for (auto& p : entry.second)
-		{
-			if (p.object == ptr)
-				return p.identifiers[ptr->origin()];
-		}
+		if (p.object.pointer() == object)
+			return &p;
+	}
+
+	return nullptr;
+}
+
+void ObjectsCache::addFileObjects(const ObjectProperty& p)
+{
+	for (const auto& file : p.identifiers)
+	{
+		_fileObjects[file.first].push_back(p.object.pointer());
+		_watcher.watch(file.first);
 	}
+}
 
-	return 0;
+void ObjectsCache::removeFileObjects(const ObjectProperty& p)
+{
+	for (const auto& file : p.identifiers)
+	{
+		auto i = _fileObjects.find(file.first);
+		if (i == _fileObjects.end())
+			continue;
+
+		auto& objects = i->second;
+		objects.erase(std::remove(objects.begin(), objects.end(), p.object.pointer()), objects.end());
+		if (objects.empty())
+			_fileObjects.erase(i);
+
+		_watcher.unwatch(file.first);
+	}
 }
 
-void ObjectsCache::performUpdate()
+void ObjectsCache::checkChangedFiles()
 {
-	ObjectsCache& cache = *this;
+	/*
+	 * watcher has its own lock, so files are checked without blocking the cache
+	 */
+	Vector<std::string> changedFiles;
+	_watcher.poll(changedFiles);
 
-	for (auto& entry : _objects)
+	Vector<uint64_t> fileProperties;
+	fileProperties.reserve(changedFiles.size());
+	for (const std::string& file : changedFiles)
+		fileProperties.push_back(getFileProperty(file));
+
+	CriticalSectionScope lock(_lock);
+	for (size_t i = 0, e = changedFiles.size(); i < e; ++i)
 	{
-		for (auto& p : entry.second)
+		auto objects = _fileObjects.find(changedFiles[i]);
+		if (objects == _fileObjects.end())
+			continue;
+
+		for (const LoadableObject* object : objects->second)
 		{
-			if (p.loader.valid() && p.object->canBeReloaded())
-			{
-				bool shouldReload = false;
-
-				const auto& origin = p.object->origin();
-				uint64_t originProp = getFileProperty(origin);
-				if (p.identifiers[origin] != originProp)
-				{
-					p.identifiers[origin] = originProp;
-					shouldReload = true;
-				}
-				else
-				{
-					for (const auto& dOrigin : p.object->distributedOrigins())
-					{
-						auto prop = getFileProperty(dOrigin);
-						if (p.identifiers[dOrigin] != prop)
-						{
-							p.identifiers[dOrigin] = prop;
-							shouldReload = true;
-							break;
-						}
-					}
-				}
-
-				if (shouldReload)
-					p.loader->reloadObject(p.object, cache);
-			}
+			ObjectProperty* p = findProperty(object);
+			if ((p == nullptr) || p->loader.invalid())
+				continue;
+
+			uint64_t& identifier = p->identifiers[changedFiles[i]];
+			if (identifier == fileProperties[i])
+				continue;
+
+			identifier = fileProperties[i];
+
+			auto pending = std::find_if(_pendingReloads.begin(), _pendingReloads.end(),
+				[object](const ObjectProperty& r) { return r.object.pointer() == object; });
+
+			if (pending == _pendingReloads.end())
+				_pendingReloads.push_back(ObjectProperty(p->object, p->loader));
 		}
 	}
+
+	_checkInProgress = false;
+}
+
+void ObjectsCache::reloadChangedObjects()
+{
+	Vector<ObjectProperty> reloads;
+	{
+		CriticalSectionScope lock(_lock);
+		if (_pendingReloads.empty())
+			return;
+
+		reloads.swap(_pendingReloads);
+	}
+
+	for (ObjectProperty& p : reloads)
+	{
+		if (p.object->canBeReloaded())
+			p.loader->reloadObject(p.object, *this);
+	}
 }
 
 void ObjectsCache::report()
@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include <memory>
 #include <et/core/criticalsection.h>
 #include <et/core/timedobject.h>
+#include <et/core/filewatcher.h>
 
 namespace et
 {
@@ -37,9 +39,15 @@ public:
 private:
 	ET_DENY_COPY(ObjectsCache);
 
-	void performUpdate();
 	void update(float t);
 
+	/*
+	 * Changed files are collected on the background thread,
+	 * objects are reloaded on the next update, since loaders could access rendering objects
+	 */
+	void checkChangedFiles();
+	void reloadChangedObjects();
+
 private:
 	struct ObjectProperty
 	{
@@ -55,9 +63,31 @@ private:
 
 	using ObjectPropertyList = Vector<ObjectProperty>;
 	using ObjectMap = UnorderedMap<std::string, ObjectPropertyList>;
+	using ObjectIndex = UnorderedMap<const LoadableObject*, std::string>;
+	using FileObjectsMap = UnorderedMap<std::string, Vector<const LoadableObject*>>;
+
+	/*
+	 * Shared with the background checks, which could outlive the cache
+	 */
+	struct MonitoringState
+	{
+		CriticalSection lock;
+		ObjectsCache* owner = nullptr;
+	};
+
+	ObjectProperty* findProperty(const LoadableObject*);
+	void addFileObjects(const ObjectProperty&);
+	void removeFileObjects(const ObjectProperty&);
 
+private:
 	CriticalSection _lock;
 	ObjectMap _objects;
+	ObjectIndex _objectOrigins;
+	FileObjectsMap _fileObjects;
+	FileWatcher _watcher;
+	Vector<ObjectProperty> _pendingReloads;
+	std::shared_ptr<MonitoringState> _monitoringState;
+	std::atomic<bool> _checkInProgress { false };
 	float _updateTime = 0.0f;
 };
 }
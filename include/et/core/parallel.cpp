@@ -0,0 +1,163 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/parallel.h>
+#include <et/core/profiler.h>
+#include <condition_variable>
+#include <mutex>
+
+namespace et {
+namespace parallel {
+
+class WorkerPool
+{
+public:
+	static WorkerPool& instance() {
+		static WorkerPool pool;
+		return pool;
+	}
+
+	uint32_t workersCount() const {
+		return static_cast<uint32_t>(_threads.size() + 1);
+	}
+
+	void execute(uint32_t count, uint32_t grain, const RangeFunction& func);
+
+private:
+	WorkerPool();
+	~WorkerPool();
+
+	void workerMain();
+	void processChunks();
+
+private:
+	std::vector<std::thread> _threads;
+	std::mutex _executeMutex;
+	std::mutex _stateMutex;
+	std::condition_variable _jobAvailable;
+	std::condition_variable _jobFinished;
+
+	const RangeFunction* _function = nullptr;
+	uint32_t _count = 0;
+	uint32_t _grain = 1;
+	uint32_t _chunksCount = 0;
+	uint64_t _jobIndex = 0;
+	uint32_t _activeWorkers = 0;
+	std::atomic<uint32_t> _nextChunk{ 0 };
+	std::atomic<uint32_t> _completedChunks{ 0 };
+	bool _running = true;
+};
+
+static thread_local bool insideParallelRange = false;
+
+WorkerPool::WorkerPool() {
+	size_t threadsToCreate = std::max(size_t(1), threading::maxConcurrentThreads()) - 1;
+	_threads.reserve(threadsToCreate);
+	for (size_t i = 0; i < threadsToCreate; ++i)
+		_threads.emplace_back(&WorkerPool::workerMain, this);
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::unique_lock<std::mutex> lock(_stateMutex);
+		_running = false;
+	}
+	_jobAvailable.notify_all();
+
+	for (std::thread& t : _threads)
+		t.join();
+}
+
+void WorkerPool::execute(uint32_t count, uint32_t grain, const RangeFunction& func) {
+	std::unique_lock<std::mutex> executeLock(_executeMutex);
+	{
+		std::unique_lock<std::mutex> lock(_stateMutex);
+		_jobFinished.wait(lock, [this]() { return _activeWorkers == 0; });
+		_function = &func;
+		_count = count;
+		_grain = grain;
+		_chunksCount = (count + grain - 1) / grain;
+		_nextChunk.store(0);
+		_completedChunks.store(0);
+		++_jobIndex;
+	}
+	_jobAvailable.notify_all();
+
+	processChunks();
+
+	std::unique_lock<std::mutex> lock(_stateMutex);
+	_jobFinished.wait(lock, [this]() { return _completedChunks.load() == _chunksCount; });
+	_function = nullptr;
+}
+
+void WorkerPool::processChunks() {
+	ET_PROFILE_SCOPE("parallel::forRange");
+
+	insideParallelRange = true;
+	for (uint32_t chunk = _nextChunk.fetch_add(1); chunk < _chunksCount; chunk = _nextChunk.fetch_add(1)) {
+		uint32_t begin = chunk * _grain;
+		uint32_t end = std::min(begin + _grain, _count);
+		(*_function)(begin, end);
+
+		if (_completedChunks.fetch_add(1) + 1 == _chunksCount) {
+			std::unique_lock<std::mutex> lock(_stateMutex);
+			_jobFinished.notify_all();
+		}
+	}
+	insideParallelRange = false;
+}
+
+void WorkerPool::workerMain() {
+	ET_PROFILE_THREAD_NAME("et::parallel");
+
+	uint64_t lastJobIndex = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(_stateMutex);
+			_jobAvailable.wait(lock, [this, lastJobIndex]() { return !_running || (_jobIndex != lastJobIndex); });
+			if (!_running)
+				break;
+
+			lastJobIndex = _jobIndex;
+			++_activeWorkers;
+		}
+
+		processChunks();
+
+		{
+			std::unique_lock<std::mutex> lock(_stateMutex);
+			--_activeWorkers;
+		}
+		_jobFinished.notify_all();
+	}
+}
+
+uint32_t workersCount() {
+	return WorkerPool::instance().workersCount();
+}
+
+uint32_t suggestedGrain(uint32_t count, uint32_t minGrain) {
+	const uint32_t chunksPerWorker = 4;
+	uint32_t grain = count / (chunksPerWorker * workersCount());
+	return std::max(std::max(grain, minGrain), 1u);
+}
+
+void forRange(uint32_t count, uint32_t grain, const RangeFunction& func) {
+	if (count == 0)
+		return;
+
+	grain = std::max(grain, 1u);
+	if (insideParallelRange || (grain >= count) || (workersCount() == 1)) {
+		func(0, count);
+		return;
+	}
+
+	WorkerPool::instance().execute(count, grain, func);
+}
+
+}
+}
@@ -0,0 +1,38 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/et.h>
+
+namespace et {
+namespace parallel {
+
+/*
+ * Called with half-open range [begin, end) of items to process
+ */
+using RangeFunction = std::function<void(uint32_t begin, uint32_t end)>;
+
+/*
+ * Number of threads participating in forRange (including calling thread)
+ */
+uint32_t workersCount();
+
+/*
+ * Splits [0, count) into chunks of `grain` items and processes them on the shared worker pool.
+ * Calling thread participates and returns when all chunks are processed.
+ * Nested calls (from inside of the RangeFunction) are executed serially.
+ */
+void forRange(uint32_t count, uint32_t grain, const RangeFunction& func);
+
+/*
+ * Chooses grain so that every worker gets several chunks but chunks are not smaller than minGrain
+ */
+uint32_t suggestedGrain(uint32_t count, uint32_t minGrain = 1);
+
+}
+}
@@ -0,0 +1,331 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/profiler.h>
+#include <mutex>
+
+namespace et {
+namespace profiler {
+
+std::atomic<bool> captureEnabled{ false };
+
+/*
+ * Chunks are filled by the owning thread only, count is published with release semantics,
+ * so exporter can read [0, count) without locking the writer
+ */
+struct EventChunk
+{
+	enum : uint32_t
+	{
+		Capacity = 4096
+	};
+
+	Event events[Capacity];
+	std::atomic<uint32_t> count{ 0 };
+	std::atomic<EventChunk*> next{ nullptr };
+};
+
+struct ThreadEvents
+{
+	enum : uint32_t
+	{
+		MaxChunks = 256
+	};
+
+	EventChunk* first = nullptr;
+	EventChunk* current = nullptr;
+	uint32_t chunksInUse = 0;
+	uint32_t threadIndex = 0;
+	std::atomic<uint64_t> generation{ 0 };
+	std::atomic<uint64_t> droppedEvents{ 0 };
+	std::atomic<bool> alive{ true };
+	std::string name;
+
+	ThreadEvents(uint32_t index) :
+		first(new EventChunk()), current(first), chunksInUse(1), threadIndex(index) { }
+
+	~ThreadEvents()
+	{
+		while (first != nullptr)
+		{
+			EventChunk* next = first->next.load();
+			delete first;
+			first = next;
+		}
+	}
+
+	void rewind(uint64_t gen)
+	{
+		for (EventChunk* c = first; c != nullptr; c = c->next.load(std::memory_order_relaxed))
+			c->count.store(0, std::memory_order_release);
+
+		current = first;
+		chunksInUse = 1;
+		droppedEvents.store(0, std::memory_order_relaxed);
+		generation.store(gen, std::memory_order_release);
+	}
+
+	void append(const Event& e)
+	{
+		uint32_t index = current->count.load(std::memory_order_relaxed);
+		if (index == EventChunk::Capacity)
+		{
+			if (chunksInUse == MaxChunks)
+			{
+				droppedEvents.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			EventChunk* next = current->next.load(std::memory_order_relaxed);
+			if (next == nullptr)
+			{
+				next = new EventChunk();
+				current->next.store(next, std::memory_order_release);
+			}
+			current = next;
+			++chunksInUse;
+			index = 0;
+		}
+		current->events[index] = e;
+		current->count.store(index + 1, std::memory_order_release);
+	}
+};
+
+class Registry
+{
+public:
+	static Registry& instance()
+	{
+		/*
+		 * intentionally never destroyed: threads could record events while static objects are destroyed
+		 */
+		static Registry* registry = new Registry();
+		return *registry;
+	}
+
+	ThreadEvents* registerThread()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		threads.emplace_back(new ThreadEvents(nextThreadIndex++));
+		return threads.back().get();
+	}
+
+public:
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ThreadEvents>> threads;
+	std::set<std::string> names;
+	std::atomic<uint64_t> generation{ 0 };
+	uint64_t captureBegin = 0;
+	uint32_t nextThreadIndex = 1;
+};
+
+struct ThreadEventsHandle
+{
+	ThreadEvents* events = nullptr;
+
+	~ThreadEventsHandle()
+	{
+		if (events != nullptr)
+			events->alive.store(false, std::memory_order_release);
+	}
+};
+
+static thread_local ThreadEventsHandle localThreadEvents;
+
+static ThreadEvents* currentThreadEvents()
+{
+	if (localThreadEvents.events == nullptr)
+		localThreadEvents.events = Registry::instance().registerThread();
+
+	return localThreadEvents.events;
+}
+
+void beginCapture()
+{
+	Registry& registry = Registry::instance();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	registry.threads.erase(std::remove_if(registry.threads.begin(), registry.threads.end(),
+		[](const std::unique_ptr<ThreadEvents>& t) { return !t->alive.load(std::memory_order_acquire); }),
+		registry.threads.end());
+
+	registry.captureBegin = timestamp();
+	registry.generation.fetch_add(1);
+	captureEnabled.store(true);
+}
+
+void endCapture()
+{
+	captureEnabled.store(false);
+}
+
+void record(const Event& e)
+{
+	ThreadEvents* events = currentThreadEvents();
+
+	uint64_t gen = Registry::instance().generation.load(std::memory_order_relaxed);
+	if (events->generation.load(std::memory_order_relaxed) != gen)
+		events->rewind(gen);
+
+	events->append(e);
+}
+
+void setThreadName(const std::string& name)
+{
+	ThreadEvents* events = currentThreadEvents();
+
+	std::lock_guard<std::mutex> lock(Registry::instance().mutex);
+	events->name = name;
+}
+
+const char* intern(const std::string& name)
+{
+	Registry& registry = Registry::instance();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	return registry.names.insert(name).first->c_str();
+}
+
+/*
+ * Export
+ */
+static void writeJSONString(std::ostream& out, const char* s)
+{
+	out << '"';
+	for (; *s != 0; ++s)
+	{
+		unsigned char c = static_cast<unsigned char>(*s);
+		if ((c == '"') || (c == '\\'))
+		{
+			out << '\\' << *s;
+		}
+		else if (c < 0x20)
+		{
+			char buffer[8] = { };
+			snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+			out << buffer;
+		}
+		else
+		{
+			out << *s;
+		}
+	}
+	out << '"';
+}
+
+/*
+ * Trace timestamps are in microseconds, fractional part keeps nanosecond precision
+ */
+static void writeMicroseconds(std::ostream& out, uint64_t ns)
+{
+	char buffer[32] = { };
+	snprintf(buffer, sizeof(buffer), "%llu.%03llu",
+		static_cast<unsigned long long>(ns / 1000), static_cast<unsigned long long>(ns % 1000));
+	out << buffer;
+}
+
+static void writeEvent(std::ostream& out, const Event& e, uint32_t threadIndex, uint64_t captureBegin)
+{
+	static const char* phases[] = { "X", "B", "E", "C", "i" };
+
+	out << "{\"name\":";
+	writeJSONString(out, (e.name == nullptr) ? "" : e.name);
+	out << ",\"ph\":\"" << phases[static_cast<uint32_t>(e.type)] << "\",\"pid\":1,\"tid\":" << threadIndex << ",\"ts\":";
+	writeMicroseconds(out, e.timestamp - captureBegin);
+
+	switch (e.type)
+	{
+	case EventType::Scope:
+	{
+		out << ",\"dur\":";
+		writeMicroseconds(out, e.duration);
+		break;
+	}
+
+	case EventType::Counter:
+	{
+		out << ",\"args\":{\"value\":" << e.value << "}";
+		break;
+	}
+
+	case EventType::Frame:
+	{
+		out << ",\"s\":\"g\",\"args\":{\"index\":" << e.value << "}";
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	out << "}";
+}
+
+void exportChromeTrace(std::ostream& out)
+{
+	ET_ASSERT(!capturing());
+
+	Registry& registry = Registry::instance();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	uint64_t gen = registry.generation.load();
+	uint64_t totalEvents = 0;
+	uint64_t droppedEvents = 0;
+
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" << std::endl;
+	out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"et\"}}";
+	for (const std::unique_ptr<ThreadEvents>& thread : registry.threads)
+	{
+		if (thread->generation.load(std::memory_order_acquire) != gen)
+			continue;
+
+		if (!thread->name.empty())
+		{
+			out << "," << std::endl << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->threadIndex << ",\"args\":{\"name\":";
+			writeJSONString(out, thread->name.c_str());
+			out << "}}";
+		}
+
+		for (const EventChunk* c = thread->first; c != nullptr; c = c->next.load(std::memory_order_acquire))
+		{
+			uint32_t count = c->count.load(std::memory_order_acquire);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (c->events[i].timestamp < registry.captureBegin)
+					continue;
+
+				out << "," << std::endl;
+				writeEvent(out, c->events[i], thread->threadIndex, registry.captureBegin);
+				++totalEvents;
+			}
+		}
+		droppedEvents += thread->droppedEvents.load(std::memory_order_relaxed);
+	}
+	out << std::endl << "]}" << std::endl;
+
+	if (droppedEvents > 0)
+	{
+		log::warning("[et-engine] Profiler dropped %llu events, thread buffers are full",
+			static_cast<unsigned long long>(droppedEvents));
+	}
+	log::info("[et-engine] Profiler exported %llu events", static_cast<unsigned long long>(totalEvents));
+}
+
+bool exportChromeTrace(const std::string& fileName)
+{
+	std::ofstream out(fileName, std::ios::out | std::ios::trunc);
+	if (out.fail())
+	{
+		log::error("Unable to write trace to %s", fileName.c_str());
+		return false;
+	}
+
+	exportChromeTrace(out);
+	return !out.fail();
+}
+
+}
+}
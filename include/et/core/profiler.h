@@ -0,0 +1,146 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/et.h>
+#include <chrono>
+
+/*
+ * Instrumentation macros are compiled out unless ET_ENABLE_PROFILER is set to 1
+ */
+#if !defined(ET_ENABLE_PROFILER)
+#	define ET_ENABLE_PROFILER 0
+#endif
+
+namespace et {
+namespace profiler {
+
+/*
+ * Names are stored as pointers and should outlive the capture (string literals or intern results)
+ */
+enum class EventType : uint32_t
+{
+	Scope,
+	Begin,
+	End,
+	Counter,
+	Frame
+};
+
+struct Event
+{
+	const char* name = nullptr;
+	uint64_t timestamp = 0;
+	uint64_t duration = 0;
+	int64_t value = 0;
+	EventType type = EventType::Scope;
+};
+
+extern std::atomic<bool> captureEnabled;
+
+/*
+ * Nanoseconds from an arbitrary point, monotonic
+ */
+inline uint64_t timestamp()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/*
+ * Events are recorded only between beginCapture and endCapture.
+ * Each thread appends to its own buffer, so recording never takes locks.
+ * Buffers of finished threads are kept until the next beginCapture.
+ */
+void beginCapture();
+void endCapture();
+
+inline bool capturing()
+{
+	return captureEnabled.load(std::memory_order_relaxed);
+}
+
+void record(const Event&);
+void setThreadName(const std::string&);
+
+/*
+ * Returns persistent copy of the string, to be used as a name of event
+ */
+const char* intern(const std::string&);
+
+/*
+ * Writes captured events in Chrome trace event format (chrome://tracing, ui.perfetto.dev),
+ * should not be called while capture is active
+ */
+bool exportChromeTrace(const std::string& fileName);
+void exportChromeTrace(std::ostream&);
+
+class Scope
+{
+public:
+	Scope(const char* name) :
+		_name(name), _begin(capturing() ? timestamp() : 0) { }
+
+	~Scope()
+	{
+		if (_begin > 0)
+		{
+			Event e;
+			e.name = _name;
+			e.timestamp = _begin;
+			e.duration = timestamp() - _begin;
+			record(e);
+		}
+	}
+
+private:
+	ET_DENY_COPY(Scope);
+
+	const char* _name = nullptr;
+	uint64_t _begin = 0;
+};
+
+inline void recordInstant(EventType type, const char* name, int64_t value)
+{
+	if (capturing())
+	{
+		Event e;
+		e.name = name;
+		e.timestamp = timestamp();
+		e.value = value;
+		e.type = type;
+		record(e);
+	}
+}
+
+}
+}
+
+#if (ET_ENABLE_PROFILER)
+#
+#	define ET_PROFILE_CONCAT_IMPL(A, B)		A##B
+#	define ET_PROFILE_CONCAT(A, B)				ET_PROFILE_CONCAT_IMPL(A, B)
+#	define ET_PROFILE_SCOPE(NAME)				et::profiler::Scope ET_PROFILE_CONCAT(profilerScope, __LINE__)(NAME)
+#	define ET_PROFILE_FUNCTION()				ET_PROFILE_SCOPE(__FUNCTION__)
+#	define ET_PROFILE_BEGIN(NAME)				et::profiler::recordInstant(et::profiler::EventType::Begin, NAME, 0)
+#	define ET_PROFILE_END(NAME)				et::profiler::recordInstant(et::profiler::EventType::End, NAME, 0)
+#	define ET_PROFILE_COUNTER(NAME, VALUE)		et::profiler::recordInstant(et::profiler::EventType::Counter, NAME, static_cast<int64_t>(VALUE))
+#	define ET_PROFILE_FRAME(INDEX)				et::profiler::recordInstant(et::profiler::EventType::Frame, "Frame", static_cast<int64_t>(INDEX))
+#	define ET_PROFILE_THREAD_NAME(NAME)			et::profiler::setThreadName(NAME)
+#
+#else
+#
+#	define ET_PROFILE_SCOPE(NAME)
+#	define ET_PROFILE_FUNCTION()
+#	define ET_PROFILE_BEGIN(NAME)
+#	define ET_PROFILE_END(NAME)
+#	define ET_PROFILE_COUNTER(NAME, VALUE)
+#	define ET_PROFILE_FRAME(INDEX)
+#	define ET_PROFILE_THREAD_NAME(NAME)
+#
+#endif
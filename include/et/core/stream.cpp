@@ -5,6 +5,8 @@
 *
 */
 
+#include <et/core/mappedfile.h>
+
 namespace et
 {
 class InputStreamPrivate
@@ -17,6 +19,8 @@ public:
 
 public:
 	std::istream* stream = nullptr;
+	MappedFile mappedFile;
+	MemoryStreamBuffer mappedBuffer;
 };
 }
 
@@ -30,6 +34,23 @@ InputStream::InputStream()
 InputStream::InputStream(const std::string& file, StreamMode mode)
 {
 	ET_PIMPL_INIT(InputStream);
+
+	if (mode == StreamMode_Mapped)
+	{
+		/*
+		 * empty files could not be mapped, but they are still valid
+		 */
+		if (_private->mappedFile.open(file) || fileExists(file))
+		{
+			_private->mappedBuffer.setData(_private->mappedFile.data(), static_cast<size_t>(_private->mappedFile.size()));
+			_private->stream = etCreateObject<std::istream>(&_private->mappedBuffer);
+		}
+		else
+		{
+			log::error("Unable to open file: %s", file.c_str());
+		}
+		return;
+	}
 	
 	std::ios::openmode openMode = std::ios::in;
 	
@@ -68,3 +89,51 @@ std::istream& InputStream::stream()
 	
 	return *_private->stream;
 }
+
+bool InputStream::mapped() const
+{
+	return _private->mappedFile.valid();
+}
+
+const uint8_t* InputStream::data() const
+{
+	return _private->mappedFile.data();
+}
+
+uint64_t InputStream::size() const
+{
+	return _private->mappedFile.size();
+}
+
+MemoryStreamBuffer::MemoryStreamBuffer(const uint8_t* data, size_t size)
+{
+	setData(data, size);
+}
+
+void MemoryStreamBuffer::setData(const uint8_t* data, size_t size)
+{
+	char* begin = reinterpret_cast<char*>(const_cast<uint8_t*>(data));
+	setg(begin, begin, begin + size);
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode)
+{
+	char* target = gptr();
+	if (direction == std::ios_base::beg)
+		target = eback() + offset;
+	else if (direction == std::ios_base::cur)
+		target = gptr() + offset;
+	else if (direction == std::ios_base::end)
+		target = egptr() + offset;
+
+	if ((target < eback()) || (target > egptr()))
+		return pos_type(off_type(-1));
+
+	setg(eback(), target, egptr());
+	return pos_type(target - eback());
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekpos(pos_type position, std::ios_base::openmode mode)
+{
+	return seekoff(off_type(position), std::ios_base::beg, mode);
+}
@@ -12,7 +12,24 @@ namespace et
 enum StreamMode
 {
 	StreamMode_Text,
-	StreamMode_Binary
+	StreamMode_Binary,
+	StreamMode_Mapped
+};
+
+/*
+ * Read-only stream buffer over memory block, does not copy the data
+ */
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+	MemoryStreamBuffer() = default;
+	MemoryStreamBuffer(const uint8_t* data, size_t size);
+
+	void setData(const uint8_t* data, size_t size);
+
+protected:
+	pos_type seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode) override;
+	pos_type seekpos(pos_type, std::ios_base::openmode) override;
 };
 
 class InputStreamPrivate;
@@ -32,7 +49,15 @@ public:
 
 	std::istream& stream();
 
+	/*
+	 * Contents of the file opened with StreamMode_Mapped,
+	 * available for the lifetime of the stream, nullptr for other modes
+	 */
+	bool mapped() const;
+	const uint8_t* data() const;
+	uint64_t size() const;
+
 private:
-	ET_DECLARE_PIMPL(InputStream, 32);
+	ET_DECLARE_PIMPL(InputStream, 256);
 };
 }
@@ -11,66 +11,79 @@ using namespace et;
 
 TaskPool::TaskPool()
 {
-    _tasks.reserve(128);
-    _tasksToAdd.reserve(128);
+	_delayedTasks.reserve(128);
 }
 
 TaskPool::~TaskPool() 
 {
-	CriticalSectionScope lock(_csModifying);
-	
-	for (auto i : _tasks)
-		etDestroyObject(i);
+	for (Task* task : _delayedTasks)
+		etDestroyObject(task);
+
+	MPSCQueueNode* node = _addedTasks.takeAll();
+	while (node != nullptr)
+	{
+		MPSCQueueNode* next = node->next;
+		etDestroyObject(static_cast<Task*>(node));
+		node = next;
+	}
 }
 
 void TaskPool::addTask(Task* t, float delay)
 {
-	CriticalSectionScope lock(_csModifying);
-	
-	auto alreadyAdded = std::find(_tasksToAdd.begin(), _tasksToAdd.end(), t);
-	if (alreadyAdded == _tasksToAdd.end())
-	{
-		t->setExecutionTime(_lastTime + delay);
-		_tasksToAdd.push_back(t); 
-	}
+	ET_ASSERT(!t->_added);
+	t->_added = true;
+
+	t->setExecutionTime(_lastTime.load(std::memory_order_relaxed) + delay);
+	_tasksCount.fetch_add(1, std::memory_order_relaxed);
+	_addedTasks.push(t);
 }
 
 void TaskPool::update(float currentTime)
 {
-	joinTasks();
-	
-	_lastTime = currentTime;
-	
-	auto i = _tasks.begin();
-	while (i != _tasks.end())
+	_lastTime.store(currentTime, std::memory_order_relaxed);
+
+	while (!_delayedTasks.empty() && (_delayedTasks.front()->executionTime() <= currentTime))
 	{
-		Task* task = (*i);
-		if (_lastTime >= task->executionTime())
+		std::pop_heap(_delayedTasks.begin(), _delayedTasks.end(), &TaskPool::executesLater);
+		Task* task = _delayedTasks.back();
+		_delayedTasks.pop_back();
+		executeTask(task);
+	}
+
+	/*
+	 * tasks added while executing will be taken on the next update
+	 */
+	MPSCQueueNode* node = _addedTasks.takeAll();
+	while (node != nullptr)
+	{
+		MPSCQueueNode* next = node->next;
+		Task* task = static_cast<Task*>(node);
+		if (task->executionTime() <= currentTime)
 		{
-			task->execute();
-			etDestroyObject(task);
-			i = _tasks.erase(i);
+			executeTask(task);
 		}
 		else
 		{
-			++i;
+			_delayedTasks.push_back(task);
+			std::push_heap(_delayedTasks.begin(), _delayedTasks.end(), &TaskPool::executesLater);
 		}
+		node = next;
 	}
 }
 
 bool TaskPool::hasTasks()
 {
-	CriticalSectionScope lock(_csModifying);
-	return !(_tasks.empty() && _tasksToAdd.empty());
+	return _tasksCount.load(std::memory_order_relaxed) > 0;
 }
 
-void TaskPool::joinTasks()
+void TaskPool::executeTask(Task* task)
 {
-	CriticalSectionScope lock(_csModifying);
-	
-	if (!_tasksToAdd.empty())
-	{
-		_tasks.insert(_tasks.end(), _tasksToAdd.begin(), _tasksToAdd.end());
-		_tasksToAdd.clear();
-	}
+	task->execute();
+	etDestroyObject(task);
+	_tasksCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool TaskPool::executesLater(const Task* l, const Task* r)
+{
+	return l->executionTime() > r->executionTime();
 }
@@ -12,6 +12,11 @@
 
 namespace et
 {
+	/*
+	 * Tasks could be added from any thread without locking, update should be called from the owning thread.
+	 * Delayed tasks are kept in a heap ordered by execution time.
+	 * Task is an intrusive queue node owned by the pool, so it could be added only once.
+	 */
 	class TaskPool
 	{
 	public:
@@ -24,14 +29,15 @@ namespace et
 		bool hasTasks();
 				
 	private:
-		void joinTasks();
+		void executeTask(Task*);
+		static bool executesLater(const Task*, const Task*);
 		
 		ET_DENY_COPY(TaskPool);
 		
 	private:
-		CriticalSection _csModifying;
-        Task::List _tasks;
-		Task::List _tasksToAdd;
-		float _lastTime = 0.0f;
+		MPSCQueue _addedTasks;
+		Task::List _delayedTasks;
+		std::atomic<uint32_t> _tasksCount{ 0 };
+		std::atomic<float> _lastTime{ 0.0f };
 	};
 }
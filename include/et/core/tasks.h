@@ -7,11 +7,11 @@
 
 #pragma once
 
-#include <et/core/et.h>
+#include <et/core/mpscqueue.h>
 
 namespace et
 {
-	class Task
+	class Task : public MPSCQueueNode
 	{
     public:
         using List = Vector<Task*>;
@@ -31,5 +31,6 @@ namespace et
 
 	private:
 		float _executionTime = 0.0f;
+		bool _added = false;
 	};
 }
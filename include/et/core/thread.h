@@ -8,7 +8,9 @@
 #pragma once
 
 #include <mutex>
+#include <condition_variable>
 #include <et/core/threading.h>
+#include <et/core/profiler.h>
 
 namespace et {
 
@@ -74,8 +76,15 @@ private:
 		if (_name.empty())
 			return;
 
+		ET_PROFILE_THREAD_NAME(_name);
+
 	#if (ET_PLATFORM_APPLE)
 		pthread_setname_np(_name.c_str());
+	#elif (ET_PLATFORM_LINUX)
+		/*
+		 * names are limited to 15 characters
+		 */
+		pthread_setname_np(pthread_self(), _name.substr(0, 15).c_str());
 	#endif
 	}
 
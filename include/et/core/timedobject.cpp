@@ -56,6 +56,19 @@ void TimedObject::cancelUpdates()
 		_owner->detachTimedObject(this);
 }
 
+void TimedObject::scheduleUpdate(float time)
+{
+	if (_owner)
+	{
+		_owner->scheduleTimedObject(this, time);
+	}
+	else
+	{
+		_scheduledTime = time;
+		_hasSchedule = true;
+	}
+}
+
 float TimedObject::actualTime()
 {
 	return timerPool()->actualTime();
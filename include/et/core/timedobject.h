@@ -47,9 +47,28 @@ protected:
 	virtual void startUpdates(TimerPool* timerPool = nullptr);
 	virtual TimerPool* timerPool();
 
+	/*
+	 * Objects are updated every frame by default. Objects which are waiting for some moment
+	 * (like timers) could schedule their next update, pool will not visit them until that time.
+	 * Schedule is kept until the object is detached from the pool.
+	 */
+	void scheduleUpdate(float time);
+
 private:
+	enum class PoolState : uint32_t
+	{
+		Detached,
+		Continuous,
+		Scheduled,
+		Due
+	};
+
 	TimerPool* _owner = nullptr;
 	float _startTime = 0.0f;
+	float _scheduledTime = 0.0f;
+	uint32_t _poolIndex = 0;
+	PoolState _poolState = PoolState::Detached;
+	bool _hasSchedule = false;
 	bool _running = false;
 	bool _released = false;
 };
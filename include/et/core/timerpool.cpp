@@ -19,50 +19,66 @@ TimerPool::TimerPool(RunLoop* owner) :
 bool TimerPool::hasObjects()
 {
 	CriticalSectionScope lock(_lock);
-	return !(_timedObjects.empty() && _queue.empty());
+	return (_continuousCount > 0) || !_scheduled.empty() || !_due.empty();
 }
 
 void TimerPool::attachTimedObject(TimedObject* obj)
 {
 	CriticalSectionScope lock(_lock);
 
-	QueueEntry entry(obj, QueueAction_Update);
-	if (std::find(_timedObjects.begin(), _timedObjects.end(), entry) != _timedObjects.end()) return;
+	if (obj->_poolState != TimedObject::PoolState::Detached)
+		return;
 
-	if (_updating)
-	{
-		entry.action = QueueAction_Add;
-		if (std::find(_queue.begin(), _queue.end(), entry) == _queue.end())
-			_queue.push_back(entry);
-	}
+	if (obj->_hasSchedule)
+		attachScheduled(obj);
 	else
-	{
-		_timedObjects.push_back(entry);
-	}
+		attachContinuous(obj);
 }
 
 void TimerPool::detachTimedObject(TimedObject* obj)
 {
 	CriticalSectionScope lock(_lock);
 
-	QueueEntry existsAddingEntry(obj, QueueAction_Add);
-	auto existsAddingValue = std::find(_queue.begin(), _queue.end(), existsAddingEntry);
-	if (existsAddingValue != _queue.end())
+	switch (obj->_poolState)
 	{
-		if (_updating)
-			existsAddingEntry.action = QueueAction_Remove;
-		else
-			_queue.erase(existsAddingValue);
+	case TimedObject::PoolState::Continuous:
+		_continuous[obj->_poolIndex] = nullptr;
+		--_continuousCount;
+		break;
+
+	case TimedObject::PoolState::Scheduled:
+		removeScheduled(obj->_poolIndex);
+		break;
+
+	case TimedObject::PoolState::Due:
+		_due[obj->_poolIndex] = nullptr;
+		break;
+
+	default:
+		break;
 	}
 
-	QueueEntry existsUpdatingEntry(obj, QueueAction_Update);
-	auto existsUpdatingValue = std::find(_timedObjects.begin(), _timedObjects.end(), existsUpdatingEntry);
-	if (existsUpdatingValue != _timedObjects.end()) 
+	obj->_poolState = TimedObject::PoolState::Detached;
+	obj->_hasSchedule = false;
+}
+
+void TimerPool::scheduleTimedObject(TimedObject* obj, float time)
+{
+	CriticalSectionScope lock(_lock);
+
+	obj->_scheduledTime = time;
+	obj->_hasSchedule = true;
+
+	if (obj->_poolState == TimedObject::PoolState::Continuous)
 	{
-		if (_updating)
-			existsUpdatingValue->action = QueueAction_Remove;
-		else
-			_timedObjects.erase(existsUpdatingValue);
+		_continuous[obj->_poolIndex] = nullptr;
+		--_continuousCount;
+		attachScheduled(obj);
+	}
+	else if (obj->_poolState == TimedObject::PoolState::Scheduled)
+	{
+		siftUp(obj->_poolIndex);
+		siftDown(obj->_poolIndex);
 	}
 }
 
@@ -70,33 +86,139 @@ void TimerPool::update(float t)
 {
 	CriticalSectionScope lock(_lock);
 
-	if (_queue.size() > 0)
+	while (!_scheduled.empty() && (_scheduled.front()->_scheduledTime <= t))
+	{
+		TimedObject* obj = _scheduled.front();
+		removeScheduled(0);
+		obj->_poolState = TimedObject::PoolState::Due;
+		obj->_poolIndex = static_cast<uint32_t>(_due.size());
+		_due.emplace_back(obj);
+	}
+
+	/*
+	 * objects attached during update are appended and visited next frame,
+	 * detached (or destroyed) objects are replaced with null
+	 */
+	for (size_t i = 0, e = _continuous.size(); i < e; ++i)
+	{
+		TimedObject* obj = _continuous[i];
+		if ((obj != nullptr) && obj->running())
+			obj->update(t);
+	}
+
+	for (size_t i = 0; i < _due.size(); ++i)
+	{
+		TimedObject* obj = _due[i];
+		if ((obj != nullptr) && obj->running())
+			obj->update(t);
+
+		obj = _due[i];
+		if (obj == nullptr)
+			continue;
+
+		if (obj->running())
+		{
+			attachScheduled(obj);
+		}
+		else
+		{
+			obj->_poolState = TimedObject::PoolState::Detached;
+			obj->_hasSchedule = false;
+		}
+	}
+	_due.clear();
+
+	uint32_t activeCount = 0;
+	for (TimedObject* obj : _continuous)
 	{
-		for (auto& i : _queue)
+		if (obj == nullptr)
+			continue;
+
+		if (obj->running())
 		{
-			if (i.action == QueueAction_Add)
-			{
-				i.action = QueueAction_Update;
-				_timedObjects.push_back(i);
-			}
+			obj->_poolIndex = activeCount;
+			_continuous[activeCount++] = obj;
 		}
-		_queue.clear();
+		else
+		{
+			obj->_poolState = TimedObject::PoolState::Detached;
+			obj->_hasSchedule = false;
+		}
+	}
+	_continuous.resize(activeCount);
+	_continuousCount = activeCount;
+}
+
+void TimerPool::attachContinuous(TimedObject* obj)
+{
+	obj->_poolState = TimedObject::PoolState::Continuous;
+	obj->_poolIndex = static_cast<uint32_t>(_continuous.size());
+	_continuous.emplace_back(obj);
+	++_continuousCount;
+}
+
+void TimerPool::attachScheduled(TimedObject* obj)
+{
+	obj->_poolState = TimedObject::PoolState::Scheduled;
+	_scheduled.emplace_back(nullptr);
+	placeScheduled(obj, static_cast<uint32_t>(_scheduled.size() - 1));
+	siftUp(obj->_poolIndex);
+}
+
+void TimerPool::removeScheduled(uint32_t index)
+{
+	TimedObject* last = _scheduled.back();
+	_scheduled.pop_back();
+
+	if (index < _scheduled.size())
+	{
+		placeScheduled(last, index);
+		siftUp(index);
+		siftDown(last->_poolIndex);
 	}
+}
 
-	_updating = true;
+void TimerPool::placeScheduled(TimedObject* obj, uint32_t index)
+{
+	_scheduled[index] = obj;
+	obj->_poolIndex = index;
+}
 
-	for (auto& object : _timedObjects)
+void TimerPool::siftUp(uint32_t index)
+{
+	TimedObject* obj = _scheduled[index];
+	while (index > 0)
 	{
-		auto updatableObject = object.object;
-		if ((object.action == QueueAction_Update) && updatableObject->running())
-			updatableObject->update(t);
+		uint32_t parent = (index - 1) / 2;
+		if (_scheduled[parent]->_scheduledTime <= obj->_scheduledTime)
+			break;
+
+		placeScheduled(_scheduled[parent], index);
+		index = parent;
 	}
+	placeScheduled(obj, index);
+}
 
-	auto e = std::remove_if(_timedObjects.begin(), _timedObjects.end(), [](const QueueEntry& entry)
-		{ return (entry.action == QueueAction_Remove) || (!entry.object->running()); });
-	_timedObjects.erase(e, _timedObjects.end());
+void TimerPool::siftDown(uint32_t index)
+{
+	TimedObject* obj = _scheduled[index];
+	uint32_t count = static_cast<uint32_t>(_scheduled.size());
+	for (;;)
+	{
+		uint32_t child = 2 * index + 1;
+		if (child >= count)
+			break;
 
-	_updating = false;
+		if ((child + 1 < count) && (_scheduled[child + 1]->_scheduledTime < _scheduled[child]->_scheduledTime))
+			++child;
+
+		if (obj->_scheduledTime <= _scheduled[child]->_scheduledTime)
+			break;
+
+		placeScheduled(_scheduled[child], index);
+		index = child;
+	}
+	placeScheduled(obj, index);
 }
 
 float TimerPool::actualTime() const
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <memory>
 #include <et/core/criticalsection.h>
 #include <et/core/timedobject.h>
 
@@ -32,37 +33,70 @@ namespace et
 		
 		bool hasObjects();
 
+		/*
+		 * Pool is locked while objects are updated, so shared objects lock it
+		 * to modify their state from other threads
+		 */
+		CriticalSection& criticalSection()
+			{ return _lock; }
+
+		/*
+		 * Object of type T owned by the pool (one per type), created on the first request.
+		 * Used by systems which update many objects at once, like animation managers.
+		 */
+		template <typename T, typename ... Args>
+		T& sharedObject(Args&&... args);
+
 	private:
 		ET_DENY_COPY(TimerPool);
-		
-		enum QueueAction
-		{
-			QueueAction_Add,
-			QueueAction_Update,
-			QueueAction_Remove
-		};
 
-		struct QueueEntry
-		{
-		public:
-			TimedObject* object;
-			QueueAction action;
+		friend class TimedObject;
 
-		public:
-			QueueEntry(TimedObject* o, QueueAction a) : 
-					object(o), action(a) { }
+		void scheduleTimedObject(TimedObject* obj, float time);
 
-			bool operator == (const QueueEntry& e)
-				{ return (e.object == object) && (e.action == action); }
-		};
+		void attachContinuous(TimedObject* obj);
+		void attachScheduled(TimedObject* obj);
+		void removeScheduled(uint32_t index);
+		void placeScheduled(TimedObject* obj, uint32_t index);
+		void siftUp(uint32_t index);
+		void siftDown(uint32_t index);
 
-		typedef std::vector<QueueEntry> TimerPoolQueue;
+		template <typename T>
+		static const void* sharedObjectKey()
+		{
+			static const char key = 0;
+			return &key;
+		}
 
 	private:
-		TimerPoolQueue _timedObjects;
-		TimerPoolQueue _queue;
+		/*
+		 * Objects store their index in one of the arrays (depending on their state),
+		 * so attach and detach never search. Continuous objects are updated every frame,
+		 * detached slots are set to null and compacted during the update.
+		 * Scheduled objects are kept in the binary heap ordered by the time of the next update,
+		 * only expired ones are moved to the due list and visited.
+		 */
+		Vector<TimedObject*> _continuous;
+		Vector<TimedObject*> _scheduled;
+		Vector<TimedObject*> _due;
+		uint32_t _continuousCount = 0;
 		CriticalSection _lock;
 		RunLoop* _owner = nullptr;
-		bool _updating = false;
+
+		/*
+		 * declared last, so shared objects are destroyed (and detached) while pool is still valid
+		 */
+		UnorderedMap<const void*, std::shared_ptr<void>> _sharedObjects;
 	};
+
+	template <typename T, typename ... Args>
+	inline T& TimerPool::sharedObject(Args&&... args)
+	{
+		CriticalSectionScope lock(_lock);
+		std::shared_ptr<void>& object = _sharedObjects[sharedObjectKey<T>()];
+		if (object == nullptr)
+			object = std::make_shared<T>(std::forward<Args>(args)...);
+
+		return *static_cast<T*>(object.get());
+	}
 }
@@ -25,13 +25,12 @@ intptr_t streamSize(std::istream& s)
 
 std::string loadTextFile(const std::string& fileName)
 {
-	InputStream file(fileName, StreamMode_Binary);
+	InputStream file(fileName, StreamMode_Mapped);
 	if (file.invalid()) return emptyString;
 
-	StringDataStorage data(static_cast<uint32_t>(streamSize(file.stream()) + 1), 0);
-	file.stream().read(data.data(), data.size());
-	
-	return std::string(data.data());
+	const char* begin = reinterpret_cast<const char*>(file.data());
+	const char* end = begin + file.size();
+	return std::string(begin, std::find(begin, end, 0));
 }
 
 std::string addTrailingSlash(const std::string& path)
@@ -0,0 +1,108 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/geometry/broadphase.h>
+#include <et/geometry/vector4-simd.h>
+
+using namespace et;
+
+void SweepAndPrune::findPairs(const BoundingBoxBatch& boxes, Vector<Pair>& pairs)
+{
+	pairs.clear();
+	sortOrder(boxes);
+
+	/*
+	 * sorted copy is padded with at least four inverted boxes,
+	 * so blocks starting at any box are loaded without bounds checks
+	 */
+	uint32_t count = boxes.size;
+	uint32_t paddedCount = ((count + 3) & ~3u) + 4;
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		_minVertex[c].resize(paddedCount);
+		_maxVertex[c].resize(paddedCount);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			_minVertex[c][i] = boxes.minVertex[c][_order[i]];
+			_maxVertex[c][i] = boxes.maxVertex[c][_order[i]];
+		}
+		std::fill(_minVertex[c].begin() + count, _minVertex[c].end(), std::numeric_limits<float>::max());
+		std::fill(_maxVertex[c].begin() + count, _maxVertex[c].end(), -std::numeric_limits<float>::max());
+	}
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		vec4simd maxX(_maxVertex[0][i]);
+		vec4simd minY(_minVertex[1][i]);
+		vec4simd maxY(_maxVertex[1][i]);
+		vec4simd minZ(_minVertex[2][i]);
+		vec4simd maxZ(_maxVertex[2][i]);
+
+		for (uint32_t j = i + 1; j < count; j += 4)
+		{
+			/*
+			 * boxes are sorted by minimal x, so once it is beyond the end of the box i,
+			 * none of the remaining boxes can overlap it
+			 */
+			uint32_t xMask = vec4simd(*reinterpret_cast<const vec4*>(_minVertex[0].data() + j)).lessOrEqualMask(maxX);
+			if (xMask == 0)
+				break;
+
+			vec4simd otherMinY(*reinterpret_cast<const vec4*>(_minVertex[1].data() + j));
+			vec4simd otherMaxY(*reinterpret_cast<const vec4*>(_maxVertex[1].data() + j));
+			vec4simd otherMinZ(*reinterpret_cast<const vec4*>(_minVertex[2].data() + j));
+			vec4simd otherMaxZ(*reinterpret_cast<const vec4*>(_maxVertex[2].data() + j));
+
+			uint32_t mask = xMask & otherMinY.lessOrEqualMask(maxY) & minY.lessOrEqualMask(otherMaxY) &
+				otherMinZ.lessOrEqualMask(maxZ) & minZ.lessOrEqualMask(otherMaxZ);
+
+			for (uint32_t lane = 0; (mask != 0) && (lane < 4); ++lane)
+			{
+				if (mask & (1 << lane))
+				{
+					uint32_t a = _order[i];
+					uint32_t b = _order[j + lane];
+					pairs.emplace_back(std::min(a, b), std::max(a, b));
+				}
+			}
+
+			if (xMask != 0x0f)
+				break;
+		}
+	}
+}
+
+void SweepAndPrune::sortOrder(const BoundingBoxBatch& boxes)
+{
+	const Vector<float>& minX = boxes.minVertex[0];
+
+	if (_order.size() != boxes.size)
+	{
+		_order.resize(boxes.size);
+		for (uint32_t i = 0; i < boxes.size; ++i)
+			_order[i] = i;
+		std::sort(_order.begin(), _order.end(), [&minX](uint32_t l, uint32_t r)
+			{ return minX[l] < minX[r]; });
+		return;
+	}
+
+	/*
+	 * insertion sort is close to linear when boxes move slightly between updates
+	 */
+	for (uint32_t i = 1; i < boxes.size; ++i)
+	{
+		uint32_t index = _order[i];
+		float value = minX[index];
+		uint32_t j = i;
+		while ((j > 0) && (minX[_order[j - 1]] > value))
+		{
+			_order[j] = _order[j - 1];
+			--j;
+		}
+		_order[j] = index;
+	}
+}
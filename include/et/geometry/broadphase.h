@@ -0,0 +1,45 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/geometry/collisionbatch.h>
+
+namespace et {
+
+/*
+ * Sweep and prune along x axis: boxes are sorted by their minimal x and each box is tested
+ * only against the following ones which start before it ends, four at a time.
+ * Order from the previous call is kept, so for coherent motion sorting takes only a few swaps.
+ */
+class SweepAndPrune
+{
+public:
+	using Pair = std::pair<uint32_t, uint32_t>;
+
+public:
+	/*
+	 * Outputs pairs of indices (first < second) of the overlapping boxes
+	 */
+	void findPairs(const BoundingBoxBatch& boxes, Vector<Pair>& pairs);
+
+	/*
+	 * Forget previous order, should be called when set of boxes changes
+	 */
+	void reset()
+		{ _order.clear(); }
+
+private:
+	void sortOrder(const BoundingBoxBatch& boxes);
+
+private:
+	Vector<uint32_t> _order;
+	Vector<float> _minVertex[3];
+	Vector<float> _maxVertex[3];
+};
+
+}
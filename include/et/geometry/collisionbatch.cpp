@@ -0,0 +1,467 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/geometry/collision.h>
+#include <et/geometry/collisionbatch.h>
+#include <et/geometry/vector4-simd.h>
+
+using namespace et;
+
+namespace
+{
+	inline uint32_t paddedSize(uint32_t size)
+	{
+		return (size + 3) & ~3u;
+	}
+
+	inline void growArrays(Vector<float>* arrays, uint32_t count, uint32_t size, float padding)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			arrays[i].resize(paddedSize(size), padding);
+	}
+
+	inline vec4simd loadBlock(const Vector<float>& values, uint32_t i)
+	{
+		return vec4simd(*reinterpret_cast<const vec4*>(values.data() + i));
+	}
+
+	inline vec4simd safeInverse(float value)
+	{
+		return vec4simd((std::abs(value) > std::numeric_limits<float>::epsilon()) ? 1.0f / value :
+			std::copysign(std::numeric_limits<float>::max(), value));
+	}
+
+	inline void appendIndices(uint32_t mask, uint32_t base, uint32_t size, Vector<uint32_t>& indices)
+	{
+		for (uint32_t lane = 0; (lane < 4) && (base + lane < size); ++lane)
+		{
+			if (mask & (1 << lane))
+				indices.emplace_back(base + lane);
+		}
+	}
+
+	const float maxFloat = std::numeric_limits<float>::max();
+	const float rayEpsilon = 0.00001f;
+}
+
+/*
+ * Batches
+ */
+void TriangleBatch::clear()
+{
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		v1[i].clear();
+		edge1[i].clear();
+		edge2[i].clear();
+	}
+	size = 0;
+}
+
+void TriangleBatch::reserve(uint32_t count)
+{
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		v1[i].reserve(paddedSize(count));
+		edge1[i].reserve(paddedSize(count));
+		edge2[i].reserve(paddedSize(count));
+	}
+}
+
+void TriangleBatch::push_back(const triangle& t)
+{
+	/*
+	 * padding triangles have zero edges, so determinant is zero and they are never hit
+	 */
+	growArrays(v1, 3, size + 1, 0.0f);
+	growArrays(edge1, 3, size + 1, 0.0f);
+	growArrays(edge2, 3, size + 1, 0.0f);
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		v1[i][size] = t.v1()[i];
+		edge1[i][size] = t.edge2to1()[i];
+		edge2[i][size] = t.edge3to1()[i];
+	}
+	++size;
+}
+
+triangle TriangleBatch::at(uint32_t i) const
+{
+	vec3 p1(v1[0][i], v1[1][i], v1[2][i]);
+	vec3 e1(edge1[0][i], edge1[1][i], edge1[2][i]);
+	vec3 e2(edge2[0][i], edge2[1][i], edge2[2][i]);
+	return triangle(p1, p1 + e1, p1 + e2);
+}
+
+void BoundingBoxBatch::clear()
+{
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		minVertex[i].clear();
+		maxVertex[i].clear();
+	}
+	size = 0;
+}
+
+void BoundingBoxBatch::reserve(uint32_t count)
+{
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		minVertex[i].reserve(paddedSize(count));
+		maxVertex[i].reserve(paddedSize(count));
+	}
+}
+
+void BoundingBoxBatch::push_back(const BoundingBox& box)
+{
+	/*
+	 * padding boxes are inverted (min > max) and contain nothing
+	 */
+	growArrays(minVertex, 3, size + 1, maxFloat);
+	growArrays(maxVertex, 3, size + 1, -maxFloat);
+	set(size++, box);
+}
+
+void BoundingBoxBatch::set(uint32_t i, const BoundingBox& box)
+{
+	vec3 minV = box.minVertex();
+	vec3 maxV = box.maxVertex();
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		minVertex[c][i] = minV[c];
+		maxVertex[c][i] = maxV[c];
+	}
+}
+
+BoundingBox BoundingBoxBatch::at(uint32_t i) const
+{
+	vec3 minV(minVertex[0][i], minVertex[1][i], minVertex[2][i]);
+	vec3 maxV(maxVertex[0][i], maxVertex[1][i], maxVertex[2][i]);
+	return BoundingBox(0.5f * (minV + maxV), 0.5f * (maxV - minV));
+}
+
+void SphereBatch::clear()
+{
+	for (uint32_t i = 0; i < 3; ++i)
+		center[i].clear();
+	radius.clear();
+	size = 0;
+}
+
+void SphereBatch::reserve(uint32_t count)
+{
+	for (uint32_t i = 0; i < 3; ++i)
+		center[i].reserve(paddedSize(count));
+	radius.reserve(paddedSize(count));
+}
+
+void SphereBatch::push_back(const Sphere& s)
+{
+	/*
+	 * padding spheres are infinitely far away
+	 */
+	growArrays(center, 3, size + 1, maxFloat);
+	growArrays(&radius, 1, size + 1, 0.0f);
+	set(size++, s);
+}
+
+void SphereBatch::set(uint32_t i, const Sphere& s)
+{
+	for (uint32_t c = 0; c < 3; ++c)
+		center[c][i] = s.center()[c];
+	radius[i] = s.radius();
+}
+
+Sphere SphereBatch::at(uint32_t i) const
+{
+	return Sphere(vec3(center[0][i], center[1][i], center[2][i]), radius[i]);
+}
+
+/*
+ * Ray tests
+ */
+uint32_t et::intersect::rayTriangles(const ray3d& r, const TriangleBatch& batch, float& distance)
+{
+	const vec4simd zero(0.0f);
+	const vec4simd one(1.0f);
+	const vec4simd epsilon(rayEpsilon);
+	const vec4simd epsilonSquared(rayEpsilon * rayEpsilon);
+	const vec4simd ox(r.origin.x), oy(r.origin.y), oz(r.origin.z);
+	const vec4simd dx(r.direction.x), dy(r.direction.y), dz(r.direction.z);
+
+	uint32_t result = InvalidIndex;
+	for (uint32_t i = 0; i < batch.size; i += 4)
+	{
+		vec4simd e1x = loadBlock(batch.edge1[0], i);
+		vec4simd e1y = loadBlock(batch.edge1[1], i);
+		vec4simd e1z = loadBlock(batch.edge1[2], i);
+		vec4simd e2x = loadBlock(batch.edge2[0], i);
+		vec4simd e2y = loadBlock(batch.edge2[1], i);
+		vec4simd e2z = loadBlock(batch.edge2[2], i);
+
+		vec4simd px = dy * e2z - dz * e2y;
+		vec4simd py = dz * e2x - dx * e2z;
+		vec4simd pz = dx * e2y - dy * e2x;
+		vec4simd det = e1x * px + e1y * py + e1z * pz;
+
+		uint32_t mask = epsilonSquared.lessThanMask(det * det);
+		if (mask == 0)
+			continue;
+
+		vec4simd invDet = one / det;
+		vec4simd sx = ox - loadBlock(batch.v1[0], i);
+		vec4simd sy = oy - loadBlock(batch.v1[1], i);
+		vec4simd sz = oz - loadBlock(batch.v1[2], i);
+
+		vec4simd u = (sx * px + sy * py + sz * pz) * invDet;
+		mask &= zero.lessOrEqualMask(u) & u.lessOrEqualMask(one);
+		if (mask == 0)
+			continue;
+
+		vec4simd qx = sy * e1z - sz * e1y;
+		vec4simd qy = sz * e1x - sx * e1z;
+		vec4simd qz = sx * e1y - sy * e1x;
+
+		vec4simd v = (dx * qx + dy * qy + dz * qz) * invDet;
+		mask &= zero.lessOrEqualMask(v) & (u + v).lessOrEqualMask(one);
+		if (mask == 0)
+			continue;
+
+		vec4simd t = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+		mask &= epsilon.lessThanMask(t) & t.lessThanMask(vec4simd(distance));
+		if (mask == 0)
+			continue;
+
+		ET_ALIGNED(16) float tValues[4];
+		t.loadToFloats(tValues);
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			if ((mask & (1 << lane)) && (tValues[lane] < distance))
+			{
+				distance = tValues[lane];
+				result = i + lane;
+			}
+		}
+	}
+	return result;
+}
+
+bool et::intersect::rayTrianglesAny(const ray3d& r, const TriangleBatch& batch, float maxDistance)
+{
+	const vec4simd zero(0.0f);
+	const vec4simd one(1.0f);
+	const vec4simd epsilon(rayEpsilon);
+	const vec4simd epsilonSquared(rayEpsilon * rayEpsilon);
+	const vec4simd maxT(maxDistance);
+	const vec4simd ox(r.origin.x), oy(r.origin.y), oz(r.origin.z);
+	const vec4simd dx(r.direction.x), dy(r.direction.y), dz(r.direction.z);
+
+	for (uint32_t i = 0; i < batch.size; i += 4)
+	{
+		vec4simd e1x = loadBlock(batch.edge1[0], i);
+		vec4simd e1y = loadBlock(batch.edge1[1], i);
+		vec4simd e1z = loadBlock(batch.edge1[2], i);
+		vec4simd e2x = loadBlock(batch.edge2[0], i);
+		vec4simd e2y = loadBlock(batch.edge2[1], i);
+		vec4simd e2z = loadBlock(batch.edge2[2], i);
+
+		vec4simd px = dy * e2z - dz * e2y;
+		vec4simd py = dz * e2x - dx * e2z;
+		vec4simd pz = dx * e2y - dy * e2x;
+		vec4simd det = e1x * px + e1y * py + e1z * pz;
+
+		uint32_t mask = epsilonSquared.lessThanMask(det * det);
+		if (mask == 0)
+			continue;
+
+		vec4simd invDet = one / det;
+		vec4simd sx = ox - loadBlock(batch.v1[0], i);
+		vec4simd sy = oy - loadBlock(batch.v1[1], i);
+		vec4simd sz = oz - loadBlock(batch.v1[2], i);
+
+		vec4simd u = (sx * px + sy * py + sz * pz) * invDet;
+		mask &= zero.lessOrEqualMask(u) & u.lessOrEqualMask(one);
+		if (mask == 0)
+			continue;
+
+		vec4simd qx = sy * e1z - sz * e1y;
+		vec4simd qy = sz * e1x - sx * e1z;
+		vec4simd qz = sx * e1y - sy * e1x;
+
+		vec4simd v = (dx * qx + dy * qy + dz * qz) * invDet;
+		vec4simd t = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+		mask &= zero.lessOrEqualMask(v) & (u + v).lessOrEqualMask(one) &
+			epsilon.lessThanMask(t) & t.lessThanMask(maxT);
+
+		if (mask != 0)
+			return true;
+	}
+	return false;
+}
+
+uint32_t et::intersect::raySpheres(const ray3d& r, const SphereBatch& batch, float& distance)
+{
+	const vec4simd zero(0.0f);
+	const vec4simd ox(r.origin.x), oy(r.origin.y), oz(r.origin.z);
+	const vec4simd dx(r.direction.x), dy(r.direction.y), dz(r.direction.z);
+
+	uint32_t result = InvalidIndex;
+	for (uint32_t i = 0; i < batch.size; i += 4)
+	{
+		vec4simd cx = ox - loadBlock(batch.center[0], i);
+		vec4simd cy = oy - loadBlock(batch.center[1], i);
+		vec4simd cz = oz - loadBlock(batch.center[2], i);
+		vec4simd radius = loadBlock(batch.radius, i);
+
+		vec4simd b = cx * dx + cy * dy + cz * dz;
+		vec4simd c = cx * cx + cy * cy + cz * cz - radius * radius;
+		vec4simd discriminant = b * b - c;
+
+		uint32_t mask = zero.lessOrEqualMask(discriminant);
+		if (mask == 0)
+			continue;
+
+		/*
+		 * nearest intersection in front of the origin, far one if origin is inside the sphere
+		 */
+		vec4simd root = discriminant.sqrt();
+		vec4simd tFar = root - b;
+		mask &= zero.lessOrEqualMask(tFar);
+		if (mask == 0)
+			continue;
+
+		ET_ALIGNED(16) float tNear[4];
+		ET_ALIGNED(16) float tFarValues[4];
+		(zero - b - root).loadToFloats(tNear);
+		tFar.loadToFloats(tFarValues);
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			if ((mask & (1 << lane)) == 0)
+				continue;
+
+			float t = (tNear[lane] >= 0.0f) ? tNear[lane] : tFarValues[lane];
+			if (t < distance)
+			{
+				distance = t;
+				result = i + lane;
+			}
+		}
+	}
+	return result;
+}
+
+uint32_t et::intersect::rayBoundingBoxes(const ray3d& r, const BoundingBoxBatch& batch, float maxDistance,
+	Vector<uint32_t>& indices)
+{
+	const vec4simd zero(0.0f);
+	const vec4simd maxT(maxDistance);
+	const vec4simd ox(r.origin.x), oy(r.origin.y), oz(r.origin.z);
+	const vec4simd ix = safeInverse(r.direction.x);
+	const vec4simd iy = safeInverse(r.direction.y);
+	const vec4simd iz = safeInverse(r.direction.z);
+
+	uint32_t initialSize = static_cast<uint32_t>(indices.size());
+	for (uint32_t i = 0; i < batch.size; i += 4)
+	{
+		vec4simd t0x = (loadBlock(batch.minVertex[0], i) - ox) * ix;
+		vec4simd t1x = (loadBlock(batch.maxVertex[0], i) - ox) * ix;
+		vec4simd t0y = (loadBlock(batch.minVertex[1], i) - oy) * iy;
+		vec4simd t1y = (loadBlock(batch.maxVertex[1], i) - oy) * iy;
+		vec4simd t0z = (loadBlock(batch.minVertex[2], i) - oz) * iz;
+		vec4simd t1z = (loadBlock(batch.maxVertex[2], i) - oz) * iz;
+
+		vec4simd tEnter = t0x.minWith(t1x).maxWith(t0y.minWith(t1y)).maxWith(t0z.minWith(t1z));
+		vec4simd tExit = t0x.maxWith(t1x).minWith(t0y.maxWith(t1y)).minWith(t0z.maxWith(t1z));
+
+		uint32_t mask = tEnter.lessOrEqualMask(tExit) & zero.lessOrEqualMask(tExit) & tEnter.lessOrEqualMask(maxT);
+		appendIndices(mask, i, batch.size, indices);
+	}
+	return static_cast<uint32_t>(indices.size()) - initialSize;
+}
+
+/*
+ * Sphere tests
+ */
+uint32_t et::intersect::sphereBoundingBoxes(const Sphere& s, const BoundingBoxBatch& batch, Vector<uint32_t>& indices)
+{
+	const vec4simd cx(s.center().x), cy(s.center().y), cz(s.center().z);
+	const vec4simd radiusSquared(s.radius() * s.radius());
+
+	uint32_t initialSize = static_cast<uint32_t>(indices.size());
+	for (uint32_t i = 0; i < batch.size; i += 4)
+	{
+		vec4simd px = cx.minWith(loadBlock(batch.maxVertex[0], i)).maxWith(loadBlock(batch.minVertex[0], i)) - cx;
+		vec4simd py = cy.minWith(loadBlock(batch.maxVertex[1], i)).maxWith(loadBlock(batch.minVertex[1], i)) - cy;
+		vec4simd pz = cz.minWith(loadBlock(batch.maxVertex[2], i)).maxWith(loadBlock(batch.minVertex[2], i)) - cz;
+
+		uint32_t mask = (px * px + py * py + pz * pz).lessOrEqualMask(radiusSquared);
+		appendIndices(mask, i, batch.size, indices);
+	}
+	return static_cast<uint32_t>(indices.size()) - initialSize;
+}
+
+uint32_t et::intersect::sphereSpheres(const Sphere& s, const SphereBatch& batch, Vector<uint32_t>& indices)
+{
+	const vec4simd cx(s.center().x), cy(s.center().y), cz(s.center().z);
+	const vec4simd radius(s.radius());
+
+	uint32_t initialSize = static_cast<uint32_t>(indices.size());
+	for (uint32_t i = 0; i < batch.size; i += 4)
+	{
+		vec4simd dx = loadBlock(batch.center[0], i) - cx;
+		vec4simd dy = loadBlock(batch.center[1], i) - cy;
+		vec4simd dz = loadBlock(batch.center[2], i) - cz;
+		vec4simd radii = loadBlock(batch.radius, i) + radius;
+
+		uint32_t mask = (dx * dx + dy * dy + dz * dz).lessOrEqualMask(radii * radii);
+		appendIndices(mask, i, batch.size, indices);
+	}
+	return static_cast<uint32_t>(indices.size()) - initialSize;
+}
+
+uint32_t et::intersect::sphereTriangles(const Sphere& s, const TriangleBatch& batch, Vector<uint32_t>& indices)
+{
+	const vec4simd zero(0.0f);
+	const vec4simd cx(s.center().x), cy(s.center().y), cz(s.center().z);
+	const vec4simd radiusSquared(s.radius() * s.radius());
+
+	uint32_t initialSize = static_cast<uint32_t>(indices.size());
+	for (uint32_t i = 0; i < batch.size; i += 4)
+	{
+		vec4simd e1x = loadBlock(batch.edge1[0], i);
+		vec4simd e1y = loadBlock(batch.edge1[1], i);
+		vec4simd e1z = loadBlock(batch.edge1[2], i);
+		vec4simd e2x = loadBlock(batch.edge2[0], i);
+		vec4simd e2y = loadBlock(batch.edge2[1], i);
+		vec4simd e2z = loadBlock(batch.edge2[2], i);
+
+		vec4simd nx = e1y * e2z - e1z * e2y;
+		vec4simd ny = e1z * e2x - e1x * e2z;
+		vec4simd nz = e1x * e2y - e1y * e2x;
+		vec4simd nSquared = nx * nx + ny * ny + nz * nz;
+
+		/*
+		 * distance to the plane compared without normalization: (dot(c - v1, n))^2 <= r^2 * |n|^2
+		 */
+		vec4simd d = (cx - loadBlock(batch.v1[0], i)) * nx + (cy - loadBlock(batch.v1[1], i)) * ny +
+			(cz - loadBlock(batch.v1[2], i)) * nz;
+
+		uint32_t mask = zero.lessThanMask(nSquared) & (d * d).lessOrEqualMask(radiusSquared * nSquared);
+		for (uint32_t lane = 0; (mask != 0) && (lane < 4); ++lane)
+		{
+			if ((mask & (1 << lane)) == 0)
+				continue;
+
+			vec3 point;
+			vec3 normal;
+			float penetration = 0.0f;
+			if (sphereTriangle(s, batch.at(i + lane), point, normal, penetration))
+				indices.emplace_back(i + lane);
+		}
+	}
+	return static_cast<uint32_t>(indices.size()) - initialSize;
+}
@@ -0,0 +1,97 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/geometry/geometry.h>
+
+namespace et {
+
+/*
+ * Structure of arrays storage for batched intersection tests.
+ * Sizes are padded to multiple of four with elements which never intersect anything.
+ */
+struct TriangleBatch
+{
+	Vector<float> v1[3];
+	Vector<float> edge1[3];
+	Vector<float> edge2[3];
+	uint32_t size = 0;
+
+	void clear();
+	void reserve(uint32_t);
+	void push_back(const triangle&);
+
+	triangle at(uint32_t) const;
+};
+
+struct BoundingBoxBatch
+{
+	Vector<float> minVertex[3];
+	Vector<float> maxVertex[3];
+	uint32_t size = 0;
+
+	void clear();
+	void reserve(uint32_t);
+	void push_back(const BoundingBox&);
+	void set(uint32_t, const BoundingBox&);
+
+	BoundingBox at(uint32_t) const;
+};
+
+struct SphereBatch
+{
+	Vector<float> center[3];
+	Vector<float> radius;
+	uint32_t size = 0;
+
+	void clear();
+	void reserve(uint32_t);
+	void push_back(const Sphere&);
+	void set(uint32_t, const Sphere&);
+
+	Sphere at(uint32_t) const;
+};
+
+/*
+ * Tests of one ray or sphere against whole batch, four elements at a time
+ */
+namespace intersect {
+
+const uint32_t InvalidIndex = static_cast<uint32_t>(-1);
+
+/*
+ * Closest hit (two-sided), returns index of the triangle or InvalidIndex,
+ * distance is in/out: hits farther than the input value are ignored
+ */
+uint32_t rayTriangles(const ray3d&, const TriangleBatch&, float& distance);
+
+/*
+ * Returns as soon as any hit closer than maxDistance is found
+ */
+bool rayTrianglesAny(const ray3d&, const TriangleBatch&, float maxDistance);
+
+/*
+ * Nearest intersection in front of the ray origin (exit point if origin is inside the sphere)
+ */
+uint32_t raySpheres(const ray3d&, const SphereBatch&, float& distance);
+
+/*
+ * Output indices of intersected elements, returns their count
+ */
+uint32_t rayBoundingBoxes(const ray3d&, const BoundingBoxBatch&, float maxDistance, Vector<uint32_t>& indices);
+uint32_t sphereBoundingBoxes(const Sphere&, const BoundingBoxBatch&, Vector<uint32_t>& indices);
+uint32_t sphereSpheres(const Sphere&, const SphereBatch&, Vector<uint32_t>& indices);
+
+/*
+ * Triangles are rejected by distance to their planes four at a time,
+ * the rest are tested with sphereTriangle
+ */
+uint32_t sphereTriangles(const Sphere&, const TriangleBatch&, Vector<uint32_t>& indices);
+
+}
+}
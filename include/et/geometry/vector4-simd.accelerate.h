@@ -147,6 +147,26 @@ public:
 		return false;
 	}
 
+	vec4simd maxWith(const vec4simd& r) const {
+		return vec4simd(std::max(_vector[0], r._vector[0]), std::max(_vector[1], r._vector[1]),
+			std::max(_vector[2], r._vector[2]), std::max(_vector[3], r._vector[3]));
+	}
+
+	vec4simd minWith(const vec4simd& r) const {
+		return vec4simd(std::min(_vector[0], r._vector[0]), std::min(_vector[1], r._vector[1]),
+			std::min(_vector[2], r._vector[2]), std::min(_vector[3], r._vector[3]));
+	}
+
+	uint32_t lessThanMask(const vec4simd& r) const {
+		return (_vector[0] < r._vector[0] ? 1 : 0) | (_vector[1] < r._vector[1] ? 2 : 0) |
+			(_vector[2] < r._vector[2] ? 4 : 0) | (_vector[3] < r._vector[3] ? 8 : 0);
+	}
+
+	uint32_t lessOrEqualMask(const vec4simd& r) const {
+		return (_vector[0] <= r._vector[0] ? 1 : 0) | (_vector[1] <= r._vector[1] ? 2 : 0) |
+			(_vector[2] <= r._vector[2] ? 4 : 0) | (_vector[3] <= r._vector[3] ? 8 : 0);
+	}
+
 	vec4simd sqrt() const {
 		return vec4simd(vsqrtf(_data));
 	}
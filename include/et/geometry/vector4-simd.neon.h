@@ -55,6 +55,12 @@ namespace et
 		
 		const float32x4_t& data() const
 			{ return _data; }
+
+		static uint32_t movemask(const uint32x4_t& m)
+		{
+			return (vgetq_lane_u32(m, 0) & 1) | (vgetq_lane_u32(m, 1) & 2) |
+				(vgetq_lane_u32(m, 2) & 4) | (vgetq_lane_u32(m, 3) & 8);
+		}
 	
 	public:
 		void clear()
@@ -182,6 +188,26 @@ namespace et
 		{
 			return (_data[0] < r._data[0]);
 		}
+
+		vec4simd maxWith(const vec4simd& r) const
+		{
+			return vec4simd(vmaxq_f32(_data, r._data));
+		}
+
+		vec4simd minWith(const vec4simd& r) const
+		{
+			return vec4simd(vminq_f32(_data, r._data));
+		}
+
+		uint32_t lessThanMask(const vec4simd& r) const
+		{
+			return movemask(vcltq_f32(_data, r._data));
+		}
+
+		uint32_t lessOrEqualMask(const vec4simd& r) const
+		{
+			return movemask(vcleq_f32(_data, r._data));
+		}
 				
 		vec4simd sqrt() const
 		{
@@ -171,6 +171,17 @@ public:
 		return vec4simd(_mm_min_ps(_data, v._data));
 	}
 
+	/*
+	 * bit i of the mask is set when comparison holds for the component i
+	 */
+	uint32_t lessThanMask(const vec4simd& r) const {
+		return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(_data, r._data)));
+	}
+
+	uint32_t lessOrEqualMask(const vec4simd& r) const {
+		return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(_data, r._data)));
+	}
+
 public:
 	vec4simd & operator += (const vec4simd& r) {
 		_data = _mm_add_ps(_data, r._data);
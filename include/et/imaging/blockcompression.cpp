@@ -0,0 +1,830 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/parallel.h>
+#include <et/imaging/ddsloader.h>
+#include <et/imaging/blockcompression.h>
+
+namespace et {
+namespace bc {
+
+/*
+ * Encoders work on 16 pixels with 4 float channels each,
+ * loops over channels and pixels are kept simple so compiler could vectorize them.
+ */
+using BlockPixels = float[16][4];
+
+const uint32_t allPixelsMask = 0xffff;
+const float bc1Weights4[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+const float bc1Weights3[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+const float bc4Weights8[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+const int32_t bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BitWriter
+{
+	uint8_t* data = nullptr;
+	uint32_t position = 0;
+
+	BitWriter(uint8_t* d) : data(d) { }
+
+	void write(uint32_t value, uint32_t bits) {
+		for (uint32_t b = 0; b < bits; ++b, ++position) {
+			if (value & (1u << b))
+				data[position / 8] |= static_cast<uint8_t>(1u << (position % 8));
+		}
+	}
+};
+
+uint32_t refinementIterations(BlockCompressionQuality quality) {
+	switch (quality) {
+	case BlockCompressionQuality::Fast:
+		return 0;
+	case BlockCompressionQuality::Normal:
+		return 1;
+	default:
+		return 4;
+	}
+}
+
+void loadBlockPixels(const vec4ub* pixels, BlockPixels& p) {
+	for (uint32_t i = 0; i < 16; ++i) {
+		for (uint32_t c = 0; c < 4; ++c)
+			p[i][c] = static_cast<float>(pixels[i][c]);
+	}
+}
+
+template <uint32_t N>
+float squaredDistance(const float* a, const float* b) {
+	float result = 0.0f;
+	for (uint32_t c = 0; c < N; ++c)
+		result += (a[c] - b[c]) * (a[c] - b[c]);
+	return result;
+}
+
+template <uint32_t N>
+void boundingBoxEndpoints(const BlockPixels& p, uint32_t mask, float* e0, float* e1) {
+	float minValue[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+	float maxValue[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (uint32_t i = 0; i < 16; ++i) {
+		if (mask & (1u << i)) {
+			for (uint32_t c = 0; c < N; ++c) {
+				minValue[c] = std::min(minValue[c], p[i][c]);
+				maxValue[c] = std::max(maxValue[c], p[i][c]);
+			}
+		}
+	}
+
+	// inset by 1/16 of the range, endpoints are rarely hit exactly by interpolated values
+	uint32_t mainChannel = 0;
+	for (uint32_t c = 0; c < N; ++c) {
+		float inset = std::max(0.0f, maxValue[c] - minValue[c]) / 16.0f;
+		e0[c] = std::min(255.0f, minValue[c] + inset);
+		e1[c] = std::max(0.0f, maxValue[c] - inset);
+		if (maxValue[c] - minValue[c] > maxValue[mainChannel] - minValue[mainChannel])
+			mainChannel = c;
+	}
+
+	// flip diagonal of the box for channels anti-correlated with the most varying one
+	float center[4] = { };
+	for (uint32_t c = 0; c < N; ++c)
+		center[c] = 0.5f * (minValue[c] + maxValue[c]);
+
+	float correlation[4] = { };
+	for (uint32_t i = 0; i < 16; ++i) {
+		if (mask & (1u << i)) {
+			for (uint32_t c = 0; c < N; ++c)
+				correlation[c] += (p[i][c] - center[c]) * (p[i][mainChannel] - center[mainChannel]);
+		}
+	}
+	for (uint32_t c = 0; c < N; ++c) {
+		if (correlation[c] < 0.0f)
+			std::swap(e0[c], e1[c]);
+	}
+}
+
+template <uint32_t N>
+void principalAxisEndpoints(const BlockPixels& p, uint32_t mask, float* e0, float* e1) {
+	float mean[4] = { };
+	float count = 0.0f;
+	for (uint32_t i = 0; i < 16; ++i) {
+		if (mask & (1u << i)) {
+			for (uint32_t c = 0; c < N; ++c)
+				mean[c] += p[i][c];
+			count += 1.0f;
+		}
+	}
+	if (count == 0.0f) {
+		std::fill(e0, e0 + N, 0.0f);
+		std::fill(e1, e1 + N, 0.0f);
+		return;
+	}
+	for (uint32_t c = 0; c < N; ++c)
+		mean[c] /= count;
+
+	float covariance[4][4] = { };
+	for (uint32_t i = 0; i < 16; ++i) {
+		if (mask & (1u << i)) {
+			float d[4] = { };
+			for (uint32_t c = 0; c < N; ++c)
+				d[c] = p[i][c] - mean[c];
+			for (uint32_t a = 0; a < N; ++a) {
+				for (uint32_t b = 0; b < N; ++b)
+					covariance[a][b] += d[a] * d[b];
+			}
+		}
+	}
+
+	// power iteration, seeded with the row of the most varying channel
+	uint32_t seed = 0;
+	for (uint32_t c = 1; c < N; ++c) {
+		if (covariance[c][c] > covariance[seed][seed])
+			seed = c;
+	}
+
+	float axis[4] = { };
+	for (uint32_t c = 0; c < N; ++c)
+		axis[c] = covariance[seed][c];
+
+	for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+		float next[4] = { };
+		float maxComponent = 0.0f;
+		for (uint32_t a = 0; a < N; ++a) {
+			for (uint32_t b = 0; b < N; ++b)
+				next[a] += covariance[a][b] * axis[b];
+			maxComponent = std::max(maxComponent, std::abs(next[a]));
+		}
+		if (maxComponent < std::numeric_limits<float>::epsilon())
+			break;
+
+		for (uint32_t c = 0; c < N; ++c)
+			axis[c] = next[c] / maxComponent;
+	}
+
+	float zero[4] = { };
+	float axisLength = std::sqrt(squaredDistance<N>(axis, zero));
+
+	if (axisLength < std::numeric_limits<float>::epsilon()) {
+		std::copy(mean, mean + N, e0);
+		std::copy(mean, mean + N, e1);
+		return;
+	}
+	for (uint32_t c = 0; c < N; ++c)
+		axis[c] /= axisLength;
+
+	float tMin = std::numeric_limits<float>::max();
+	float tMax = -std::numeric_limits<float>::max();
+	for (uint32_t i = 0; i < 16; ++i) {
+		if (mask & (1u << i)) {
+			float t = 0.0f;
+			for (uint32_t c = 0; c < N; ++c)
+				t += (p[i][c] - mean[c]) * axis[c];
+			tMin = std::min(tMin, t);
+			tMax = std::max(tMax, t);
+		}
+	}
+
+	for (uint32_t c = 0; c < N; ++c) {
+		e0[c] = clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+		e1[c] = clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+	}
+}
+
+/*
+ * Finds endpoints minimizing squared error for the given interpolation weights:
+ * x[i] ~ (1 - w[i]) * e0 + w[i] * e1
+ */
+template <uint32_t N>
+bool leastSquaresEndpoints(const BlockPixels& p, uint32_t mask, const float* weights, float* e0, float* e1) {
+	float aa = 0.0f;
+	float bb = 0.0f;
+	float ab = 0.0f;
+	float ax[4] = { };
+	float bx[4] = { };
+	for (uint32_t i = 0; i < 16; ++i) {
+		if (mask & (1u << i)) {
+			float b = weights[i];
+			float a = 1.0f - b;
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			for (uint32_t c = 0; c < N; ++c) {
+				ax[c] += a * p[i][c];
+				bx[c] += b * p[i][c];
+			}
+		}
+	}
+
+	float determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) < 1.0e-5f)
+		return false;
+
+	float invDeterminant = 1.0f / determinant;
+	for (uint32_t c = 0; c < N; ++c) {
+		e0[c] = clamp((ax[c] * bb - bx[c] * ab) * invDeterminant, 0.0f, 255.0f);
+		e1[c] = clamp((bx[c] * aa - ax[c] * ab) * invDeterminant, 0.0f, 255.0f);
+	}
+	return true;
+}
+
+/*
+ * BC1 color block
+ */
+uint16_t packColor565(const float* c) {
+	uint32_t r = static_cast<uint32_t>(c[0] * 31.0f / 255.0f + 0.5f);
+	uint32_t g = static_cast<uint32_t>(c[1] * 63.0f / 255.0f + 0.5f);
+	uint32_t b = static_cast<uint32_t>(c[2] * 31.0f / 255.0f + 0.5f);
+	return static_cast<uint16_t>((std::min(r, 31u) << 11) | (std::min(g, 63u) << 5) | std::min(b, 31u));
+}
+
+void unpackColor565(uint16_t value, float* c) {
+	uint32_t r = (value >> 11) & 31;
+	uint32_t g = (value >> 5) & 63;
+	uint32_t b = value & 31;
+	c[0] = static_cast<float>((r << 3) | (r >> 2));
+	c[1] = static_cast<float>((g << 2) | (g >> 4));
+	c[2] = static_cast<float>((b << 3) | (b >> 2));
+}
+
+struct ColorBlockCandidate
+{
+	uint16_t color0 = 0;
+	uint16_t color1 = 0;
+	uint32_t indices = 0;
+	float weights[16] = { };
+	float error = std::numeric_limits<float>::max();
+};
+
+void evaluateColorBlock(const BlockPixels& p, uint32_t mask, bool threeColorMode, ColorBlockCandidate& candidate) {
+	float palette[4][4] = { };
+	unpackColor565(candidate.color0, palette[0]);
+	unpackColor565(candidate.color1, palette[1]);
+
+	uint32_t paletteSize = 4;
+	const float* weights = bc1Weights4;
+	if (threeColorMode) {
+		for (uint32_t c = 0; c < 3; ++c)
+			palette[2][c] = 0.5f * (palette[0][c] + palette[1][c]);
+		paletteSize = 3;
+		weights = bc1Weights3;
+	}
+	else if (candidate.color0 == candidate.color1) {
+		// decoder switches to three color mode, index 0 is still valid
+		paletteSize = 1;
+	}
+	else {
+		for (uint32_t c = 0; c < 3; ++c) {
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+	}
+
+	candidate.indices = 0;
+	candidate.error = 0.0f;
+	for (uint32_t i = 0; i < 16; ++i) {
+		if ((mask & (1u << i)) == 0) {
+			candidate.indices |= 3u << (2 * i);
+			candidate.weights[i] = 0.0f;
+			continue;
+		}
+
+		uint32_t bestIndex = 0;
+		float bestError = squaredDistance<3>(p[i], palette[0]);
+		for (uint32_t k = 1; k < paletteSize; ++k) {
+			float error = squaredDistance<3>(p[i], palette[k]);
+			if (error < bestError) {
+				bestError = error;
+				bestIndex = k;
+			}
+		}
+		candidate.indices |= bestIndex << (2 * i);
+		candidate.weights[i] = weights[bestIndex];
+		candidate.error += bestError;
+	}
+}
+
+void evaluateColorEndpoints(const BlockPixels& p, uint32_t mask, bool threeColorMode, const float* e0, const float* e1,
+	ColorBlockCandidate& candidate) {
+	candidate.color0 = packColor565(e0);
+	candidate.color1 = packColor565(e1);
+
+	// four color mode requires color0 > color1, three color mode - color0 <= color1
+	bool needsSwap = threeColorMode ? (candidate.color0 > candidate.color1) : (candidate.color0 < candidate.color1);
+	if (needsSwap)
+		std::swap(candidate.color0, candidate.color1);
+
+	evaluateColorBlock(p, mask, threeColorMode, candidate);
+}
+
+void encodeColorBlock(const BlockPixels& p, uint32_t mask, bool threeColorMode, BlockCompressionQuality quality, uint8_t* output) {
+	ColorBlockCandidate best;
+	if (mask == 0) {
+		best.indices = 0xffffffff;
+	}
+	else {
+		float e0[4] = { };
+		float e1[4] = { };
+		if (quality == BlockCompressionQuality::Fast)
+			boundingBoxEndpoints<3>(p, mask, e0, e1);
+		else
+			principalAxisEndpoints<3>(p, mask, e0, e1);
+
+		evaluateColorEndpoints(p, mask, threeColorMode, e0, e1, best);
+
+		for (uint32_t iteration = 0, e = refinementIterations(quality); (iteration < e) && (best.error > 0.0f); ++iteration) {
+			float r0[4] = { };
+			float r1[4] = { };
+			if (!leastSquaresEndpoints<3>(p, mask, best.weights, r0, r1))
+				break;
+
+			ColorBlockCandidate refined;
+			evaluateColorEndpoints(p, mask, threeColorMode, r0, r1, refined);
+			if (refined.error >= best.error)
+				break;
+
+			best = refined;
+		}
+	}
+
+	output[0] = static_cast<uint8_t>(best.color0 & 0xff);
+	output[1] = static_cast<uint8_t>(best.color0 >> 8);
+	output[2] = static_cast<uint8_t>(best.color1 & 0xff);
+	output[3] = static_cast<uint8_t>(best.color1 >> 8);
+	for (uint32_t i = 0; i < 4; ++i)
+		output[4 + i] = static_cast<uint8_t>((best.indices >> (8 * i)) & 0xff);
+}
+
+/*
+ * BC4 single channel block, used for BC3 alpha and BC5 channels
+ */
+float evaluateSingleChannelBlock(const float* values, uint8_t a0, uint8_t a1, uint64_t& indices, float* weights) {
+	float palette[8] = { static_cast<float>(a0), static_cast<float>(a1) };
+	bool eightValues = a0 > a1;
+	if (eightValues) {
+		for (uint32_t k = 1; k < 7; ++k)
+			palette[k + 1] = (static_cast<float>(7 - k) * palette[0] + static_cast<float>(k) * palette[1]) / 7.0f;
+	}
+	else {
+		for (uint32_t k = 1; k < 5; ++k)
+			palette[k + 1] = (static_cast<float>(5 - k) * palette[0] + static_cast<float>(k) * palette[1]) / 5.0f;
+		palette[6] = 0.0f;
+		palette[7] = 255.0f;
+	}
+
+	float error = 0.0f;
+	indices = 0;
+	for (uint32_t i = 0; i < 16; ++i) {
+		uint32_t bestIndex = 0;
+		float bestError = std::abs(values[i] - palette[0]);
+		for (uint32_t k = 1; k < 8; ++k) {
+			float e = std::abs(values[i] - palette[k]);
+			if (e < bestError) {
+				bestError = e;
+				bestIndex = k;
+			}
+		}
+		indices |= static_cast<uint64_t>(bestIndex) << (3 * i);
+		if (weights != nullptr)
+			weights[i] = bc4Weights8[bestIndex];
+		error += bestError * bestError;
+	}
+	return error;
+}
+
+void encodeSingleChannelBlock(const BlockPixels& p, uint32_t channel, BlockCompressionQuality quality, uint8_t* output) {
+	float values[16] = { };
+	float minValue = 255.0f;
+	float maxValue = 0.0f;
+	float innerMin = 255.0f;
+	float innerMax = 0.0f;
+	for (uint32_t i = 0; i < 16; ++i) {
+		values[i] = p[i][channel];
+		minValue = std::min(minValue, values[i]);
+		maxValue = std::max(maxValue, values[i]);
+		if ((values[i] > 0.0f) && (values[i] < 255.0f)) {
+			innerMin = std::min(innerMin, values[i]);
+			innerMax = std::max(innerMax, values[i]);
+		}
+	}
+
+	uint8_t a0 = static_cast<uint8_t>(maxValue);
+	uint8_t a1 = static_cast<uint8_t>(minValue);
+	uint64_t indices = 0;
+	float weights[16] = { };
+	float error = evaluateSingleChannelBlock(values, a0, a1, indices, weights);
+
+	if (a0 > a1) {
+		for (uint32_t iteration = 0, e = refinementIterations(quality); (iteration < e) && (error > 0.0f); ++iteration) {
+			BlockPixels channelPixels = { };
+			for (uint32_t i = 0; i < 16; ++i)
+				channelPixels[i][0] = values[i];
+
+			float r0 = 0.0f;
+			float r1 = 0.0f;
+			if (!leastSquaresEndpoints<1>(channelPixels, allPixelsMask, weights, &r0, &r1))
+				break;
+
+			uint8_t b0 = static_cast<uint8_t>(r0 + 0.5f);
+			uint8_t b1 = static_cast<uint8_t>(r1 + 0.5f);
+			if (b0 <= b1)
+				break;
+
+			uint64_t refinedIndices = 0;
+			float refinedWeights[16] = { };
+			float refinedError = evaluateSingleChannelBlock(values, b0, b1, refinedIndices, refinedWeights);
+			if (refinedError >= error)
+				break;
+
+			a0 = b0;
+			a1 = b1;
+			indices = refinedIndices;
+			error = refinedError;
+			std::copy(refinedWeights, refinedWeights + 16, weights);
+		}
+	}
+
+	// six values mode with explicit 0 and 255 helps blocks with hard edges
+	if ((quality != BlockCompressionQuality::Fast) && (innerMin <= innerMax) && (error > 0.0f)) {
+		uint64_t sixIndices = 0;
+		uint8_t b0 = static_cast<uint8_t>(innerMin);
+		uint8_t b1 = static_cast<uint8_t>(innerMax);
+		float sixError = evaluateSingleChannelBlock(values, b0, b1, sixIndices, nullptr);
+		if (sixError < error) {
+			a0 = b0;
+			a1 = b1;
+			indices = sixIndices;
+		}
+	}
+
+	output[0] = a0;
+	output[1] = a1;
+	for (uint32_t i = 0; i < 6; ++i)
+		output[2 + i] = static_cast<uint8_t>((indices >> (8 * i)) & 0xff);
+}
+
+/*
+ * BC7, mode 6: single subset, RGBA 7.7.7.7 endpoints with unique p-bits, 4-bit indices
+ */
+struct BC7Candidate
+{
+	uint8_t endpoints[2][4] = { };
+	uint32_t pbits[2] = { };
+	uint8_t indices[16] = { };
+	float weights[16] = { };
+	float error = std::numeric_limits<float>::max();
+};
+
+void quantizeBC7Endpoint(const float* e, uint32_t pbit, uint8_t* q) {
+	for (uint32_t c = 0; c < 4; ++c) {
+		int32_t value = static_cast<int32_t>((e[c] - static_cast<float>(pbit)) * 0.5f + 0.5f);
+		q[c] = static_cast<uint8_t>((clamp(value, 0, 127) << 1) | static_cast<int32_t>(pbit));
+	}
+}
+
+float endpointQuantizationError(const float* e, const uint8_t* q) {
+	float error = 0.0f;
+	for (uint32_t c = 0; c < 4; ++c)
+		error += (e[c] - static_cast<float>(q[c])) * (e[c] - static_cast<float>(q[c]));
+	return error;
+}
+
+void evaluateBC7Block(const BlockPixels& p, BC7Candidate& candidate) {
+	float palette[16][4];
+	for (uint32_t k = 0; k < 16; ++k) {
+		int32_t w = bc7Weights4[k];
+		for (uint32_t c = 0; c < 4; ++c) {
+			int32_t value = ((64 - w) * candidate.endpoints[0][c] + w * candidate.endpoints[1][c] + 32) >> 6;
+			palette[k][c] = static_cast<float>(value);
+		}
+	}
+
+	candidate.error = 0.0f;
+	for (uint32_t i = 0; i < 16; ++i) {
+		uint32_t bestIndex = 0;
+		float bestError = squaredDistance<4>(p[i], palette[0]);
+		for (uint32_t k = 1; k < 16; ++k) {
+			float error = squaredDistance<4>(p[i], palette[k]);
+			if (error < bestError) {
+				bestError = error;
+				bestIndex = k;
+			}
+		}
+		candidate.indices[i] = static_cast<uint8_t>(bestIndex);
+		candidate.weights[i] = static_cast<float>(bc7Weights4[bestIndex]) / 64.0f;
+		candidate.error += bestError;
+	}
+}
+
+void evaluateBC7Endpoints(const BlockPixels& p, const float* e0, const float* e1, bool searchPBits, BC7Candidate& best) {
+	if (searchPBits) {
+		for (uint32_t pbits = 0; pbits < 4; ++pbits) {
+			BC7Candidate candidate;
+			candidate.pbits[0] = pbits & 1;
+			candidate.pbits[1] = pbits >> 1;
+			quantizeBC7Endpoint(e0, candidate.pbits[0], candidate.endpoints[0]);
+			quantizeBC7Endpoint(e1, candidate.pbits[1], candidate.endpoints[1]);
+			evaluateBC7Block(p, candidate);
+			if (candidate.error < best.error)
+				best = candidate;
+		}
+	}
+	else {
+		BC7Candidate candidate;
+		const float* e[2] = { e0, e1 };
+		for (uint32_t i = 0; i < 2; ++i) {
+			uint8_t q0[4] = { };
+			uint8_t q1[4] = { };
+			quantizeBC7Endpoint(e[i], 0, q0);
+			quantizeBC7Endpoint(e[i], 1, q1);
+			candidate.pbits[i] = (endpointQuantizationError(e[i], q1) < endpointQuantizationError(e[i], q0)) ? 1 : 0;
+			std::copy(candidate.pbits[i] ? q1 : q0, (candidate.pbits[i] ? q1 : q0) + 4, candidate.endpoints[i]);
+		}
+		evaluateBC7Block(p, candidate);
+		if (candidate.error < best.error)
+			best = candidate;
+	}
+}
+
+/*
+ * Public interface
+ */
+void compressBlockBC1(const vec4ub* pixels, uint8_t* output, BlockCompressionQuality quality, bool allowTransparency) {
+	BlockPixels p;
+	loadBlockPixels(pixels, p);
+
+	uint32_t opaqueMask = allPixelsMask;
+	if (allowTransparency) {
+		for (uint32_t i = 0; i < 16; ++i) {
+			if (pixels[i].w < 128)
+				opaqueMask &= ~(1u << i);
+		}
+	}
+	encodeColorBlock(p, opaqueMask, opaqueMask != allPixelsMask, quality, output);
+}
+
+void compressBlockBC2(const vec4ub* pixels, uint8_t* output, BlockCompressionQuality quality) {
+	for (uint32_t i = 0; i < 8; ++i) {
+		uint32_t a0 = (static_cast<uint32_t>(pixels[2 * i + 0].w) * 15 + 127) / 255;
+		uint32_t a1 = (static_cast<uint32_t>(pixels[2 * i + 1].w) * 15 + 127) / 255;
+		output[i] = static_cast<uint8_t>(a0 | (a1 << 4));
+	}
+
+	BlockPixels p;
+	loadBlockPixels(pixels, p);
+	encodeColorBlock(p, allPixelsMask, false, quality, output + 8);
+}
+
+void compressBlockBC3(const vec4ub* pixels, uint8_t* output, BlockCompressionQuality quality) {
+	BlockPixels p;
+	loadBlockPixels(pixels, p);
+	encodeSingleChannelBlock(p, 3, quality, output);
+	encodeColorBlock(p, allPixelsMask, false, quality, output + 8);
+}
+
+void compressBlockBC5(const vec4ub* pixels, uint8_t* output, BlockCompressionQuality quality) {
+	BlockPixels p;
+	loadBlockPixels(pixels, p);
+	encodeSingleChannelBlock(p, 0, quality, output);
+	encodeSingleChannelBlock(p, 1, quality, output + 8);
+}
+
+void compressBlockBC7(const vec4ub* pixels, uint8_t* output, BlockCompressionQuality quality) {
+	BlockPixels p;
+	loadBlockPixels(pixels, p);
+
+	float e0[4] = { };
+	float e1[4] = { };
+	if (quality == BlockCompressionQuality::Fast)
+		boundingBoxEndpoints<4>(p, allPixelsMask, e0, e1);
+	else
+		principalAxisEndpoints<4>(p, allPixelsMask, e0, e1);
+
+	bool searchPBits = (quality == BlockCompressionQuality::Best);
+
+	BC7Candidate best;
+	evaluateBC7Endpoints(p, e0, e1, searchPBits, best);
+	for (uint32_t iteration = 0, e = refinementIterations(quality); (iteration < e) && (best.error > 0.0f); ++iteration) {
+		if (!leastSquaresEndpoints<4>(p, allPixelsMask, best.weights, e0, e1))
+			break;
+
+		BC7Candidate refined = best;
+		refined.error = std::numeric_limits<float>::max();
+		evaluateBC7Endpoints(p, e0, e1, searchPBits, refined);
+		if (refined.error >= best.error)
+			break;
+
+		best = refined;
+	}
+
+	// anchor index (pixel 0) is stored without most significant bit
+	if (best.indices[0] & 8) {
+		std::swap(best.endpoints[0], best.endpoints[1]);
+		std::swap(best.pbits[0], best.pbits[1]);
+		for (uint8_t& index : best.indices)
+			index = static_cast<uint8_t>(15 - index);
+	}
+
+	std::fill(output, output + 16, static_cast<uint8_t>(0));
+	BitWriter writer(output);
+	writer.write(1u << 6, 7);
+	for (uint32_t c = 0; c < 4; ++c) {
+		writer.write(best.endpoints[0][c] >> 1, 7);
+		writer.write(best.endpoints[1][c] >> 1, 7);
+	}
+	writer.write(best.pbits[0], 1);
+	writer.write(best.pbits[1], 1);
+	writer.write(best.indices[0], 3);
+	for (uint32_t i = 1; i < 16; ++i)
+		writer.write(best.indices[i], 4);
+	ET_ASSERT(writer.position == 128);
+}
+
+bool isSupportedFormat(TextureFormat format) {
+	return blockDataSize(format) > 0;
+}
+
+uint32_t blockDataSize(TextureFormat format) {
+	switch (format) {
+	case TextureFormat::DXT1_RGB:
+	case TextureFormat::DXT1_RGBA:
+		return 8;
+
+	case TextureFormat::DXT3:
+	case TextureFormat::DXT5:
+	case TextureFormat::RGTC2:
+	case TextureFormat::BC7:
+		return 16;
+
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Texture level processing
+ */
+struct SourceLevel
+{
+	vec2i size;
+	Vector<vec4ub> pixels;
+};
+
+bool convertToRGBA8(const TextureDescription& source, uint32_t offset, const vec2i& size, Vector<vec4ub>& pixels) {
+	uint32_t pixelsCount = static_cast<uint32_t>(size.square());
+	uint32_t bytesPerPixel = bitsPerPixelForTextureFormat(source.format) / 8;
+	if (offset + pixelsCount * bytesPerPixel > source.data.size()) {
+		log::error("Unable to compress texture %s: not enough data", source.origin().c_str());
+		return false;
+	}
+
+	pixels.resize(pixelsCount);
+	const uint8_t* ptr = source.data.data() + offset;
+	switch (source.format) {
+	case TextureFormat::R8: {
+		for (uint32_t i = 0; i < pixelsCount; ++i)
+			pixels[i] = vec4ub(ptr[i], ptr[i], ptr[i], 255);
+		break;
+	}
+	case TextureFormat::RG8: {
+		for (uint32_t i = 0; i < pixelsCount; ++i)
+			pixels[i] = vec4ub(ptr[2 * i], ptr[2 * i + 1], 0, 255);
+		break;
+	}
+	case TextureFormat::RGBA8: {
+		etCopyMemory(reinterpret_cast<uint8_t*>(pixels.data()), ptr, pixelsCount * sizeof(vec4ub));
+		break;
+	}
+	case TextureFormat::BGRA8: {
+		for (uint32_t i = 0; i < pixelsCount; ++i)
+			pixels[i] = vec4ub(ptr[4 * i + 2], ptr[4 * i + 1], ptr[4 * i], ptr[4 * i + 3]);
+		break;
+	}
+	default:
+		log::error("Unable to compress texture %s: unsupported source format %u", source.origin().c_str(),
+			static_cast<uint32_t>(source.format));
+		return false;
+	}
+	return true;
+}
+
+void compressLevel(const SourceLevel& level, const BlockCompressionOptions& options, uint8_t* output) {
+	uint32_t blockSize = blockDataSize(options.format);
+	int32_t blocksX = (level.size.x + 3) / 4;
+	int32_t blocksY = (level.size.y + 3) / 4;
+
+	uint32_t rowsCount = static_cast<uint32_t>(blocksY);
+	parallel::forRange(rowsCount, parallel::suggestedGrain(rowsCount, 1), [&](uint32_t begin, uint32_t end) {
+		vec4ub block[16];
+		for (int32_t by = static_cast<int32_t>(begin); by < static_cast<int32_t>(end); ++by) {
+			uint8_t* rowOutput = output + static_cast<uint32_t>(by * blocksX) * blockSize;
+			for (int32_t bx = 0; bx < blocksX; ++bx) {
+				// pixels outside of the image are replicated from the edge
+				for (int32_t v = 0; v < 4; ++v) {
+					int32_t y = std::min(4 * by + v, level.size.y - 1);
+					for (int32_t u = 0; u < 4; ++u) {
+						int32_t x = std::min(4 * bx + u, level.size.x - 1);
+						block[4 * v + u] = level.pixels[y * level.size.x + x];
+					}
+				}
+
+				uint8_t* blockOutput = rowOutput + static_cast<uint32_t>(bx) * blockSize;
+				switch (options.format) {
+				case TextureFormat::DXT1_RGB:
+					compressBlockBC1(block, blockOutput, options.quality, false);
+					break;
+				case TextureFormat::DXT1_RGBA:
+					compressBlockBC1(block, blockOutput, options.quality, true);
+					break;
+				case TextureFormat::DXT3:
+					compressBlockBC2(block, blockOutput, options.quality);
+					break;
+				case TextureFormat::DXT5:
+					compressBlockBC3(block, blockOutput, options.quality);
+					break;
+				case TextureFormat::RGTC2:
+					compressBlockBC5(block, blockOutput, options.quality);
+					break;
+				case TextureFormat::BC7:
+					compressBlockBC7(block, blockOutput, options.quality);
+					break;
+				default:
+					ET_FAIL("Invalid format");
+				}
+			}
+		}
+	});
+}
+
+TextureDescription::Pointer compress(const TextureDescription& input, const BlockCompressionOptions& options) {
+	if (!isSupportedFormat(options.format)) {
+		log::error("Unsupported block compression format: %u", static_cast<uint32_t>(options.format));
+		return TextureDescription::Pointer();
+	}
+
+	if ((input.size.x <= 0) || (input.size.y <= 0) || (input.depth != 1)) {
+		log::error("Unable to compress texture %s: invalid dimensions", input.origin().c_str());
+		return TextureDescription::Pointer();
+	}
+
+	TextureDescription::Pointer inputWithLevels;
+	if ((std::max(1u, input.levelCount) == 1) && options.generateMipLevels && mip::isSupportedFormat(input.format)) {
+		inputWithLevels = mip::generate(input, options.mipGeneration);
+		if (inputWithLevels.invalid())
+			return TextureDescription::Pointer();
+	}
+	const TextureDescription& source = inputWithLevels.valid() ? inputWithLevels.reference() : input;
+
+	uint32_t sourceBytesPerPixel = bitsPerPixelForTextureFormat(source.format) / 8;
+	uint32_t levelCount = std::max(1u, source.levelCount);
+
+	auto levelSize = [&source](uint32_t level) {
+		return vec2i(std::max(1, source.size.x >> level), std::max(1, source.size.y >> level));
+	};
+
+	uint32_t sourceLayerDataSize = 0;
+	uint32_t compressedLayerDataSize = 0;
+	for (uint32_t level = 0; level < levelCount; ++level) {
+		vec2i sz = levelSize(level);
+		sourceLayerDataSize += static_cast<uint32_t>(sz.square()) * sourceBytesPerPixel;
+		compressedLayerDataSize += static_cast<uint32_t>(((sz.x + 3) / 4) * ((sz.y + 3) / 4)) * blockDataSize(options.format);
+	}
+
+	TextureDescription::Pointer result = TextureDescription::Pointer::create();
+	result->setOrigin(source.origin());
+	result->size = source.size;
+	result->format = options.format;
+	result->target = source.target;
+	result->levelCount = levelCount;
+	result->layerCount = std::max(1u, source.layerCount);
+	result->dataLayout = TextureDataLayout::FacesFirst;
+	result->data.resize(compressedLayerDataSize * result->layerCount);
+
+	uint8_t* output = result->data.data();
+	for (uint32_t layer = 0; layer < result->layerCount; ++layer) {
+		uint32_t sourceOffset = layer * sourceLayerDataSize;
+		SourceLevel current;
+		for (uint32_t level = 0; level < levelCount; ++level) {
+			current.size = levelSize(level);
+			if (!convertToRGBA8(source, sourceOffset, current.size, current.pixels))
+				return TextureDescription::Pointer();
+			sourceOffset += static_cast<uint32_t>(current.size.square()) * sourceBytesPerPixel;
+
+			compressLevel(current, options, output);
+			output += static_cast<uint32_t>(((current.size.x + 3) / 4) * ((current.size.y + 3) / 4)) * blockDataSize(options.format);
+		}
+	}
+	ET_ASSERT(output == result->data.data() + result->data.size());
+
+	return result;
+}
+
+bool compressToFile(const TextureDescription& source, const std::string& fileName, const BlockCompressionOptions& options) {
+	TextureDescription::Pointer compressed = compress(source, options);
+	return compressed.valid() && dds::saveToFile(compressed.reference(), fileName);
+}
+
+}
+}
@@ -0,0 +1,57 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/imaging/mipgenerator.h>
+
+namespace et {
+
+enum class BlockCompressionQuality : uint32_t
+{
+	Fast,
+	Normal,
+	Best,
+};
+
+struct BlockCompressionOptions
+{
+	TextureFormat format = TextureFormat::DXT5;
+	BlockCompressionQuality quality = BlockCompressionQuality::Normal;
+	bool generateMipLevels = true;
+	MipGenerationOptions mipGeneration;
+};
+
+namespace bc {
+
+/*
+ * Supported output formats: DXT1_RGB, DXT1_RGBA (BC1), DXT3 (BC2), DXT5 (BC3), RGTC2 (BC5), BC7
+ * Supported input formats: R8, RG8, RGBA8, BGRA8
+ */
+bool isSupportedFormat(TextureFormat);
+uint32_t blockDataSize(TextureFormat);
+
+/*
+ * Compresses all layers and mip levels of the source description.
+ * If source has single level and options.generateMipLevels is set - mip chain is generated
+ * with mip::generate using options.mipGeneration.
+ * Returns invalid pointer on error.
+ */
+TextureDescription::Pointer compress(const TextureDescription& source, const BlockCompressionOptions& options);
+bool compressToFile(const TextureDescription& source, const std::string& fileName, const BlockCompressionOptions& options);
+
+/*
+ * Single block encoders, input is 16 pixels in row-major order
+ */
+void compressBlockBC1(const vec4ub* pixels, uint8_t* output, BlockCompressionQuality quality, bool allowTransparency);
+void compressBlockBC2(const vec4ub* pixels, uint8_t* output, BlockCompressionQuality quality);
+void compressBlockBC3(const vec4ub* pixels, uint8_t* output, BlockCompressionQuality quality);
+void compressBlockBC5(const vec4ub* pixels, uint8_t* output, BlockCompressionQuality quality);
+void compressBlockBC7(const vec4ub* pixels, uint8_t* output, BlockCompressionQuality quality);
+
+}
+}
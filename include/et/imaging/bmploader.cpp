@@ -80,7 +80,7 @@ void et::bmp::loadFromStream(std::istream& source, TextureDescription& desc)
 
 void et::bmp::loadFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
@@ -90,7 +90,7 @@ void et::bmp::loadFromFile(const std::string& path, TextureDescription& desc)
 
 void et::bmp::loadInfoFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
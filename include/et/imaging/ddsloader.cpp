@@ -190,6 +190,24 @@ enum DDSCAPS2
 	DDSCAPS2_VOLUME = 0x200000
 };
 
+enum DDSD
+{
+	DDSD_CAPS = 0x1,
+	DDSD_HEIGHT = 0x2,
+	DDSD_WIDTH = 0x4,
+	DDSD_PITCH = 0x8,
+	DDSD_PIXELFORMAT = 0x1000,
+	DDSD_MIPMAPCOUNT = 0x20000,
+	DDSD_LINEARSIZE = 0x80000,
+};
+
+enum DDSCAPS
+{
+	DDSCAPS_COMPLEX = 0x8,
+	DDSCAPS_TEXTURE = 0x1000,
+	DDSCAPS_MIPMAP = 0x400000,
+};
+
 enum DDPF
 {
 	DDPF_ALPHAPIXELS = 0x1,
@@ -208,6 +226,7 @@ const uint32_t FOURCC_ATI2 = ET_COMPOSE_UINT32('1', 'I', 'T', 'A');
 const uint32_t FOURCC_DX10 = ET_COMPOSE_UINT32('0', '1', 'X', 'D');
 
 void fillDescriptionWithFormat(TextureDescription&, DXGI_FORMAT);
+bool fillPixelFormatWithDescription(const TextureDescription&, DDS_PIXELFORMAT&, DDS_HEADER_DXT10&);
 
 void dds::loadInfoFromStream(std::istream& source, TextureDescription& desc)
 {
@@ -298,8 +317,8 @@ void dds::loadInfoFromStream(std::istream& source, TextureDescription& desc)
 			
 		case FOURCC_DXT1:
 		{
-			bool hasAlpha = header.ddspf.dwFlags & DDPF_ALPHAPIXELS;
-			desc.format = hasAlpha ? TextureFormat::DXT1_RGB : TextureFormat::DXT1_RGBA;
+			bool hasAlpha = (header.ddspf.dwFlags & DDPF_ALPHAPIXELS) == DDPF_ALPHAPIXELS;
+			desc.format = hasAlpha ? TextureFormat::DXT1_RGBA : TextureFormat::DXT1_RGB;
 			break;
 		}
 
@@ -349,7 +368,7 @@ void dds::loadFromStream(std::istream& source, TextureDescription& desc)
 	
 	loadInfoFromStream(source, desc);
 	
-	uint32_t dataSize = desc.layerCount * desc.dataSizeForAllMipLevels();
+	uint32_t dataSize = desc.dataSizeForAllMipLevels();
 	if (dataSize)
 	{
 		desc.data = BinaryDataStorage(dataSize);
@@ -359,17 +378,33 @@ void dds::loadFromStream(std::istream& source, TextureDescription& desc)
 
 void dds::loadFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
-		loadFromStream(file.stream(), desc);
+		loadInfoFromStream(file.stream(), desc);
+
+		/*
+		 * mip levels are copied directly from the mapping, without intermediate reads
+		 */
+		uint64_t dataOffset = static_cast<uint64_t>(file.stream().tellg());
+		uint64_t dataSize = desc.dataSizeForAllMipLevels();
+		if (dataOffset + dataSize > file.size())
+		{
+			log::error("Unable to load DDS image, file is truncated: %s", path.c_str());
+			desc.data = BinaryDataStorage();
+		}
+		else if (dataSize > 0)
+		{
+			desc.data = BinaryDataStorage(dataSize);
+			etCopyMemory(desc.data.data(), file.data() + dataOffset, dataSize);
+		}
 	}
 }
 
 void dds::loadInfoFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
@@ -377,6 +412,65 @@ void dds::loadInfoFromFile(const std::string& path, TextureDescription& desc)
 	}
 }
 
+bool dds::canSaveFormat(TextureFormat format)
+{
+	TextureDescription desc;
+	desc.format = format;
+	DDS_PIXELFORMAT pf = { };
+	DDS_HEADER_DXT10 dx10Header = { };
+	return fillPixelFormatWithDescription(desc, pf, dx10Header);
+}
+
+bool dds::saveToStream(const TextureDescription& desc, std::ostream& stream)
+{
+	DDS_HEADER header = { };
+	DDS_HEADER_DXT10 dx10Header = { };
+	if (!fillPixelFormatWithDescription(desc, header.ddspf, dx10Header))
+	{
+		log::error("Unable to save DDS, unsupported texture format: %u", static_cast<uint32_t>(desc.format));
+		return false;
+	}
+
+	bool compressed = isCompressedTextureFormat(desc.format);
+	bool isCubemap = (desc.target == TextureTarget::Texture_Cube);
+
+	header.dwSize = sizeof(DDS_HEADER);
+	header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT |
+		(compressed ? DDSD_LINEARSIZE : DDSD_PITCH);
+	header.dwWidth = static_cast<uint32_t>(desc.size.x);
+	header.dwHeight = static_cast<uint32_t>(desc.size.y);
+	header.dwDepth = 1;
+	header.dwMipMapCount = desc.levelCount;
+	header.dwPitchOrLinearSize = compressed ? desc.dataSizeForMipLevel(0) / desc.layerCount :
+		static_cast<uint32_t>(desc.size.x) * bitsPerPixelForTextureFormat(desc.format) / 8;
+	header.dwCaps = DDSCAPS_TEXTURE | ((desc.levelCount > 1) ? (DDSCAPS_MIPMAP | DDSCAPS_COMPLEX) : 0);
+	if (isCubemap)
+	{
+		header.dwCaps |= DDSCAPS_COMPLEX;
+		header.dwCaps2 = DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX | DDSCAPS2_CUBEMAP_NEGATIVEX |
+			DDSCAPS2_CUBEMAP_POSITIVEY | DDSCAPS2_CUBEMAP_NEGATIVEY | DDSCAPS2_CUBEMAP_POSITIVEZ | DDSCAPS2_CUBEMAP_NEGATIVEZ;
+	}
+
+	stream.write(reinterpret_cast<const char*>(&DDS_HEADER_ID), sizeof(DDS_HEADER_ID));
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (header.ddspf.dwFourCC == FOURCC_DX10)
+		stream.write(reinterpret_cast<const char*>(&dx10Header), sizeof(dx10Header));
+
+	stream.write(desc.data.binary(), desc.data.dataSize());
+	return !stream.fail();
+}
+
+bool dds::saveToFile(const TextureDescription& desc, const std::string& path)
+{
+	std::ofstream file(path, std::ios::out | std::ios::binary);
+	if (file.fail())
+	{
+		log::error("Unable to open file for writing: %s", path.c_str());
+		return false;
+	}
+	return saveToStream(desc, file);
+}
+
 /*
  * Service
  */
@@ -400,6 +494,31 @@ void fillDescriptionWithFormat(TextureDescription& desc, DXGI_FORMAT format)
 			desc.format = TextureFormat::RGBA32F;
 			break;
 		}
+		case DXGI_FORMAT_BC1_UNORM:
+		{
+			desc.format = TextureFormat::DXT1_RGBA;
+			break;
+		}
+		case DXGI_FORMAT_BC2_UNORM:
+		{
+			desc.format = TextureFormat::DXT3;
+			break;
+		}
+		case DXGI_FORMAT_BC3_UNORM:
+		{
+			desc.format = TextureFormat::DXT5;
+			break;
+		}
+		case DXGI_FORMAT_BC5_UNORM:
+		{
+			desc.format = TextureFormat::RGTC2;
+			break;
+		}
+		case DXGI_FORMAT_BC7_UNORM:
+		{
+			desc.format = TextureFormat::BC7;
+			break;
+		}
 			
 		default:
 		{
@@ -408,3 +527,94 @@ void fillDescriptionWithFormat(TextureDescription& desc, DXGI_FORMAT format)
 		}
 	}
 }
+
+bool fillPixelFormatWithDescription(const TextureDescription& desc, DDS_PIXELFORMAT& pf, DDS_HEADER_DXT10& dx10)
+{
+	pf.dwSize = sizeof(DDS_PIXELFORMAT);
+	pf.dwFlags = DDPF_FOURCC;
+	switch (desc.format)
+	{
+		case TextureFormat::RGBA8:
+		case TextureFormat::BGRA8:
+		{
+			bool isBGR = (desc.format == TextureFormat::BGRA8);
+			pf.dwFlags = DDPF_RGB | DDPF_ALPHAPIXELS;
+			pf.dwRGBBitCount = 32;
+			pf.dwRBitMask = isBGR ? 0x00ff0000 : 0x000000ff;
+			pf.dwGBitMask = 0x0000ff00;
+			pf.dwBBitMask = isBGR ? 0x000000ff : 0x00ff0000;
+			pf.dwABitMask = 0xff000000;
+			break;
+		}
+		case TextureFormat::RG16:
+		{
+			pf.dwFourCC = 34;
+			break;
+		}
+		case TextureFormat::RGBA16:
+		{
+			pf.dwFourCC = 36;
+			break;
+		}
+		case TextureFormat::R16F:
+		{
+			pf.dwFourCC = 111;
+			break;
+		}
+		case TextureFormat::RG16F:
+		{
+			pf.dwFourCC = 112;
+			break;
+		}
+		case TextureFormat::RGBA16F:
+		{
+			pf.dwFourCC = 113;
+			break;
+		}
+		case TextureFormat::R32F:
+		{
+			pf.dwFourCC = 114;
+			break;
+		}
+		case TextureFormat::RGBA32F:
+		{
+			pf.dwFourCC = 116;
+			break;
+		}
+		case TextureFormat::DXT1_RGB:
+		case TextureFormat::DXT1_RGBA:
+		{
+			pf.dwFourCC = FOURCC_DXT1;
+			if (desc.format == TextureFormat::DXT1_RGBA)
+				pf.dwFlags |= DDPF_ALPHAPIXELS;
+			break;
+		}
+		case TextureFormat::DXT3:
+		{
+			pf.dwFourCC = FOURCC_DXT3;
+			break;
+		}
+		case TextureFormat::DXT5:
+		{
+			pf.dwFourCC = FOURCC_DXT5;
+			break;
+		}
+		case TextureFormat::RGTC2:
+		{
+			pf.dwFourCC = FOURCC_ATI2;
+			break;
+		}
+		case TextureFormat::R8:
+		case TextureFormat::BC7:
+		{
+			pf.dwFourCC = FOURCC_DX10;
+			dx10.dxgiFormat = (desc.format == TextureFormat::R8) ? DXGI_FORMAT_R8_UNORM : DXGI_FORMAT_BC7_UNORM;
+			dx10.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+			dx10.arraySize = 1;
+			break;
+		}
+		default:
+			return false;
+	}
+	return true;
+}
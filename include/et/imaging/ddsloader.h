@@ -18,6 +18,10 @@ namespace et
 
 		void loadInfoFromStream(std::istream& stream, TextureDescription& desc);
 		void loadInfoFromFile(const std::string& path, TextureDescription& desc);
+
+		bool canSaveFormat(TextureFormat format);
+		bool saveToStream(const TextureDescription& desc, std::ostream& stream);
+		bool saveToFile(const TextureDescription& desc, const std::string& path);
 	}
 }
 
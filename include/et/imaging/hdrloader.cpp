@@ -20,7 +20,8 @@ void et::hdr::setShouldConvertRGBEToFloat(bool value)
 	shouldConvertRGBEToFloat = value;
 }
 
-unsigned char* readScanline(unsigned char*, int, vec4ub*);
+const uint8_t* decodeScanlines(const uint8_t* ptr, const uint8_t* end, TextureDescription& desc);
+const uint8_t* readScanline(const uint8_t* ptr, const uint8_t* end, int width, vec4ub* scanline);
 
 void et::hdr::loadInfoFromStream(std::istream& source, TextureDescription& desc)
 {
@@ -97,21 +98,63 @@ void et::hdr::loadFromStream(std::istream& source, TextureDescription& desc)
 {
 	loadInfoFromStream(source, desc);
 
+	auto sourcePos = source.tellg();
+
+	uint64_t maxDataSize = desc.size.square() * bitsPerPixelForTextureFormat(desc.format) / 8;
+	BinaryDataStorage inData(maxDataSize, 0);
+	source.read(inData.binary(), maxDataSize);
+
+	const uint8_t* ptr = decodeScanlines(inData.begin(), inData.end(), desc);
+	if (ptr != nullptr)
+	{
+		decltype(sourcePos) dataSize = ptr - inData.begin();
+		source.seekg(sourcePos + dataSize, std::ios::beg);
+	}
+}
+
+void et::hdr::loadFromFile(const std::string& path, TextureDescription& desc)
+{
+	InputStream file(path, StreamMode_Mapped);
+	if (file.valid())
+	{
+		desc.setOrigin(path);
+		loadInfoFromStream(file.stream(), desc);
+
+		/*
+		 * scanlines are decoded directly from the mapping
+		 */
+		uint64_t dataOffset = static_cast<uint64_t>(file.stream().tellg());
+		if (dataOffset < file.size())
+			decodeScanlines(file.data() + dataOffset, file.data() + file.size(), desc);
+		else
+			log::error("Failed to load HDR image, file is truncated: %s", path.c_str());
+	}
+}
+
+void et::hdr::loadInfoFromFile(const std::string& path, TextureDescription& desc)
+{
+	InputStream file(path, StreamMode_Mapped);
+	if (file.valid())
+	{
+		desc.setOrigin(path);
+		loadInfoFromStream(file.stream(), desc);
+	}
+}
+
+/*
+ * Internal stuff
+ */
+
+const uint8_t* decodeScanlines(const uint8_t* ptr, const uint8_t* end, TextureDescription& desc)
+{
 	if ((desc.size.x < 8) || (desc.size.x > 0x7fff))
 	{
 		log::error("Failed to load HDR image");
-		return;
+		desc.data = BinaryDataStorage();
+		return nullptr;
 	}
 
-	auto sourcePos = source.tellg();
-
-    uint64_t square = desc.size.square();
-    uint64_t maxDataSize = square * bitsPerPixelForTextureFormat(desc.format) / 8;
-    
-    uint64_t rowSize = desc.size.x * 4;
-	BinaryDataStorage inData(maxDataSize, 0);
-	source.read(inData.binary(), maxDataSize);
-	uint8_t* ptr = inData.begin();
+	uint64_t rowSize = desc.size.x * 4;
 
 	if (shouldConvertRGBEToFloat)
 	{
@@ -120,13 +163,13 @@ void et::hdr::loadFromStream(std::istream& source, TextureDescription& desc)
 		DataStorage<vec4ub> rgbeData(desc.size.square(), 0);
 		DataStorage<vec4> floatDataWrapper(reinterpret_cast<vec4*>(desc.data.data()), desc.data.size());
 
-		for (int32_t y = 0; y < desc.size.y; ++y)
+		for (int32_t y = 0; (ptr != nullptr) && (y < desc.size.y); ++y)
 		{
 			auto rowPtr = rgbeData.binary() + rowSize * (desc.size.y - 1 - y);
-			ptr = readScanline(ptr, desc.size.x, reinterpret_cast<vec4ub*>(rowPtr));
+			ptr = readScanline(ptr, end, desc.size.x, reinterpret_cast<vec4ub*>(rowPtr));
 		}
 
-		for (int32_t i = 0; i < desc.size.square(); ++i)
+		for (int32_t i = 0; (ptr != nullptr) && (i < desc.size.square()); ++i)
 		{
 			int8_t expo = rgbeData[i].w - 128;
 			float scale = (expo > 0) ? static_cast<float>(1 << expo) : 1.0f / static_cast<float>(1 << -expo);
@@ -139,75 +182,68 @@ void et::hdr::loadFromStream(std::istream& source, TextureDescription& desc)
 	else
 	{
 		desc.data.resize(desc.size.y * rowSize);
-		for (int y = 0; y < desc.size.y; ++y)
+		for (int y = 0; (ptr != nullptr) && (y < desc.size.y); ++y)
 		{
 			auto rowPtr = desc.data.element_ptr((desc.size.y - 1 - y) * rowSize);
-			ptr = readScanline(ptr, desc.size.x, reinterpret_cast<vec4ub*>(rowPtr));
+			ptr = readScanline(ptr, end, desc.size.x, reinterpret_cast<vec4ub*>(rowPtr));
 		}
 	}
-	
-	
-	decltype(sourcePos) dataSize = ptr - inData.begin();
-	source.seekg(sourcePos + dataSize, std::ios::beg);
-}
 
-void et::hdr::loadFromFile(const std::string& path, TextureDescription& desc)
-{
-	InputStream file(path, StreamMode_Binary);
-	if (file.valid())
+	if (ptr == nullptr)
 	{
-		desc.setOrigin(path);
-		loadFromStream(file.stream(), desc);
+		log::error("Failed to load HDR image, invalid or truncated data");
+		desc.data = BinaryDataStorage();
 	}
+
+	return ptr;
 }
 
-void et::hdr::loadInfoFromFile(const std::string& path, TextureDescription& desc)
+const uint8_t* readScanline(const uint8_t* ptr, const uint8_t* end, int width, vec4ub* scanline)
 {
-	InputStream file(path, StreamMode_Binary);
-	if (file.valid())
+	if (end - ptr < 4)
 	{
-		desc.setOrigin(path);
-		loadInfoFromStream(file.stream(), desc);
+		log::error("Failed to read HDR scanline, data is truncated");
+		return nullptr;
 	}
-}
 
-/*
- * Internal stuff
- */
-
-unsigned char* readScanline(unsigned char* ptr, int width, vec4ub* scanline)
-{
-	if (*ptr++ == 2)
+	if (*ptr != 2)
 	{
-		scanline->y = *ptr++;
-		scanline->z = *ptr++;
+		ET_FAIL("Legacy scanlines are not supported");
+		return nullptr;
+	}
 
-		++ptr;
+	scanline->y = ptr[1];
+	scanline->z = ptr[2];
+	ptr += 4;
 
-		for (int i = 0; i < 4; ++i)
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < width;)
 		{
-			for (int j = 0; j < width;)
+			if (ptr >= end)
+				return nullptr;
+
+			unsigned char code = *ptr++;
+			if (code > 128)
 			{
-				unsigned char code = *ptr++;
-				if (code > 128)
-				{
-					code &= 127;
-					unsigned char val = *ptr++;
-					while (code--)
-						scanline[j++][i] = val;
-				}
-				else
-				{
-					while (code--)
-						scanline[j++][i] = *ptr++;
-				}
+				code &= 127;
+				if ((ptr >= end) || (j + code > width))
+					return nullptr;
+
+				unsigned char val = *ptr++;
+				while (code--)
+					scanline[j++][i] = val;
+			}
+			else
+			{
+				if ((code == 0) || (end - ptr < code) || (j + code > width))
+					return nullptr;
+
+				while (code--)
+					scanline[j++][i] = *ptr++;
 			}
 		}
 	}
-	else
-	{
-		ET_FAIL("Legacy scanlines are not supported");
-	}
 
 	return ptr;
 }
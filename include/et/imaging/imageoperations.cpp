@@ -5,6 +5,7 @@
  *
  */
 
+#include <et/core/parallel.h>
 #include <et/geometry/geometry.h>
 #include <et/imaging/imageoperations.h>
 
@@ -26,7 +27,8 @@ mat3i ImageOperations::matrixFilterSharpen = mat3i(
 	 0, -1,  0);
 
 int indexForCoord(const vec2i& coord, const vec2i& size);
-bool grayscaleSortFunction(const vec4ub& v1, const vec4ub& v2);
+uint64_t median9(uint64_t* values);
+uint64_t selectMedian(uint64_t* values, size_t count);
 
 inline int roundf(float v, int minV, int maxV)
 	{ return clamp(static_cast<int32_t>(v), minV, maxV); }
@@ -154,121 +156,241 @@ void ImageOperations::applyPixelFilter(BinaryDataStorage& data, const vec2i& siz
 
 void ImageOperations::blur(BinaryDataStorage& data, const vec2i& size, int components, vec2i direction, int radius, ImageBlurType type)
 {
-	type = ImageBlurType_Average;
+	// only box (average) blur is implemented, linear weights are not supported
+	(void)type;
+
+	if ((size.x <= 0) || (size.y <= 0))
+		return;
 
 	BinaryDataStorage source(data);
-	for (int y = 0; y < size.y; ++y)
-	{
-		for (int x = 0; x < size.x; ++x)
-		{
-			int i0 = components * indexForCoord(vec2i(x, y), size);
+	const uint8_t* src = source.data();
+	uint8_t* dst = data.data();
+	int divisor = 2 * radius + 1;
 
-			vec4i sum;
-			int scale = (type == ImageBlurType_Average) ? 1 : (radius + 1);
-			int totalScale = scale;
-			for (int c = 0; c < components; ++c)
-				sum[c] = source[i0 + c] * scale;
+	bool horizontal = (std::abs(direction.x) == 1) && (direction.y == 0);
+	bool vertical = (direction.x == 0) && (std::abs(direction.y) == 1);
 
-			for (int r = 1; r <= radius; ++r)
+	if (horizontal)
+	{
+		/*
+		 * Sliding window along the row: each output pixel costs one add and one subtract
+		 */
+		uint32_t rowsCount = static_cast<uint32_t>(size.y);
+		parallel::forRange(rowsCount, parallel::suggestedGrain(rowsCount, 8), [&](uint32_t begin, uint32_t end)
+		{
+			for (int y = static_cast<int>(begin); y < static_cast<int>(end); ++y)
 			{
-				vec2i vNext = vec2i(x, y) + direction * r;
-				vec2i vPrev = vec2i(x, y) - direction * r;
-				int iNext = components * indexForCoord(vNext, size);
-				int iPrev = components * indexForCoord(vPrev, size);
-				scale = (type == ImageBlurType_Average) ? 1 : (radius + 1 - r);
-				totalScale += 2 * scale;
+				const uint8_t* srcRow = src + components * y * size.x;
+				uint8_t* dstRow = dst + components * y * size.x;
 				for (int c = 0; c < components; ++c)
 				{
-					sum[c] += source[iNext + c] * scale;
-					sum[c] += source[iPrev + c] * scale;
+					int sum = 0;
+					for (int r = -radius; r <= radius; ++r)
+						sum += srcRow[components * clamp(r, 0, size.x - 1) + c];
+
+					for (int x = 0; x < size.x; ++x)
+					{
+						dstRow[components * x + c] = static_cast<uint8_t>(sum / divisor);
+						int xAdd = clamp(x + radius + 1, 0, size.x - 1);
+						int xRemove = clamp(x - radius, 0, size.x - 1);
+						sum += srcRow[components * xAdd + c] - srcRow[components * xRemove + c];
+					}
+				}
+			}
+		});
+	}
+	else if (vertical)
+	{
+		/*
+		 * Sliding window along columns, processed in strips of adjacent columns
+		 * so that every step reads contiguous memory
+		 */
+		const int stripWidth = 64;
+		int rowStride = components * size.x;
+		uint32_t stripsCount = static_cast<uint32_t>((rowStride + stripWidth - 1) / stripWidth);
+		parallel::forRange(stripsCount, 1, [&](uint32_t begin, uint32_t end)
+		{
+			int sums[stripWidth];
+			for (uint32_t strip = begin; strip < end; ++strip)
+			{
+				int x0 = static_cast<int>(strip) * stripWidth;
+				int x1 = std::min(x0 + stripWidth, rowStride);
+				int width = x1 - x0;
+
+				std::fill(sums, sums + width, 0);
+				for (int r = -radius; r <= radius; ++r)
+				{
+					const uint8_t* row = src + clamp(r, 0, size.y - 1) * rowStride + x0;
+					for (int i = 0; i < width; ++i)
+						sums[i] += row[i];
 				}
 
+				for (int y = 0; y < size.y; ++y)
+				{
+					uint8_t* dstRow = dst + y * rowStride + x0;
+					for (int i = 0; i < width; ++i)
+						dstRow[i] = static_cast<uint8_t>(sums[i] / divisor);
+
+					const uint8_t* addRow = src + clamp(y + radius + 1, 0, size.y - 1) * rowStride + x0;
+					const uint8_t* removeRow = src + clamp(y - radius, 0, size.y - 1) * rowStride + x0;
+					for (int i = 0; i < width; ++i)
+						sums[i] += addRow[i] - removeRow[i];
+				}
 			}
+		});
+	}
+	else
+	{
+		uint32_t rowsCount = static_cast<uint32_t>(size.y);
+		parallel::forRange(rowsCount, parallel::suggestedGrain(rowsCount, 4), [&](uint32_t begin, uint32_t end)
+		{
+			for (int y = static_cast<int>(begin); y < static_cast<int>(end); ++y)
+			{
+				for (int x = 0; x < size.x; ++x)
+				{
+					int i0 = components * indexForCoord(vec2i(x, y), size);
 
-			sum /= totalScale;
-			for (int c = 0; c < components; ++c)
-				data[i0 + c] = static_cast<uint8_t>(sum[c]);
-		}
+					vec4i sum;
+					for (int c = 0; c < components; ++c)
+						sum[c] = src[i0 + c];
+
+					for (int r = 1; r <= radius; ++r)
+					{
+						int iNext = components * indexForCoord(vec2i(x, y) + direction * r, size);
+						int iPrev = components * indexForCoord(vec2i(x, y) - direction * r, size);
+						for (int c = 0; c < components; ++c)
+							sum[c] += src[iNext + c] + src[iPrev + c];
+					}
+
+					for (int c = 0; c < components; ++c)
+						dst[i0 + c] = static_cast<uint8_t>(sum[c] / divisor);
+				}
+			}
+		});
 	}
 }
 
 void ImageOperations::median(BinaryDataStorage& data, const vec2i& size, int components, int radius)
 {
-	BinaryDataStorage source(data);
+	if ((size.x <= 0) || (size.y <= 0) || (radius <= 0))
+		return;
 
-	std::vector<vec4ub> matrix;
-	matrix.reserve(static_cast<std::vector<vec4ub>::size_type>((1 + 2 * radius) * (1 + 2 * radius)));
-
-	for (int y = 0; y < size.y; ++y)
+	BinaryDataStorage source(data);
+	const uint8_t* src = source.data();
+	uint8_t* dst = data.data();
+
+	/*
+	 * Luminance keys are computed once per pixel instead of once per comparison.
+	 * Key and pixel index are packed together, so median selection is done on plain integers.
+	 */
+	uint32_t pixelsCount = static_cast<uint32_t>(size.x * size.y);
+	std::vector<uint32_t> keys(pixelsCount);
+	parallel::forRange(pixelsCount, parallel::suggestedGrain(pixelsCount, 4096), [&](uint32_t begin, uint32_t end)
 	{
-		for (int x = 0; x < size.x; ++x)
+		for (uint32_t i = begin; i < end; ++i)
 		{
-			int i0 = components * indexForCoord(vec2i(x, y), size);
+			const uint8_t* p = src + components * i;
+			uint32_t r = p[0];
+			uint32_t g = (components > 1) ? p[1] : 0;
+			uint32_t b = (components > 2) ? p[2] : 0;
+			keys[i] = 76 * r + 150 * g + 29 * b;
+		}
+	});
 
-			matrix.clear();
-			for (int v = -radius; v <= radius; ++v)
+	int windowSize = (1 + 2 * radius) * (1 + 2 * radius);
+	uint32_t rowsCount = static_cast<uint32_t>(size.y);
+	parallel::forRange(rowsCount, parallel::suggestedGrain(rowsCount, 4), [&](uint32_t begin, uint32_t end)
+	{
+		std::vector<uint64_t> window(static_cast<size_t>(windowSize));
+		for (int y = static_cast<int>(begin); y < static_cast<int>(end); ++y)
+		{
+			for (int x = 0; x < size.x; ++x)
 			{
-				for (int u = - radius; u <= radius; ++u)
+				uint64_t* w = window.data();
+				for (int v = -radius; v <= radius; ++v)
 				{
-					int index = components * indexForCoord(vec2i(x + u, y + v), size);
-					vec4ub color(0);
-					for (int c = 0; c < components; ++c)
-						color[c] = source[index+c];
-					matrix.push_back(color);
+					int rowOffset = clamp(y + v, 0, size.y - 1) * size.x;
+					for (int u = -radius; u <= radius; ++u)
+					{
+						uint32_t index = static_cast<uint32_t>(rowOffset + clamp(x + u, 0, size.x - 1));
+						*w++ = (static_cast<uint64_t>(keys[index]) << 32) | index;
+					}
 				}
-			}
 
-			std::sort(matrix.begin(), matrix.end(), grayscaleSortFunction);
+				uint64_t median = (radius == 1) ? median9(window.data()) :
+					selectMedian(window.data(), window.size());
 
-			vec4ub& middle = matrix.at(matrix.size() / 2);
-			for (int c = 0; c < components; ++c)
-				data[i0 + c] = middle[c];
+				const uint8_t* p = src + components * static_cast<uint32_t>(median & 0xffffffff);
+				uint8_t* o = dst + components * (y * size.x + x);
+				for (int c = 0; c < components; ++c)
+					o[c] = p[c];
+			}
 		}
-	}
+	});
 }
 
 void ImageOperations::applyMatrixFilter(BinaryDataStorage& data, const vec2i& size, int components, const mat3i& m)
 {
+	if ((size.x <= 0) || (size.y <= 0))
+		return;
+
 	BinaryDataStorage source(data);
-	matrix3<uint8_t> colorMatrix[4];
+	const uint8_t* src = source.data();
+	uint8_t* dst = data.data();
 
-	for (int y = 0; y < size.y; ++y)
+	int cSum = 0;
+	int weights[3][3] = { };
+	for (int v = 0; v < 3; ++v)
 	{
-		for (int x = 0; x < size.x; ++x)
+		for (int u = 0; u < 3; ++u)
 		{
+			weights[v][u] = m[v][u];
+			cSum += m[v][u];
+		}
+	}
+	int divisor = (cSum == 0) ? 1 : cSum;
+
+	int rowStride = components * size.x;
+	uint32_t rowsCount = static_cast<uint32_t>(size.y);
+	parallel::forRange(rowsCount, parallel::suggestedGrain(rowsCount, 4), [&](uint32_t begin, uint32_t end)
+	{
+		std::vector<int> accum(static_cast<size_t>(rowStride));
+		for (int y = static_cast<int>(begin); y < static_cast<int>(end); ++y)
+		{
+			std::fill(accum.begin(), accum.end(), 0);
+
 			for (int dy = -1; dy <= 1; ++dy)
 			{
-				for (int dx = -1; dx <= 1; ++dx)
+				const int* w = weights[dy + 1];
+				const uint8_t* row = src + clamp(y + dy, 0, size.y - 1) * rowStride;
+
+				/*
+				 * Interior: neighbours are at fixed offsets, loop is branch-free and auto-vectorizes
+				 */
+				int* acc = accum.data();
+				for (int i = components; i + components < rowStride; ++i)
+					acc[i] += w[0] * row[i - components] + w[1] * row[i] + w[2] * row[i + components];
+
+				/*
+				 * Left and right columns with clamped coordinates
+				 */
+				for (int x : { 0, size.x - 1 })
 				{
-					int index = components * indexForCoord(vec2i(x + dx, y + dy), size);
+					int xl = components * std::max(x - 1, 0);
+					int xc = components * x;
+					int xr = components * std::min(x + 1, size.x - 1);
 					for (int c = 0; c < components; ++c)
-						colorMatrix[c][dy+1][dx+1] = source[index+c];
+						acc[xc + c] += w[0] * row[xl + c] + w[1] * row[xc + c] + w[2] * row[xr + c];
+					if (size.x == 1)
+						break;
 				}
 			}
 
-			vec4i result(0);
-			int cSum = 0;
-			for (int v = 0; v < 3; ++v)
-			{
-				for (int u = 0; u < 3; ++u)
-				{
-					int value = m[v][u];
-					result.x += colorMatrix[0][v][u] * value;
-					result.y += colorMatrix[1][v][u] * value;
-					result.z += colorMatrix[2][v][u] * value;
-					result.w += colorMatrix[3][v][u] * value;
-					cSum += value;
-				}
-			}
-
-			if (cSum)
-				result /= cSum;
-
-			int i0 = components * indexForCoord(vec2i(x, y), size);
-			for (int c = 0; c < components; ++c)
-				data[i0 + c] = static_cast<uint8_t>(clamp(result[c], 0, 255));
+			uint8_t* dstRow = dst + y * rowStride;
+			for (int i = 0; i < rowStride; ++i)
+				dstRow[i] = static_cast<uint8_t>(clamp(accum[i] / divisor, 0, 255));
 		}
-	}
+	});
 }
 
 void ImageOperations::normalMapFilter(BinaryDataStorage& data, const vec2i& size, int components, const vec2& scale)
@@ -277,36 +399,43 @@ void ImageOperations::normalMapFilter(BinaryDataStorage& data, const vec2i& size
 
 	vec2 fScale = scale / 255.0f;
 	BinaryDataStorage source(data);
-	for (int y = 0; y < size.y; ++y)
+	const uint8_t* src = source.data();
+	uint8_t* dst = data.data();
+
+	uint32_t rowsCount = static_cast<uint32_t>(std::max(0, size.y));
+	parallel::forRange(rowsCount, parallel::suggestedGrain(rowsCount, 8), [&](uint32_t begin, uint32_t end)
 	{
-		bool halfY = y < size.y / 2;
-		for (int x = 0; x < size.x; ++x)
+		for (int y = static_cast<int>(begin); y < static_cast<int>(end); ++y)
 		{
-			bool halfX = x < size.x / 2;
-			vec2i nextX(x + (halfX ? 1 : -1), y);
-			vec2i nextY(x, y + (halfY ? 1 : -1));
+			bool halfY = y < size.y / 2;
+			for (int x = 0; x < size.x; ++x)
+			{
+				bool halfX = x < size.x / 2;
+				vec2i nextX(x + (halfX ? 1 : -1), y);
+				vec2i nextY(x, y + (halfY ? 1 : -1));
 
-			int c00 = components * indexForCoord(vec2i(x, y), size);
-			int c01 = components * indexForCoord(nextX, size);
-			int c10 = components * indexForCoord(nextY, size);
+				int c00 = components * indexForCoord(vec2i(x, y), size);
+				int c01 = components * indexForCoord(nextX, size);
+				int c10 = components * indexForCoord(nextY, size);
 
-			short h00 = source[c00];
-			short h01 = source[c01];
-			short h10 = source[c10];
+				short h00 = src[c00];
+				short h01 = src[c01];
+				short h10 = src[c10];
 
-			float dx = static_cast<float>(halfX ? h01 - h00 : h00 - h01) * fScale.x;
-			float dy = static_cast<float>(halfY ? h10 - h00 : h00 - h10) * fScale.y;
+				float dx = static_cast<float>(halfX ? h01 - h00 : h00 - h01) * fScale.x;
+				float dy = static_cast<float>(halfY ? h10 - h00 : h00 - h10) * fScale.y;
 
-			vec3 du(1.0f, 0.0f, dx);
-			vec3 dv(0.0f, 1.0f, dy);
+				vec3 du(1.0f, 0.0f, dx);
+				vec3 dv(0.0f, 1.0f, dy);
 
-			vec3 produce = normalize(cross(du, dv));
+				vec3 produce = normalize(cross(du, dv));
 
-			data[c00+0] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.x));
-			data[c00+1] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.y));
-			data[c00+2] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.z));
+				dst[c00+0] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.x));
+				dst[c00+1] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.y));
+				dst[c00+2] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.z));
+			}
 		}
-	}
+	});
 }
 
 /*
@@ -319,9 +448,25 @@ int indexForCoord(const vec2i& coord, const vec2i& size)
 	return yVal * size.x + xVal;
 }
 
-bool grayscaleSortFunction(const vec4ub& v1, const vec4ub& v2)
+#define ET_SORT_PAIR(a, b) { if (p[a] > p[b]) std::swap(p[a], p[b]); }
+uint64_t median9(uint64_t* p)
+{
+	/*
+	 * Optimal 19-comparison median network for 9 elements
+	 */
+	ET_SORT_PAIR(1, 2); ET_SORT_PAIR(4, 5); ET_SORT_PAIR(7, 8);
+	ET_SORT_PAIR(0, 1); ET_SORT_PAIR(3, 4); ET_SORT_PAIR(6, 7);
+	ET_SORT_PAIR(1, 2); ET_SORT_PAIR(4, 5); ET_SORT_PAIR(7, 8);
+	ET_SORT_PAIR(0, 3); ET_SORT_PAIR(5, 8); ET_SORT_PAIR(4, 7);
+	ET_SORT_PAIR(3, 6); ET_SORT_PAIR(1, 4); ET_SORT_PAIR(2, 5);
+	ET_SORT_PAIR(4, 7); ET_SORT_PAIR(4, 2); ET_SORT_PAIR(6, 4);
+	ET_SORT_PAIR(4, 2);
+	return p[4];
+}
+#undef ET_SORT_PAIR
+
+uint64_t selectMedian(uint64_t* values, size_t count)
 {
-	int g1 = 76 * v1.x + 150 * v1.y + 29 * v1.z;
-	int g2 = 76 * v2.x + 150 * v2.y + 29 * v2.z;
-	return g1 < g2;
+	std::nth_element(values, values + count / 2, values + count);
+	return values[count / 2];
 }
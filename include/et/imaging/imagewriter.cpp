@@ -6,7 +6,10 @@
  */
 
 #include <external/libpng/png.h>
+#include <sstream>
 #include <et/imaging/imagewriter.h>
+#include <et/imaging/ddsloader.h>
+#include <et/imaging/blockcompression.h>
 
 using namespace et;
 
@@ -19,7 +22,10 @@ bool internal_writePNGtoBuffer(BinaryDataStorage& buffer, const BinaryDataStorag
 void internal_func_writePNGtoBuffer(png_structp png_ptr, png_bytep data, png_size_t length);
 void internal_func_PNGflush(png_structp png_ptr);
 
-static float compressionLevels[ImageFormat_max] = { 0.5f };
+bool internal_writeDDStoStream(std::ostream& stream, const BinaryDataStorage& data,
+	const vec2i& size, int components, int bitsPerComponent, bool flip);
+
+static float compressionLevels[ImageFormat_max] = { 0.5f, 0.5f };
 
 void et::setCompressionLevelForImageFormat(ImageFormat fmt, float value)
 {
@@ -35,6 +41,12 @@ bool et::writeImageToFile(const std::string& fileName, const BinaryDataStorage&
 	case ImageFormat_PNG:
 		return internal_writePNGtoFile(fileName, data, size, components, bitsPerComponent, flip);
 
+	case ImageFormat_DDS:
+	{
+		std::ofstream file(fileName, std::ios::out | std::ios::binary);
+		return file.good() && internal_writeDDStoStream(file, data, size, components, bitsPerComponent, flip);
+	}
+
 	default:
 		return false;
 	}
@@ -47,6 +59,19 @@ bool et::writeImageToBuffer(BinaryDataStorage& buffer, const BinaryDataStorage&
 	{
 		case ImageFormat_PNG:
 			return internal_writePNGtoBuffer(buffer, data, size, components, bitsPerComponent, flip);
+
+		case ImageFormat_DDS:
+		{
+			std::ostringstream stream(std::ios::out | std::ios::binary);
+			if (!internal_writeDDStoStream(stream, data, size, components, bitsPerComponent, flip))
+				return false;
+
+			std::string encoded = stream.str();
+			buffer.fitToSize(static_cast<uint32_t>(encoded.size()));
+			etCopyMemory(buffer.current_ptr(), encoded.data(), encoded.size());
+			buffer.applyOffset(static_cast<uint32_t>(encoded.size()));
+			return true;
+		}
 			
 		default:
 			return false;
@@ -63,6 +88,9 @@ std::string et::extensionForImageFormat(ImageFormat fmt)
 	case ImageFormat_PNG:
 		return ".png";
 
+	case ImageFormat_DDS:
+		return ".dds";
+
 	default:
 		return ".image";
 	}
@@ -217,3 +245,71 @@ bool internal_writePNGtoFile(const std::string& fileName, const BinaryDataStorag
 	
 	return true;
 }
+
+bool internal_writeDDStoStream(std::ostream& stream, const BinaryDataStorage& data,
+	const vec2i& size, int components, int bitsPerComponent, bool flip)
+{
+	if (bitsPerComponent != 8)
+	{
+		log::error("Only 8 bits per component images could be written to DDS");
+		return false;
+	}
+
+	TextureDescription source;
+	source.size = size;
+
+	BlockCompressionOptions options;
+	switch (components)
+	{
+		case 1:
+		{
+			source.format = TextureFormat::R8;
+			options.format = TextureFormat::DXT1_RGB;
+			break;
+		}
+		case 2:
+		{
+			source.format = TextureFormat::RG8;
+			options.format = TextureFormat::RGTC2;
+			break;
+		}
+		case 3:
+		{
+			source.format = TextureFormat::RGBA8;
+			options.format = TextureFormat::DXT1_RGB;
+			break;
+		}
+		case 4:
+		{
+			source.format = TextureFormat::RGBA8;
+			options.format = TextureFormat::DXT5;
+			break;
+		}
+		default:
+		{
+			log::error("Invalid components number: %d", components);
+			return false;
+		}
+	}
+
+	int sourceRowSize = size.x * components;
+	int targetComponents = static_cast<int>(bitsPerPixelForTextureFormat(source.format) / 8);
+	source.data.resize(static_cast<uint32_t>(size.square() * targetComponents));
+	for (int y = 0; y < size.y; ++y)
+	{
+		const uint8_t* sourceRow = data.data() + (flip ? (size.y - 1 - y) : y) * sourceRowSize;
+		uint8_t* targetRow = source.data.data() + y * size.x * targetComponents;
+		for (int x = 0; x < size.x; ++x)
+		{
+			for (int c = 0; c < targetComponents; ++c)
+				targetRow[x * targetComponents + c] = (c < components) ? sourceRow[x * components + c] : 255;
+		}
+	}
+
+	float level = clamp(compressionLevels[ImageFormat_DDS], 0.0f, 1.0f);
+	options.quality = (level < 1.0f / 3.0f) ? BlockCompressionQuality::Fast :
+		((level > 2.0f / 3.0f) ? BlockCompressionQuality::Best : BlockCompressionQuality::Normal);
+
+	TextureDescription::Pointer compressed = bc::compress(source, options);
+	return compressed.valid() && dds::saveToStream(compressed.reference(), stream);
+}
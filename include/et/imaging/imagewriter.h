@@ -14,10 +14,16 @@ namespace et
 enum ImageFormat 
 {
 	ImageFormat_PNG,
+	ImageFormat_DDS,
 	ImageFormat_max
 };
 
 std::string extensionForImageFormat(ImageFormat);
+
+/*
+ * For ImageFormat_DDS compression level selects block compression quality
+ * (fast below 1/3, best above 2/3)
+ */
 void setCompressionLevelForImageFormat(ImageFormat, float);
 
 bool writeImageToFile(const std::string& fileName, const BinaryDataStorage& data,
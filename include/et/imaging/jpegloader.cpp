@@ -123,7 +123,7 @@ void et::jpeg::loadFromStream(std::istream& source, TextureDescription& desc)
 
 void et::jpeg::loadFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
@@ -133,7 +133,7 @@ void et::jpeg::loadFromFile(const std::string& path, TextureDescription& desc)
 
 void et::jpeg::loadInfoFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
@@ -0,0 +1,502 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/parallel.h>
+#include <et/imaging/mipgenerator.h>
+
+namespace et {
+namespace mip {
+
+enum class ComponentType : uint32_t
+{
+	Invalid,
+	UnsignedByte,
+	Half,
+	Float,
+};
+
+struct FormatInfo
+{
+	ComponentType type = ComponentType::Invalid;
+	uint32_t channels = 0;
+	uint32_t bytesPerComponent = 0;
+	bool swizzleBGR = false;
+};
+
+FormatInfo formatInfo(TextureFormat format) {
+	FormatInfo result;
+	switch (format) {
+	case TextureFormat::R8:
+		return { ComponentType::UnsignedByte, 1, 1, false };
+	case TextureFormat::RG8:
+		return { ComponentType::UnsignedByte, 2, 1, false };
+	case TextureFormat::RGBA8:
+		return { ComponentType::UnsignedByte, 4, 1, false };
+	case TextureFormat::BGRA8:
+		return { ComponentType::UnsignedByte, 4, 1, true };
+	case TextureFormat::R16F:
+		return { ComponentType::Half, 1, 2, false };
+	case TextureFormat::RG16F:
+		return { ComponentType::Half, 2, 2, false };
+	case TextureFormat::RGBA16F:
+		return { ComponentType::Half, 4, 2, false };
+	case TextureFormat::R32F:
+		return { ComponentType::Float, 1, 4, false };
+	case TextureFormat::RG32F:
+		return { ComponentType::Float, 2, 4, false };
+	case TextureFormat::RGBA32F:
+		return { ComponentType::Float, 4, 4, false };
+	default:
+		return result;
+	}
+}
+
+/*
+ * Half float conversion
+ */
+float halfToFloat(uint16_t h) {
+	uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+	uint32_t exponent = (h >> 10) & 0x1f;
+	uint32_t mantissa = h & 0x3ff;
+
+	uint32_t bits = 0;
+	if (exponent == 0) {
+		if (mantissa == 0) {
+			bits = sign;
+		}
+		else {
+			// denormalized half becomes normalized float
+			uint32_t shift = 0;
+			while ((mantissa & 0x400) == 0) {
+				mantissa <<= 1;
+				++shift;
+			}
+			bits = sign | ((113 - shift) << 23) | ((mantissa & 0x3ff) << 13);
+		}
+	}
+	else if (exponent == 31) {
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else {
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+
+	float result = 0.0f;
+	etCopyMemory(&result, &bits, sizeof(result));
+	return result;
+}
+
+uint16_t floatToHalf(float value) {
+	uint32_t bits = 0;
+	etCopyMemory(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t mantissa = bits & 0x7fffff;
+	int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+
+	if ((bits & 0x7fffffff) >= 0x7f800000)
+		return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+	if (exponent >= 31)
+		return static_cast<uint16_t>(sign | 0x7c00);
+
+	if (exponent <= 0) {
+		if (exponent < -10)
+			return static_cast<uint16_t>(sign);
+
+		mantissa |= 0x800000;
+		uint32_t shift = static_cast<uint32_t>(14 - exponent);
+		uint32_t result = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1)
+			++result;
+		return static_cast<uint16_t>(sign | result);
+	}
+
+	// rounding carry propagates into exponent, which is correct behavior
+	uint32_t result = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000)
+		++result;
+	return static_cast<uint16_t>(result);
+}
+
+/*
+ * sRGB conversion, decoding uses exact table, encoding - table over linear value
+ */
+const uint32_t linearToSRGBTableSize = 4096;
+
+struct GammaTables
+{
+	float sRGBToLinear[256];
+	uint8_t linearToSRGB[linearToSRGBTableSize + 1];
+
+	GammaTables() {
+		for (uint32_t i = 0; i < 256; ++i) {
+			float c = static_cast<float>(i) / 255.0f;
+			sRGBToLinear[i] = (c <= 0.04045f) ? (c / 12.92f) : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		for (uint32_t i = 0; i <= linearToSRGBTableSize; ++i) {
+			float c = static_cast<float>(i) / static_cast<float>(linearToSRGBTableSize);
+			float s = (c <= 0.0031308f) ? (12.92f * c) : (1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f);
+			linearToSRGB[i] = static_cast<uint8_t>(clamp(s * 255.0f + 0.5f, 0.0f, 255.0f));
+		}
+	}
+};
+
+const GammaTables& gammaTables() {
+	static const GammaTables tables;
+	return tables;
+}
+
+/*
+ * Filters
+ */
+float sinc(float x) {
+	if (std::abs(x) < 1.0e-5f)
+		return 1.0f;
+	x *= PI;
+	return std::sin(x) / x;
+}
+
+float besselI0(float x) {
+	float sum = 1.0f;
+	float term = 1.0f;
+	float halfX = 0.5f * x;
+	for (uint32_t k = 1; k < 32; ++k) {
+		float t = halfX / static_cast<float>(k);
+		term *= t * t;
+		sum += term;
+		if (term < sum * 1.0e-8f)
+			break;
+	}
+	return sum;
+}
+
+float filterRadius(MipFilter filter) {
+	switch (filter) {
+	case MipFilter::Box:
+		return 0.5f;
+	default:
+		return 3.0f;
+	}
+}
+
+float evaluateFilter(MipFilter filter, float t) {
+	float radius = filterRadius(filter);
+	float absT = std::abs(t);
+	switch (filter) {
+	case MipFilter::Box:
+		return (absT <= radius) ? 1.0f : 0.0f;
+
+	case MipFilter::Kaiser: {
+		if (absT >= radius)
+			return 0.0f;
+		const float alpha = 4.0f;
+		float ratio = t / radius;
+		return sinc(t) * besselI0(alpha * std::sqrt(1.0f - ratio * ratio)) / besselI0(alpha);
+	}
+
+	case MipFilter::Lanczos:
+		return (absT < radius) ? sinc(t) * sinc(t / radius) : 0.0f;
+
+	default:
+		ET_FAIL("Invalid filter");
+		return 0.0f;
+	}
+}
+
+/*
+ * Resampling kernel: list of (source index, weight) taps for every target pixel
+ */
+struct ResampleKernel
+{
+	Vector<uint32_t> offsets;
+	Vector<uint32_t> indices;
+	Vector<float> weights;
+};
+
+void buildResampleKernel(int32_t sourceSize, int32_t targetSize, MipFilter filter, ResampleKernel& kernel) {
+	float scale = static_cast<float>(sourceSize) / static_cast<float>(targetSize);
+	float filterScale = std::max(1.0f, scale);
+	float support = filterRadius(filter) * filterScale;
+
+	kernel.offsets.clear();
+	kernel.indices.clear();
+	kernel.weights.clear();
+	kernel.offsets.reserve(targetSize + 1);
+
+	for (int32_t x = 0; x < targetSize; ++x) {
+		kernel.offsets.emplace_back(static_cast<uint32_t>(kernel.indices.size()));
+
+		float center = (static_cast<float>(x) + 0.5f) * scale;
+		int32_t first = static_cast<int32_t>(std::floor(center - support));
+		int32_t last = static_cast<int32_t>(std::ceil(center + support));
+
+		float totalWeight = 0.0f;
+		size_t firstTap = kernel.weights.size();
+		for (int32_t s = first; s <= last; ++s) {
+			float w = evaluateFilter(filter, (static_cast<float>(s) + 0.5f - center) / filterScale);
+			if (std::abs(w) < 1.0e-5f)
+				continue;
+
+			// taps outside of the image are clamped to the edge and merged
+			uint32_t index = static_cast<uint32_t>(clamp(s, 0, sourceSize - 1));
+			if ((kernel.indices.size() > firstTap) && (kernel.indices.back() == index))
+				kernel.weights.back() += w;
+			else {
+				kernel.indices.emplace_back(index);
+				kernel.weights.emplace_back(w);
+			}
+			totalWeight += w;
+		}
+
+		if (kernel.weights.size() == firstTap) {
+			kernel.indices.emplace_back(static_cast<uint32_t>(clamp(static_cast<int32_t>(center), 0, sourceSize - 1)));
+			kernel.weights.emplace_back(1.0f);
+			totalWeight = 1.0f;
+		}
+
+		for (size_t i = firstTap; i < kernel.weights.size(); ++i)
+			kernel.weights[i] /= totalWeight;
+	}
+	kernel.offsets.emplace_back(static_cast<uint32_t>(kernel.indices.size()));
+}
+
+/*
+ * Level in linear floating point representation
+ */
+struct FloatLevel
+{
+	vec2i size;
+	Vector<float> data;
+};
+
+template <uint32_t N>
+void resampleLevel(const FloatLevel& source, FloatLevel& target, MipFilter filter) {
+	ResampleKernel horizontal;
+	ResampleKernel vertical;
+	buildResampleKernel(source.size.x, target.size.x, filter, horizontal);
+	buildResampleKernel(source.size.y, target.size.y, filter, vertical);
+
+	uint32_t targetRowSize = static_cast<uint32_t>(target.size.x) * N;
+	uint32_t sourceRowSize = static_cast<uint32_t>(source.size.x) * N;
+
+	// horizontal pass: source rows -> intermediate rows of target width
+	Vector<float> intermediate(static_cast<size_t>(source.size.y) * targetRowSize);
+	uint32_t sourceRows = static_cast<uint32_t>(source.size.y);
+	parallel::forRange(sourceRows, parallel::suggestedGrain(sourceRows, 4), [&](uint32_t begin, uint32_t end) {
+		for (uint32_t y = begin; y < end; ++y) {
+			const float* sourceRow = source.data.data() + y * sourceRowSize;
+			float* outputRow = intermediate.data() + y * targetRowSize;
+			for (int32_t x = 0; x < target.size.x; ++x) {
+				float sum[N] = { };
+				for (uint32_t tap = horizontal.offsets[x], e = horizontal.offsets[x + 1]; tap < e; ++tap) {
+					const float* p = sourceRow + horizontal.indices[tap] * N;
+					float w = horizontal.weights[tap];
+					for (uint32_t c = 0; c < N; ++c)
+						sum[c] += w * p[c];
+				}
+				for (uint32_t c = 0; c < N; ++c)
+					outputRow[x * N + c] = sum[c];
+			}
+		}
+	});
+
+	// vertical pass: whole rows are accumulated, inner loop is contiguous and vectorizes well
+	target.data.resize(static_cast<size_t>(target.size.y) * targetRowSize);
+	uint32_t targetRows = static_cast<uint32_t>(target.size.y);
+	parallel::forRange(targetRows, parallel::suggestedGrain(targetRows, 2), [&](uint32_t begin, uint32_t end) {
+		for (uint32_t y = begin; y < end; ++y) {
+			float* outputRow = target.data.data() + y * targetRowSize;
+			std::fill(outputRow, outputRow + targetRowSize, 0.0f);
+			for (uint32_t tap = vertical.offsets[y], e = vertical.offsets[y + 1]; tap < e; ++tap) {
+				const float* inputRow = intermediate.data() + vertical.indices[tap] * targetRowSize;
+				float w = vertical.weights[tap];
+				for (uint32_t i = 0; i < targetRowSize; ++i)
+					outputRow[i] += w * inputRow[i];
+			}
+		}
+	});
+}
+
+void resampleLevel(uint32_t channels, const FloatLevel& source, FloatLevel& target, MipFilter filter) {
+	switch (channels) {
+	case 1:
+		resampleLevel<1>(source, target, filter);
+		break;
+	case 2:
+		resampleLevel<2>(source, target, filter);
+		break;
+	case 4:
+		resampleLevel<4>(source, target, filter);
+		break;
+	default:
+		ET_FAIL("Invalid channels count");
+	}
+}
+
+void decodeLevel(const FormatInfo& info, bool gammaCorrect, const uint8_t* input, FloatLevel& level) {
+	uint32_t valuesCount = static_cast<uint32_t>(level.size.square()) * info.channels;
+	level.data.resize(valuesCount);
+	float* output = level.data.data();
+
+	switch (info.type) {
+	case ComponentType::UnsignedByte: {
+		const GammaTables& tables = gammaTables();
+		for (uint32_t i = 0; i < valuesCount; ++i) {
+			uint32_t c = i % info.channels;
+			uint32_t sourceIndex = (info.swizzleBGR && (c < 3)) ? (i - c + 2 - c) : i;
+			bool isColor = gammaCorrect && (c < 3);
+			output[i] = isColor ? tables.sRGBToLinear[input[sourceIndex]] : static_cast<float>(input[sourceIndex]) / 255.0f;
+		}
+		break;
+	}
+	case ComponentType::Half: {
+		const uint16_t* halfInput = reinterpret_cast<const uint16_t*>(input);
+		for (uint32_t i = 0; i < valuesCount; ++i)
+			output[i] = halfToFloat(halfInput[i]);
+		break;
+	}
+	case ComponentType::Float: {
+		etCopyMemory(output, input, valuesCount * sizeof(float));
+		break;
+	}
+	default:
+		ET_FAIL("Invalid component type");
+	}
+}
+
+void encodeLevel(const FormatInfo& info, bool gammaCorrect, const FloatLevel& level, uint8_t* output) {
+	uint32_t valuesCount = static_cast<uint32_t>(level.size.square()) * info.channels;
+	const float* input = level.data.data();
+
+	switch (info.type) {
+	case ComponentType::UnsignedByte: {
+		const GammaTables& tables = gammaTables();
+		for (uint32_t i = 0; i < valuesCount; ++i) {
+			uint32_t c = i % info.channels;
+			uint32_t targetIndex = (info.swizzleBGR && (c < 3)) ? (i - c + 2 - c) : i;
+			float value = clamp(input[i], 0.0f, 1.0f);
+			if (gammaCorrect && (c < 3)) {
+				uint32_t tableIndex = static_cast<uint32_t>(value * static_cast<float>(linearToSRGBTableSize) + 0.5f);
+				output[targetIndex] = tables.linearToSRGB[tableIndex];
+			}
+			else {
+				output[targetIndex] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+			}
+		}
+		break;
+	}
+	case ComponentType::Half: {
+		uint16_t* halfOutput = reinterpret_cast<uint16_t*>(output);
+		for (uint32_t i = 0; i < valuesCount; ++i)
+			halfOutput[i] = floatToHalf(input[i]);
+		break;
+	}
+	case ComponentType::Float: {
+		etCopyMemory(output, input, valuesCount * sizeof(float));
+		break;
+	}
+	default:
+		ET_FAIL("Invalid component type");
+	}
+}
+
+/*
+ * Public interface
+ */
+bool isSupportedFormat(TextureFormat format) {
+	return formatInfo(format).type != ComponentType::Invalid;
+}
+
+uint32_t levelCountForSize(const vec2i& size) {
+	uint32_t maxDimension = static_cast<uint32_t>(std::max(1, std::max(size.x, size.y)));
+	uint32_t result = 1;
+	while ((maxDimension >> result) > 0)
+		++result;
+	return result;
+}
+
+TextureDescription::Pointer generate(const TextureDescription& source, const MipGenerationOptions& options) {
+	FormatInfo info = formatInfo(source.format);
+	if (info.type == ComponentType::Invalid) {
+		log::error("Unable to generate mip levels for %s: unsupported format %u", source.origin().c_str(),
+			static_cast<uint32_t>(source.format));
+		return TextureDescription::Pointer();
+	}
+
+	if ((source.size.x <= 0) || (source.size.y <= 0) || (source.depth != 1)) {
+		log::error("Unable to generate mip levels for %s: invalid dimensions", source.origin().c_str());
+		return TextureDescription::Pointer();
+	}
+
+	uint32_t levelCount = levelCountForSize(source.size);
+	if (options.maxLevelCount > 0)
+		levelCount = std::min(levelCount, options.maxLevelCount);
+
+	bool gammaCorrect = options.gammaCorrect && (info.type == ComponentType::UnsignedByte) && (info.channels == 4);
+	uint32_t bytesPerPixel = info.channels * info.bytesPerComponent;
+	uint32_t layerCount = std::max(1u, source.layerCount);
+
+	auto levelSize = [&source](uint32_t level) {
+		return vec2i(std::max(1, source.size.x >> level), std::max(1, source.size.y >> level));
+	};
+
+	uint32_t sourceLayerDataSize = 0;
+	for (uint32_t level = 0, e = std::max(1u, source.levelCount); level < e; ++level)
+		sourceLayerDataSize += static_cast<uint32_t>(levelSize(level).square()) * bytesPerPixel;
+
+	uint32_t targetLayerDataSize = 0;
+	for (uint32_t level = 0; level < levelCount; ++level)
+		targetLayerDataSize += static_cast<uint32_t>(levelSize(level).square()) * bytesPerPixel;
+
+	uint32_t firstLevelDataSize = static_cast<uint32_t>(source.size.square()) * bytesPerPixel;
+	if ((layerCount - 1) * sourceLayerDataSize + firstLevelDataSize > source.data.size()) {
+		log::error("Unable to generate mip levels for %s: not enough data", source.origin().c_str());
+		return TextureDescription::Pointer();
+	}
+
+	TextureDescription::Pointer result = TextureDescription::Pointer::create(source.desc());
+	result->setOrigin(source.origin());
+	result->levelCount = levelCount;
+	result->layerCount = layerCount;
+	result->dataLayout = TextureDataLayout::FacesFirst;
+	result->data.resize(targetLayerDataSize * layerCount);
+
+	/*
+	 * Levels depend on each other (every level is filtered from the previous one), layers and faces do not.
+	 * Layers are processed in parallel, rows of the level are processed in parallel inside of resampleLevel,
+	 * which runs serially when called from a layer task, so single layer textures still use all workers.
+	 */
+	parallel::forRange(layerCount, 1, [&](uint32_t beginLayer, uint32_t endLayer) {
+		for (uint32_t layer = beginLayer; layer < endLayer; ++layer) {
+			const uint8_t* input = source.data.data() + layer * sourceLayerDataSize;
+			uint8_t* output = result->data.data() + layer * targetLayerDataSize;
+
+			// first level is copied as is, every next level is filtered from previous one in linear space
+			etCopyMemory(output, input, firstLevelDataSize);
+			output += firstLevelDataSize;
+
+			FloatLevel levels[2];
+			levels[0].size = source.size;
+			decodeLevel(info, gammaCorrect, input, levels[0]);
+
+			for (uint32_t level = 1; level < levelCount; ++level) {
+				const FloatLevel& previous = levels[(level + 1) % 2];
+				FloatLevel& current = levels[level % 2];
+				current.size = levelSize(level);
+				resampleLevel(info.channels, previous, current, options.filter);
+				encodeLevel(info, gammaCorrect, current, output);
+				output += static_cast<uint32_t>(current.size.square()) * bytesPerPixel;
+			}
+		}
+	});
+
+	return result;
+}
+
+}
+}
@@ -0,0 +1,53 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/imaging/texturedescription.h>
+
+namespace et {
+
+enum class MipFilter : uint32_t
+{
+	Box,
+	Kaiser,
+	Lanczos,
+};
+
+struct MipGenerationOptions
+{
+	MipFilter filter = MipFilter::Kaiser;
+
+	/*
+	 * Color channels of RGBA8/BGRA8 textures are converted from sRGB to linear space
+	 * before filtering and back after, alpha and other formats are filtered as is
+	 */
+	bool gammaCorrect = true;
+
+	/*
+	 * 0 - generate full chain down to 1x1
+	 */
+	uint32_t maxLevelCount = 0;
+};
+
+namespace mip {
+
+/*
+ * Supported formats: R8, RG8, RGBA8, BGRA8, R16F, RG16F, RGBA16F, R32F, RG32F, RGBA32F
+ */
+bool isSupportedFormat(TextureFormat);
+
+uint32_t levelCountForSize(const vec2i& size);
+
+/*
+ * Generates mip chain from the first level of each layer of the source.
+ * Returns invalid pointer if format is not supported.
+ */
+TextureDescription::Pointer generate(const TextureDescription& source, const MipGenerationOptions& options);
+
+}
+}
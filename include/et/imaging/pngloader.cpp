@@ -150,7 +150,7 @@ void et::png::loadFromStream(std::istream& source, TextureDescription& desc, boo
 
 void et::png::loadFromFile(const std::string& path, TextureDescription& desc, bool flip)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
@@ -160,7 +160,7 @@ void et::png::loadFromFile(const std::string& path, TextureDescription& desc, bo
 
 void et::png::loadInfoFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
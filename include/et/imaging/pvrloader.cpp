@@ -74,7 +74,7 @@ void pvr::loadFromStream(std::istream& stream, TextureDescription& desc)
 
 void pvr::loadInfoFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
@@ -84,7 +84,7 @@ void pvr::loadInfoFromFile(const std::string& path, TextureDescription& desc)
 
 void pvr::loadFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
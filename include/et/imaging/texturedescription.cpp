@@ -13,6 +13,7 @@
 #include <et/imaging/tgaloader.h>
 #include <et/imaging/bmploader.h>
 #include <et/imaging/texturedescription.h>
+#include <et/core/profiler.h>
 
 namespace et
 {
@@ -85,6 +86,9 @@ bool TextureDescription::preload(const std::string& fileName, bool initWithZero)
 
 bool TextureDescription::load(const std::string& fileName)
 {
+    ET_PROFILE_SCOPE("TextureDescription::load");
+    MemoryTagScope memoryTag(MemoryTag::Textures);
+
     if (!fileExists(fileName))
         return false;
     
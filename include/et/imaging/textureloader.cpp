@@ -0,0 +1,290 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/imaging/ddsloader.h>
+#include <et/imaging/textureloader.h>
+#include <et/core/profiler.h>
+
+namespace et {
+
+const uint32_t textureCacheVersion = 2;
+
+/*
+ * TextureLoadRequest
+ */
+TextureLoadRequest::TextureLoadRequest(const std::string& fileName, TextureLoadPriority priority, Callback callback) :
+	_fileName(fileName), _callback(callback), _priority(priority) {
+}
+
+bool TextureLoadRequest::finished() const {
+	State currentState = _state.load();
+	return (currentState == State::Completed) || (currentState == State::Failed) || (currentState == State::Cancelled);
+}
+
+void TextureLoadRequest::cancel() {
+	std::unique_lock<std::mutex> lock(_stateMutex);
+	if (_state.load() == State::Pending) {
+		_state.store(State::Cancelled);
+		_finishedCondition.notify_all();
+	}
+}
+
+TextureDescription::Pointer TextureLoadRequest::wait() {
+	std::unique_lock<std::mutex> lock(_stateMutex);
+	_finishedCondition.wait(lock, [this]() { return finished(); });
+	return _result;
+}
+
+bool TextureLoadRequest::beginLoading() {
+	std::unique_lock<std::mutex> lock(_stateMutex);
+	if (_state.load() != State::Pending)
+		return false;
+
+	_state.store(State::Loading);
+	return true;
+}
+
+void TextureLoadRequest::finish(State state, TextureDescription::Pointer result) {
+	std::unique_lock<std::mutex> lock(_stateMutex);
+	_result = result;
+	_state.store(state);
+	_finishedCondition.notify_all();
+}
+
+/*
+ * AsyncTextureLoader
+ */
+bool AsyncTextureLoader::requestOrder(const TextureLoadRequest::Pointer& a, const TextureLoadRequest::Pointer& b) {
+	// heap top is the highest priority, the oldest request within the same priority
+	if (a->priority() != b->priority())
+		return a->priority() < b->priority();
+	return a->_sequenceIndex > b->_sequenceIndex;
+}
+
+AsyncTextureLoader::AsyncTextureLoader(const Options& options) :
+	_options(options) {
+	if (!_options.cacheFolder.empty()) {
+		_options.cacheFolder = addTrailingSlash(_options.cacheFolder);
+		if (!folderExists(_options.cacheFolder))
+			createDirectory(_options.cacheFolder, true);
+	}
+
+	uint32_t threadsCount = _options.workersCount;
+	if (threadsCount == 0)
+		threadsCount = static_cast<uint32_t>(std::max(size_t(2), threading::maxConcurrentThreads()) - 1);
+
+	_workers.reserve(threadsCount);
+	for (uint32_t i = 0; i < threadsCount; ++i)
+		_workers.emplace_back(&AsyncTextureLoader::workerMain, this);
+}
+
+AsyncTextureLoader::~AsyncTextureLoader() {
+	cancelAll();
+	{
+		std::unique_lock<std::mutex> lock(_queueMutex);
+		_running = false;
+	}
+	_queueCondition.notify_all();
+
+	for (std::thread& worker : _workers)
+		worker.join();
+}
+
+TextureLoadRequest::Pointer AsyncTextureLoader::load(const std::string& fileName, TextureLoadPriority priority,
+	TextureLoadRequest::Callback callback) {
+	TextureLoadRequest::Pointer request = TextureLoadRequest::Pointer::create(fileName, priority, callback);
+	{
+		std::unique_lock<std::mutex> lock(_queueMutex);
+		request->_sequenceIndex = _sequenceIndex++;
+		_queue.emplace_back(request);
+		std::push_heap(_queue.begin(), _queue.end(), requestOrder);
+	}
+	_queueCondition.notify_one();
+	return request;
+}
+
+void AsyncTextureLoader::cancelAll() {
+	Vector<TextureLoadRequest::Pointer> cancelled;
+	{
+		std::unique_lock<std::mutex> lock(_queueMutex);
+		std::swap(cancelled, _queue);
+	}
+
+	for (TextureLoadRequest::Pointer& request : cancelled)
+		request->cancel();
+}
+
+void AsyncTextureLoader::dispatchCallbacks() {
+	Vector<TextureLoadRequest::Pointer> completed;
+	{
+		std::unique_lock<std::mutex> lock(_completedMutex);
+		std::swap(completed, _completed);
+	}
+
+	for (TextureLoadRequest::Pointer& request : completed) {
+		if (request->_callback)
+			request->_callback(request->result());
+	}
+}
+
+uint32_t AsyncTextureLoader::pendingRequestsCount() {
+	std::unique_lock<std::mutex> lock(_queueMutex);
+	return static_cast<uint32_t>(_queue.size());
+}
+
+TextureLoadRequest::Pointer AsyncTextureLoader::popRequest() {
+	std::unique_lock<std::mutex> lock(_queueMutex);
+	for (;;) {
+		_queueCondition.wait(lock, [this]() { return !_running || !_queue.empty(); });
+		if (!_running)
+			return TextureLoadRequest::Pointer();
+
+		std::pop_heap(_queue.begin(), _queue.end(), requestOrder);
+		TextureLoadRequest::Pointer request = _queue.back();
+		_queue.pop_back();
+
+		// cancelled requests are dropped here instead of being searched in the queue
+		if (request->beginLoading())
+			return request;
+	}
+}
+
+void AsyncTextureLoader::workerMain() {
+	ET_PROFILE_THREAD_NAME("et::texture loader");
+
+	for (;;) {
+		TextureLoadRequest::Pointer request = popRequest();
+		if (request.invalid())
+			break;
+
+		TextureDescription::Pointer result = loadTexture(request->fileName());
+		request->finish(result.valid() ? TextureLoadRequest::State::Completed : TextureLoadRequest::State::Failed, result);
+
+		if (request->_callback) {
+			std::unique_lock<std::mutex> lock(_completedMutex);
+			_completed.emplace_back(request);
+		}
+	}
+}
+
+TextureDescription::Pointer AsyncTextureLoader::loadTexture(const std::string& fileName) {
+	ET_PROFILE_SCOPE("AsyncTextureLoader::loadTexture");
+	MemoryTagScope memoryTag(MemoryTag::Textures);
+
+	if (!fileExists(fileName)) {
+		log::error("Unable to load texture, file not found: %s", fileName.c_str());
+		return TextureDescription::Pointer();
+	}
+
+	std::string cachedFile = cacheFileName(fileName);
+	if (!cachedFile.empty() && fileExists(cachedFile)) {
+		TextureDescription::Pointer cached = TextureDescription::Pointer::create();
+		dds::loadFromFile(cachedFile, cached.reference());
+		if (!cached->data.empty()) {
+			cached->setOrigin(fileName);
+			return cached;
+		}
+
+		// truncated or unreadable cache file, it will be rebuilt from the source below
+		log::warning("Removing invalid cached texture: %s", cachedFile.c_str());
+		removeFile(cachedFile);
+	}
+
+	TextureDescription::Pointer desc = TextureDescription::Pointer::create();
+	if (!desc->load(fileName)) {
+		log::error("Unable to load texture from %s", fileName.c_str());
+		return TextureDescription::Pointer();
+	}
+
+	if (_options.generateMipLevels && (desc->levelCount == 1) && mip::isSupportedFormat(desc->format)) {
+		ET_PROFILE_SCOPE("mip::generate");
+		TextureDescription::Pointer withLevels = mip::generate(desc.reference(), _options.mipGeneration);
+		if (withLevels.valid())
+			desc = withLevels;
+	}
+
+	if (_options.compressTextures)
+		desc = compressTexture(desc);
+
+	bool cacheable = !cachedFile.empty() && (desc->target == TextureTarget::Texture_2D) &&
+		(desc->layerCount == 1) && dds::canSaveFormat(desc->format);
+
+	if (cacheable) {
+		// written under temporary name, so other workers never read partially written file
+		std::string temporaryFile = cachedFile + "." + intToStr(threading::currentThread()) + ".tmp";
+		bool saved = dds::saveToFile(desc.reference(), temporaryFile);
+
+		// rename does not replace existing file on Windows, so outdated cache is removed first
+		if (saved && (std::rename(temporaryFile.c_str(), cachedFile.c_str()) != 0)) {
+			removeFile(cachedFile);
+			saved = (std::rename(temporaryFile.c_str(), cachedFile.c_str()) == 0);
+			if (!saved)
+				log::error("Unable to write cached texture: %s", cachedFile.c_str());
+		}
+
+		if (!saved)
+			removeFile(temporaryFile);
+	}
+
+	return desc;
+}
+
+TextureDescription::Pointer AsyncTextureLoader::compressTexture(TextureDescription::Pointer source) {
+	ET_PROFILE_SCOPE("AsyncTextureLoader::compressTexture");
+
+	BlockCompressionOptions options;
+	options.quality = _options.compressionQuality;
+	switch (source->format) {
+	case TextureFormat::R8:
+		options.format = TextureFormat::DXT1_RGB;
+		break;
+	case TextureFormat::RG8:
+		options.format = TextureFormat::RGTC2;
+		break;
+	case TextureFormat::RGBA8:
+	case TextureFormat::BGRA8:
+		options.format = TextureFormat::DXT5;
+		break;
+	default:
+		return source;
+	}
+
+	TextureDescription::Pointer compressed = bc::compress(source.reference(), options);
+	return compressed.valid() ? compressed : source;
+}
+
+std::string AsyncTextureLoader::cacheFileName(const std::string& fileName) {
+	if (_options.cacheFolder.empty())
+		return std::string();
+
+	InputStream file(fileName, StreamMode_Mapped);
+	if (file.invalid())
+		return std::string();
+
+	// FNV-1a over file content, so cache survives file moves and is invalidated by any edit
+	uint64_t hash = 14695981039346656037ull;
+	auto hashBytes = [&hash](const char* data, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			hash ^= static_cast<uint8_t>(data[i]);
+			hash *= 1099511628211ull;
+		}
+	};
+
+	hashBytes(reinterpret_cast<const char*>(file.data()), static_cast<size_t>(file.size()));
+
+	uint32_t settings[] = { textureCacheVersion, _options.compressTextures ? 1u : 0u,
+		static_cast<uint32_t>(_options.compressionQuality), _options.generateMipLevels ? 1u : 0u,
+		static_cast<uint32_t>(_options.mipGeneration.filter), _options.mipGeneration.gammaCorrect ? 1u : 0u,
+		_options.mipGeneration.maxLevelCount };
+	hashBytes(reinterpret_cast<const char*>(settings), sizeof(settings));
+
+	char name[64] = { };
+	sprintf(name, "%016llX.dds", static_cast<unsigned long long>(hash));
+	return _options.cacheFolder + name;
+}
+
+}
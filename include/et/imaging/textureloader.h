@@ -0,0 +1,169 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <et/imaging/blockcompression.h>
+
+namespace et {
+
+enum class TextureLoadPriority : uint32_t
+{
+	Low,
+	Normal,
+	High,
+};
+
+class TextureLoadRequest : public Shared
+{
+public:
+	ET_DECLARE_POINTER(TextureLoadRequest);
+
+	enum class State : uint32_t
+	{
+		Pending,
+		Loading,
+		Completed,
+		Failed,
+		Cancelled,
+	};
+
+	using Callback = std::function<void(TextureDescription::Pointer)>;
+
+public:
+	TextureLoadRequest(const std::string& fileName, TextureLoadPriority priority, Callback callback);
+
+	const std::string& fileName() const {
+		return _fileName;
+	}
+
+	TextureLoadPriority priority() const {
+		return _priority;
+	}
+
+	State state() const {
+		return _state.load();
+	}
+
+	bool finished() const;
+
+	/*
+	 * Request is removed from queue if it was not started yet,
+	 * callback of the cancelled request is never invoked
+	 */
+	void cancel();
+
+	/*
+	 * Blocks until request is finished, returns invalid pointer if loading failed or was cancelled
+	 */
+	TextureDescription::Pointer wait();
+
+	/*
+	 * Valid only when request is completed
+	 */
+	const TextureDescription::Pointer& result() const {
+		return _result;
+	}
+
+private:
+	friend class AsyncTextureLoader;
+
+	bool beginLoading();
+	void finish(State, TextureDescription::Pointer);
+
+private:
+	std::string _fileName;
+	Callback _callback;
+	TextureDescription::Pointer _result;
+	std::mutex _stateMutex;
+	std::condition_variable _finishedCondition;
+	std::atomic<State> _state{ State::Pending };
+	TextureLoadPriority _priority = TextureLoadPriority::Normal;
+	uint64_t _sequenceIndex = 0;
+};
+
+class AsyncTextureLoader
+{
+public:
+	struct Options
+	{
+		/*
+		 * 0 - one worker per hardware thread except calling one
+		 */
+		uint32_t workersCount = 0;
+
+		/*
+		 * Decoded textures are stored in this folder, keyed by hash of the source file content.
+		 * Empty folder disables disk cache.
+		 */
+		std::string cacheFolder;
+
+		/*
+		 * Block compress RGBA8/BGRA8/RG8/R8 textures before returning (and caching) them
+		 */
+		bool compressTextures = false;
+		BlockCompressionQuality compressionQuality = BlockCompressionQuality::Normal;
+
+		/*
+		 * Generate mip chain for textures loaded with single level,
+		 * so they could be uploaded without waiting for GPU mip generation
+		 */
+		bool generateMipLevels = false;
+		MipGenerationOptions mipGeneration;
+	};
+
+public:
+	AsyncTextureLoader(const Options& options);
+	~AsyncTextureLoader();
+
+	/*
+	 * Callback is invoked from dispatchCallbacks, on the thread which calls it
+	 */
+	TextureLoadRequest::Pointer load(const std::string& fileName, TextureLoadPriority priority,
+		TextureLoadRequest::Callback callback = nullptr);
+
+	void cancelAll();
+	void dispatchCallbacks();
+
+	uint32_t pendingRequestsCount();
+	uint32_t workersCount() const {
+		return static_cast<uint32_t>(_workers.size());
+	}
+
+	/*
+	 * Synchronous path used by workers, could be called from any thread
+	 */
+	TextureDescription::Pointer loadTexture(const std::string& fileName);
+
+private:
+	ET_DENY_COPY(AsyncTextureLoader);
+
+	static bool requestOrder(const TextureLoadRequest::Pointer&, const TextureLoadRequest::Pointer&);
+
+	void workerMain();
+	TextureLoadRequest::Pointer popRequest();
+
+	std::string cacheFileName(const std::string& fileName);
+	TextureDescription::Pointer compressTexture(TextureDescription::Pointer);
+
+private:
+	Options _options;
+	std::vector<std::thread> _workers;
+
+	std::mutex _queueMutex;
+	std::condition_variable _queueCondition;
+	Vector<TextureLoadRequest::Pointer> _queue;
+	uint64_t _sequenceIndex = 0;
+	bool _running = true;
+
+	std::mutex _completedMutex;
+	Vector<TextureLoadRequest::Pointer> _completed;
+};
+
+}
@@ -252,7 +252,7 @@ void et::tga::loadFromStream(std::istream& source, TextureDescription& desc)
 
 void et::tga::loadFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
@@ -262,7 +262,7 @@ void et::tga::loadFromFile(const std::string& path, TextureDescription& desc)
 
 void et::tga::loadInfoFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
+	InputStream file(path, StreamMode_Mapped);
 	if (file.valid())
 	{
 		desc.setOrigin(path);
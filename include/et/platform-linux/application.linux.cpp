@@ -0,0 +1,187 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/app/application.h>
+
+#if (ET_PLATFORM_LINUX)
+
+#include <et/rendering/rendercontext.h>
+#include <signal.h>
+
+namespace et {
+
+/*
+ * Headless application: there is no window and no event loop,
+ * frames are performed one after another until quit is requested
+ * (by the delegate, by frame count or by SIGINT / SIGTERM)
+ */
+static volatile sig_atomic_t terminationRequested = 0;
+
+void handleTerminationSignal(int);
+void applyLaunchParameters(const StringList&, ApplicationParameters&);
+
+void Application::platformInit() {
+	struct sigaction action = { };
+	action.sa_handler = handleTerminationSignal;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+}
+
+void Application::platformFinalize() {
+}
+
+void Application::platformSuspend() {
+}
+
+void Application::platformResume() {
+}
+
+void Application::platformActivate() {
+}
+
+void Application::platformDeactivate() {
+}
+
+void Application::initContext() {
+}
+
+void Application::freeContext() {
+}
+
+int Application::platformRun() {
+	_running = true;
+
+	applyLaunchParameters(_launchParameters, _parameters);
+
+	if (!_parameters.traceFile.empty())
+	{
+		ET_PROFILE_THREAD_NAME("et::main");
+		profiler::beginCapture();
+	}
+
+	RunLoopScope runLoopScope(_runLoop);
+	initContext();
+
+	RenderContextParameters renderContextParameters;
+	delegate()->setRenderContextParameters(renderContextParameters);
+
+	_lastQueuedTimeMSec = queryContinuousTimeInMilliSeconds();
+	_runLoop.updateTime(_lastQueuedTimeMSec);
+
+	_renderContext.init(_parameters, renderContextParameters);
+	_renderThread.init(_renderContext.renderer());
+
+	delegate()->applicationDidLoad();
+
+	setActive(true);
+
+	delegate()->applicationWillResizeContext(_renderContext.renderer()->contextSize());
+
+	while (_running)
+	{
+		if (terminationRequested)
+		{
+			log::info("[et-engine] Termination requested");
+			quit(0);
+			break;
+		}
+
+		processEvents();
+	}
+
+	reportFrameTimes();
+
+	if (!_parameters.traceFile.empty())
+	{
+		profiler::endCapture();
+		profiler::exportChromeTrace(_parameters.traceFile);
+	}
+
+	if (!_parameters.memorySnapshotFile.empty())
+		sharedBlockAllocator().saveSnapshot(_parameters.memorySnapshotFile);
+
+	_delegate->applicationWillTerminate();
+	_renderContext.renderer()->shutdown();
+
+	sharedObjectFactory().deleteObject(_delegate);
+	_delegate = nullptr;
+
+	_renderContext.shutdown();
+	freeContext();
+
+	return _exitCode;
+}
+
+void Application::quit(int exitCode) {
+	ET_ASSERT(_running);
+
+	_running = false;
+	_exitCode = exitCode;
+}
+
+Application::~Application() {
+	_renderThread.stop();
+	_renderThread.join();
+	_backgroundThread.stop();
+	_backgroundThread.join();
+}
+
+void Application::setTitle(const std::string&) {
+}
+
+void Application::requestUserAttention() {
+}
+
+void Application::processEvents() {
+	if (shouldPerformRendering())
+	{
+		performUpdateAndRender();
+	}
+}
+
+/*
+ * Service functions
+ */
+void handleTerminationSignal(int) {
+	terminationRequested = 1;
+}
+
+/*
+ * Overrides for benchmark runs:
+ *   --frames N          quit after N frames
+ *   --fixed-step MSEC   advance time by MSEC each frame, do not wait between frames
+ *   --frame-times FILE  write CPU time of each frame to FILE
+ *   --trace FILE        capture profiler events and export them to FILE (Chrome trace format)
+ *   --memory-snapshot FILE  write per-tag memory statistics to FILE (JSON)
+ */
+void applyLaunchParameters(const StringList& params, ApplicationParameters& appParams) {
+	for (size_t i = 0, e = params.size(); i + 1 < e; ++i)
+	{
+		const std::string& name = params[i];
+		const std::string& value = params[i + 1];
+
+		if (name == "--frames")
+			appParams.framesToRun = static_cast<uint32_t>(strToInt(value));
+		else if (name == "--fixed-step")
+			appParams.fixedTimeStepMSec = static_cast<uint32_t>(strToInt(value));
+		else if (name == "--frame-times")
+			appParams.frameTimesFile = value;
+		else if (name == "--trace")
+			appParams.traceFile = value;
+		else if (name == "--memory-snapshot")
+			appParams.memorySnapshotFile = value;
+		else
+			continue;
+
+		++i;
+	}
+}
+
+}
+
+#endif // ET_PLATFORM_LINUX
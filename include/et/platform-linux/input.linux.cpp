@@ -0,0 +1,37 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/app/application.h>
+
+#if (ET_PLATFORM_LINUX)
+
+#include <et/input/input.h>
+
+using namespace et;
+
+/*
+ * Headless backend has no input devices
+ */
+PointerInputInfo Input::currentPointer()
+{
+	return PointerInputInfo(0, vec2(0.0f), vec2(0.0f), vec2(0.0f), 0, mainRunLoop().time(), PointerOrigin::Mouse);
+}
+
+bool Input::canGetCurrentPointerInfo()
+{
+	return false;
+}
+
+void Input::activateSoftwareKeyboard()
+{
+}
+
+void Input::deactivateSoftwareKeyboard()
+{
+}
+
+#endif
@@ -0,0 +1,63 @@
+/*
+* This file is part of `et engine`
+* Copyright 2009-2016 by Sergey Reznik
+* Please, modify content only if you know what are you doing.
+*
+*/
+
+#include <et/core/tools.h>
+#include <et/core/containers.h>
+#include <et/locale/locale.hpp>
+
+#if (ET_PLATFORM_LINUX)
+
+using namespace et;
+
+static std::string formatTime(time_t t, const char* format)
+{
+	tm localTime = { };
+	localtime_r(&t, &localTime);
+
+	char buffer[256] = { };
+	strftime(buffer, sizeof(buffer), format, &localTime);
+	return std::string(buffer);
+}
+
+std::string locale::time()
+{
+	return formatTime(std::time(nullptr), "%X");
+}
+
+std::string locale::date()
+{
+	return formatTime(std::time(nullptr), "%x");
+}
+
+std::string locale::dateTimeFromTimestamp(uint64_t t)
+{
+	return formatTime(static_cast<time_t>(t), "%x %X");
+}
+
+/*
+ * Language part of LC_ALL / LC_MESSAGES / LANG, e.g. "en_US.UTF-8" -> "en-us"
+ */
+std::string locale::currentLocale()
+{
+	const char* variables[] = { "LC_ALL", "LC_MESSAGES", "LANG" };
+	for (const char* variable : variables)
+	{
+		const char* value = getenv(variable);
+		if ((value == nullptr) || (*value == 0) || (strcmp(value, "C") == 0) || (strcmp(value, "POSIX") == 0))
+			continue;
+
+		std::string result(value);
+		result = result.substr(0, result.find_first_of(".@"));
+		std::replace(result.begin(), result.end(), '_', '-');
+		lowercase(result);
+		return result;
+	}
+
+	return std::string("en");
+}
+
+#endif // ET_PLATFORM_LINUX
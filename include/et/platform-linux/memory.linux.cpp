@@ -0,0 +1,67 @@
+/*
+* This file is part of `et engine`
+* Copyright 2009-2016 by Sergey Reznik
+* Please, modify content only if you know what are you doing.
+*
+*/
+
+#include <et/core/memory.h>
+
+#if (ET_PLATFORM_LINUX)
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace et;
+
+/*
+ * Resident set size, from the second field of /proc/self/statm (in pages)
+ */
+size_t et::memoryUsage()
+{
+	unsigned long long totalPages = 0;
+	unsigned long long residentPages = 0;
+
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if (statm == nullptr)
+		return 0;
+
+	int fieldsRead = fscanf(statm, "%llu %llu", &totalPages, &residentPages);
+	fclose(statm);
+
+	return (fieldsRead == 2) ? static_cast<size_t>(residentPages * sysconf(_SC_PAGESIZE)) : 0;
+}
+
+/*
+ * MemAvailable from /proc/meminfo (in kilobytes), includes reclaimable caches
+ */
+size_t et::availableMemory()
+{
+	FILE* meminfo = fopen("/proc/meminfo", "r");
+	if (meminfo == nullptr)
+		return 0;
+
+	char line[256] = { };
+	unsigned long long availableKb = 0;
+	while (fgets(line, sizeof(line), meminfo) != nullptr)
+	{
+		if (sscanf(line, "MemAvailable: %llu kB", &availableKb) == 1)
+			break;
+	}
+	fclose(meminfo);
+
+	return static_cast<size_t>(availableKb * 1024);
+}
+
+void* et::allocateVirtualMemory(size_t size)
+{
+	void* result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return (result == MAP_FAILED) ? nullptr : result;
+}
+
+void et::deallocateVirtualMemory(void* ptr, size_t size)
+{
+	munmap(ptr, size);
+}
+
+#endif // ET_PLATFORM_LINUX
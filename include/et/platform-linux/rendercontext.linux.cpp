@@ -0,0 +1,77 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/rendering/rendercontext.h>
+
+#if (ET_PLATFORM_LINUX)
+
+#include <et/rendering/null/null_renderer.h>
+#include <et/rendering/base/helpers.h>
+#include <et/app/application.h>
+
+namespace et {
+
+class RenderContextPrivate
+{
+public:
+	RendererFrame currentFrame;
+	vec2i scheduledSize = vec2i(0);
+	bool resizeScheduled = false;
+};
+
+RenderContext::RenderContext() {
+	ET_PIMPL_INIT(RenderContext);
+}
+
+RenderContext::~RenderContext() {
+	ET_PIMPL_FINALIZE(RenderContext);
+}
+
+void RenderContext::init(const ApplicationParameters& appParams, const RenderContextParameters& rcParams) {
+	if (appParams.renderingAPI == RenderingAPI::Null)
+	{
+		_renderer = NullRenderer::Pointer::create();
+	}
+	else
+	{
+		ET_FAIL("Invalid or unsupported rendering api provided");
+	}
+	_renderer->init(rcParams);
+	_renderer->resize(appParams.context.size);
+	renderhelper::init(_renderer);
+}
+
+void RenderContext::shutdown() {
+	renderhelper::release();
+	_renderer->destroy();
+	_renderer.release();
+}
+
+bool RenderContext::beginRender() {
+	if (_private->resizeScheduled)
+	{
+		_renderer->resize(_private->scheduledSize);
+		_private->resizeScheduled = false;
+	}
+
+	_private->currentFrame = _renderer->allocateFrame();
+	return (_private->currentFrame.identifier != 0);
+}
+
+void RenderContext::endRender() {
+	_renderer->submitFrame(_private->currentFrame);
+	_renderer->present();
+}
+
+void RenderContext::performResizing(const vec2i& size) {
+	_private->scheduledSize = size;
+	_private->resizeScheduled = true;
+}
+
+}
+
+#endif // ET_PLATFORM_LINUX
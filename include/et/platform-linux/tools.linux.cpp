@@ -0,0 +1,370 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/tools.h>
+
+#if (ET_PLATFORM_LINUX)
+
+#include <et/core/hardware.h>
+#include <et/core/containers.h>
+#include <et/app/application.h>
+
+#include <dirent.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace et
+{
+
+/*
+ * Monotonic clock, not affected by changes of the system time
+ */
+uint64_t queryMonotonicTimeInMicroSeconds()
+{
+	timespec ts = { };
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000 + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+uint64_t queryContinuousTimeInMilliSeconds()
+{
+	// thread-safe initialization on the first call
+	static const uint64_t initialTime = queryMonotonicTimeInMicroSeconds();
+	return (queryMonotonicTimeInMicroSeconds() - initialTime) / 1000;
+}
+
+float queryContinuousTimeInSeconds()
+{
+	return static_cast<float>(queryContinuousTimeInMilliSeconds()) / 1000.0f;
+}
+
+uint64_t queryCurrentTimeInMicroSeconds()
+{
+	return queryMonotonicTimeInMicroSeconds();
+}
+
+const char pathDelimiter = '/';
+const char invalidPathDelimiter = '\\';
+
+std::string environmentFolder(const char* variable, const std::string& fallback)
+{
+	const char* value = getenv(variable);
+	return addTrailingSlash(((value != nullptr) && (*value != 0)) ? std::string(value) : fallback);
+}
+
+std::string homeFolder()
+{
+	return environmentFolder("HOME", "/tmp");
+}
+
+std::string applicationPath()
+{
+	char buffer[PATH_MAX] = { };
+	ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+	return (length > 0) ? getFilePath(std::string(buffer, static_cast<size_t>(length))) : workingFolder();
+}
+
+std::string applicationPackagePath()
+{
+	return workingFolder();
+}
+
+std::string applicationDataFolder()
+{
+	return workingFolder();
+}
+
+std::string documentsBaseFolder()
+{
+	return environmentFolder("XDG_DOCUMENTS_DIR", homeFolder() + "Documents");
+}
+
+std::string libraryBaseFolder()
+{
+	return environmentFolder("XDG_DATA_HOME", homeFolder() + ".local/share");
+}
+
+std::string temporaryBaseFolder()
+{
+	return environmentFolder("TMPDIR", "/tmp");
+}
+
+std::string workingFolder()
+{
+	char buffer[PATH_MAX] = { };
+	if (getcwd(buffer, sizeof(buffer)) == nullptr)
+		return emptyString;
+
+	return addTrailingSlash(std::string(buffer));
+}
+
+bool fileExists(const std::string& name)
+{
+	struct stat s = { };
+	return (stat(name.c_str(), &s) == 0) && S_ISREG(s.st_mode);
+}
+
+bool folderExists(const std::string& folder)
+{
+	struct stat s = { };
+	return (stat(folder.c_str(), &s) == 0) && S_ISDIR(s.st_mode);
+}
+
+bool createDirectory(const std::string& name, bool intermediates)
+{
+	if (intermediates)
+	{
+		std::string path = (name.front() == pathDelimiter) ? std::string(1, pathDelimiter) : emptyString;
+		for (const std::string& dir : split(name, std::string(1, pathDelimiter)))
+		{
+			if (dir.empty())
+				continue;
+
+			path += dir + pathDelimiter;
+			if (!folderExists(path) && (mkdir(path.c_str(), 0755) != 0))
+				return false;
+		}
+		return true;
+	}
+
+	return mkdir(name.c_str(), 0755) == 0;
+}
+
+bool removeFile(const std::string& name)
+{
+	return unlink(name.c_str()) == 0;
+}
+
+bool copyFile(const std::string& from, const std::string& to)
+{
+	std::ifstream fIn(from, std::ios::in | std::ios::binary);
+	if (fIn.fail())
+		return false;
+
+	std::ofstream fOut(to, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (fOut.fail())
+		return false;
+
+	fOut << fIn.rdbuf();
+	return !fOut.fail();
+}
+
+/*
+ * Calls function for each entry of the folder except `.` and `..`
+ */
+template <class F>
+void enumerateFolder(const std::string& folder, F func)
+{
+	DIR* dir = opendir(folder.c_str());
+	if (dir == nullptr)
+		return;
+
+	while (dirent* entry = readdir(dir))
+	{
+		if ((strcmp(entry->d_name, ".") != 0) && (strcmp(entry->d_name, "..") != 0))
+			func(std::string(entry->d_name));
+	}
+	closedir(dir);
+}
+
+bool removeDirectory(const std::string& name)
+{
+	std::string normalizedFolder = addTrailingSlash(name);
+
+	bool success = true;
+	enumerateFolder(normalizedFolder, [&normalizedFolder, &success](const std::string& entry) {
+		std::string path = normalizedFolder + entry;
+		success &= folderExists(path) ? removeDirectory(path) : removeFile(path);
+	});
+
+	return success && (rmdir(name.c_str()) == 0);
+}
+
+void getFolderContent(const std::string& folder, StringList& list)
+{
+	std::string normalizedFolder = addTrailingSlash(folder);
+	enumerateFolder(normalizedFolder, [&normalizedFolder, &list](const std::string& entry) {
+		list.push_back(normalizedFolder + entry);
+	});
+}
+
+void findFiles(const std::string& folder, const std::string& mask, bool recursive, StringList& list)
+{
+	std::string normalizedFolder = addTrailingSlash(folder);
+
+	StringList folderList;
+	enumerateFolder(normalizedFolder, [&](const std::string& entry) {
+		std::string path = normalizedFolder + entry;
+		if (folderExists(path))
+		{
+			if (recursive)
+				folderList.push_back(path);
+		}
+		else if (fnmatch(mask.c_str(), entry.c_str(), 0) == 0)
+		{
+			list.push_back(path);
+		}
+	});
+
+	for (const std::string& i : folderList)
+		findFiles(i, mask, recursive, list);
+}
+
+void findSubfolders(const std::string& folder, bool recursive, StringList& list)
+{
+	std::string normalizedFolder = addTrailingSlash(folder);
+
+	StringList folderList;
+	enumerateFolder(normalizedFolder, [&normalizedFolder, &folderList](const std::string& entry) {
+		std::string path = normalizedFolder + entry + pathDelimiter;
+		if (folderExists(path))
+			folderList.push_back(path);
+	});
+
+	if (recursive)
+	{
+		for (const std::string& i : folderList)
+			findSubfolders(i, true, list);
+	}
+
+	list.insert(list.end(), folderList.begin(), folderList.end());
+}
+
+void openUrl(const std::string& url)
+{
+	log::info("Unable to open URL in headless application: %s", url.c_str());
+}
+
+/*
+ * wchar_t is UTF-32 on Linux
+ */
+std::string unicodeToUtf8(const std::wstring& w)
+{
+	std::string result;
+	result.reserve(w.size());
+
+	for (wchar_t wc : w)
+	{
+		uint32_t c = static_cast<uint32_t>(wc);
+		if (c < 0x80)
+		{
+			result.push_back(static_cast<char>(c));
+		}
+		else if (c < 0x800)
+		{
+			result.push_back(static_cast<char>(0xC0 | (c >> 6)));
+			result.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+		}
+		else if (c < 0x10000)
+		{
+			result.push_back(static_cast<char>(0xE0 | (c >> 12)));
+			result.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+		}
+		else if (c < 0x110000)
+		{
+			result.push_back(static_cast<char>(0xF0 | (c >> 18)));
+			result.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+			result.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+		}
+	}
+
+	return result;
+}
+
+std::wstring utf8ToUnicode(const std::string& mbcs)
+{
+	std::wstring result;
+	result.reserve(mbcs.size());
+
+	const uint8_t* ptr = reinterpret_cast<const uint8_t*>(mbcs.data());
+	const uint8_t* end = ptr + mbcs.size();
+	while (ptr < end)
+	{
+		uint32_t c = *ptr++;
+		uint32_t extraBytes = (c >= 0xF0) ? 3 : ((c >= 0xE0) ? 2 : ((c >= 0xC0) ? 1 : 0));
+		if ((c >= 0x80) && (extraBytes == 0))
+			continue;
+
+		c &= (0x3F >> extraBytes);
+		for (uint32_t i = 0; (i < extraBytes) && (ptr < end) && ((*ptr & 0xC0) == 0x80); ++i)
+			c = (c << 6) | (*ptr++ & 0x3F);
+
+		result.push_back(static_cast<wchar_t>(c));
+	}
+
+	return result;
+}
+
+std::string applicationIdentifierForCurrentProject()
+{
+	return "com.et.app";
+}
+
+uint64_t getFileDate(const std::string& path)
+{
+	struct stat s = { };
+	stat(path.c_str(), &s);
+	return static_cast<uint64_t>(s.st_mtim.tv_sec);
+}
+
+uint64_t getFileUniqueIdentifier(const std::string& path)
+{
+	struct stat s = { };
+	stat(path.c_str(), &s);
+
+	uint64_t dateUid = static_cast<uint64_t>(s.st_mtim.tv_sec) * 1000000000 + static_cast<uint64_t>(s.st_mtim.tv_nsec);
+	uint64_t sizeUid = static_cast<uint64_t>(s.st_size);
+
+	return dateUid ^ sizeUid;
+}
+
+/*
+ * Single virtual screen, matching size of the application context
+ */
+Vector<Screen> availableScreens()
+{
+	recti screenRect(vec2i(0), application().parameters().context.size);
+	return Vector<Screen>(1, Screen(screenRect, screenRect, 1.0f));
+}
+
+Screen currentScreen()
+{
+	return availableScreens().front();
+}
+
+std::string selectFile(const StringList&, SelectFileMode, const std::string&)
+{
+	return emptyString;
+}
+
+void alert(const std::string& title, const std::string& message, const std::string&, AlertType type)
+{
+	switch (type)
+	{
+	case AlertType::Warning:
+	{
+		log::warning("%s: %s", title.c_str(), message.c_str());
+		break;
+	}
+
+	case AlertType::Error:
+	{
+		log::error("%s: %s", title.c_str(), message.c_str());
+		break;
+	}
+
+	default:
+		log::info("%s: %s", title.c_str(), message.c_str());
+	}
+}
+
+}
+
+#endif // ET_PLATFORM_LINUX
@@ -43,6 +43,11 @@
 #	define ET_PLATFORM_MAC				1
 #	define CurrentPlatform				Platform::Mac
 #
+#elif defined(__linux__)
+#
+#	define ET_PLATFORM_LINUX			1
+#	define CurrentPlatform				Platform::Linux
+#
 #else
 #
 #	error Unable to determine current platform
@@ -78,6 +83,7 @@ namespace et
 	{
 		Windows,
 		Mac,
+		Linux,
 	};
 	
 	enum Architecture : uint32_t
@@ -37,6 +37,8 @@ ConstantBuffer::~ConstantBuffer()
 
 void ConstantBuffer::init(RenderInterface* renderer, uint32_t allowedAllocations)
 {
+	MemoryTagScope memoryTag(MemoryTag::ConstantBuffers);
+
 	_private->allowedAllocations = allowedAllocations;
 
 	_private->heap.init(Capacity, Granularity);
@@ -99,6 +101,8 @@ const ConstantBufferEntry::Pointer& ConstantBuffer::allocate(uint64_t size, uint
 
 const ConstantBufferEntry::Pointer& ConstantBufferPrivate::allocateInternal(uint64_t size, uint32_t cls)
 {
+	MemoryTagScope memoryTag(MemoryTag::ConstantBuffers);
+
 	uint64_t offset = 0;
 
 	if (!heap.allocate(size, offset))
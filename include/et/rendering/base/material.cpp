@@ -244,6 +244,7 @@ std::string Material::generateInputLayout(const VertexDeclaration& decl) {
 
 		layout.append(buffer);
 	}
+	layout.append("uint instanceIndex : SV_InstanceID;\n");
 	layout.append("};\n");
 
 	return layout;
@@ -569,6 +570,9 @@ void Material::initDefaultHeader() {
 
 #define DECL_OBJECT_BUFFER		register(c0, space0)
 #define DECL_MATERIAL_BUFFER	register(c1, space0)
+#define DECL_INSTANCE_BUFFER	register(c2, space0)
+
+#define MAX_INSTANCES_PER_BATCH	64
 
 #define DECLARE_BUFFER		DECL_REGISTER(c, space0)
 #define DECLARE_TEXTURE		DECL_REGISTER(t, space1) 
@@ -168,7 +168,7 @@ inline T Material::getParameter(MaterialVariable p) const
 	auto i = std::find_if(properties.begin(), properties.end(), [pIndex](const VariablesHolder::value_type& t) {
 		return t.first == pIndex;
 	});
-	return ((i != properties.end()) && i->second.is<T>()) ? i->second.as<T>() : T();
+	return ((i != properties.end()) && i->second.template is<T>()) ? i->second.template as<T>() : T();
 }
 
 }
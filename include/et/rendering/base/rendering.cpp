@@ -8,6 +8,11 @@
 #include <et/rendering/base/rendering.h>
 #include <et/rendering/interface/sampler.h>
 
+#if !(ET_PLATFORM_WIN)
+#	include <strings.h>
+#	define stricmp strcasecmp
+#endif
+
 namespace et {
 
 const ResourceRange ResourceRange::whole;
@@ -304,7 +309,14 @@ uint32_t bitsPerPixelForTextureFormat(TextureFormat format) {
 	case TextureFormat::RGBA32F:
 		return 128;
 
+	case TextureFormat::DXT1_RGB:
+	case TextureFormat::DXT1_RGBA:
+		return 4;
+
+	case TextureFormat::DXT3:
 	case TextureFormat::DXT5:
+	case TextureFormat::RGTC2:
+	case TextureFormat::BC7:
 		return 8;
 
 	default:
@@ -364,6 +376,7 @@ bool isCompressedTextureFormat(TextureFormat internalFormat) {
 	case TextureFormat::DXT3:
 	case TextureFormat::DXT5:
 	case TextureFormat::RGTC2:
+	case TextureFormat::BC7:
 		return true;
 
 	default:
@@ -374,7 +387,12 @@ bool isCompressedTextureFormat(TextureFormat internalFormat) {
 vec2i compressedFormatBlockSize(TextureFormat internalFormat) {
 	switch (internalFormat)
 	{
+	case TextureFormat::DXT1_RGB:
+	case TextureFormat::DXT1_RGBA:
+	case TextureFormat::DXT3:
 	case TextureFormat::DXT5:
+	case TextureFormat::RGTC2:
+	case TextureFormat::BC7:
 		return vec2i(4);
 
 	default:
@@ -425,6 +443,7 @@ uint32_t channelsForTextureFormat(TextureFormat internalFormat) {
 	case TextureFormat::DXT1_RGBA:
 	case TextureFormat::DXT3:
 	case TextureFormat::DXT5:
+	case TextureFormat::BC7:
 		return 4;
 
 	default:
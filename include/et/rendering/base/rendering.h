@@ -202,6 +202,7 @@ enum class TextureFormat : uint32_t
 	PVR_4bpp_RGBA,
 	PVR_4bpp_sRGBA,
 	R11G11B10F,
+	BC7,
 	max
 };
 
@@ -338,6 +339,9 @@ enum : uint32_t
 
 	ObjectVariablesBufferIndex = 0,
 	MaterialVariablesBufferIndex = 1,
+	InstanceVariablesBufferIndex = 2,
+
+	MaxInstancesPerBatch = 64,
 
 	MaxRenderTargets = 8,
 	MaxTextureUnits = 8,
@@ -73,18 +73,18 @@ const std::string& materialVariableToString(MaterialVariable p) {
 
 namespace MaterialTexture {
 
-const std::string MaterialTexture::BaseColor = "baseColor";
-const std::string MaterialTexture::Normal = "normal";
-const std::string MaterialTexture::Opacity = "opacity";
-const std::string MaterialTexture::EmissiveColor = "emissiveColor";
-const std::string MaterialTexture::Shadow = "shadow";
-const std::string MaterialTexture::AmbientOcclusion = "ao";
-const std::string MaterialTexture::ConvolvedSpecular = "convolvedSpecular";
-const std::string MaterialTexture::BRDFLookup = "brdfLookup";
-const std::string MaterialTexture::Noise = "noise";
-const std::string MaterialTexture::LTCTransform = "ltcTransform";
-const std::string MaterialTexture::Input = "inputTexture";
-const std::string MaterialTexture::OutputImage = "outputImage";
+const std::string BaseColor = "baseColor";
+const std::string Normal = "normal";
+const std::string Opacity = "opacity";
+const std::string EmissiveColor = "emissiveColor";
+const std::string Shadow = "shadow";
+const std::string AmbientOcclusion = "ao";
+const std::string ConvolvedSpecular = "convolvedSpecular";
+const std::string BRDFLookup = "brdfLookup";
+const std::string Noise = "noise";
+const std::string LTCTransform = "ltcTransform";
+const std::string Input = "inputTexture";
+const std::string OutputImage = "outputImage";
 
 }
 
@@ -91,6 +91,14 @@ enum : uint32_t
 	MaterialVariable_max = static_cast<uint32_t>(MaterialVariable::max),
 };
 
+struct ObjectInstance
+{
+	mat4 worldTransform;
+	mat4 worldRotationTransform;
+	mat4 previousWorldTransform;
+	mat4 previousWorldRotationTransform;
+};
+
 struct MaterialTextureHolder
 {
 	std::string binding;
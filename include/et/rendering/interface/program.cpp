@@ -33,6 +33,9 @@ void Program::printReflection() const
 	printVariables("Material variables", _reflection.materialVariables, MaterialVariable_max, mtlToStr);
 	printVariables("Object variables", _reflection.objectVariables, ObjectVariable_max, objToStr);
 
+	if (_reflection.instanceVariablesBufferSize > 0)
+		log::info("Instance variables: %u bytes", _reflection.instanceVariablesBufferSize);
+
 	for (const auto& tex : _reflection.textures)
 	{
 		if (!tex.textures.empty())
@@ -83,6 +86,8 @@ void Program::Reflection::serialize(std::ostream& file) const
 		serializeUInt32(file, materialVariables[i].enabled);
 	}
 
+	serializeUInt32(file, instanceVariablesBufferSize);
+
 	serializeUInt32(file, static_cast<uint32_t>(textures.size()));
 	for (const auto& tex : textures)
 	{
@@ -140,6 +145,8 @@ bool Program::Reflection::deserialize(std::istream& file)
 		materialVariables[i].enabled = deserializeUInt32(file);
 	}
 
+	instanceVariablesBufferSize = deserializeUInt32(file);
+
 	textures.clear();
 	uint32_t texturesSize = deserializeInt32(file);
 	for (uint32_t i = 0; i < texturesSize; ++i)
@@ -41,6 +41,8 @@ public:
 		uint32_t materialVariablesBufferSize = 0;
 		Variable materialVariables[MaterialVariable_max];
 
+		uint32_t instanceVariablesBufferSize = 0;
+
 		TextureSet::Reflection textures;
 
 		void serialize(std::ostream&) const;
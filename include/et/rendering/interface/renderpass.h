@@ -105,6 +105,8 @@ public:
 
 	// virtual void begin(const RenderPassBeginInfo& info) = 0;
 	virtual void pushRenderBatch(const MaterialInstance::Pointer&, const VertexStream::Pointer&, uint32_t first, uint32_t count) = 0;
+	virtual void pushInstancedRenderBatch(const MaterialInstance::Pointer&, const VertexStream::Pointer&, uint32_t first, uint32_t count,
+		const ObjectInstance* instances, uint32_t instanceCount) = 0;
 	virtual void pushImageBarrier(const Texture::Pointer&, const ResourceBarrier&) = 0;
 	virtual void copyImage(const Texture::Pointer&, const Texture::Pointer&, const CopyDescriptor&) = 0;
 	virtual void copyImageToBuffer(const Texture::Pointer&, const Buffer::Pointer&, const CopyDescriptor&) = 0;
@@ -139,6 +141,8 @@ public:
 		pushRenderBatch(inBatch->material(), inBatch->vertexStream(), inBatch->firstIndex(), inBatch->numIndexes());
 	}
 
+	void pushInstancedRenderBatch(const RenderBatch::Pointer& inBatch, const ObjectInstance* instances, uint32_t instanceCount);
+
 	void addSingleRenderBatchSubpass(const RenderBatch::Pointer& inBatch);
 
 	const Texture::Pointer& colorTarget(uint32_t = 0) const;
@@ -182,6 +186,14 @@ inline void RenderPass::addSingleRenderBatchSubpass(const RenderBatch::Pointer&
 	endSubpass();
 }
 
+inline void RenderPass::pushInstancedRenderBatch(const RenderBatch::Pointer& inBatch, const ObjectInstance* instances, uint32_t instanceCount) {
+	for (uint32_t i = 0; i < instanceCount; i += MaxInstancesPerBatch)
+	{
+		pushInstancedRenderBatch(inBatch->material(), inBatch->vertexStream(), inBatch->firstIndex(), inBatch->numIndexes(),
+			instances + i, std::min(instanceCount - i, static_cast<uint32_t>(MaxInstancesPerBatch)));
+	}
+}
+
 inline const Texture::Pointer& RenderPass::colorTarget(uint32_t index) const {
 	return _info.color[index].texture;
 }
@@ -151,11 +151,17 @@ inline uint32_t Texture::Description::dataOffsetForLayer(uint32_t layer, uint32_
 }
 
 inline uint32_t Texture::Description::dataSizeForMipLevel(uint32_t level) const {
-	uint32_t bpp = bitsPerPixelForTextureFormat(format) / 8;
+	uint32_t bitsPerPixel = bitsPerPixelForTextureFormat(format);
+	vec2i blockSize = compressedFormatBlockSize(format);
 
-	uint32_t actualSize = static_cast<uint32_t>(sizeForMipLevel(level).square()) * depth * bpp;
-	uint32_t minimumSize = static_cast<uint32_t>(Texture::minCompressedBlockHeight * Texture::minCompressedBlockWidth) * bpp;
-	uint32_t sz = isCompressedTextureFormat(format) ? std::max(static_cast<uint32_t>(Texture::minCompressedBlockDataSize),
+	// block compressed formats store partial blocks at the edges as full blocks
+	vec2i levelSize = sizeForMipLevel(level);
+	levelSize = blockSize * ((levelSize + blockSize - vec2i(1)) / blockSize);
+
+	uint32_t actualSize = static_cast<uint32_t>(levelSize.square()) * depth * bitsPerPixel / 8;
+	uint32_t minimumSize = static_cast<uint32_t>(Texture::minCompressedBlockHeight * Texture::minCompressedBlockWidth) * bitsPerPixel / 8;
+	bool variableBlockFormat = isCompressedTextureFormat(format) && (blockSize.x == 1);
+	uint32_t sz = variableBlockFormat ? std::max(static_cast<uint32_t>(Texture::minCompressedBlockDataSize),
 		std::max(minimumSize, actualSize)) : actualSize;
 
 	return sz * layerCount;
@@ -11,6 +11,90 @@
 
 namespace et {
 class RenderContext;
+
+/*
+ * Renderer without GPU: buffers are kept in system memory, programs are empty,
+ * render passes ignore everything. Used by headless applications to run
+ * update, culling, animation and loading code without display.
+ */
+class NullBuffer : public Buffer
+{
+public:
+	ET_DECLARE_POINTER(NullBuffer);
+
+public:
+	NullBuffer(const Buffer::Description& desc) :
+		_data(static_cast<size_t>(desc.size), 0) {
+		if (desc.initialData.size() > 0)
+			updateData(0, desc.initialData);
+	}
+
+	uint8_t* map(uint64_t begin, uint64_t) override {
+		_mapped = true;
+		return _data.data() + begin;
+	}
+
+	void modifyRange(uint64_t, uint64_t) override {}
+
+	void unmap() override {
+		_mapped = false;
+	}
+
+	bool mapped() const override {
+		return _mapped;
+	}
+
+	void updateData(uint64_t offset, const BinaryDataStorage& data) override {
+		ET_ASSERT(offset + data.size() <= _data.size());
+		memcpy(_data.data() + offset, data.data(), data.size());
+	}
+
+	void transferData(Buffer::Pointer destination, uint64_t srcOffset, uint64_t dstOffset, uint64_t size) override {
+		uint8_t* target = destination->map(dstOffset, size);
+		memcpy(target, _data.data() + srcOffset, static_cast<size_t>(size));
+		destination->unmap();
+	}
+
+	uint64_t size() const override {
+		return _data.size();
+	}
+
+private:
+	BinaryDataStorage _data;
+	bool _mapped = false;
+};
+
+class NullProgram : public Program
+{
+public:
+	ET_DECLARE_POINTER(NullProgram);
+
+public:
+	void build(uint32_t, const std::string&) override {}
+};
+
+class NullRenderPass : public RenderPass
+{
+public:
+	ET_DECLARE_POINTER(NullRenderPass);
+
+public:
+	NullRenderPass(RenderInterface* renderer, const ConstructionInfo& info) :
+		RenderPass(renderer, info) {
+	}
+
+	void pushRenderBatch(const MaterialInstance::Pointer&, const VertexStream::Pointer&, uint32_t, uint32_t) override {}
+	void pushInstancedRenderBatch(const MaterialInstance::Pointer&, const VertexStream::Pointer&, uint32_t, uint32_t,
+		const ObjectInstance*, uint32_t) override {}
+	void pushImageBarrier(const Texture::Pointer&, const ResourceBarrier&) override {}
+	void copyImage(const Texture::Pointer&, const Texture::Pointer&, const CopyDescriptor&) override {}
+	void copyImageToBuffer(const Texture::Pointer&, const Buffer::Pointer&, const CopyDescriptor&) override {}
+	void dispatchCompute(const Compute::Pointer&, const vec3i&) override {}
+	void endSubpass() override {}
+	void nextSubpass() override {}
+	void debug() override {}
+};
+
 class NullRenderer : public RenderInterface
 {
 public:
@@ -29,25 +113,48 @@ public:
 		return RenderingAPI::Null;
 	}
 
-	void init(const RenderContextParameters& params) override {}
+	void init(const RenderContextParameters& params) override {
+		_parameters = params;
+	}
 
 	void shutdown() override {}
 
 	void destroy() override {}
 
-	RendererFrame allocateFrame() override { return RendererFrame(); }
+	/*
+	 * Frames have non-zero identifiers, so render context does not skip them
+	 */
+	RendererFrame allocateFrame() override {
+		RendererFrame frame;
+		frame.continuousNumber = _framesCounter++;
+		frame.identifier = _framesCounter;
+		return frame;
+	}
+
 	void submitFrame(const RendererFrame&) override {}
 	void present() override {}
 
-	void resize(const vec2i&) override {}
+	void resize(const vec2i& size) override {
+		_contextSize = size;
+	}
+
+	vec2i contextSize() const override {
+		return _contextSize;
+	}
+
+	RenderPass::Pointer allocateRenderPass(const RenderPass::ConstructionInfo& info) override {
+		return NullRenderPass::Pointer::create(this, info);
+	}
 
-	RenderPass::Pointer allocateRenderPass(const RenderPass::ConstructionInfo&) override { return RenderPass::Pointer(); }
+	void beginRenderPass(const RenderPass::Pointer&, const RenderPassBeginInfo&) override {}
 	void submitRenderPass(const RenderPass::Pointer&) override {}
 
 	/*
 	 * Buffer
 	 */
-	Buffer::Pointer createBuffer(const std::string&, const Buffer::Description& desc) override { return Buffer::Pointer(); }
+	Buffer::Pointer createBuffer(const std::string&, const Buffer::Description& desc) override {
+		return NullBuffer::Pointer::create(desc);
+	}
 
 	/*
 	 * Textures
@@ -58,7 +165,9 @@ public:
 	/*
 	 * Programs
 	 */
-	Program::Pointer createProgram(uint32_t stages, const std::string& source) override { return Program::Pointer(); }
+	Program::Pointer createProgram(uint32_t, const std::string&) override {
+		return NullProgram::Pointer::create();
+	}
 
 	/*
 	 * Pipeline state
@@ -77,5 +186,9 @@ public:
 	 * Compute
 	 */
 	Compute::Pointer createCompute(const Material::Pointer&) override { return Compute::Pointer(); }
+
+private:
+	vec2i _contextSize = vec2i(0);
+	uint64_t _framesCounter = 0;
 };
 }
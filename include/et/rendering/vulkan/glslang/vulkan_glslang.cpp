@@ -301,6 +301,7 @@ void buildProgramReflection(const glslang::TProgram& program, Program::Reflectio
 {
 	static const String& kObjectVariables = "ObjectVariables";
 	static const String& kMaterialVariables = "MaterialVariables";
+	static const String& kInstanceVariables = "InstanceVariables";
 
 	int blocks = program.getNumLiveUniformBlocks();
 	for (int block = 0; block < blocks; ++block)
@@ -316,6 +317,10 @@ void buildProgramReflection(const glslang::TProgram& program, Program::Reflectio
 		{
 			reflection.materialVariablesBufferSize = blockSize;
 		}
+		else if (blockName == kInstanceVariables)
+		{
+			reflection.instanceVariablesBufferSize = blockSize;
+		}
 		else
 		{
 			log::error("Unknown uniform block: %s", blockName.c_str());
@@ -409,6 +414,10 @@ void buildProgramReflection(const glslang::TProgram& program, Program::Reflectio
 				reflection.materialVariables[static_cast<uint32_t>(varId)].offset = static_cast<uint32_t>(uniformOffset);
 				reflection.materialVariables[static_cast<uint32_t>(varId)].enabled = 1;
 			}
+			else if (blockName == kInstanceVariables)
+			{
+				// instance variables are uploaded as a whole array of ObjectInstance
+			}
 			else
 			{
 				log::error("Unknown uniform block: %s for uniform %s", blockName.c_str(), uniformName.c_str());
@@ -188,7 +188,7 @@ enum DescriptorSetClass : uint32_t
 	Images,
 
 	DescriptorSetClass_Count,
-	DynamicDescriptorsCount = 2
+	DynamicDescriptorsCount = 3
 };
 
 struct VulkanNativePipeline
@@ -34,7 +34,7 @@ public:
 			type(typ), controller(cap, Alignment)
 		{
 			uint64_t infoSize = controller.requiredInfoSize();
-			info =  sharedBlockAllocator().allocate(infoSize);
+			info = sharedBlockAllocator().allocate(infoSize, MemoryTag::Rendering);
 			controller.setInfoStorage(info);
 		}
 
@@ -18,6 +18,7 @@
 #include <et/rendering/vulkan/vulkan_renderer.h>
 #include <et/rendering/vulkan/vulkan.h>
 #include <et/rendering/vulkan/glslang/vulkan_glslang.h>
+#include <et/core/profiler.h>
 #include <et/app/application.h>
 
 namespace et {
@@ -423,6 +424,7 @@ void VulkanRenderer::submitFrame(const RendererFrame& frame) {
 }
 
 void VulkanRenderer::present() {
+	ET_PROFILE_SCOPE("VulkanRenderer::present");
 
 	VulkanRendererPrivate::FrameInternal::Pointer frameToExecute;
 	
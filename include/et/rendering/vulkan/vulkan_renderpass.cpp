@@ -10,6 +10,7 @@
 #include <et/rendering/vulkan/vulkan_renderpass.h>
 #include <et/rendering/vulkan/vulkan_textureset.h>
 #include <et/rendering/vulkan/vulkan.h>
+#include <et/core/profiler.h>
 
 namespace et {
 struct VulkanRenderSubpass
@@ -32,6 +33,23 @@ public:
 		uint32_t endQueryIndex = 0;
 	};
 
+	/*
+	 * Instance variables are bound with descriptor range of 1, 2, 4 ... MaxInstancesPerBatch instances,
+	 * so the range never exceeds the allocation, while small batches do not allocate whole batch
+	 */
+	enum : uint32_t
+	{
+		InstanceBatchClasses = 7
+	};
+	static_assert((1u << (InstanceBatchClasses - 1)) == MaxInstancesPerBatch, "Invalid instance batch classes count");
+
+	static uint32_t instanceBatchClass(uint32_t instanceCount) {
+		uint32_t result = 0;
+		while ((result + 1 < InstanceBatchClasses) && ((1u << result) < instanceCount))
+			++result;
+		return result;
+	}
+
 public:
 	VulkanRenderPassPrivate(VulkanState& v, VulkanRenderer* r)
 		: vulkan(v), renderer(r) {
@@ -48,6 +66,8 @@ public:
 	Vector<VulkanRenderSubpass> subpassSequence;
 	uint32_t currentSubpassIndex = InvalidIndex;
 	uint32_t subframeIndex = InvalidIndex;
+	const char* profilerName = nullptr;
+	VkDescriptorSet instanceDescriptorSets[InstanceBatchClasses] = { };
 
 	std::atomic_bool recording{ false };
 	std::atomic_bool renderPassStarted{ false };
@@ -72,6 +92,9 @@ VulkanRenderPass::VulkanRenderPass(VulkanRenderer* renderer, VulkanState& vulkan
 	ET_PIMPL_INIT(VulkanRenderPass, vulkan, renderer);
 
 	ET_ASSERT(!passInfo.name.empty());
+#if (ET_ENABLE_PROFILER)
+	_private->profilerName = profiler::intern("RenderPass: " + passInfo.name);
+#endif
 
 	for (uint32_t i = 0; i < RendererFrameCount; ++i)
 		_private->internals[i].usedObjects.reserve(65536);
@@ -194,7 +217,8 @@ VulkanRenderPass::~VulkanRenderPass() {
 		vkFreeCommandBuffers(_private->vulkan.device, _private->vulkan.graphicsCommandPool, 1, &_private->internals[i].commandBuffer);
 		vkDestroySemaphore(_private->vulkan.device, _private->internals[i].semaphore, nullptr);
 	}
-	vkFreeDescriptorSets(_private->vulkan.device, _private->vulkan.descriptorPool, 1, &_private->dynamicDescriptorSet);
+	vkFreeDescriptorSets(_private->vulkan.device, _private->vulkan.descriptorPool,
+		VulkanRenderPassPrivate::InstanceBatchClasses, _private->instanceDescriptorSets);
 	vkDestroyDescriptorSetLayout(_private->vulkan.device, _private->dynamicDescriptorSetLayout, nullptr);
 	ET_PIMPL_FINALIZE(VulkanRenderPass);
 }
@@ -209,6 +233,7 @@ const VulkanNativeRenderPass::Content& VulkanRenderPass::nativeRenderPassContent
 
 void VulkanRenderPass::begin(const RendererFrame& frame, const RenderPassBeginInfo& beginInfo) {
 	ET_ASSERT(_private->recording == false);
+	ET_PROFILE_BEGIN(_private->profilerName);
 
 	_private->buildingFrame = frame;
 	_private->subpassSequence.clear();
@@ -367,7 +392,22 @@ void VulkanRenderPass::nextSubpass() {
 }
 
 void VulkanRenderPass::pushRenderBatch(const MaterialInstance::Pointer& inMaterial, const VertexStream::Pointer& vertexStream, uint32_t first, uint32_t count) {
+	pushRenderBatchInternal(inMaterial, vertexStream, first, count, nullptr, 1);
+}
+
+void VulkanRenderPass::pushInstancedRenderBatch(const MaterialInstance::Pointer& inMaterial, const VertexStream::Pointer& vertexStream,
+	uint32_t first, uint32_t count, const ObjectInstance* instances, uint32_t instanceCount) {
+	ET_ASSERT(instances != nullptr);
+	ET_ASSERT(instanceCount <= MaxInstancesPerBatch);
+
+	if (instanceCount > 0)
+		pushRenderBatchInternal(inMaterial, vertexStream, first, count, instances, instanceCount);
+}
+
+void VulkanRenderPass::pushRenderBatchInternal(const MaterialInstance::Pointer& inMaterial, const VertexStream::Pointer& vertexStream,
+	uint32_t first, uint32_t count, const ObjectInstance* instances, uint32_t instanceCount) {
 	ET_ASSERT(_private->recording);
+	ET_PROFILE_SCOPE("RenderPass::pushRenderBatch");
 
 	VulkanPipelineState::Pointer pipelineState;
 	{
@@ -379,6 +419,23 @@ void VulkanRenderPass::pushRenderBatch(const MaterialInstance::Pointer& inMateri
 	if (pipelineState->nativePipeline().pipeline == nullptr)
 		return;
 
+	if ((instances != nullptr) && (pipelineState->program()->reflection().instanceVariablesBufferSize == 0))
+	{
+		/*
+		 * Program does not declare InstanceVariables buffer,
+		 * so each instance is drawn separately using object variables
+		 */
+		for (uint32_t i = 0; i < instanceCount; ++i)
+		{
+			setSharedVariable(ObjectVariable::WorldTransform, instances[i].worldTransform);
+			setSharedVariable(ObjectVariable::WorldRotationTransform, instances[i].worldRotationTransform);
+			setSharedVariable(ObjectVariable::PreviousWorldTransform, instances[i].previousWorldTransform);
+			setSharedVariable(ObjectVariable::PreviousWorldRotationTransform, instances[i].previousWorldRotationTransform);
+			pushRenderBatchInternal(inMaterial, vertexStream, first, count, nullptr, 1);
+		}
+		return;
+	}
+
 	bool hasVertexBuffer = vertexStream.valid() && vertexStream->vertexBuffer().valid();
 	bool hasIndexBuffer = vertexStream.valid() && vertexStream->indexBuffer().valid();
 
@@ -392,7 +449,7 @@ void VulkanRenderPass::pushRenderBatch(const MaterialInstance::Pointer& inMateri
 			material->setSampler(sh.first, sh.second.second);
 	}
 	Vector<Object::Pointer>& usedObjects = _private->currentContent().usedObjects;
-	usedObjects.reserve(usedObjects.size() + 6);
+	usedObjects.reserve(usedObjects.size() + 7);
 	usedObjects.emplace_back(pipelineState);
 
 	usedObjects.emplace_back(material->constantBufferData(info().name));
@@ -401,17 +458,21 @@ void VulkanRenderPass::pushRenderBatch(const MaterialInstance::Pointer& inMateri
 	usedObjects.emplace_back(buildObjectVariables(pipelineState->program()));
 	ConstantBufferEntry* objectVariables = static_cast<ConstantBufferEntry*>(usedObjects.back().pointer());
 
+	usedObjects.emplace_back(buildInstanceVariables(pipelineState->program(), instances, instanceCount));
+	ConstantBufferEntry* instanceVariables = static_cast<ConstantBufferEntry*>(usedObjects.back().pointer());
+
 	usedObjects.emplace_back(material->textureBindingsSet(info().name));
 	VulkanTextureSet* textureBindings = static_cast<VulkanTextureSet*>(usedObjects.back().pointer());
 	
 	VkDescriptorSet descriptorSets[DescriptorSetClass_Count] = {
-		_private->dynamicDescriptorSet,
+		_private->instanceDescriptorSets[VulkanRenderPassPrivate::instanceBatchClass(instanceCount)],
 	};
 	_private->fillDescriptorSetWithTextures(descriptorSets, textureBindings->nativeSet());
 
 	uint32_t dynamicOffsets[DescriptorSetClass::DynamicDescriptorsCount] = {
 		static_cast<uint32_t>(objectVariables != nullptr ? objectVariables->offset() : 0),
-		static_cast<uint32_t>(materialVariables != nullptr ? materialVariables->offset() : 0)
+		static_cast<uint32_t>(materialVariables != nullptr ? materialVariables->offset() : 0),
+		static_cast<uint32_t>(instanceVariables != nullptr ? instanceVariables->offset() : 0)
 	};
 
 	ET_ASSERT(_private->renderPassStarted);
@@ -438,11 +499,11 @@ void VulkanRenderPass::pushRenderBatch(const MaterialInstance::Pointer& inMateri
 
 		VkIndexType indexType = vulkan::indexBufferFormat(vertexStream->indexArrayFormat());
 		vkCmdBindIndexBuffer(commandBuffer, indexBuffer->nativeBuffer().buffer, 0, indexType);
-		vkCmdDrawIndexed(commandBuffer, count, 1, first, 0, 0);
+		vkCmdDrawIndexed(commandBuffer, count, instanceCount, first, 0, 0);
 	}
 	else
 	{
-		vkCmdDraw(commandBuffer, count, 1, first, 0);
+		vkCmdDraw(commandBuffer, count, instanceCount, first, 0);
 	}
 }
 
@@ -475,7 +536,8 @@ void VulkanRenderPass::dispatchCompute(const Compute::Pointer& compute, const ve
 
 	uint32_t dynamicOffsets[DescriptorSetClass::DynamicDescriptorsCount] = {
 		static_cast<uint32_t>(objectVariables.valid() ? objectVariables->offset() : 0),
-		static_cast<uint32_t>(materialVariables.valid() ? materialVariables->offset() : 0)
+		static_cast<uint32_t>(materialVariables.valid() ? materialVariables->offset() : 0),
+		0
 	};
 
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vulkanCompute->nativeCompute().pipeline);
@@ -585,6 +647,7 @@ void VulkanRenderPass::end(const RendererFrame& frame) {
 
 	_private->recording = false;
 	_private->currentContent().endTime = queryCurrentTimeInMicroSeconds();
+	ET_PROFILE_END(_private->profilerName);
 }
 
 void VulkanRenderPass::debug() {
@@ -611,6 +674,38 @@ ConstantBufferEntry::Pointer VulkanRenderPass::buildObjectVariables(const Vulkan
 	return result;
 }
 
+ConstantBufferEntry::Pointer VulkanRenderPass::buildInstanceVariables(const VulkanProgram::Pointer& program,
+	const ObjectInstance* instances, uint32_t instanceCount) {
+	ConstantBufferEntry::Pointer result;
+	uint32_t bufferSize = program->reflection().instanceVariablesBufferSize;
+	if (bufferSize > 0)
+	{
+		/*
+		 * Program declares space for the whole batch, but only instance batch class is allocated
+		 * (it matches descriptor range), shared constant buffer would be exhausted otherwise
+		 */
+		uint32_t batchClass = VulkanRenderPassPrivate::instanceBatchClass(instanceCount);
+		uint32_t batchSize = (1u << batchClass) * static_cast<uint32_t>(sizeof(ObjectInstance));
+		result = _private->renderer->sharedConstantBuffer().allocate(batchSize, ConstantBufferDynamicAllocation);
+
+		if (instances != nullptr)
+		{
+			ET_ASSERT(instanceCount * sizeof(ObjectInstance) <= std::min(bufferSize, batchSize));
+			memcpy(result->data(), instances, instanceCount * sizeof(ObjectInstance));
+		}
+		else
+		{
+			ObjectInstance* instance = reinterpret_cast<ObjectInstance*>(result->data());
+			*instance = ObjectInstance();
+			loadSharedVariable(ObjectVariable::WorldTransform, instance->worldTransform);
+			loadSharedVariable(ObjectVariable::WorldRotationTransform, instance->worldRotationTransform);
+			loadSharedVariable(ObjectVariable::PreviousWorldTransform, instance->previousWorldTransform);
+			loadSharedVariable(ObjectVariable::PreviousWorldRotationTransform, instance->previousWorldRotationTransform);
+		}
+	}
+	return result;
+}
+
 bool VulkanRenderPass::fillStatistics(uint64_t frameIndex, uint64_t* buffer, RenderPassStatistics& stat) {
 	uint32_t validBits = _private->vulkan.queues[VulkanQueueClass::Graphics].properties.timestampValidBits;
 
@@ -636,11 +731,13 @@ bool VulkanRenderPass::fillStatistics(uint64_t frameIndex, uint64_t* buffer, Ren
  * Private implementation
  */
 void VulkanRenderPassPrivate::generateDynamicDescriptorSet(RenderPass* pass) {
-	VkDescriptorSetLayoutBinding bindings[] = { {},{} };
+	VkDescriptorSetLayoutBinding bindings[] = { {},{},{} };
 	bindings[0] = { ObjectVariablesBufferIndex, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 };
 	bindings[0].stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT;
 	bindings[1] = { MaterialVariablesBufferIndex, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 };
 	bindings[1].stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[2] = { InstanceVariablesBufferIndex, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 };
+	bindings[2].stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
 
 	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
 	descriptorSetLayoutCreateInfo.bindingCount = sizeof(bindings) / sizeof(bindings[0]);
@@ -651,27 +748,46 @@ void VulkanRenderPassPrivate::generateDynamicDescriptorSet(RenderPass* pass) {
 	VkDescriptorBufferInfo objectBufferInfo = { cb->nativeBuffer().buffer, 0, sizeof(mat4) * ObjectVariable_max };
 	VkDescriptorBufferInfo materialBufferInfo = { cb->nativeBuffer().buffer, 0, sizeof(mat4) * MaterialVariable_max };
 
+	VkDescriptorSetLayout setLayouts[InstanceBatchClasses] = { };
+	for (VkDescriptorSetLayout& layout : setLayouts)
+		layout = dynamicDescriptorSetLayout;
+
 	VkDescriptorSetAllocateInfo descriptorAllocInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-	descriptorAllocInfo.pSetLayouts = &dynamicDescriptorSetLayout;
+	descriptorAllocInfo.pSetLayouts = setLayouts;
 	descriptorAllocInfo.descriptorPool = vulkan.descriptorPool;
-	descriptorAllocInfo.descriptorSetCount = 1;
-	VULKAN_CALL(vkAllocateDescriptorSets(vulkan.device, &descriptorAllocInfo, &dynamicDescriptorSet));
+	descriptorAllocInfo.descriptorSetCount = InstanceBatchClasses;
+	VULKAN_CALL(vkAllocateDescriptorSets(vulkan.device, &descriptorAllocInfo, instanceDescriptorSets));
+
+	// compute does not use instance variables, it is bound with the largest set
+	dynamicDescriptorSet = instanceDescriptorSets[InstanceBatchClasses - 1];
 
-	VkWriteDescriptorSet writeSets[] = { { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET } };
+	for (uint32_t batchClass = 0; batchClass < InstanceBatchClasses; ++batchClass)
 	{
+		VkDescriptorSet descriptorSet = instanceDescriptorSets[batchClass];
+		VkDescriptorBufferInfo instanceBufferInfo = { cb->nativeBuffer().buffer, 0, sizeof(ObjectInstance) * (1u << batchClass) };
+
+		VkWriteDescriptorSet writeSets[] = { { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
+			{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET } };
+
 		writeSets[0].descriptorCount = bindings[0].descriptorCount;
 		writeSets[0].descriptorType = bindings[0].descriptorType;
 		writeSets[0].dstBinding = bindings[0].binding;
 		writeSets[0].pBufferInfo = &objectBufferInfo;
-		writeSets[0].dstSet = dynamicDescriptorSet;
+		writeSets[0].dstSet = descriptorSet;
 		writeSets[1].descriptorCount = bindings[1].descriptorCount;
 		writeSets[1].descriptorType = bindings[1].descriptorType;
 		writeSets[1].dstBinding = bindings[1].binding;
 		writeSets[1].pBufferInfo = &materialBufferInfo;
-		writeSets[1].dstSet = dynamicDescriptorSet;
+		writeSets[1].dstSet = descriptorSet;
+		writeSets[2].descriptorCount = bindings[2].descriptorCount;
+		writeSets[2].descriptorType = bindings[2].descriptorType;
+		writeSets[2].dstBinding = bindings[2].binding;
+		writeSets[2].pBufferInfo = &instanceBufferInfo;
+		writeSets[2].dstSet = descriptorSet;
+
+		uint32_t writeSetsCount = static_cast<uint32_t>(sizeof(writeSets) / sizeof(writeSets[0]));
+		vkUpdateDescriptorSets(vulkan.device, writeSetsCount, writeSets, 0, nullptr);
 	}
-	uint32_t writeSetsCount = static_cast<uint32_t>(sizeof(writeSets) / sizeof(writeSets[0]));
-	vkUpdateDescriptorSets(vulkan.device, writeSetsCount, writeSets, 0, nullptr);
 }
 
 }
@@ -29,6 +29,8 @@ public:
 	const VulkanNativeRenderPass::Content& nativeRenderPassContent() const;
 
 	void pushRenderBatch(const MaterialInstance::Pointer&, const VertexStream::Pointer&, uint32_t, uint32_t) override;
+	void pushInstancedRenderBatch(const MaterialInstance::Pointer&, const VertexStream::Pointer&, uint32_t, uint32_t,
+		const ObjectInstance*, uint32_t) override;
 	void pushImageBarrier(const Texture::Pointer&, const ResourceBarrier&) override;
 	void copyImage(const Texture::Pointer&, const Texture::Pointer&, const CopyDescriptor&) override;
 	void copyImageToBuffer(const Texture::Pointer&, const Buffer::Pointer&, const CopyDescriptor&) override;
@@ -44,6 +46,9 @@ public:
 	
 private:
 	ConstantBufferEntry::Pointer VulkanRenderPass::buildObjectVariables(const VulkanProgram::Pointer&);
+	ConstantBufferEntry::Pointer buildInstanceVariables(const VulkanProgram::Pointer&, const ObjectInstance*, uint32_t);
+	void pushRenderBatchInternal(const MaterialInstance::Pointer&, const VertexStream::Pointer&, uint32_t, uint32_t,
+		const ObjectInstance*, uint32_t);
 
 private:
 	ET_DECLARE_PIMPL(VulkanRenderPass, 4096);
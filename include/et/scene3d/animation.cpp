@@ -6,11 +6,46 @@
  */
 
 #include <et/core/serialization.h>
+#include <et/geometry/vector4-simd.h>
 #include <et/scene3d/animation.h>
 
 using namespace et;
 using namespace et::s3d;
 
+namespace et
+{
+namespace s3d
+{
+inline vec4simd lerpSimd(const vec4simd& a, const vec4simd& b, float t)
+{
+	return a + (b - a) * t;
+}
+
+inline vec4simd slerpSimd(const vec4simd& from, vec4simd to, float t)
+{
+	const float epsilon = 0.0001f;
+
+	float cosom = from.dot(to);
+	if (cosom < 0.0f)
+	{
+		to = to * -1.0f;
+		cosom = -cosom;
+	}
+
+	float scale0 = 1.0f - t;
+	float scale1 = t;
+	if (1.0f - cosom > epsilon)
+	{
+		float omega = std::acos(cosom);
+		float sinom = 1.0f / std::sin(omega);
+		scale0 = std::sin(scale0 * omega) * sinom;
+		scale1 = std::sin(scale1 * omega) * sinom;
+	}
+	return from * scale0 + to * scale1;
+}
+}
+}
+
 Animation::Animation()
 {
 }
@@ -21,7 +56,14 @@ Animation::Animation(Dictionary)
 
 void Animation::addKeyFrame(float t, const vec3& tr, const quaternion& o, const vec3& s)
 {
-	_frames.emplace_back(t, tr, o, s);
+	// key frames are usually added in order, so it's a push_back in most cases
+	auto position = std::upper_bound(_times.begin(), _times.end(), t);
+	size_t index = static_cast<size_t>(position - _times.begin());
+
+	_times.insert(position, t);
+	_translations.insert(_translations.begin() + index, vec4(tr, 0.0f));
+	_orientations.insert(_orientations.begin() + index, vec4(o.scalar, o.vector.x, o.vector.y, o.vector.z));
+	_scales.insert(_scales.begin() + index, vec4(s, 0.0f));
 }
 
 void Animation::setTimeRange(float start, float stop)
@@ -36,19 +78,10 @@ void Animation::setFrameRate(float r)
 	_frameRate = r;
 }
 
-void Animation::transformation(float time, vec3& t, quaternion& o, vec3& s) const
+float Animation::normalizedTime(float time) const
 {
 	float d = duration();
 	
-	if (d == 0.0f)
-	{
-		auto mainTransform = _frames.front();
-		t = mainTransform.translation;
-		o = mainTransform.orientation;
-		s = mainTransform.scale;
-		return;
-	}
-	
 	switch (_outOfRangeMode)
 	{
 		case OutOfRangeMode_Loop:
@@ -69,46 +102,91 @@ void Animation::transformation(float time, vec3& t, quaternion& o, vec3& s) cons
 			break;
 	}
 	
-	time = clamp(time, _startTime, _stopTime);
-	
-	int nearestLowerFrame = static_cast<int32_t>(_frames.size()) - 1;
-	for (auto i = _frames.rbegin(), e = _frames.rend(); (i != e) && (nearestLowerFrame >= 0); ++i)
+	return clamp(time, _startTime, _stopTime);
+}
+
+uint32_t Animation::findKeyFrame(float time, uint32_t cursor) const
+{
+	uint32_t framesCount = keyFramesCount();
+
+	// time usually advances by less than one key frame between calls
+	if (cursor < framesCount && (_times[cursor] <= time))
 	{
-		if (i->time <= time) break;
-		--nearestLowerFrame;
+		if ((cursor + 1 >= framesCount) || (time < _times[cursor + 1]))
+			return cursor;
+
+		if ((cursor + 2 >= framesCount) || (time < _times[cursor + 2]))
+			return cursor + 1;
 	}
-	
-	if (static_cast<size_t>(nearestLowerFrame + 1) >= _frames.size())
+
+	auto upper = std::upper_bound(_times.begin(), _times.end(), time);
+	return (upper == _times.begin()) ? 0 : static_cast<uint32_t>(upper - _times.begin()) - 1;
+}
+
+void Animation::transformation(float time, vec3& t, quaternion& o, vec3& s, uint32_t& cursor) const
+{
+	ET_ASSERT(!_times.empty());
+
+	// animation without time range always uses the first key frame
+	bool interpolate = duration() > 0.0f;
+
+	uint32_t lower = 0;
+	if (interpolate)
 	{
-		const auto& frame = _frames.at(nearestLowerFrame);
-		t = frame.translation;
-		o = frame.orientation;
-		s = frame.scale;
+		time = normalizedTime(time);
+		lower = findKeyFrame(time, cursor);
 	}
-	else
+	cursor = lower;
+
+	vec4simd translation(_translations[lower]);
+	vec4simd orientation(_orientations[lower]);
+	vec4simd scale(_scales[lower]);
+
+	uint32_t upper = lower + 1;
+	if (interpolate && (upper < keyFramesCount()) && (time > _times[lower]))
 	{
-		const auto& lowerFrame = _frames.at(nearestLowerFrame);
-		const auto& upperFrame = _frames.at(nearestLowerFrame + 1);
-		float interolationFactor = (time - lowerFrame.time) / (upperFrame.time - lowerFrame.time);
-		t = mix(lowerFrame.translation, upperFrame.translation, interolationFactor);
-		o = slerp(lowerFrame.orientation, upperFrame.orientation, interolationFactor);
-		s = mix(lowerFrame.scale, upperFrame.scale, interolationFactor);
+		float interpolationFactor = (time - _times[lower]) / (_times[upper] - _times[lower]);
+		translation = lerpSimd(translation, vec4simd(_translations[upper]), interpolationFactor);
+		orientation = slerpSimd(orientation, vec4simd(_orientations[upper]), interpolationFactor);
+		scale = lerpSimd(scale, vec4simd(_scales[upper]), interpolationFactor);
 	}
+
+	ET_ALIGNED(16) float orientationData[4];
+	orientation.loadToFloats(orientationData);
+
+	t = translation.xyz();
+	o = quaternion(orientationData[0], orientationData[1], orientationData[2], orientationData[3]);
+	s = scale.xyz();
 }
 
-mat4 Animation::transformation(float time) const
+void Animation::transformation(float time, vec3& t, quaternion& o, vec3& s) const
+{
+	uint32_t cursor = 0;
+	transformation(time, t, o, s, cursor);
+}
+
+mat4 Animation::transformation(float time, uint32_t& cursor) const
 {
 	vec3 t(0.0f);
 	vec3 s(0.0f);
 	quaternion o;
 
-	transformation(time, t, o, s);
-	
-	ComponentTransformable result;
-	result.setTranslation(t);
-	result.setOrientation(o);
-	result.setScale(s);
-	return result.transform();
+	transformation(time, t, o, s, cursor);
+	return composeTransform(t, o, s);
+}
+
+mat4 Animation::transformation(float time) const
+{
+	uint32_t cursor = 0;
+	return transformation(time, cursor);
+}
+
+mat4 Animation::composeTransform(const vec3& t, const quaternion& o, const vec3& s)
+{
+	// same as ComponentTransformable::buildTransform
+	mat4 result = o.toMatrix() * scaleMatrix(s);
+	result[3] = vec4(t, 1.0f);
+	return result;
 }
 
 void Animation::setOutOfRangeMode(OutOfRangeMode mode)
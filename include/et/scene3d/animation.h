@@ -17,20 +17,6 @@ namespace s3d
 class Animation
 {
 public:
-	struct Frame
-	{
-		float time = 0.0f;
-		
-		vec3 translation;
-		quaternion orientation;
-		vec3 scale;
-		
-		Frame() { }
-		
-		Frame(float t, const vec3& tr, const quaternion& o, const vec3& s) :
-			time(t), translation(tr), orientation(o), scale(s) { }
-	};
-	
 	enum OutOfRangeMode
 	{
 		OutOfRangeMode_Loop,
@@ -47,6 +33,18 @@ public:
 	mat4 transformation(float) const;
 	
 	void transformation(float, vec3&, quaternion&, vec3&) const;
+
+	/*
+	 * cursor keeps index of the last used key frame between calls,
+	 * so sequential sampling finds key frame without search
+	 */
+	void transformation(float, vec3&, quaternion&, vec3&, uint32_t& cursor) const;
+	mat4 transformation(float, uint32_t& cursor) const;
+
+	uint32_t keyFramesCount() const
+		{ return static_cast<uint32_t>(_times.size()); }
+
+	static mat4 composeTransform(const vec3&, const quaternion&, const vec3&);
 				
 	void setTimeRange(float, float);
 	
@@ -67,7 +65,18 @@ public:
 		{ return _stopTime - _startTime; }
 	
 private:
-	Vector<Frame> _frames;
+	float normalizedTime(float) const;
+	uint32_t findKeyFrame(float, uint32_t cursor) const;
+
+private:
+	/*
+	 * Key frames are stored as separate tracks sorted by time,
+	 * orientations are stored as (scalar, x, y, z) to match quaternion layout
+	 */
+	Vector<float> _times;
+	Vector<vec4> _translations;
+	Vector<vec4> _orientations;
+	Vector<vec4> _scales;
 	
 	float _startTime = 0.0f;
 	float _stopTime = 0.0f;
@@ -12,10 +12,26 @@
 using namespace et;
 using namespace et::s3d;
 
+namespace
+{
+	std::atomic<uint64_t> sharedHierarchyVersion(0);
+}
+
+uint64_t BaseElement::hierarchyVersion()
+{
+	return sharedHierarchyVersion.load();
+}
+
+void BaseElement::incrementHierarchyVersion()
+{
+	++sharedHierarchyVersion;
+}
+
 BaseElement::BaseElement(const std::string& name, BaseElement* parent) :
 	ElementHierarchy(parent)
 {
 	setName(name);
+	incrementHierarchyVersion();
 	
 	_animationTimer.expired.connect([this](NotifyTimer* timer)
 	{
@@ -36,14 +52,30 @@ void BaseElement::setParent(BaseElement* p)
 {
 	invalidateTransform();
 	ElementHierarchy::setParent(p);
+	incrementHierarchyVersion();
+}
+
+void BaseElement::childRemoved(BaseElement*)
+{
+	incrementHierarchyVersion();
 }
 
 void BaseElement::invalidateTransform()
 {
 	ComponentTransformable::invalidateTransform();
 	
-	for (auto i : children())
-		i->invalidateTransform();
+	/*
+	 * Final transform of a child could be valid only if parent's one is valid,
+	 * so there is no need to walk children of already invalidated element
+	 */
+	if (_finalTransformValid)
+	{
+		_finalTransformValid = false;
+		_finalInverseTransformValid = false;
+
+		for (auto& i : children())
+			i->invalidateTransform();
+	}
 	
 	transformInvalidated();
 }
@@ -57,7 +89,8 @@ void BaseElement::buildTransform()
 		_cachedFinalTransform *= parent()->finalTransform();
 	}
 	
-	_cachedFinalInverseTransform = _cachedFinalTransform.inverted();
+	_finalTransformValid = true;
+	_finalInverseTransformValid = false;
 }
 
 const mat4& BaseElement::localTransform()
@@ -68,7 +101,7 @@ const mat4& BaseElement::localTransform()
 
 const mat4& BaseElement::finalTransform()
 {
-	if (!transformValid())
+	if (!_finalTransformValid)
 	{
 		buildTransform();
 	}
@@ -77,9 +110,11 @@ const mat4& BaseElement::finalTransform()
 
 const mat4& BaseElement::finalInverseTransform()
 {
-	if (!transformValid())
-		buildTransform();
-	
+	if (!_finalInverseTransformValid)
+	{
+		_cachedFinalInverseTransform = finalTransform().inverted();
+		_finalInverseTransformValid = true;
+	}
 	return _cachedFinalInverseTransform;
 }
 
@@ -161,6 +196,7 @@ void BaseElement::childrenHavingFlagCallback(size_t flag, BaseElement::List& lis
 void BaseElement::clear()
 {
 	removeChildren();
+	incrementHierarchyVersion();
 }
 
 void BaseElement::clearRecursively()
@@ -202,7 +238,8 @@ bool BaseElement::hasPropertyString(const std::string& s) const
 void BaseElement::addAnimation(const Animation& a)
 {
 	_animations.push_back(a);
-	_animationTransform = a.transformation(a.startTime());
+	_animationCursor = 0;
+	_animationTransform = a.transformation(a.startTime(), _animationCursor);
 }
 
 void BaseElement::removeAnimations()
@@ -270,10 +307,15 @@ const Animation& BaseElement::defaultAnimation() const
 
 void BaseElement::setAnimationTime(float t)
 {
-	_animationTransform = _animations.empty() ? identityMatrix : _animations.front().transformation(t);
+	sampleAnimation(t);
 	invalidateTransform();
 }
 
+void BaseElement::sampleAnimation(float t)
+{
+	_animationTransform = _animations.empty() ? identityMatrix : _animations.front().transformation(t, _animationCursor);
+}
+
 void BaseElement::setAnimationTimeRecursive(float a)
 {
 	setAnimationTime(a);
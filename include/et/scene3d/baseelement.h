@@ -19,6 +19,7 @@ namespace et
 {
 namespace s3d
 {
+class Scene;
 typedef Hierarchy<BaseElement, LoadableObject> ElementHierarchy;
 class BaseElement : public ElementHierarchy, public FlagsHolder, public ComponentTransformable
 {
@@ -40,6 +41,15 @@ public:
 	void setAnimationTime(float);
 	void setAnimationTimeRecursive(float);
 
+	/*
+	 * Evaluates default animation without invalidating transforms,
+	 * safe to call for different elements concurrently (see Scene::sampleAll)
+	 */
+	void sampleAnimation(float);
+
+	bool hasAnimations() const
+		{ return !_animations.empty(); }
+
 	bool animating() const;
 	bool anyChildAnimating() const;
 	
@@ -76,6 +86,12 @@ public:
 		{ _properites.insert(s); }
 	
 	bool hasPropertyString(const std::string& s) const;
+
+	/*
+	 * Incremented on every change of any elements hierarchy,
+	 * used to invalidate flattened representations of the scene
+	 */
+	static uint64_t hierarchyVersion();
 	
 	void addAnimation(const Animation&);
 	
@@ -83,6 +99,7 @@ public:
 
 protected:
 	virtual void transformInvalidated() { }
+	void childRemoved(BaseElement*) override;
 
 	void duplicateChildrenToObject(BaseElement* object);
 	void duplicateBasePropertiesToObject(BaseElement* object);
@@ -94,6 +111,10 @@ private:
 	
 	void buildTransform();
 
+	static void incrementHierarchyVersion();
+
+	friend class Scene;
+
 private:
 	Animation _emptyAnimation;
 	NotifyTimer _animationTimer;
@@ -102,9 +123,12 @@ private:
 	Vector<Animation> _animations;
 	
 	mat4 _animationTransform = mat4(1.0f);
+	uint32_t _animationCursor = 0;
 	mat4 _cachedLocalTransform = mat4(1.0f);
 	mat4 _cachedFinalTransform = mat4(1.0f);
 	mat4 _cachedFinalInverseTransform = mat4(1.0f);
+	bool _finalTransformValid = false;
+	bool _finalInverseTransformValid = false;
 };
 }
 }
@@ -12,6 +12,7 @@
 #include <et/imaging/pngloader.h>
 #include <et/imaging/imagewriter.h>
 #include <et/app/application.h>
+#include <et/core/profiler.h>
 
 #define ET_ANIMATE_LIGHT_POSITION 0
 
@@ -93,6 +94,8 @@ Drawer::Drawer(RenderInterface::Pointer& renderer) :
 }
 
 void Drawer::updateVisibleMeshes() {
+	_scene->updateTransforms();
+
 	_visibleMeshes.clear();
 	_visibleMeshes.reserve(_allMeshes.size());
 	for (Mesh::Pointer& mesh : _allMeshes)
@@ -104,14 +107,60 @@ void Drawer::updateVisibleMeshes() {
 	}
 }
 
+void Drawer::buildInstancedBatches() {
+	for (uint32_t i = 0; i < _activeInstancedBatches; ++i)
+	{
+		_instancedBatches[i].batch.reset(nullptr);
+		_instancedBatches[i].instances.clear();
+	}
+	_instancedBatchIndices.clear();
+	_activeInstancedBatches = 0;
+
+	for (Mesh::Pointer& mesh : _visibleMeshes)
+	{
+		std::pair<mat4, mat4>& previousTransforms = _previousFrameTransforms[mesh];
+
+		ObjectInstance instance;
+		instance.worldTransform = mesh->transform();
+		instance.worldRotationTransform = mesh->rotationTransform();
+		instance.previousWorldTransform = previousTransforms.first;
+		instance.previousWorldRotationTransform = previousTransforms.second;
+
+		for (const RenderBatch::Pointer& rb : mesh->renderBatches())
+		{
+			InstancedBatchKey key(rb->vertexStream().pointer(), rb->material().pointer(), rb->firstIndex(), rb->numIndexes());
+			auto i = _instancedBatchIndices.find(key);
+			if (i == _instancedBatchIndices.end())
+			{
+				if (_activeInstancedBatches == _instancedBatches.size())
+					_instancedBatches.emplace_back();
+
+				i = _instancedBatchIndices.emplace(key, _activeInstancedBatches++).first;
+				_instancedBatches[i->second].batch = rb;
+			}
+			_instancedBatches[i->second].instances.emplace_back(instance);
+		}
+
+		previousTransforms = std::make_pair(instance.worldTransform, instance.worldRotationTransform);
+	}
+}
+
 void Drawer::draw() {
+	ET_PROFILE_SCOPE("Drawer::draw");
+
 #if (ET_ANIMATE_LIGHT_POSITION)
 	_lighting.directional->lookAt(10.0f * fromSpherical(0.25f * queryContinuousTimeInSeconds(), DEG_15));
 	options.rebuldEnvironmentProbe = true;
 #endif
 
-	_cubemapProcessor->process(_renderer, options, _lighting.directional);
-	_shadowmapProcessor->process(_renderer, options);
+	{
+		ET_PROFILE_SCOPE("CubemapProcessor::process");
+		_cubemapProcessor->process(_renderer, options, _lighting.directional);
+	}
+	{
+		ET_PROFILE_SCOPE("ShadowmapProcessor::process");
+		_shadowmapProcessor->process(_renderer, options);
+	}
 
 	validate(_renderer);
 
@@ -128,18 +177,22 @@ void Drawer::draw() {
 	projectionMatrix[2].y = _jitter.y;
 	_scene->renderCamera()->setProjectionMatrix(projectionMatrix);
 
-	updateVisibleMeshes();
+	{
+		ET_PROFILE_SCOPE("Drawer::updateVisibleMeshes");
+		updateVisibleMeshes();
+		buildInstancedBatches();
+	}
+	ET_PROFILE_COUNTER("Instanced batches", _activeInstancedBatches);
 
 	_renderer->beginRenderPass(_main.zPrepass, RenderPassBeginInfo::singlePass());
 	{
 		_main.zPrepass->setSharedVariable(ObjectVariable::CameraJitter, _jitter);
 		_main.zPrepass->loadSharedVariablesFromCamera(_scene->renderCamera());
 		_main.zPrepass->nextSubpass();
-		for (Mesh::Pointer& mesh : _visibleMeshes)
+		for (uint32_t i = 0; i < _activeInstancedBatches; ++i)
 		{
-			_main.zPrepass->setSharedVariable(ObjectVariable::WorldTransform, mesh->transform());
-			for (const RenderBatch::Pointer& rb : mesh->renderBatches())
-				_main.zPrepass->pushRenderBatch(rb);
+			const InstancedBatch& ib = _instancedBatches[i];
+			_main.zPrepass->pushInstancedRenderBatch(ib.batch, ib.instances.data(), static_cast<uint32_t>(ib.instances.size()));
 		}
 		_main.zPrepass->endSubpass();
 		_main.zPrepass->pushImageBarrier(_main.zPrepass->info().depth.texture, ResourceBarrier(TextureState::ShaderResource));
@@ -179,17 +232,10 @@ void Drawer::draw() {
 		_main.forward->setSharedVariable(ObjectVariable::EnvironmentSphericalHarmonics, _cubemapProcessor->environmentSphericalHarmonics(), 9);
 		_main.forward->setSharedVariable(ObjectVariable::CameraJitter, _jitter);
 		_main.forward->nextSubpass();
-		for (Mesh::Pointer& mesh : _visibleMeshes)
+		for (uint32_t i = 0; i < _activeInstancedBatches; ++i)
 		{
-			_main.forward->setSharedVariable(ObjectVariable::WorldTransform, mesh->transform());
-			_main.forward->setSharedVariable(ObjectVariable::WorldRotationTransform, mesh->rotationTransform());
-			_main.forward->setSharedVariable(ObjectVariable::PreviousWorldTransform, _previousFrameTransforms[mesh].first);
-			_main.forward->setSharedVariable(ObjectVariable::PreviousWorldRotationTransform, _previousFrameTransforms[mesh].second);
-
-			for (const RenderBatch::Pointer& rb : mesh->renderBatches())
-				_main.forward->pushRenderBatch(rb);
-
-			_previousFrameTransforms[mesh] = std::make_pair(mesh->transform(), mesh->rotationTransform());
+			const InstancedBatch& ib = _instancedBatches[i];
+			_main.forward->pushInstancedRenderBatch(ib.batch, ib.instances.data(), static_cast<uint32_t>(ib.instances.size()));
 		}
 		_main.forward->setSharedVariable(ObjectVariable::WorldTransform, identityMatrix);
 		_main.forward->pushRenderBatch(_lighting.environmentBatch);
@@ -289,44 +335,40 @@ void Drawer::setRenderTarget(const Texture::Pointer& tex) {
 
 void Drawer::setScene(const Scene::Pointer& inScene) {
 	_scene = inScene;
-	BaseElement::List elements = _scene->childrenOfType(ElementType::DontCare);
+	const Vector<BaseElement*>& meshes = _scene->elementsOfType(ElementType::Mesh);
 
 	_allMeshes.clear();
-	_allMeshes.reserve(elements.size());
+	_allMeshes.reserve(meshes.size());
+	for (BaseElement* element : meshes)
+		_allMeshes.emplace_back(static_cast<Mesh*>(element));
+
 	_lighting.directional.reset(nullptr);
 
 	bool updateEnvironment = false;
 
-	for (const BaseElement::Pointer& element : elements)
+	for (BaseElement* element : _scene->elementsOfType(ElementType::Light))
 	{
-		if (element->type() == ElementType::Mesh)
+		Light::Pointer light = static_cast<LightElement*>(element)->light();
+		switch (light->type())
+		{
+		case Light::Type::Directional:
 		{
-			_allMeshes.emplace_back(element);
+			_lighting.directional = light;
+			break;
 		}
-		else if (element->type() == ElementType::Light)
+		case Light::Type::ImageBasedEnvironment:
 		{
-			Light::Pointer light = LightElement::Pointer(element)->light();
-			switch (light->type())
-			{
-			case Light::Type::Directional:
-			{
-				_lighting.directional = light;
-				break;
-			}
-			case Light::Type::ImageBasedEnvironment:
-			{
-				updateEnvironment = (_lighting.environmentTextureFile != light->environmentMap());
-				_lighting.environmentTextureFile = light->environmentMap();
-				break;
-			}
-			case Light::Type::UniformColorEnvironment:
-			{
-				_lighting.environmentTextureFile.clear();
-				break;
-			}
-			default:
-				ET_FAIL_FMT("Unsupported light type: %u", static_cast<uint32_t>(light->type()));
-			}
+			updateEnvironment = (_lighting.environmentTextureFile != light->environmentMap());
+			_lighting.environmentTextureFile = light->environmentMap();
+			break;
+		}
+		case Light::Type::UniformColorEnvironment:
+		{
+			_lighting.environmentTextureFile.clear();
+			break;
+		}
+		default:
+			ET_FAIL_FMT("Unsupported light type: %u", static_cast<uint32_t>(light->type()));
 		}
 	}
 
@@ -45,8 +45,16 @@ public:
 
 private:
 	void updateVisibleMeshes();
+	void buildInstancedBatches();
 	void validate(RenderInterface::Pointer&);
 
+	struct InstancedBatch
+	{
+		RenderBatch::Pointer batch;
+		Vector<ObjectInstance> instances;
+	};
+	using InstancedBatchKey = std::tuple<const VertexStream*, const MaterialInstance*, uint32_t, uint32_t>;
+
 private:
 	ObjectsCache _cache;
 
@@ -54,6 +62,9 @@ private:
 	Vector<Mesh::Pointer> _allMeshes;
 	Vector<Mesh::Pointer> _visibleMeshes;
 	Map<Mesh::Pointer, std::pair<mat4, mat4>> _previousFrameTransforms;
+	Map<InstancedBatchKey, uint32_t> _instancedBatchIndices;
+	Vector<InstancedBatch> _instancedBatches;
+	uint32_t _activeInstancedBatches = 0;
 
 	RenderInterface::Pointer _renderer;
 	DebugDrawer::Pointer _debugDrawer;
@@ -16,18 +16,19 @@ void ShadowmapProcessor::setScene(const Scene::Pointer& scene, Light::Pointer& l
 {
 	_scene = scene;
 
-	Vector<BaseElement::Pointer> meshes = _scene->childrenOfType(s3d::ElementType::Mesh);
+	const Vector<BaseElement*>& meshes = _scene->elementsOfType(s3d::ElementType::Mesh);
 
 	_renderables.meshes.clear();
 	_renderables.meshes.reserve(meshes.size());
 
 	vec3 minVertex(std::numeric_limits<float>::max());
 	vec3 maxVertex = -minVertex;
-	for (Mesh::Pointer mesh : meshes)
+	for (BaseElement* element : meshes)
 	{
+		Mesh* mesh = static_cast<Mesh*>(element);
 		minVertex = minv(minVertex, mesh->tranformedBoundingBox().minVertex());
 		maxVertex = maxv(maxVertex, mesh->tranformedBoundingBox().maxVertex());
-		_renderables.meshes.emplace_back(mesh);
+		_renderables.meshes.emplace_back(Mesh::Pointer(mesh));
 	}
 	_sceneBoundingBox = BoundingBox(0.5f * (maxVertex + minVertex), 0.5f * (maxVertex - minVertex));
 	updateLight(light);
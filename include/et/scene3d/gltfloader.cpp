@@ -5,38 +5,1391 @@
  *
  */
 
-#include <et/scene3d/gltfloader.h>
 #include <et/core/json.h>
+#include <et/core/base64.h>
+#include <et/core/mappedfile.h>
+#include <et/core/parallel.h>
+#include <et/core/profiler.h>
+#include <et/imaging/jpegloader.h>
+#include <et/imaging/pngloader.h>
+#include <et/imaging/textureloader.h>
+#include <et/rendering/base/primitives.h>
+#include <et/scene3d/gltfloader.h>
 
 namespace et {
 
-class GLTFLoaderPrivate
+namespace gltf {
+
+enum : uint32_t
 {
-public:
-	std::string inputFileName;
-	Dictionary data;
+	GLBMagic = 0x46546C67,
+	GLBVersion = 2,
+	GLBChunkJSON = 0x4E4F534A,
+	GLBChunkBIN = 0x004E4942,
+	GLBHeaderSize = 12,
+	GLBChunkHeaderSize = 8,
 };
 
-GLTFLoader::GLTFLoader(const std::string& fileName) {
-	ET_PIMPL_INIT(GLTFLoader);
+enum ComponentType : uint32_t
+{
+	ComponentType_Byte = 5120,
+	ComponentType_UnsignedByte = 5121,
+	ComponentType_Short = 5122,
+	ComponentType_UnsignedShort = 5123,
+	ComponentType_UnsignedInt = 5125,
+	ComponentType_Float = 5126,
+};
+
+enum : uint32_t
+{
+	PrimitiveMode_Triangles = 4,
+};
+
+uint32_t componentSize(uint32_t componentType) {
+	switch (componentType) {
+	case ComponentType_Byte:
+	case ComponentType_UnsignedByte:
+		return 1;
+	case ComponentType_Short:
+	case ComponentType_UnsignedShort:
+		return 2;
+	case ComponentType_UnsignedInt:
+	case ComponentType_Float:
+		return 4;
+	default:
+		return 0;
+	}
 }
 
-GLTFLoader::~GLTFLoader() {
-	ET_PIMPL_FINALIZE(GLTFLoader);
+uint32_t componentsCount(const std::string& type) {
+	if (type == "SCALAR")
+		return 1;
+	if (type == "VEC2")
+		return 2;
+	if (type == "VEC3")
+		return 3;
+	if ((type == "VEC4") || (type == "MAT2"))
+		return 4;
+	if (type == "MAT3")
+		return 9;
+	if (type == "MAT4")
+		return 16;
+	return 0;
+}
+
+float readComponent(const uint8_t* ptr, uint32_t componentType, bool normalized) {
+	switch (componentType) {
+	case ComponentType_Byte: {
+		float value = static_cast<float>(*reinterpret_cast<const int8_t*>(ptr));
+		return normalized ? std::max(value / 127.0f, -1.0f) : value;
+	}
+	case ComponentType_UnsignedByte: {
+		float value = static_cast<float>(*ptr);
+		return normalized ? value / 255.0f : value;
+	}
+	case ComponentType_Short: {
+		int16_t raw = 0;
+		etCopyMemory(&raw, ptr, sizeof(raw));
+		float value = static_cast<float>(raw);
+		return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+	}
+	case ComponentType_UnsignedShort: {
+		uint16_t raw = 0;
+		etCopyMemory(&raw, ptr, sizeof(raw));
+		float value = static_cast<float>(raw);
+		return normalized ? value / 65535.0f : value;
+	}
+	case ComponentType_UnsignedInt: {
+		uint32_t raw = 0;
+		etCopyMemory(&raw, ptr, sizeof(raw));
+		return static_cast<float>(raw);
+	}
+	case ComponentType_Float: {
+		float value = 0.0f;
+		etCopyMemory(&value, ptr, sizeof(value));
+		return value;
+	}
+	default:
+		return 0.0f;
+	}
+}
+
+uint32_t readInteger(const uint8_t* ptr, uint32_t componentType) {
+	switch (componentType) {
+	case ComponentType_UnsignedByte:
+		return *ptr;
+	case ComponentType_UnsignedShort: {
+		uint16_t value = 0;
+		etCopyMemory(&value, ptr, sizeof(value));
+		return value;
+	}
+	case ComponentType_UnsignedInt: {
+		uint32_t value = 0;
+		etCopyMemory(&value, ptr, sizeof(value));
+		return value;
+	}
+	default:
+		return static_cast<uint32_t>(readComponent(ptr, componentType, false));
+	}
+}
+
+/*
+ * JSON helpers, numbers could be stored either as integer or as float values
+ */
+float numberValue(const VariantBase::Pointer& value, float defaultValue) {
+	if (value.invalid())
+		return defaultValue;
+
+	if (value->variantClass() == VariantClass::Float)
+		return FloatValue(value)->content;
+
+	if (value->variantClass() == VariantClass::Integer)
+		return static_cast<float>(IntegerValue(value)->content);
+
+	return defaultValue;
+}
+
+float floatForKey(const Dictionary& dict, const std::string& key, float defaultValue) {
+	return dict.hasKey(key) ? numberValue(dict.objectForKey(key), defaultValue) : defaultValue;
+}
+
+uint64_t sizeForKey(const Dictionary& dict, const std::string& key) {
+	if (!dict.hasKey(key) || (dict.VariantClassForKey(key) != VariantClass::Integer))
+		return 0;
+	return static_cast<uint64_t>(std::max(int64_t(0), dict.integerForKey(key)->content));
+}
+
+int32_t indexForKey(const Dictionary& dict, const std::string& key) {
+	if (!dict.hasKey(key) || (dict.VariantClassForKey(key) != VariantClass::Integer))
+		return -1;
+	return static_cast<int32_t>(dict.integerForKey(key)->content);
+}
+
+uint32_t readFloats(const Dictionary& dict, const std::string& key, float* values, uint32_t maxCount) {
+	if (!dict.hasKey(key) || (dict.VariantClassForKey(key) != VariantClass::Array))
+		return 0;
+
+	const ArrayValue array = dict.arrayForKey(key);
+	uint32_t count = std::min(maxCount, static_cast<uint32_t>(array->content.size()));
+	for (uint32_t i = 0; i < count; ++i)
+		values[i] = numberValue(array->content[i], values[i]);
+	return count;
+}
+
+Vector<Dictionary> dictionaries(const Dictionary& dict, const std::string& key) {
+	Vector<Dictionary> result;
+	if (dict.hasKey(key) && (dict.VariantClassForKey(key) == VariantClass::Array)) {
+		const ArrayValue array = dict.arrayForKey(key);
+		result.reserve(array->content.size());
+		for (const VariantBase::Pointer& value : array->content) {
+			if (value.valid() && (value->variantClass() == VariantClass::Dictionary))
+				result.emplace_back(value);
+			else
+				result.emplace_back();
+		}
+	}
+	return result;
+}
+
+Vector<int32_t> indices(const Dictionary& dict, const std::string& key) {
+	Vector<int32_t> result;
+	if (dict.hasKey(key) && (dict.VariantClassForKey(key) == VariantClass::Array)) {
+		const ArrayValue array = dict.arrayForKey(key);
+		result.reserve(array->content.size());
+		for (const VariantBase::Pointer& value : array->content)
+			result.emplace_back(static_cast<int32_t>(numberValue(value, -1.0f)));
+	}
+	return result;
 }
 
-s3d::ElementContainer::Pointer GLTFLoader::load(RenderInterface::Pointer, s3d::Storage&, ObjectsCache&) {
-	s3d::ElementContainer::Pointer result(PointerInit::CreateInplace);
+std::string decodeURI(const std::string& uri) {
+	std::string result;
+	result.reserve(uri.size());
+	for (size_t i = 0; i < uri.size(); ++i) {
+		if ((uri[i] == '%') && (i + 2 < uri.size())) {
+			result.push_back(static_cast<char>(strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16)));
+			i += 2;
+		}
+		else {
+			result.push_back(uri[i]);
+		}
+	}
+	return result;
+}
+
+bool isDataURI(const std::string& uri) {
+	return uri.compare(0, 5, "data:") == 0;
+}
+
+BinaryDataStorage decodeDataURI(const std::string& uri) {
+	size_t dataStart = uri.find(";base64,");
+	if (dataStart == std::string::npos)
+		return BinaryDataStorage();
+	return base64::decode(uri.substr(dataStart + 8));
+}
+
+/*
+ * glTF quaternions are [x, y, z, w] and act on column vectors,
+ * engine transforms act on row vectors, so rotation is conjugated
+ */
+quaternion orientationFromArray(const float* q) {
+	return quaternion(q[3], -q[0], -q[1], -q[2]);
+}
+
+/*
+ * Loaded data
+ */
+struct DataBuffer
+{
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+	std::unique_ptr<MappedFile> mapping;
+	BinaryDataStorage decoded;
+};
+
+struct BufferView
+{
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+	uint32_t stride = 0;
+};
+
+struct Accessor
+{
+	const uint8_t* data = nullptr;
+	uint32_t count = 0;
+	uint32_t componentType = 0;
+	uint32_t components = 0;
+	uint32_t stride = 0;
+	bool normalized = false;
+
+	bool valid() const {
+		return data != nullptr;
+	}
+
+	uint32_t elementSize() const {
+		return components * componentSize(componentType);
+	}
+
+	const uint8_t* element(uint32_t i) const {
+		return data + static_cast<size_t>(i) * stride;
+	}
+};
+
+struct Image
+{
+	std::string fileName;
+	std::string mimeType;
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+	BinaryDataStorage decoded;
+	TextureDescription::Pointer description;
+	TextureLoadRequest::Pointer request;
+	Texture::Pointer texture;
+	bool used = false;
+};
+
+enum : uint32_t
+{
+	Attribute_Position,
+	Attribute_Normal,
+	Attribute_Tangent,
+	Attribute_TexCoord0,
+	Attribute_TexCoord1,
+	Attribute_Color,
+	Attribute_Joints,
+	Attribute_Weights,
+
+	Attribute_max
+};
+
+struct AttributeInfo
+{
+	const char* name;
+	VertexAttributeUsage usage;
+	DataType type;
+	uint32_t components;
+};
+
+const AttributeInfo attributeInfos[Attribute_max] = {
+	{ "POSITION", VertexAttributeUsage::Position, DataType::Vec3, 3 },
+	{ "NORMAL", VertexAttributeUsage::Normal, DataType::Vec3, 3 },
+	{ "TANGENT", VertexAttributeUsage::Tangent, DataType::Vec4, 4 },
+	{ "TEXCOORD_0", VertexAttributeUsage::TexCoord0, DataType::Vec2, 2 },
+	{ "TEXCOORD_1", VertexAttributeUsage::TexCoord1, DataType::Vec2, 2 },
+	{ "COLOR_0", VertexAttributeUsage::Color, DataType::Vec4, 4 },
+	{ "JOINTS_0", VertexAttributeUsage::BlendIndices, DataType::IntVec4, 4 },
+	{ "WEIGHTS_0", VertexAttributeUsage::BlendWeights, DataType::Vec4, 4 },
+};
+
+struct Primitive
+{
+	Accessor attributes[Attribute_max];
+	Accessor indices;
+	int32_t material = -1;
+	uint32_t group = 0;
+	uint32_t firstVertex = 0;
+	uint32_t vertexCount = 0;
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+};
+
+struct VertexGroup
+{
+	uint32_t attributesMask = 0;
+	uint32_t vertexCount = 0;
+	VertexStorage::Pointer storage;
+	VertexStream::Pointer stream;
+};
+
+struct NodeTransform
+{
+	vec3 translation = vec3(0.0f);
+	quaternion orientation;
+	vec3 scale = vec3(1.0f);
+};
+
+/*
+ * Vertex data copy into interleaved storage: float elements with matching
+ * component count are copied as is, other component types are converted
+ */
+void copyAttribute(const Accessor& accessor, uint8_t* target, uint32_t targetStride, uint32_t targetComponents) {
+	if ((accessor.componentType == ComponentType_Float) && (accessor.components == targetComponents)) {
+		uint32_t elementSize = accessor.elementSize();
+		for (uint32_t i = 0; i < accessor.count; ++i)
+			etCopyMemory(target + static_cast<size_t>(i) * targetStride, accessor.element(i), elementSize);
+		return;
+	}
+
+	uint32_t componentBytes = componentSize(accessor.componentType);
+	uint32_t copyComponents = std::min(accessor.components, targetComponents);
+	for (uint32_t i = 0; i < accessor.count; ++i) {
+		const uint8_t* input = accessor.element(i);
+		float* output = reinterpret_cast<float*>(target + static_cast<size_t>(i) * targetStride);
+		for (uint32_t c = 0; c < copyComponents; ++c)
+			output[c] = readComponent(input + c * componentBytes, accessor.componentType, accessor.normalized);
+		for (uint32_t c = copyComponents; c < targetComponents; ++c)
+			output[c] = (c == 3) ? 1.0f : 0.0f;
+	}
+}
+
+void copyIntegerAttribute(const Accessor& accessor, uint8_t* target, uint32_t targetStride, uint32_t targetComponents) {
+	uint32_t componentBytes = componentSize(accessor.componentType);
+	uint32_t copyComponents = std::min(accessor.components, targetComponents);
+	for (uint32_t i = 0; i < accessor.count; ++i) {
+		const uint8_t* input = accessor.element(i);
+		int32_t* output = reinterpret_cast<int32_t*>(target + static_cast<size_t>(i) * targetStride);
+		for (uint32_t c = 0; c < copyComponents; ++c)
+			output[c] = static_cast<int32_t>(readInteger(input + c * componentBytes, accessor.componentType));
+		for (uint32_t c = copyComponents; c < targetComponents; ++c)
+			output[c] = 0;
+	}
+}
+
+/*
+ * Indices are used to address vertices of the primitive (normals generation, skinning),
+ * so all of them are validated before the primitive is accepted
+ */
+bool indicesInRange(const Accessor& indices, uint32_t vertexCount) {
+	for (uint32_t i = 0; i < indices.count; ++i) {
+		if (readInteger(indices.element(i), indices.componentType) >= vertexCount)
+			return false;
+	}
+	return true;
+}
+
+template <typename T>
+void copyIndices(const Primitive& primitive, T* output) {
+	const Accessor& indices = primitive.indices;
+	if (!indices.valid()) {
+		for (uint32_t i = 0; i < primitive.indexCount; ++i)
+			output[i] = static_cast<T>(i);
+		return;
+	}
+
+	// indices are stored relative to the group storage, so direct copy is only possible for the first primitive
+	if ((primitive.firstVertex == 0) && (indices.componentType == ComponentType_UnsignedShort) && (sizeof(T) == 2) &&
+		(indices.stride == 2)) {
+		etCopyMemory(output, indices.data, primitive.indexCount * sizeof(T));
+		return;
+	}
+
+	for (uint32_t i = 0; i < primitive.indexCount; ++i)
+		output[i] = static_cast<T>(primitive.firstVertex + readInteger(indices.element(i), indices.componentType));
+}
+
+/*
+ * Keyframe sampling for animations
+ */
+struct AnimationTrack
+{
+	Accessor input;
+	Accessor output;
+	bool step = false;
+	bool cubicSpline = false;
+	bool rotation = false;
+};
+
+/*
+ * Cubic spline keys are stored as (in-tangent, value, out-tangent) triplets
+ */
+enum CubicSplineElement : uint32_t
+{
+	CubicSpline_InTangent,
+	CubicSpline_Value,
+	CubicSpline_OutTangent,
+	CubicSpline_ElementsPerKey
+};
+
+void sampleTrack(const AnimationTrack& track, float time, float* value, uint32_t components) {
+	uint32_t keysCount = track.input.count;
+	uint32_t valuesPerKey = track.cubicSpline ? static_cast<uint32_t>(CubicSpline_ElementsPerKey) : 1u;
+	uint32_t componentBytes = componentSize(track.output.componentType);
+
+	auto keyTime = [&track](uint32_t key) {
+		return readComponent(track.input.element(key), track.input.componentType, false);
+	};
+
+	auto keyElement = [&](uint32_t key, uint32_t element, float* out) {
+		const uint8_t* ptr = track.output.element(key * valuesPerKey + element);
+		for (uint32_t c = 0; c < components; ++c)
+			out[c] = readComponent(ptr + c * componentBytes, track.output.componentType, track.output.normalized);
+	};
+
+	auto keyValue = [&](uint32_t key, float* out) {
+		keyElement(key, track.cubicSpline ? static_cast<uint32_t>(CubicSpline_Value) : 0u, out);
+	};
+
+	// binary search for the last key with time <= requested time
+	uint32_t low = 0;
+	uint32_t high = keysCount;
+	while (low + 1 < high) {
+		uint32_t middle = (low + high) / 2;
+		if (keyTime(middle) <= time)
+			low = middle;
+		else
+			high = middle;
+	}
+
+	float t0 = keyTime(low);
+	if (track.step || (low + 1 >= keysCount) || (time <= t0)) {
+		keyValue(low, value);
+		return;
+	}
+
+	float t1 = keyTime(low + 1);
+	float duration = t1 - t0;
+	float factor = (duration > 0.0f) ? clamp((time - t0) / duration, 0.0f, 1.0f) : 0.0f;
+
+	float v0[4] = { };
+	float v1[4] = { };
+	keyValue(low, v0);
+	keyValue(low + 1, v1);
+
+	if (!track.cubicSpline && track.rotation) {
+		// linear rotation channels are interpolated along the arc, as required by specification
+		quaternion q = slerp(quaternion(v0[3], v0[0], v0[1], v0[2]), quaternion(v1[3], v1[0], v1[1], v1[2]), factor);
+		value[0] = q.vector.x;
+		value[1] = q.vector.y;
+		value[2] = q.vector.z;
+		value[3] = q.scalar;
+		return;
+	}
+
+	if (!track.cubicSpline) {
+		for (uint32_t c = 0; c < components; ++c)
+			value[c] = mix(v0[c], v1[c], factor);
+		return;
+	}
+
+	// Hermite spline from glTF 2.0 specification, tangents are scaled by the key interval
+	float outTangent0[4] = { };
+	float inTangent1[4] = { };
+	keyElement(low, CubicSpline_OutTangent, outTangent0);
+	keyElement(low + 1, CubicSpline_InTangent, inTangent1);
+
+	float s = factor;
+	float s2 = s * s;
+	float s3 = s2 * s;
+	float h00 = 2.0f * s3 - 3.0f * s2 + 1.0f;
+	float h10 = s3 - 2.0f * s2 + s;
+	float h01 = -2.0f * s3 + 3.0f * s2;
+	float h11 = s3 - s2;
+	for (uint32_t c = 0; c < components; ++c) {
+		value[c] = h00 * v0[c] + h10 * duration * outTangent0[c] +
+			h01 * v1[c] + h11 * duration * inTangent1[c];
+	}
+}
+
+/*
+ * Document
+ */
+class Document
+{
+public:
+	Document(const std::string& fileName, AsyncTextureLoader* textureLoader) :
+		_fileName(fileName), _basePath(getFilePath(fileName)), _textureLoader(textureLoader) {
+	}
+
+	s3d::ElementContainer::Pointer load(RenderInterface::Pointer, s3d::Storage&, ObjectsCache&);
+
+private:
+	bool parse();
+	bool loadBuffers();
+	bool loadAccessors();
+	void loadImages();
+	void createTextures(ObjectsCache&);
+	void loadMaterials();
+	bool loadMeshes();
+	void fillVertexData();
+	void buildNodes(s3d::ElementContainer::Pointer);
+	void buildNode(int32_t index, s3d::BaseElement* parent, uint32_t depth);
+	void loadSkins();
+	void loadAnimations();
+
+	Accessor accessor(int32_t index) const {
+		return ((index >= 0) && (index < static_cast<int32_t>(_accessors.size()))) ? _accessors[index] : Accessor();
+	}
+
+	Texture::Pointer textureForInfo(const Dictionary& info);
+
+private:
+	std::string _fileName;
+	std::string _basePath;
+	AsyncTextureLoader* _textureLoader = nullptr;
+	RenderInterface::Pointer _renderer;
+
+	MappedFile _file;
+	Dictionary _document;
+	const uint8_t* _binaryChunk = nullptr;
+	uint64_t _binaryChunkSize = 0;
+
+	Vector<DataBuffer> _buffers;
+	Vector<BufferView> _bufferViews;
+	Vector<Accessor> _accessors;
+	Vector<Image> _images;
+	Vector<int32_t> _textureImages;
+	Vector<MaterialInstance::Pointer> _materials;
+	MaterialInstance::Pointer _defaultMaterial;
+
+	Vector<Primitive> _primitives;
+	Vector<Vector<uint32_t>> _meshPrimitives;
+	Vector<VertexGroup> _groups;
+	IndexArray::Pointer _indexArray;
+
+	Vector<Dictionary> _nodes;
+	Vector<s3d::BaseElement*> _nodeElements;
+	Vector<NodeTransform> _nodeTransforms;
+	Vector<bool> _jointNodes;
+};
+
+bool Document::parse() {
+	if (!_file.open(_fileName)) {
+		log::error("Unable to open glTF file: %s", _fileName.c_str());
+		return false;
+	}
+
+	const char* jsonData = reinterpret_cast<const char*>(_file.data());
+	size_t jsonSize = static_cast<size_t>(_file.size());
+
+	uint32_t magic = 0;
+	if (_file.size() >= GLBHeaderSize)
+		etCopyMemory(&magic, _file.data(), sizeof(magic));
+
+	if (magic == GLBMagic) {
+		uint32_t header[3] = { };
+		etCopyMemory(header, _file.data(), sizeof(header));
+		if ((header[1] != GLBVersion) || (header[2] > _file.size())) {
+			log::error("Invalid GLB header in %s", _fileName.c_str());
+			return false;
+		}
+
+		jsonData = nullptr;
+		uint64_t offset = GLBHeaderSize;
+		while (offset + GLBChunkHeaderSize <= header[2]) {
+			uint32_t chunkHeader[2] = { };
+			etCopyMemory(chunkHeader, _file.data() + offset, sizeof(chunkHeader));
+			offset += GLBChunkHeaderSize;
+
+			if (offset + chunkHeader[0] > header[2])
+				break;
+
+			if ((chunkHeader[1] == GLBChunkJSON) && (jsonData == nullptr)) {
+				jsonData = reinterpret_cast<const char*>(_file.data() + offset);
+				jsonSize = chunkHeader[0];
+			}
+			else if ((chunkHeader[1] == GLBChunkBIN) && (_binaryChunk == nullptr)) {
+				_binaryChunk = _file.data() + offset;
+				_binaryChunkSize = chunkHeader[0];
+			}
+			offset += alignUpTo(chunkHeader[0], 4u);
+		}
+
+		if (jsonData == nullptr) {
+			log::error("GLB file does not contain JSON chunk: %s", _fileName.c_str());
+			return false;
+		}
+	}
 
 	VariantClass cls = VariantClass::Invalid;
-	json::deserialize(loadTextFile(_private->inputFileName), cls);
-	if (cls != VariantClass::Dictionary)
+	VariantBase::Pointer root = json::deserialize(jsonData, jsonSize, cls);
+	if (cls != VariantClass::Dictionary) {
+		log::error("Failed to load glTF from file: %s", _fileName.c_str());
+		return false;
+	}
+	_document = root;
+
+	Dictionary asset = _document.dictionaryForKey("asset");
+	std::string version = asset.stringForKey("version")->content;
+	if (version.compare(0, 2, "2.") != 0) {
+		log::error("Unsupported glTF version `%s` in %s", version.c_str(), _fileName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool Document::loadBuffers() {
+	ET_PROFILE_SCOPE("gltf::Document::loadBuffers");
+
+	Vector<Dictionary> buffers = dictionaries(_document, "buffers");
+	_buffers.resize(buffers.size());
+	for (size_t i = 0, e = buffers.size(); i < e; ++i) {
+		DataBuffer& buffer = _buffers[i];
+		uint64_t byteLength = sizeForKey(buffers[i], "byteLength");
+
+		if (!buffers[i].hasKey("uri")) {
+			buffer.data = _binaryChunk;
+			buffer.size = _binaryChunkSize;
+		}
+		else {
+			std::string uri = buffers[i].stringForKey("uri")->content;
+			if (isDataURI(uri)) {
+				buffer.decoded = decodeDataURI(uri);
+				buffer.data = buffer.decoded.data();
+				buffer.size = buffer.decoded.size();
+			}
+			else {
+				buffer.mapping.reset(new MappedFile());
+				if (buffer.mapping->open(_basePath + decodeURI(uri))) {
+					buffer.data = buffer.mapping->data();
+					buffer.size = buffer.mapping->size();
+				}
+			}
+		}
+
+		if ((buffer.data == nullptr) || (buffer.size < byteLength)) {
+			log::error("Unable to load buffer %u for %s", static_cast<uint32_t>(i), _fileName.c_str());
+			return false;
+		}
+	}
+
+	Vector<Dictionary> views = dictionaries(_document, "bufferViews");
+	_bufferViews.resize(views.size());
+	for (size_t i = 0, e = views.size(); i < e; ++i) {
+		int32_t bufferIndex = indexForKey(views[i], "buffer");
+		uint64_t offset = sizeForKey(views[i], "byteOffset");
+		uint64_t length = sizeForKey(views[i], "byteLength");
+		if ((bufferIndex < 0) || (bufferIndex >= static_cast<int32_t>(_buffers.size())) ||
+			(offset + length > _buffers[bufferIndex].size)) {
+			log::error("Invalid buffer view %u in %s", static_cast<uint32_t>(i), _fileName.c_str());
+			return false;
+		}
+
+		_bufferViews[i].data = _buffers[bufferIndex].data + offset;
+		_bufferViews[i].size = length;
+		_bufferViews[i].stride = static_cast<uint32_t>(sizeForKey(views[i], "byteStride"));
+	}
+
+	return true;
+}
+
+bool Document::loadAccessors() {
+	ET_PROFILE_SCOPE("gltf::Document::loadAccessors");
+
+	Vector<Dictionary> accessors = dictionaries(_document, "accessors");
+	_accessors.resize(accessors.size());
+	for (size_t i = 0, e = accessors.size(); i < e; ++i) {
+		const Dictionary& desc = accessors[i];
+		Accessor& result = _accessors[i];
+		result.count = static_cast<uint32_t>(sizeForKey(desc, "count"));
+		result.componentType = static_cast<uint32_t>(sizeForKey(desc, "componentType"));
+		result.components = componentsCount(desc.stringForKey("type")->content);
+		result.normalized = desc.boolForKey("normalized")->content != 0;
+
+		if (desc.hasKey("sparse"))
+			log::warning("Sparse accessors are not supported (accessor %u in %s)", static_cast<uint32_t>(i), _fileName.c_str());
+
+		int32_t viewIndex = indexForKey(desc, "bufferView");
+		if ((viewIndex < 0) || (viewIndex >= static_cast<int32_t>(_bufferViews.size())))
+			continue;
+
+		const BufferView& view = _bufferViews[viewIndex];
+		uint64_t offset = sizeForKey(desc, "byteOffset");
+		result.stride = (view.stride > 0) ? view.stride : result.elementSize();
+
+		uint64_t requiredSize = (result.count > 0) ?
+			offset + static_cast<uint64_t>(result.count - 1) * result.stride + result.elementSize() : 0;
+		if ((result.elementSize() == 0) || (requiredSize > view.size)) {
+			log::error("Invalid accessor %u in %s", static_cast<uint32_t>(i), _fileName.c_str());
+			return false;
+		}
+		result.data = view.data + offset;
+	}
+	return true;
+}
+
+void Document::loadImages() {
+	ET_PROFILE_SCOPE("gltf::Document::loadImages");
+
+	Vector<Dictionary> images = dictionaries(_document, "images");
+	_images.resize(images.size());
+	for (size_t i = 0, e = images.size(); i < e; ++i) {
+		Image& image = _images[i];
+		image.mimeType = images[i].stringForKey("mimeType")->content;
+
+		int32_t viewIndex = indexForKey(images[i], "bufferView");
+		if ((viewIndex >= 0) && (viewIndex < static_cast<int32_t>(_bufferViews.size()))) {
+			image.data = _bufferViews[viewIndex].data;
+			image.size = _bufferViews[viewIndex].size;
+		}
+		else if (images[i].hasKey("uri")) {
+			std::string uri = images[i].stringForKey("uri")->content;
+			if (isDataURI(uri)) {
+				size_t mimeEnd = uri.find(';');
+				if (image.mimeType.empty() && (mimeEnd != std::string::npos))
+					image.mimeType = uri.substr(5, mimeEnd - 5);
+				image.decoded = decodeDataURI(uri);
+				image.data = image.decoded.data();
+				image.size = image.decoded.size();
+			}
+			else {
+				image.fileName = _basePath + decodeURI(uri);
+			}
+		}
+	}
+
+	Vector<Dictionary> textures = dictionaries(_document, "textures");
+	_textureImages.reserve(textures.size());
+	for (const Dictionary& texture : textures)
+		_textureImages.emplace_back(indexForKey(texture, "source"));
+
+	// only images referenced by materials are decoded
+	for (const Dictionary& material : dictionaries(_document, "materials")) {
+		Dictionary pbr = material.dictionaryForKey("pbrMetallicRoughness");
+		const Dictionary infos[] = { pbr.dictionaryForKey("baseColorTexture"), material.dictionaryForKey("normalTexture"),
+			material.dictionaryForKey("emissiveTexture") };
+		for (const Dictionary& info : infos) {
+			int32_t textureIndex = indexForKey(info, "index");
+			if ((textureIndex >= 0) && (textureIndex < static_cast<int32_t>(_textureImages.size())) &&
+				(_textureImages[textureIndex] >= 0) && (_textureImages[textureIndex] < static_cast<int32_t>(_images.size()))) {
+				_images[_textureImages[textureIndex]].used = true;
+			}
+		}
+	}
+}
+
+void Document::createTextures(ObjectsCache& cache) {
+	Vector<uint32_t> decodeList;
+	for (uint32_t i = 0, e = static_cast<uint32_t>(_images.size()); i < e; ++i) {
+		Image& image = _images[i];
+		if (!image.used)
+			continue;
+
+		if (!image.fileName.empty()) {
+			LoadableObject::Collection existing = cache.findObjects(image.fileName);
+			if (!existing.empty()) {
+				image.texture = existing.front();
+				continue;
+			}
+
+			if (_textureLoader != nullptr) {
+				image.request = _textureLoader->load(image.fileName, TextureLoadPriority::High);
+				continue;
+			}
+		}
+
+		decodeList.emplace_back(i);
+	}
+
+	uint32_t decodeCount = static_cast<uint32_t>(decodeList.size());
+	parallel::forRange(decodeCount, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i) {
+			Image& image = _images[decodeList[i]];
+			TextureDescription::Pointer desc = TextureDescription::Pointer::create();
+			if (!image.fileName.empty()) {
+				if (!desc->load(image.fileName))
+					continue;
+			}
+			else if (image.data != nullptr) {
+				MemoryStreamBuffer buffer(image.data, static_cast<size_t>(image.size));
+				std::istream stream(&buffer);
+				desc->target = TextureTarget::Texture_2D;
+				if (image.mimeType == "image/png")
+					png::loadFromStream(stream, desc.reference(), true);
+				else if (image.mimeType == "image/jpeg")
+					jpeg::loadFromStream(stream, desc.reference());
+				else
+					continue;
+			}
+			if (desc->dataSizeForAllMipLevels() > 0)
+				image.description = desc;
+		}
+	});
+
+	// textures are created on the calling thread, since renderer is not thread safe
+	for (uint32_t i = 0, e = static_cast<uint32_t>(_images.size()); i < e; ++i) {
+		Image& image = _images[i];
+		if (image.request.valid())
+			image.description = image.request->wait();
+
+		if (image.texture.valid() || image.description.invalid())
+			continue;
+
+		image.texture = _renderer->createTexture(image.description);
+		if (image.texture.valid() && !image.fileName.empty()) {
+			image.texture->setOrigin(image.fileName);
+			cache.manage(image.texture, ObjectLoader::Pointer());
+		}
+		else if (image.used && image.texture.invalid()) {
+			log::error("Unable to load image %u for %s", i, _fileName.c_str());
+		}
+
+		image.description.reset(nullptr);
+		image.decoded = BinaryDataStorage();
+	}
+}
+
+Texture::Pointer Document::textureForInfo(const Dictionary& info) {
+	int32_t textureIndex = indexForKey(info, "index");
+	if ((textureIndex < 0) || (textureIndex >= static_cast<int32_t>(_textureImages.size())))
+		return Texture::Pointer();
+
+	int32_t imageIndex = _textureImages[textureIndex];
+	if ((imageIndex < 0) || (imageIndex >= static_cast<int32_t>(_images.size())))
+		return Texture::Pointer();
+
+	return _images[imageIndex].texture;
+}
+
+void Document::loadMaterials() {
+	ET_PROFILE_SCOPE("gltf::Document::loadMaterials");
+
+	Material::Pointer microfacet = _renderer->sharedMaterialLibrary().loadDefaultMaterial(DefaultMaterial::Microfacet);
+
+	Vector<Dictionary> materials = dictionaries(_document, "materials");
+	_materials.reserve(materials.size());
+	for (size_t i = 0, e = materials.size(); i < e; ++i) {
+		const Dictionary& desc = materials[i];
+		Dictionary pbr = desc.dictionaryForKey("pbrMetallicRoughness");
+
+		MaterialInstance::Pointer material = microfacet->instance();
+		std::string name = desc.stringForKey("name")->content;
+		material->setName(name.empty() ? ("material_" + intToStr(i)) : name);
+
+		vec4 baseColor(1.0f);
+		readFloats(pbr, "baseColorFactor", baseColor.data(), 4);
+		material->setVector(MaterialVariable::DiffuseReflectance, baseColor);
+
+		vec4 emissive(0.0f, 0.0f, 0.0f, 1.0f);
+		readFloats(desc, "emissiveFactor", emissive.data(), 3);
+		material->setVector(MaterialVariable::EmissiveColor, emissive);
+
+		material->setFloat(MaterialVariable::MetallnessScale, floatForKey(pbr, "metallicFactor", 1.0f));
+		material->setFloat(MaterialVariable::RoughnessScale, floatForKey(pbr, "roughnessFactor", 1.0f));
+
+		Dictionary normalInfo = desc.dictionaryForKey("normalTexture");
+		material->setFloat(MaterialVariable::NormalScale, floatForKey(normalInfo, "scale", 1.0f));
+
+		Texture::Pointer baseColorTexture = textureForInfo(pbr.dictionaryForKey("baseColorTexture"));
+		Texture::Pointer normalTexture = textureForInfo(normalInfo);
+		Texture::Pointer emissiveTexture = textureForInfo(desc.dictionaryForKey("emissiveTexture"));
+
+		material->setTexture(MaterialTexture::BaseColor, baseColorTexture.valid() ? baseColorTexture : _renderer->whiteTexture());
+		material->setTexture(MaterialTexture::Normal, normalTexture.valid() ? normalTexture : _renderer->flatNormalTexture());
+		material->setTexture(MaterialTexture::Opacity, _renderer->whiteTexture());
+		if (emissiveTexture.valid())
+			material->setTexture(MaterialTexture::EmissiveColor, emissiveTexture);
+
+		_materials.emplace_back(material);
+	}
+
+	_defaultMaterial = microfacet->instance();
+	_defaultMaterial->setName("default_material");
+	_defaultMaterial->setTexture(MaterialTexture::BaseColor, _renderer->whiteTexture());
+	_defaultMaterial->setTexture(MaterialTexture::Normal, _renderer->flatNormalTexture());
+	_defaultMaterial->setTexture(MaterialTexture::Opacity, _renderer->whiteTexture());
+}
+
+bool Document::loadMeshes() {
+	ET_PROFILE_SCOPE("gltf::Document::loadMeshes");
+
+	Vector<Dictionary> meshes = dictionaries(_document, "meshes");
+	_meshPrimitives.resize(meshes.size());
+
+	uint32_t totalIndices = 0;
+	for (size_t meshIndex = 0, e = meshes.size(); meshIndex < e; ++meshIndex) {
+		for (const Dictionary& desc : dictionaries(meshes[meshIndex], "primitives")) {
+			uint64_t mode = desc.hasKey("mode") ? sizeForKey(desc, "mode") : static_cast<uint64_t>(PrimitiveMode_Triangles);
+			if (mode != PrimitiveMode_Triangles) {
+				log::warning("Skipping non-triangle primitive (mode %u) in %s", static_cast<uint32_t>(mode), _fileName.c_str());
+				continue;
+			}
+
+			Primitive primitive;
+			Dictionary attributes = desc.dictionaryForKey("attributes");
+			uint32_t attributesMask = 1u << Attribute_Normal;
+			for (uint32_t a = 0; a < Attribute_max; ++a) {
+				primitive.attributes[a] = accessor(indexForKey(attributes, attributeInfos[a].name));
+				if (primitive.attributes[a].valid())
+					attributesMask |= 1u << a;
+			}
+
+			const Accessor& position = primitive.attributes[Attribute_Position];
+			if (!position.valid() || (position.count == 0))
+				continue;
+
+			// skinning data is only useful when both attributes are present
+			uint32_t skinMask = (1u << Attribute_Joints) | (1u << Attribute_Weights);
+			if ((attributesMask & skinMask) != skinMask)
+				attributesMask &= ~skinMask;
+
+			primitive.vertexCount = position.count;
+			primitive.indices = accessor(indexForKey(desc, "indices"));
+			primitive.indexCount = primitive.indices.valid() ? primitive.indices.count : position.count;
+			primitive.material = indexForKey(desc, "material");
+
+			if ((primitive.indexCount < 3) || (primitive.indices.valid() && (primitive.indices.components != 1)))
+				continue;
+
+			// primitives are addressed by triangles (normals generation), so partial triangles are rejected
+			if (primitive.indexCount % 3 != 0) {
+				log::warning("Skipping primitive with %u indices, not a triangle list, in %s", primitive.indexCount, _fileName.c_str());
+				continue;
+			}
+
+			if (primitive.indices.valid() && !indicesInRange(primitive.indices, primitive.vertexCount)) {
+				log::error("Skipping primitive with indices out of %u vertices in %s", primitive.vertexCount, _fileName.c_str());
+				continue;
+			}
+
+			auto group = std::find_if(_groups.begin(), _groups.end(), [attributesMask](const VertexGroup& g) {
+				return g.attributesMask == attributesMask;
+			});
+			if (group == _groups.end()) {
+				_groups.emplace_back();
+				_groups.back().attributesMask = attributesMask;
+				group = _groups.end() - 1;
+			}
+
+			primitive.group = static_cast<uint32_t>(group - _groups.begin());
+			primitive.firstVertex = group->vertexCount;
+			primitive.firstIndex = totalIndices;
+			group->vertexCount += primitive.vertexCount;
+			totalIndices += primitive.indexCount;
+
+			_meshPrimitives[meshIndex].emplace_back(static_cast<uint32_t>(_primitives.size()));
+			_primitives.emplace_back(primitive);
+		}
+	}
+
+	if (_primitives.empty())
+		return false;
+
+	uint32_t maxGroupVertexCount = 0;
+	for (VertexGroup& group : _groups) {
+		VertexDeclaration decl(true);
+		for (uint32_t a = 0; a < Attribute_max; ++a) {
+			if (group.attributesMask & (1u << a))
+				decl.push_back(attributeInfos[a].usage, attributeInfos[a].type);
+		}
+		group.storage = VertexStorage::Pointer::create(decl, group.vertexCount);
+		maxGroupVertexCount = std::max(maxGroupVertexCount, group.vertexCount);
+	}
+
+	IndexArrayFormat format = (maxGroupVertexCount > 65535) ? IndexArrayFormat::Format_32bit : IndexArrayFormat::Format_16bit;
+	_indexArray = IndexArray::Pointer::create(format, totalIndices, PrimitiveType::Triangles);
+	_indexArray->setActualSize(totalIndices);
+
+	return true;
+}
+
+void Document::fillVertexData() {
+	// every primitive writes to its own range of vertices and indices
+	uint32_t primitivesCount = static_cast<uint32_t>(_primitives.size());
+	parallel::forRange(primitivesCount, 1, [this](uint32_t begin, uint32_t end) {
+		for (uint32_t p = begin; p < end; ++p) {
+			const Primitive& primitive = _primitives[p];
+			VertexStorage::Pointer& storage = _groups[primitive.group].storage;
+			uint32_t stride = storage->stride();
+			uint8_t* vertexData = reinterpret_cast<uint8_t*>(storage->data().binary()) +
+				static_cast<size_t>(primitive.firstVertex) * stride;
+
+			for (uint32_t a = 0; a < Attribute_max; ++a) {
+				const Accessor& source = primitive.attributes[a];
+				if (!source.valid() || !storage->hasAttribute(attributeInfos[a].usage))
+					continue;
+
+				uint8_t* target = vertexData + storage->offsetOfAttribute(attributeInfos[a].usage);
+				if (a == Attribute_Joints) {
+					copyIntegerAttribute(source, target, stride, attributeInfos[a].components);
+				}
+				else {
+					copyAttribute(source, target, stride, attributeInfos[a].components);
+				}
+
+				// images are loaded with bottom-left origin
+				if ((a == Attribute_TexCoord0) || (a == Attribute_TexCoord1)) {
+					for (uint32_t i = 0; i < source.count; ++i) {
+						float* uv = reinterpret_cast<float*>(target + static_cast<size_t>(i) * stride);
+						uv[1] = 1.0f - uv[1];
+					}
+				}
+			}
+
+			if (_indexArray->format() == IndexArrayFormat::Format_32bit)
+				copyIndices(primitive, reinterpret_cast<uint32_t*>(_indexArray->binary()) + primitive.firstIndex);
+			else
+				copyIndices(primitive, reinterpret_cast<uint16_t*>(_indexArray->binary()) + primitive.firstIndex);
+		}
+	});
+
+	for (const Primitive& primitive : _primitives) {
+		if (!primitive.attributes[Attribute_Normal].valid()) {
+			ET_ASSERT((primitive.firstIndex % 3 == 0) && (primitive.indexCount % 3 == 0));
+			uint32_t firstTriangle = primitive.firstIndex / 3;
+			primitives::calculateNormals(_groups[primitive.group].storage, _indexArray, firstTriangle,
+				firstTriangle + primitive.indexCount / 3);
+		}
+	}
+}
+
+void Document::buildNode(int32_t index, s3d::BaseElement* parent, uint32_t depth) {
+	if ((index < 0) || (index >= static_cast<int32_t>(_nodes.size())) || (_nodeElements[index] != nullptr))
+		return;
+
+	const uint32_t maxHierarchyDepth = 256;
+	if (depth > maxHierarchyDepth) {
+		log::error("glTF node hierarchy is too deep in %s", _fileName.c_str());
+		return;
+	}
+
+	const Dictionary& desc = _nodes[index];
+	std::string name = desc.stringForKey("name")->content;
+	if (name.empty())
+		name = "node_" + intToStr(index);
+
+	int32_t meshIndex = indexForKey(desc, "mesh");
+	bool hasMesh = (meshIndex >= 0) && (meshIndex < static_cast<int32_t>(_meshPrimitives.size()));
+
+	s3d::BaseElement* element = nullptr;
+	if (_jointNodes[index]) {
+		if (hasMesh)
+			log::warning("Mesh attached to joint node `%s` is ignored", name.c_str());
+		element = s3d::SkeletonElement::Pointer::create(name, parent).pointer();
+	}
+	else if (hasMesh) {
+		s3d::Mesh::Pointer mesh = s3d::Mesh::Pointer::create(name, parent);
+		for (uint32_t p : _meshPrimitives[meshIndex]) {
+			const Primitive& primitive = _primitives[p];
+			const VertexGroup& group = _groups[primitive.group];
+			bool hasMaterial = (primitive.material >= 0) && (primitive.material < static_cast<int32_t>(_materials.size()));
+			const MaterialInstance::Pointer& material = hasMaterial ? _materials[primitive.material] : _defaultMaterial;
+
+			RenderBatch::Pointer batch = _renderer->allocateRenderBatch(material, group.stream, primitive.firstIndex, primitive.indexCount);
+			batch->setVertexStorage(group.storage);
+			batch->setIndexArray(_indexArray);
+			mesh->addRenderBatch(batch);
+		}
+		element = mesh.pointer();
+	}
+	else {
+		element = s3d::ElementContainer::Pointer::create(name, parent).pointer();
+	}
+	_nodeElements[index] = element;
+
+	NodeTransform& transform = _nodeTransforms[index];
+	float values[16] = { };
+	if (readFloats(desc, "matrix", values, 16) == 16) {
+		// column-major matrix for column vectors has the same layout as row-major for row vectors
+		mat4 matrix;
+		etCopyMemory(matrix.data(), values, sizeof(values));
+		element->setTransform(matrix);
+		decomposeMatrix(matrix, transform.translation, transform.orientation, transform.scale);
+	}
+	else {
+		float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		readFloats(desc, "translation", transform.translation.data(), 3);
+		readFloats(desc, "scale", transform.scale.data(), 3);
+		readFloats(desc, "rotation", rotation, 4);
+		transform.orientation = orientationFromArray(rotation);
+		element->setTranslation(transform.translation);
+		element->setOrientation(transform.orientation);
+		element->setScale(transform.scale);
+	}
+
+	for (int32_t child : indices(desc, "children"))
+		buildNode(child, element, depth + 1);
+
+	if (hasMesh && !_jointNodes[index])
+		static_cast<s3d::Mesh*>(element)->calculateSupportData();
+}
+
+void Document::buildNodes(s3d::ElementContainer::Pointer root) {
+	_nodes = dictionaries(_document, "nodes");
+	_nodeElements.resize(_nodes.size(), nullptr);
+	_nodeTransforms.resize(_nodes.size());
+	_jointNodes.resize(_nodes.size(), false);
+
+	for (const Dictionary& skin : dictionaries(_document, "skins")) {
+		for (int32_t joint : indices(skin, "joints")) {
+			if ((joint >= 0) && (joint < static_cast<int32_t>(_nodes.size())))
+				_jointNodes[joint] = true;
+		}
+	}
+
+	Vector<Dictionary> scenes = dictionaries(_document, "scenes");
+	int32_t sceneIndex = indexForKey(_document, "scene");
+	if ((sceneIndex < 0) || (sceneIndex >= static_cast<int32_t>(scenes.size())))
+		sceneIndex = 0;
+
+	if (sceneIndex < static_cast<int32_t>(scenes.size())) {
+		for (int32_t node : indices(scenes[sceneIndex], "nodes"))
+			buildNode(node, root.pointer(), 0);
+	}
+
+	// nodes which are not referenced by scene (or file without scenes) are attached to the root
+	Vector<bool> isChild(_nodes.size(), false);
+	for (const Dictionary& node : _nodes) {
+		for (int32_t child : indices(node, "children")) {
+			if ((child >= 0) && (child < static_cast<int32_t>(_nodes.size())))
+				isChild[child] = true;
+		}
+	}
+
+	for (int32_t i = 0, e = static_cast<int32_t>(_nodes.size()); i < e; ++i) {
+		if (!isChild[i])
+			buildNode(i, root.pointer(), 0);
+	}
+}
+
+void Document::loadSkins() {
+	ET_PROFILE_SCOPE("gltf::Document::loadSkins");
+
+	Vector<Dictionary> skins = dictionaries(_document, "skins");
+	for (size_t n = 0, e = _nodes.size(); n < e; ++n) {
+		int32_t skinIndex = indexForKey(_nodes[n], "skin");
+		s3d::BaseElement* element = _nodeElements[n];
+		if ((skinIndex < 0) || (skinIndex >= static_cast<int32_t>(skins.size())) || (element == nullptr) ||
+			(element->type() != s3d::ElementType::Mesh)) {
+			continue;
+		}
+
+		Vector<int32_t> joints = indices(skins[skinIndex], "joints");
+		Accessor inverseBindMatrices = accessor(indexForKey(skins[skinIndex], "inverseBindMatrices"));
+		bool hasMatrices = inverseBindMatrices.valid() && (inverseBindMatrices.components == 16) &&
+			(inverseBindMatrices.componentType == ComponentType_Float) && (inverseBindMatrices.count >= joints.size());
+
+		s3d::MeshDeformer::Pointer deformer = s3d::MeshDeformer::Pointer::create();
+		for (size_t j = 0, je = joints.size(); j < je; ++j) {
+			s3d::MeshDeformerCluster::Pointer cluster = s3d::MeshDeformerCluster::Pointer::create();
+			cluster->setMeshInitialTransform(identityMatrix);
+			cluster->setLinkTag(j);
+			deformer->addCluster(cluster);
+
+			// clusters are addressed by JOINTS_0 values, so invalid joints keep their slot with identity transform
+			int32_t joint = joints[j];
+			if ((joint < 0) || (joint >= static_cast<int32_t>(_nodeElements.size())) || (_nodeElements[joint] == nullptr) ||
+				(_nodeElements[joint]->type() != s3d::ElementType::Skeleton)) {
+				log::error("Invalid joint %d in skin %d of %s", joint, skinIndex, _fileName.c_str());
+				cluster->setLinkInitialTransform(identityMatrix);
+				continue;
+			}
+
+			mat4 inverseBindMatrix(1.0f);
+			if (hasMatrices)
+				etCopyMemory(inverseBindMatrix.data(), inverseBindMatrices.element(static_cast<uint32_t>(j)), sizeof(mat4));
+
+			cluster->setLink(s3d::SkeletonElement::Pointer(static_cast<s3d::SkeletonElement*>(_nodeElements[joint])));
+			cluster->setLinkInitialTransform(inverseBindMatrix.inverted());
+		}
+
+		static_cast<s3d::Mesh*>(element)->setDeformer(deformer);
+	}
+}
+
+void Document::loadAnimations() {
+	ET_PROFILE_SCOPE("gltf::Document::loadAnimations");
+
+	enum : uint32_t
 	{
-		log::error("Failed to load GLTF from file: %s", _private->inputFileName.c_str());
+		Path_Translation,
+		Path_Rotation,
+		Path_Scale,
+		Path_max
+	};
+
+	for (const Dictionary& animation : dictionaries(_document, "animations")) {
+		Vector<Dictionary> samplers = dictionaries(animation, "samplers");
+
+		// tracks are grouped by node, since engine animation stores complete transform per key frame
+		Map<int32_t, std::array<AnimationTrack, Path_max>> nodeTracks;
+		for (const Dictionary& channel : dictionaries(animation, "channels")) {
+			Dictionary target = channel.dictionaryForKey("target");
+			int32_t node = indexForKey(target, "node");
+			int32_t samplerIndex = indexForKey(channel, "sampler");
+			if ((node < 0) || (node >= static_cast<int32_t>(_nodeElements.size())) || (_nodeElements[node] == nullptr) ||
+				(samplerIndex < 0) || (samplerIndex >= static_cast<int32_t>(samplers.size()))) {
+				continue;
+			}
+
+			std::string path = target.stringForKey("path")->content;
+			uint32_t pathIndex = Path_max;
+			if (path == "translation")
+				pathIndex = Path_Translation;
+			else if (path == "rotation")
+				pathIndex = Path_Rotation;
+			else if (path == "scale")
+				pathIndex = Path_Scale;
+
+			if (pathIndex == Path_max)
+				continue;
+
+			const Dictionary& sampler = samplers[samplerIndex];
+			std::string interpolation = sampler.stringForKey("interpolation")->content;
+
+			AnimationTrack track;
+			track.input = accessor(indexForKey(sampler, "input"));
+			track.output = accessor(indexForKey(sampler, "output"));
+			track.step = (interpolation == "STEP");
+			track.cubicSpline = (interpolation == "CUBICSPLINE");
+			track.rotation = (pathIndex == Path_Rotation);
+
+			uint32_t expectedComponents = (pathIndex == Path_Rotation) ? 4 : 3;
+			uint32_t valuesPerKey = track.cubicSpline ? static_cast<uint32_t>(CubicSpline_ElementsPerKey) : 1u;
+			if (!track.input.valid() || !track.output.valid() || (track.input.count == 0) ||
+				(track.output.components != expectedComponents) || (track.output.count < track.input.count * valuesPerKey)) {
+				continue;
+			}
+
+			nodeTracks[node][pathIndex] = track;
+		}
+
+		for (const auto& entry : nodeTracks) {
+			const NodeTransform& rest = _nodeTransforms[entry.first];
+			const auto& tracks = entry.second;
+
+			Vector<float> times;
+			for (const AnimationTrack& track : tracks) {
+				for (uint32_t k = 0; track.input.valid() && (k < track.input.count); ++k)
+					times.emplace_back(readComponent(track.input.element(k), track.input.componentType, false));
+			}
+			std::sort(times.begin(), times.end());
+			times.erase(std::unique(times.begin(), times.end()), times.end());
+
+			s3d::Animation result;
+			for (float time : times) {
+				vec3 translation = rest.translation;
+				quaternion orientation = rest.orientation;
+				vec3 scale = rest.scale;
+
+				if (tracks[Path_Translation].input.valid())
+					sampleTrack(tracks[Path_Translation], time, translation.data(), 3);
+
+				if (tracks[Path_Scale].input.valid())
+					sampleTrack(tracks[Path_Scale], time, scale.data(), 3);
+
+				if (tracks[Path_Rotation].input.valid()) {
+					float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+					sampleTrack(tracks[Path_Rotation], time, rotation, 4);
+					orientation = orientationFromArray(rotation);
+					orientation.normalize();
+				}
+
+				result.addKeyFrame(time, translation, orientation, scale);
+			}
+			result.setTimeRange(times.front(), times.back());
+			_nodeElements[entry.first]->addAnimation(result);
+		}
+	}
+}
+
+s3d::ElementContainer::Pointer Document::load(RenderInterface::Pointer renderer, s3d::Storage& storage, ObjectsCache& cache) {
+	ET_PROFILE_SCOPE("gltf::Document::load");
+	MemoryTagScope memoryTag(MemoryTag::Scene);
+
+	_renderer = renderer;
+
+	s3d::ElementContainer::Pointer result = s3d::ElementContainer::Pointer::create(_fileName, nullptr);
+	if (!parse() || !loadBuffers() || !loadAccessors())
 		return result;
+
+	loadImages();
+	createTextures(cache);
+	loadMaterials();
+
+	storage.flush();
+	if (loadMeshes()) {
+		fillVertexData();
+
+		Buffer::Pointer indexBuffer = _renderer->createIndexBuffer("gltf-ib", _indexArray, Buffer::Location::Device);
+		for (VertexGroup& group : _groups) {
+			group.stream = VertexStream::Pointer::create();
+			group.stream->setVertexBuffer(_renderer->createVertexBuffer("gltf-vb", group.storage, Buffer::Location::Device),
+				group.storage->declaration());
+			group.stream->setIndexBuffer(indexBuffer, _indexArray->format());
+			group.stream->setPrimitiveType(_indexArray->primitiveType());
+			storage.addVertexStorage(group.storage);
+		}
+		storage.setIndexArray(_indexArray);
 	}
 
+	for (const MaterialInstance::Pointer& material : _materials)
+		storage.addMaterial(material);
+
+	for (const Image& image : _images) {
+		if (image.texture.valid())
+			storage.addTexture(image.texture);
+	}
+
+	buildNodes(result);
+	loadSkins();
+	loadAnimations();
+
 	return result;
 }
 
-}
\ No newline at end of file
+}
+
+/*
+ * GLTFLoader
+ */
+class GLTFLoaderPrivate
+{
+public:
+	GLTFLoaderPrivate(const std::string& fileName) :
+		inputFileName(fileName) {
+	}
+
+	std::string inputFileName;
+	AsyncTextureLoader* textureLoader = nullptr;
+};
+
+GLTFLoader::GLTFLoader(const std::string& fileName) {
+	ET_PIMPL_INIT(GLTFLoader, fileName);
+}
+
+GLTFLoader::~GLTFLoader() {
+	ET_PIMPL_FINALIZE(GLTFLoader);
+}
+
+void GLTFLoader::setTextureLoader(AsyncTextureLoader* loader) {
+	_private->textureLoader = loader;
+}
+
+s3d::ElementContainer::Pointer GLTFLoader::load(RenderInterface::Pointer renderer, s3d::Storage& storage, ObjectsCache& cache) {
+	gltf::Document document(_private->inputFileName, _private->textureLoader);
+	return document.load(renderer, storage, cache);
+}
+
+}
@@ -11,6 +11,7 @@
 
 namespace et {
 
+class AsyncTextureLoader;
 class GLTFLoaderPrivate;
 class GLTFLoader : public ModelLoader
 {
@@ -18,8 +19,18 @@ public:
 	GLTFLoader(const std::string& fileName);
 	~GLTFLoader();
 
+	/*
+	 * Loads .gltf (with external or embedded buffers) and .glb files.
+	 * Buffers are memory mapped and accessor data is copied directly into vertex storages.
+	 */
 	s3d::ElementContainer::Pointer load(RenderInterface::Pointer, s3d::Storage&, ObjectsCache&) override;
 
+	/*
+	 * Optional, images referenced by file name are loaded through it (using its disk cache),
+	 * otherwise all images are decoded in parallel within load call
+	 */
+	void setTextureLoader(AsyncTextureLoader*);
+
 private:
 	ET_DECLARE_PIMPL(GLTFLoader, 256);
 };
@@ -141,54 +141,10 @@ const Vector<mat4>& Mesh::deformationMatrices()
  * Bake deformations + stuff for it
  */
 
-template <DataType attribType>
-void copyAttributeWithType(VertexStorage::Pointer from, VertexStorage::Pointer to, VertexAttributeUsage attrib)
-{
-	auto c0 = from->accessData<attribType>(attrib, 0);
-	auto c1 = to->accessData<attribType>(attrib, 0);
-	for (uint32_t i = 0; i < from->capacity(); ++i)
-		c1[i] = c0[i];
-}
-
-void copyAttribute(VertexStorage::Pointer from, VertexStorage::Pointer to, VertexAttributeUsage attrib)
-{
-	if (!from->hasAttribute(attrib)) return;
-	
-	switch (from->attributeType(attrib))
-	{
-		case DataType::Float:
-			copyAttributeWithType<DataType::Float>(from, to, attrib);
-			break;
-		case DataType::Int:
-			copyAttributeWithType<DataType::Int>(from, to, attrib);
-			break;
-		case DataType::Vec2:
-			copyAttributeWithType<DataType::Vec2>(from, to, attrib);
-			break;
-		case DataType::Vec3:
-			copyAttributeWithType<DataType::Vec3>(from, to, attrib);
-			break;
-		case DataType::Vec4:
-			copyAttributeWithType<DataType::Vec4>(from, to, attrib);
-			break;
-		case DataType::IntVec2:
-			copyAttributeWithType<DataType::IntVec2>(from, to, attrib);
-			break;
-		case DataType::IntVec3:
-			copyAttributeWithType<DataType::IntVec3>(from, to, attrib);
-			break;
-		case DataType::IntVec4:
-			copyAttributeWithType<DataType::IntVec4>(from, to, attrib);
-			break;
-		default:
-			ET_FAIL("Unhandled attribute type");
-	}
-}
-
 void copyVector3Rotated(VertexStorage::Pointer from, VertexStorage::Pointer to, VertexAttributeUsage attrib,
 	const mat4& transform)
 {
-	if (!from->hasAttribute(attrib)) return;
+	if (!from->hasAttributeWithType(attrib, DataType::Vec3)) return;
 	
 	auto c0 = from->accessData<DataType::Vec3>(attrib, 0);
 	auto c1 = to->accessData<DataType::Vec3>(attrib, 0);
@@ -199,7 +155,7 @@ void copyVector3Rotated(VertexStorage::Pointer from, VertexStorage::Pointer to,
 void copyVector3Transformed(VertexStorage::Pointer from, VertexStorage::Pointer to, VertexAttributeUsage attrib,
 	const mat4& transform)
 {
-	if (!from->hasAttribute(attrib)) return;
+	if (!from->hasAttributeWithType(attrib, DataType::Vec3)) return;
 	
 	auto c0 = from->accessData<DataType::Vec3>(attrib, 0);
 	auto c1 = to->accessData<DataType::Vec3>(attrib, 0);
@@ -207,92 +163,85 @@ void copyVector3Transformed(VertexStorage::Pointer from, VertexStorage::Pointer
 		c1[i] = transform * c0[i];
 }
 
-void skinVector3Rotated(VertexStorage::Pointer from, VertexStorage::Pointer to, VertexAttributeUsage attrib,
-	const Vector<mat4>& transforms)
+void writeVector3(const Vector<vec3>& values, VertexStorage::Pointer to, VertexAttributeUsage attrib)
 {
-	if (!from->hasAttribute(attrib)) return;
-	
-	auto c0 = from->accessData<DataType::Vec3>(attrib, 0);
 	auto c1 = to->accessData<DataType::Vec3>(attrib, 0);
-	auto bi = to->accessData<DataType::IntVec4>(VertexAttributeUsage::BlendIndices, 0);
-	auto bw = to->accessData<DataType::Vec4>(VertexAttributeUsage::BlendWeights, 0);
-	for (uint32_t i = 0; i < from->capacity(); ++i)
-	{
-		c1[i] =
-			transforms[bi[i][0]].rotationMultiply(c0[i]) * bw[i][0] +
-			transforms[bi[i][1]].rotationMultiply(c0[i]) * bw[i][1] +
-			transforms[bi[i][2]].rotationMultiply(c0[i]) * bw[i][2] +
-			transforms[bi[i][3]].rotationMultiply(c0[i]) * bw[i][3];
-	}
+	for (uint32_t i = 0, e = static_cast<uint32_t>(values.size()); i < e; ++i)
+		c1[i] = values[i];
 }
 
-void skinVector3Transformed(VertexStorage::Pointer from, VertexStorage::Pointer to, VertexAttributeUsage attrib,
-	const Vector<mat4>& transforms)
+VertexStorage::Pointer Mesh::sourceVertexStorage() const
 {
-	if (!from->hasAttribute(attrib)) return;
-	
-	auto c0 = from->accessData<DataType::Vec3>(attrib, 0);
-	auto c1 = to->accessData<DataType::Vec3>(attrib, 0);
-	auto bi = to->accessData<DataType::IntVec4>(VertexAttributeUsage::BlendIndices, 0);
-	auto bw = to->accessData<DataType::Vec4>(VertexAttributeUsage::BlendWeights, 0);
-	for (uint32_t i = 0; i < from->capacity(); ++i)
+	for (const auto& rb : renderBatches())
 	{
-		c1[i] = (transforms[bi[i][0]] * c0[i]) * bw[i][0] + (transforms[bi[i][1]] * c0[i]) * bw[i][1] +
-			(transforms[bi[i][2]] * c0[i]) * bw[i][2] +  (transforms[bi[i][3]] * c0[i]) * bw[i][3];
+		if (rb->vertexStorage().valid())
+			return rb->vertexStorage();
 	}
+	return VertexStorage::Pointer();
 }
 
 bool Mesh::skinned() const
 {
-	ET_FAIL("TODO");
-	/*
-	 * TODO
-	 *
-	return _vertexStorage->hasAttribute(VertexAttributeUsage::BlendIndices) &&
-		_vertexStorage->hasAttribute(VertexAttributeUsage::BlendWeights);
-	// */
+	if (_deformer.invalid())
+		return false;
+
+	VertexStorage::Pointer storage = sourceVertexStorage();
+	if (storage.invalid())
+		return false;
+
+	if (storage->hasAttribute(VertexAttributeUsage::BlendIndices) &&
+		storage->hasAttribute(VertexAttributeUsage::BlendWeights))
+	{
+		return true;
+	}
+
+	for (const auto& cluster : _deformer->clusters())
+	{
+		if (!cluster->weights().empty())
+			return true;
+	}
+
 	return false;
 }
 
-VertexStorage::Pointer Mesh::bakeDeformations()
+VertexStorage::Pointer Mesh::bakeDeformations(SkinningMethod method)
 {
-	ET_FAIL("TODO");
-	
-	/*
-	 * TODO
-	 *
-	const auto& transforms = deformationMatrices();
-	
-	VertexStorage::Pointer result =
-		VertexStorage::Pointer::create(_vertexStorage->declaration(), _vertexStorage->capacity());
-	
-	copyAttribute(_vertexStorage, result, VertexAttributeUsage::Color);
-	copyAttribute(_vertexStorage, result, VertexAttributeUsage::TexCoord0);
-	copyAttribute(_vertexStorage, result, VertexAttributeUsage::TexCoord1);
-	copyAttribute(_vertexStorage, result, VertexAttributeUsage::TexCoord2);
-	copyAttribute(_vertexStorage, result, VertexAttributeUsage::TexCoord3);
-	copyAttribute(_vertexStorage, result, VertexAttributeUsage::Smoothing);
-	copyAttribute(_vertexStorage, result, VertexAttributeUsage::BlendIndices);
-	copyAttribute(_vertexStorage, result, VertexAttributeUsage::BlendWeights);
+	VertexStorage::Pointer source = sourceVertexStorage();
+	if (source.invalid())
+		return VertexStorage::Pointer();
 	
+	VertexStorage::Pointer result = VertexStorage::Pointer::create(source->declaration(), source->capacity());
+	etCopyMemory(result->data().binary(), source->data().binary(), source->data().dataSize());
+
 	if (skinned())
 	{
-		skinVector3Transformed(_vertexStorage, result, VertexAttributeUsage::Position, transforms);
-		skinVector3Rotated(_vertexStorage, result, VertexAttributeUsage::Normal, transforms);
-		skinVector3Rotated(_vertexStorage, result, VertexAttributeUsage::Tangent, transforms);
-		skinVector3Rotated(_vertexStorage, result, VertexAttributeUsage::Binormal, transforms);
+		// influences are gathered once per vertex storage
+		if (_skinningStorage != source)
+		{
+			_skinningStorage = source;
+			skinning::prepare(source.reference(), _deformer.pointer(), _skinningSource);
+		}
+
+		uint32_t vertexCount = _skinningSource.vertexCount();
+		Vector<vec3> positions(vertexCount);
+		Vector<vec3> normals(_skinningSource.hasNormals() ? vertexCount : 0);
+
+		const skinning::Palette& palette = _deformer->calculatePalette(method);
+		skinning::deform(_skinningSource, palette, method, positions.data(), normals.empty() ? nullptr : normals.data());
+
+		writeVector3(positions, result, VertexAttributeUsage::Position);
+		if (!normals.empty())
+			writeVector3(normals, result, VertexAttributeUsage::Normal);
 	}
 	else
 	{
 		const mat4& ft = finalTransform();
-		copyVector3Transformed(_vertexStorage, result, VertexAttributeUsage::Position, ft);
-		copyVector3Rotated(_vertexStorage, result, VertexAttributeUsage::Normal, ft);
-		copyVector3Rotated(_vertexStorage, result, VertexAttributeUsage::Tangent, ft);
-		copyVector3Rotated(_vertexStorage, result, VertexAttributeUsage::Binormal, ft);
+		copyVector3Transformed(source, result, VertexAttributeUsage::Position, ft);
+		copyVector3Rotated(source, result, VertexAttributeUsage::Normal, ft);
+		copyVector3Rotated(source, result, VertexAttributeUsage::Tangent, ft);
+		copyVector3Rotated(source, result, VertexAttributeUsage::Binormal, ft);
 	}
 	return result;
-	// */
-	return VertexStorage::Pointer();
 }
 
 RayIntersection Mesh::intersectsWorldSpaceRay(const ray3d& ray)
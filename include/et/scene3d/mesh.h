@@ -48,12 +48,19 @@ public:
 	const Vector<mat4>& deformationMatrices();
 
 	bool skinned() const;
-	VertexStorage::Pointer bakeDeformations();
+
+	/*
+	 * Returns copy of the vertex storage with positions and normals deformed on CPU
+	 * (skinned or transformed with final transform)
+	 */
+	VertexStorage::Pointer bakeDeformations(SkinningMethod = SkinningMethod::LinearBlend);
 
 	RayIntersection intersectsWorldSpaceRay(const ray3d& ray) override;
 	
 protected:
 	void transformInvalidated() override;
+
+	VertexStorage::Pointer sourceVertexStorage() const;
 	
 	struct SupportData
 	{
@@ -71,6 +78,8 @@ private:
 	MeshDeformer::Pointer _deformer;
 	SupportData _supportData;
 	Vector<mat4> _undeformedTransformationMatrices;
+	VertexStorage::Pointer _skinningStorage;
+	skinning::SourceData _skinningSource;
 };
 }
 }
@@ -21,7 +21,7 @@ void MeshDeformerCluster::sortWeights()
 const Vector<mat4>& MeshDeformer::calculateTransforms()
 {
 	_transformMatrices.clear();
-	_transformMatrices.reserve(std::min(size_t(4), _clusters.size()));
+	_transformMatrices.reserve(std::max(size_t(4), _clusters.size()));
 	
 	for (auto& cluster : _clusters)
 		_transformMatrices.push_back(cluster->transformMatrix());
@@ -32,7 +32,16 @@ const Vector<mat4>& MeshDeformer::calculateTransforms()
 	return _transformMatrices;
 }
 
+const skinning::Palette& MeshDeformer::calculatePalette(SkinningMethod method)
+{
+	_palette.build(calculateTransforms(), method);
+	return _palette;
+}
+
 mat4 MeshDeformerCluster::transformMatrix()
 {
+	if (_link.invalid())
+		return _meshInitialTransform * _linkInitialTransformInverse;
+
 	return _meshInitialTransform * _linkInitialTransformInverse * _link->finalTransform();
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <et/scene3d/skeletonelement.h>
+#include <et/scene3d/skinning.h>
 
 namespace et
 {
@@ -120,11 +121,20 @@ public:
 		return _clusters;
 	}
 
+	/*
+	 * One matrix per cluster (padded with identity up to four matrices)
+	 */
 	const Vector<mat4>& calculateTransforms();
 
+	/*
+	 * Bone palette for CPU skinning, built from calculateTransforms
+	 */
+	const skinning::Palette& calculatePalette(SkinningMethod);
+
 private:
 	Vector<MeshDeformerCluster::Pointer> _clusters;
 	Vector<mat4> _transformMatrices;
+	skinning::Palette _palette;
 };
 }
 }
@@ -8,6 +8,9 @@
 #include <et/app/application.h>
 #include <et/core/conversion.h>
 #include <et/core/filesystem.h>
+#include <et/core/mappedfile.h>
+#include <et/core/parallel.h>
+#include <et/core/profiler.h>
 #include <et/rendering/base/primitives.h>
 #include <et/rendering/base/material.h>
 #include <et/scene3d/objloader.h>
@@ -43,32 +46,6 @@ inline void splitAndWrite(const std::string& s, F func)
 		func(std::string(pos, begin - pos));
 }
 
-template <typename F>
-inline void splitAndWrite(const std::string& s, char token, F func)
-{
-	if (s.empty()) return;
-	
-	const char* begin = s.data();
-	const char* pos = begin;
-	const char* end = begin + s.size();
-	while (begin < end)
-	{
-		if (*begin == token)
-		{
-			func(std::string(pos, begin - pos));
-			while (*(begin + 1) == token)
-			{
-				func(intToStr(std::numeric_limits<int32_t>::max()));
-				++begin;
-			}
-			pos = begin + 1;
-		}
-		++begin;
-	}
-	if (begin - pos > 0)
-		func(std::string(pos, begin - pos));
-}
-
 inline std::istream& operator >> (std::istream& stream, vec2& value)
 {
 	static std::string ln;
@@ -154,489 +131,510 @@ OBJLoader::~OBJLoader()
 		materialFile.close();
 }
 
-float naive_atof(const char *p) 
+namespace obj
+{
+
+inline bool isDigit(char c)
+{
+	return (c >= '0') && (c <= '9');
+}
+
+inline bool isBlank(char c)
+{
+	return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\v') || (c == '\f');
+}
+
+/*
+ * SWAR digits parsing: checks and converts 8 ASCII digits at once (little-endian load)
+ */
+inline uint64_t loadEightBytes(const char* p)
+{
+	uint64_t value = 0;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+inline bool isEightDigits(uint64_t value)
+{
+	return (((value & 0xF0F0F0F0F0F0F0F0ull) | (((value + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ==
+		0x3333333333333333ull);
+}
+
+inline uint32_t parseEightDigits(uint64_t value)
+{
+	const uint64_t mask = 0x000000FF000000FFull;
+	const uint64_t mul1 = 0x000F424000000064ull; // 100 + (1000000 << 32)
+	const uint64_t mul2 = 0x0000271000000001ull; // 1 + (10000 << 32)
+	value -= 0x3030303030303030ull;
+	value = (value * 10) + (value >> 8);
+	value = (((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32;
+	return static_cast<uint32_t>(value);
+}
+
+const uint32_t maxMantissaDigits = 19;
+
+inline void readDigits(const char*& p, const char* end, uint64_t& mantissa, uint32_t& digits, int32_t& exponent, bool fraction)
+{
+	while ((end - p >= 8) && (digits + 8 <= maxMantissaDigits))
+	{
+		uint64_t block = loadEightBytes(p);
+		if (!isEightDigits(block))
+			break;
+
+		mantissa = mantissa * 100000000ull + parseEightDigits(block);
+		if (mantissa > 0)
+			digits += 8;
+		if (fraction)
+			exponent -= 8;
+		p += 8;
+	}
+
+	while ((p < end) && isDigit(*p))
+	{
+		if (digits < maxMantissaDigits)
+		{
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+			if (mantissa > 0)
+				++digits;
+			if (fraction)
+				--exponent;
+		}
+		else if (!fraction)
+		{
+			++exponent;
+		}
+		++p;
+	}
+}
+
+inline float parseFloat(const char*& p, const char* end)
 {
-	float r = 0.0;
-	bool neg = false;
-	if (*p == '-') {
-		neg = true;
+	static const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	const int32_t maxTablePower = static_cast<int32_t>(sizeof(powersOf10) / sizeof(powersOf10[0])) - 1;
+
+	bool negative = false;
+	if ((p < end) && ((*p == '-') || (*p == '+')))
+	{
+		negative = (*p == '-');
 		++p;
 	}
-	while (*p >= '0' && *p <= '9') 
+
+	uint64_t mantissa = 0;
+	uint32_t digits = 0;
+	int32_t exponent = 0;
+	readDigits(p, end, mantissa, digits, exponent, false);
+
+	if ((p < end) && (*p == '.'))
 	{
-		r = (r * 10.0f) + (*p - '0');
 		++p;
+		readDigits(p, end, mantissa, digits, exponent, true);
 	}
-	if (*p == '.') 
+
+	if ((p < end) && ((*p == 'e') || (*p == 'E')))
 	{
-		float f = 0.0f;
-		int32_t n = 0;
 		++p;
-		while (*p >= '0' && *p <= '9') 
+		bool negativeExponent = false;
+		if ((p < end) && ((*p == '-') || (*p == '+')))
 		{
-			f = (f * 10.0f) + (*p - '0');
+			negativeExponent = (*p == '-');
 			++p;
-			++n;
 		}
-		r += f / std::pow(10.0f, n);
+		int32_t explicitExponent = 0;
+		while ((p < end) && isDigit(*p))
+		{
+			if (explicitExponent < 10000)
+				explicitExponent = explicitExponent * 10 + (*p - '0');
+			++p;
+		}
+		exponent += negativeExponent ? -explicitExponent : explicitExponent;
 	}
-	return neg ? -r : r;
+
+	double value = static_cast<double>(mantissa);
+	if ((exponent >= 0) && (exponent <= maxTablePower))
+		value *= powersOf10[exponent];
+	else if ((exponent < 0) && (exponent >= -maxTablePower))
+		value /= powersOf10[-exponent];
+	else if (mantissa > 0)
+		value *= std::pow(10.0, static_cast<double>(exponent));
+
+	return static_cast<float>(negative ? -value : value);
 }
 
-int64_t naive_atoll(char* ptr)
+inline bool parseInteger(const char*& p, const char* end, int64_t& result)
 {
-	int64_t result = 0;
-	while (*ptr)
+	bool negative = false;
+	if ((p < end) && ((*p == '-') || (*p == '+')))
 	{
-		result = (result * 10) + (*ptr - 48);
-		++ptr;
+		negative = (*p == '-');
+		++p;
 	}
-	return result;
+
+	const char* begin = p;
+	int64_t value = 0;
+	while ((p < end) && isDigit(*p))
+	{
+		value = value * 10 + (*p - '0');
+		++p;
+	}
+
+	result = negative ? -value : value;
+	return p > begin;
 }
 
-void OBJLoader::load(ObjectsCache& cache)
+inline void readFloats(const char* p, const char* end, uint32_t count, float* dst)
 {
+	for (uint32_t i = 0; (i < count) && (p < end); ++i)
+	{
+		while ((p < end) && isBlank(*p))
+			++p;
+		dst[i] = parseFloat(p, end);
+		while ((p < end) && !isBlank(*p))
+			++p;
+	}
+}
+
+}
+
+void OBJLoader::parseChunk(OBJChunk& chunk)
+{
+	ET_PROFILE_SCOPE("OBJLoader::parseChunk");
+
+	bool swapYwithZ = (_loadOptions & Option_SwapYwithZ) == Option_SwapYwithZ;
+
 	uint32_t lineNumber = 0;
+	const char* lineBegin = chunk.begin;
+	while (lineBegin < chunk.end)
+	{
+		const char* lineEnd = reinterpret_cast<const char*>(memchr(lineBegin, '\n', chunk.end - lineBegin));
+		if (lineEnd == nullptr)
+			lineEnd = chunk.end;
 
-	auto trimWhitespace = [](char* begin, char* end) -> char* {
-		
-		while (isWhitespaceChar(*begin))
+		++lineNumber;
+
+		const char* begin = lineBegin;
+		const char* end = lineEnd;
+		lineBegin = lineEnd + 1;
+
+		while ((begin < end) && obj::isBlank(*begin))
 			++begin;
 
-		while ((end > begin) && (isWhitespaceChar(*(end - 1)))) {
-			*(end - 1) = 0;
+		while ((end > begin) && obj::isBlank(*(end - 1)))
 			--end;
-		}
 
-		return begin;
-	};
+		if ((begin == end) || (*begin == '#'))
+			continue;
 
-	auto readFloats = [](char* line, char* end, uint32_t count, float* dst) {
-		uint32_t floatsRead = 0;
-		char* begin = line;
-		while ((floatsRead < count) && (begin < end))
+		const char* keyEnd = begin;
+		while ((keyEnd < end) && !obj::isBlank(*keyEnd))
+			++keyEnd;
+
+		const char* value = keyEnd;
+		while ((value < end) && obj::isBlank(*value))
+			++value;
+
+		size_t keyLength = keyEnd - begin;
+		auto keyIs = [begin, keyLength](const char* k)
 		{
-			char* token = begin;
-			while (!isWhitespaceChar(*token))
-				++token;
-			
-			char tokenValue = *token;
+			return (strlen(k) == keyLength) && (strncmp(begin, k, keyLength) == 0);
+		};
 
-			*token = 0;
-			dst[floatsRead] = naive_atof(begin);
-			*token = tokenValue;
+		auto addCommand = [&chunk, value, end](OBJChunk::Command::Type type)
+		{
+			chunk.commands.emplace_back();
+			chunk.commands.back().type = type;
+			chunk.commands.back().firstFace = static_cast<uint32_t>(chunk.faces.size());
+			chunk.commands.back().value.assign(value, end);
+		};
 
-			begin = token + 1;
-			++floatsRead;
+		if (keyIs("v"))
+		{
+			chunk.vertices.emplace_back();
+			obj::readFloats(value, end, 3, chunk.vertices.back().data());
+
+			if (swapYwithZ)
+				std::swap(chunk.vertices.back().y, chunk.vertices.back().z);
 		}
-	};
+		else if (keyIs("vn"))
+		{
+			chunk.normals.emplace_back();
+			obj::readFloats(value, end, 3, chunk.normals.back().data());
 
-	const uint32_t BufferSize = 256 * 1024;
-	char localBuffer[BufferSize + 3] = { };
+			if (swapYwithZ)
+				std::swap(chunk.normals.back().y, chunk.normals.back().z);
+		}
+		else if (keyIs("vt"))
+		{
+			chunk.texCoords.emplace_back();
+			obj::readFloats(value, end, 2, chunk.texCoords.back().data());
+		}
+		else if (keyIs("f"))
+		{
+			const int64_t localCounts[] = { static_cast<int64_t>(chunk.vertices.size()),
+				static_cast<int64_t>(chunk.texCoords.size()), static_cast<int64_t>(chunk.normals.size()) };
 
-	intptr_t readOffset = 0;
-	intptr_t charactersRead = 0;
-	do 
-	{
-		inputFile.read(localBuffer + readOffset, BufferSize - readOffset);
-		charactersRead = inputFile.gcount();
+			chunk.faces.emplace_back();
+			OBJFace& face = chunk.faces.back();
+			face.vertexLinks.fill(0);
 
-		intptr_t currentBufferLength = readOffset + charactersRead;
-		if (currentBufferLength > 0)
-		{
-			localBuffer[readOffset + charactersRead] = 0;
-			readOffset = 0;
+			size_t firstRelativeLink = chunk.relativeLinks.size();
+			bool validFace = true;
 
-			char* begin = localBuffer;
-			char* end = begin;
-			while ((end - localBuffer) < currentBufferLength)
+			const char* p = value;
+			while (p < end)
 			{
-				end = begin;
-				while ((*end != 0) && (*end != '\n'))
-					++end;
+				ET_ASSERT(face.vertexLinksCount < OBJFace::MaxVertexLinks);
+				if (face.vertexLinksCount >= OBJFace::MaxVertexLinks)
+					break;
 
-				if ((*end == '\n') || ((*end == 0) && inputFile.eof()))
+				uint32_t linkIndex = 0;
+				while ((p < end) && !obj::isBlank(*p))
 				{
-					*end = 0;
+					int64_t linkValue = 0;
+					if (obj::parseInteger(p, end, linkValue) && (linkIndex < OBJFace::MaxVertexSize))
 					{
-						++lineNumber;
-
-						char* line_begin = begin;
-						char* local_end = end;
-						char* local_begin = trimWhitespace(line_begin, local_end);
-						if ((*local_begin == '#') || ((local_end - local_begin) == 0))
+						if (linkValue < 0)
 						{
-							begin = end + 1;
-							continue;
+							OBJChunk::RelativeLink relative;
+							relative.face = static_cast<uint32_t>(chunk.faces.size() - 1);
+							relative.vertex = face.vertexLinksCount;
+							relative.component = linkIndex;
+							relative.localIndex = localCounts[std::min(linkIndex, 2u)] + linkValue;
+							chunk.relativeLinks.emplace_back(relative);
 						}
-						
-						char* keyEnd = local_begin;
-						while (!isWhitespaceChar(*keyEnd))
-							++keyEnd;
-
-						char* key = local_begin;
-						*keyEnd = 0;
-
-						char* local_value = trimWhitespace(keyEnd + 1, local_end);
-
-						bool recognized = true;
-						switch (*key)
-						{
-						case 'm':
+						else if (linkValue > 0)
 						{
-							if (strcmp(key, "mtllib") == 0)
-							{
-								loadMaterials(std::string(local_value, local_end - local_value), cache);
-							}
-							else
-							{
-								recognized = false;
-							}
-							break;
-						}
-						case 'g':
-						{
-							_groups.emplace_back(local_value, _lastUsedMaterial, _sizeEstimate);
-							break;
-						}
-						case 'u':
-						{
-							if (strcmp(key, "usemtl") == 0)
-							{
-								bool addGroup = _groups.empty() ||
-									((strlen(_groups.back().material) > 0) && (strcmp(_groups.back().material, local_value) != 0));
-
-								if (addGroup)
-								{
-									char buffer[OBJGroup::MaxGroupName] = {};
-									sprintf(buffer, "group-%u-%s", static_cast<uint32_t>(_groups.size()), local_value);
-									_groups.emplace_back(buffer, local_value, _sizeEstimate);
-								}
-								else
-								{
-									size_t stringSize = std::min(static_cast<size_t>(OBJGroup::MaxMaterialName), strlen(local_value) + 1);
-									strncpy(_groups.back().material, local_value, stringSize);
-								}
-
-								memset(_lastUsedMaterial, 0, sizeof(_lastUsedMaterial));
-								strcpy(_lastUsedMaterial, local_value);
-							}
-							else
-							{
-								recognized = false;
-							}
-							break;
+							face.vertexLinks[face.vertexLinksCount][linkIndex] = static_cast<uint32_t>(linkValue - 1);
 						}
-						case 'v':
+						else
 						{
-							switch (*(key + 1))
-							{
-							case 0:
-							{
-								_vertices.emplace_back();
-								readFloats(local_value, local_end, 3, _vertices.back().data());
-								break;
-							}
-							case 'n':
-							{
-								_normals.emplace_back();
-								readFloats(local_value, local_end, 3, _normals.back().data());
-								break;
-							}
-							case 't':
-							{
-								_texCoords.emplace_back();
-								readFloats(local_value, local_end, 2, _texCoords.back().data());
-								break;
-							}
-							default:
-								recognized = false;
-							}
-							break;
+							validFace = false;
 						}
-						case 'f':
-						{
-							if (_groups.empty())
-							{
-								char buffer[OBJGroup::MaxGroupName] = {};
-								sprintf(buffer, "group-%u", static_cast<uint32_t>(_groups.size()));
-								_groups.emplace_back(buffer, _sizeEstimate);
-							}
+					}
 
-							_groups.back().faces.emplace_back();
-							OBJFace& face = _groups.back().faces.back();
+					if ((p < end) && (*p == '/'))
+						++linkIndex;
+					else
+						while ((p < end) && !obj::isBlank(*p))
+							++p;
 
-							while (local_value < local_end)
-							{
-								char* valueEnd = local_value;
-								while ((valueEnd < local_end) && !isWhitespaceChar(*valueEnd))
-									++valueEnd;
-
-								char valueKey = *valueEnd;
-								*valueEnd = 0;
-
-								char* link = local_value;
-								char* linkEnd = link;
-
-								uint32_t linkIndex = 0;
-								while (link < valueEnd)
-								{
-									char endValue = *linkEnd;
-									if ((endValue == '/') || (endValue == 0))
-									{
-										*linkEnd = 0;
-
-										if (linkEnd > link)
-										{
-											int64_t linkValue = naive_atoll(link);
-											ET_ASSERT(linkValue > 0);
-											ET_ASSERT(face.vertexLinksCount < OBJFace::MaxVertexLinks);
-
-											face.vertexLinks[face.vertexLinksCount][linkIndex] = static_cast<uint32_t>(linkValue - 1);
-											*linkEnd = endValue;
-										}
-										++linkIndex;
-
-										link = linkEnd + 1;
-									}
-									++linkEnd;
-								}
-
-								++face.vertexLinksCount;
-
-								*valueEnd = valueKey;
-								local_value = valueEnd + 1;
-							}
-							break;
-						}
-						case 's':
-						case 'o':
-							break;
+					if ((p < end) && (*p == '/'))
+						++p;
+				}
 
-						default:
-							recognized = false;
-							break;
-						}
+				++face.vertexLinksCount;
 
-						if (!recognized)
-						{
-							log::warning("Unsupported entry `%s` in OBJ file at line %u", key, lineNumber);
-						}
-					}
-					begin = end + 1;
-				}
-				else
-				{
-					readOffset = end - begin;
-					memmove(localBuffer, begin, readOffset);
-				}
+				while ((p < end) && obj::isBlank(*p))
+					++p;
 			}
-		}
-	} while (charactersRead > 0);
-}
 
-void OBJLoader::loadData(ObjectsCache& cache)
-{
-	std::string line;
-	uint32_t lineNumber = 0;
-	char key = 0;
-	while (inputFile.is_open() && !inputFile.eof())
-	{
-		++lineNumber;
-		inputFile >> key;
-		
-		if (inputFile.eof()) 
-			break;
-		
-		key = static_cast<char>(tolower(key));
-		
-		if (key == '#')
-		{
-			getLine(inputFile, line);
-		}
-		else if (key == 'm') // mtllib
-		{
-			std::string mtllib;
-			inputFile >> mtllib;
-			lowercase(mtllib);
-			
-			if (mtllib.compare("tllib") == 0)
-			{
-				std::string matName;
-				inputFile >> matName;
-				loadMaterials(matName, cache);
-			}
-			else
+			// indices in OBJ start from 1, zero index is not valid
+			if (!validFace)
 			{
-				std::cout << "Unresolved symbol: " << key << mtllib << std::endl;
+				chunk.relativeLinks.resize(firstRelativeLink);
+				chunk.faces.pop_back();
+				chunk.invalidFaces.emplace_back(lineNumber);
 			}
 		}
-		else if (key == 'o') // object, ignored for now
+		else if (keyIs("g"))
 		{
-			getLine(inputFile, line);
+			addCommand(OBJChunk::Command::Group);
 		}
-		else if (key == 'g') // group
+		else if (keyIs("usemtl"))
 		{
-			getLine(inputFile, line);
-			trim(line);
-			
-			if (!_groups.empty())
-			{
-				_groups.back().faces.shrink_to_fit();
-			}
-
-            _groups.emplace_back(line, _sizeEstimate);
+			addCommand(OBJChunk::Command::UseMaterial);
 		}
-		else if (key == 'u') // group's material
+		else if (keyIs("mtllib"))
 		{
-			std::string usemtl;
-			inputFile >> usemtl;
-			lowercase(usemtl);
-			
-			if (usemtl.compare("semtl") == 0) 
-			{
-				std::string materialId;
-				inputFile >> materialId;
-				
-                if (_groups.empty())
-                {
-                    auto groupName = "group-" + intToStr(_lastGroupId++) + "-" + materialId;
-					_groups.emplace_back(groupName, materialId, static_cast<uint32_t>(_sizeEstimate));
-                }
-                else if ((strlen(_groups.back().material) == 0) || _groups.back().material == materialId)
-                {
-					size_t stringSize = std::min(static_cast<size_t>(OBJGroup::MaxMaterialName), materialId.size());
-					strncpy(_groups.back().material, materialId.c_str(), stringSize);
-                }
-				getLine(inputFile, line);
-			}
-			else
-			{
-				std::cout << "Unresolved symbol " << key << usemtl << ". Current group: " << _groups.back().name << std::endl;
-			}
+			addCommand(OBJChunk::Command::MaterialLibrary);
 		}
-		else if (key == 's') // smoothing group
+		else if (!keyIs("s") && !keyIs("o"))
 		{
-            if (_groups.empty())
-            {
-                _groups.emplace_back("group-" + intToStr(_lastGroupId++), _sizeEstimate);
-            }
-			getLine(inputFile, line);
-			_lastSmoothGroup = (line.compare("off") == 0) ? 0 : strToInt(line);
+			chunk.unsupportedEntries.emplace_back(lineNumber, std::string(begin, keyEnd));
 		}
-		else if (key == 'f') // faces
-		{
-			OBJFace face;
-			std::getline(inputFile, line);
-			trim(line);
-			
-			static StringList faces;
-			faces.reserve(5);
-			faces.clear();
+	}
+	chunk.linesCount = lineNumber;
+}
 
-			splitAndWrite(line, ' ', [](const std::string& s) {
-				faces.emplace_back(s);
-			});
-			ET_ASSERT((faces.size() > 2) && (faces.size() < OBJFace::MaxVertexLinks));
+void OBJLoader::appendFaces(const OBJChunk& chunk, uint32_t begin, uint32_t end)
+{
+	if (begin >= end)
+		return;
 
-			for (auto inFace : faces)
-			{
-				static Vector<int32_t> indexes;
-				indexes.reserve(3);
-				indexes.clear();
+	if (_groups.empty())
+	{
+		char buffer[OBJGroup::MaxGroupName] = {};
+		sprintf(buffer, "group-%u", static_cast<uint32_t>(_groups.size()));
+		_groups.emplace_back(buffer, _sizeEstimate);
+	}
 
-				splitAndWrite(inFace, '/', [](const std::string& s)
-					{ indexes.push_back(strToInt(s)); });
+	std::vector<OBJFace>& faces = _groups.back().faces;
+	faces.insert(faces.end(), chunk.faces.begin() + begin, chunk.faces.begin() + end);
+}
 
-				uint32_t i = 0;
-				face.vertexLinks[face.vertexLinksCount].fill(0);
-				for (auto iValue : indexes)
-				{
-					if (iValue == std::numeric_limits<int32_t>::max())
-					{
-					}
-					else if (iValue < 0)
-					{
-						uint32_t szValue = static_cast<uint32_t>(-iValue);
-						if (i == 0)
-						{
-							ET_ASSERT(szValue <= _vertices.size());
-							face.vertexLinks[face.vertexLinksCount][i] = static_cast<uint32_t>(_vertices.size() - szValue);
-						}
-						else if (i == 1)
-						{
-							ET_ASSERT(szValue <= _texCoords.size());
-							face.vertexLinks[face.vertexLinksCount][i] = static_cast<uint32_t>(_texCoords.size() - szValue);
-						}
-						else if (i == 2)
-						{
-							ET_ASSERT(szValue <= _normals.size());
-							face.vertexLinks[face.vertexLinksCount][i] = static_cast<uint32_t>(_normals.size() - szValue);
-						}
-					}
-					else
-					{
-						face.vertexLinks[face.vertexLinksCount][i] = iValue - 1;
-					}
-					++i;
-				}
-				
-				++face.vertexLinksCount;
-			}
-			
-			if (_groups.empty())
+void OBJLoader::mergeChunks(std::vector<OBJChunk>& chunks, ObjectsCache& cache)
+{
+	ET_PROFILE_SCOPE("OBJLoader::mergeChunks");
+
+	/*
+	 * Prefix sums of per-chunk counts give the offset of each chunk in the final arrays
+	 */
+	size_t chunksCount = chunks.size();
+	std::vector<size_t> vertexOffsets(chunksCount + 1, 0);
+	std::vector<size_t> texCoordOffsets(chunksCount + 1, 0);
+	std::vector<size_t> normalOffsets(chunksCount + 1, 0);
+	for (size_t i = 0; i < chunksCount; ++i)
+	{
+		vertexOffsets[i + 1] = vertexOffsets[i] + chunks[i].vertices.size();
+		texCoordOffsets[i + 1] = texCoordOffsets[i] + chunks[i].texCoords.size();
+		normalOffsets[i + 1] = normalOffsets[i] + chunks[i].normals.size();
+	}
+
+	size_t baseVertex = _vertices.size();
+	size_t baseTexCoord = _texCoords.size();
+	size_t baseNormal = _normals.size();
+	_vertices.resize(baseVertex + vertexOffsets.back());
+	_texCoords.resize(baseTexCoord + texCoordOffsets.back());
+	_normals.resize(baseNormal + normalOffsets.back());
+
+	parallel::forRange(static_cast<uint32_t>(chunksCount), 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			OBJChunk& chunk = chunks[i];
+			std::copy(chunk.vertices.begin(), chunk.vertices.end(), _vertices.begin() + baseVertex + vertexOffsets[i]);
+			std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), _texCoords.begin() + baseTexCoord + texCoordOffsets[i]);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), _normals.begin() + baseNormal + normalOffsets[i]);
+
+			const int64_t chunkOffsets[] = { static_cast<int64_t>(baseVertex + vertexOffsets[i]),
+				static_cast<int64_t>(baseTexCoord + texCoordOffsets[i]), static_cast<int64_t>(baseNormal + normalOffsets[i]) };
+
+			for (const OBJChunk::RelativeLink& link : chunk.relativeLinks)
 			{
-                _groups.emplace_back("group-" + intToStr(_lastGroupId++), _sizeEstimate);
+				int64_t index = chunkOffsets[std::min(link.component, 2u)] + link.localIndex;
+				ET_ASSERT(index >= 0);
+				chunk.faces[link.face].vertexLinks[link.vertex][link.component] = static_cast<uint32_t>(std::max(int64_t(0), index));
 			}
-			
-			_groups.back().faces.push_back(face);
+
+			std::vector<et::vec3>().swap(chunk.vertices);
+			std::vector<et::vec2>().swap(chunk.texCoords);
+			std::vector<et::vec3>().swap(chunk.normals);
 		}
-		else if (key == 'v')
+	});
+
+	/*
+	 * Groups and materials depend on the order of commands, so they are replayed sequentially
+	 */
+	uint32_t lineNumber = 0;
+	for (const OBJChunk& chunk : chunks)
+	{
+		uint32_t firstFace = 0;
+		for (const OBJChunk::Command& command : chunk.commands)
 		{
-			char subKey = static_cast<char>(inputFile.peek());
-			
-			if (subKey == 't')
+			appendFaces(chunk, firstFace, command.firstFace);
+			firstFace = command.firstFace;
+
+			const char* value = command.value.c_str();
+			switch (command.type)
 			{
-				vec2 vertex(0.0f);
-				inputFile >> subKey >> vertex;
-				_texCoords.push_back(vertex);
-			}
-			else if (subKey == 'n')
+			case OBJChunk::Command::Group:
 			{
-				vec3 vertex(0.0f);
-				inputFile >> subKey >> vertex;
-
-				if ((_loadOptions & Option_SwapYwithZ) == Option_SwapYwithZ)
-					std::swap(vertex.y, vertex.z);
-
-				_normals.push_back(vertex);
+				_groups.emplace_back(value, _lastUsedMaterial, _sizeEstimate);
+				break;
 			}
-			else if (isWhitespaceChar(subKey))
+			case OBJChunk::Command::UseMaterial:
 			{
-				vec3 vertex(0.0f);
-				inputFile >> vertex;
+				bool addGroup = _groups.empty() ||
+					((strlen(_groups.back().material) > 0) && (strcmp(_groups.back().material, value) != 0));
 
-				if ((_loadOptions & Option_SwapYwithZ) == Option_SwapYwithZ)
-					std::swap(vertex.y, vertex.z);
+				if (addGroup)
+				{
+					char buffer[OBJGroup::MaxGroupName] = {};
+					snprintf(buffer, sizeof(buffer), "group-%u-%s", static_cast<uint32_t>(_groups.size()), value);
+					_groups.emplace_back(buffer, value, _sizeEstimate);
+				}
+				else
+				{
+					size_t stringSize = std::min(static_cast<size_t>(OBJGroup::MaxMaterialName), strlen(value) + 1);
+					strncpy(_groups.back().material, value, stringSize);
+				}
 
-				_vertices.push_back(vertex);
+				memset(_lastUsedMaterial, 0, sizeof(_lastUsedMaterial));
+				strncpy(_lastUsedMaterial, value, sizeof(_lastUsedMaterial) - 1);
+				break;
 			}
-			else
+			case OBJChunk::Command::MaterialLibrary:
 			{
-				getLine(inputFile, line);
-				log::warning("Unknown line [%u] `%s`", lineNumber, line.c_str());
+				loadMaterials(command.value, cache);
+				break;
+			}
+			default:
+				ET_FAIL("Invalid OBJ command");
 			}
 		}
-		else
+		appendFaces(chunk, firstFace, static_cast<uint32_t>(chunk.faces.size()));
+
+		for (const auto& entry : chunk.unsupportedEntries)
+			log::warning("Unsupported entry `%s` in OBJ file at line %u", entry.second.c_str(), lineNumber + entry.first);
+
+		for (uint32_t faceLine : chunk.invalidFaces)
+			log::warning("Face with zero index in OBJ file at line %u is skipped", lineNumber + faceLine);
+
+		lineNumber += chunk.linesCount;
+	}
+}
+
+/*
+ * File is memory mapped and split into chunks at line boundaries, chunks are parsed in parallel
+ * into their own arrays and then merged, negative face indices are resolved using chunk offsets
+ */
+void OBJLoader::load(ObjectsCache& cache)
+{
+	const uint64_t minChunkSize = 256 * 1024;
+
+	MappedFile file(inputFileName);
+	if (!file.valid())
+	{
+		log::error("Unable to map OBJ file %s", inputFileName.c_str());
+		return;
+	}
+
+	const char* fileBegin = reinterpret_cast<const char*>(file.data());
+	const char* fileEnd = fileBegin + file.size();
+
+	uint64_t desiredChunksCount = std::max(uint64_t(1), file.size() / minChunkSize);
+	uint64_t chunkSize = file.size() / std::min(desiredChunksCount, uint64_t(4) * parallel::workersCount());
+
+	std::vector<OBJChunk> chunks;
+	const char* chunkBegin = fileBegin;
+	while (chunkBegin < fileEnd)
+	{
+		const char* chunkEnd = fileEnd;
+		if (static_cast<uint64_t>(fileEnd - chunkBegin) > chunkSize)
 		{
-			getLine(inputFile, line);
-			log::warning("Unknown line [%u] `%c%s`", lineNumber, key, line.c_str());
+			const char* lineEnd = reinterpret_cast<const char*>(memchr(chunkBegin + chunkSize, '\n', fileEnd - chunkBegin - chunkSize));
+			chunkEnd = (lineEnd == nullptr) ? fileEnd : lineEnd + 1;
 		}
+		chunks.emplace_back();
+		chunks.back().begin = chunkBegin;
+		chunks.back().end = chunkEnd;
+		chunkBegin = chunkEnd;
 	}
+
+	parallel::forRange(static_cast<uint32_t>(chunks.size()), 1, [this, &chunks](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+			parseChunk(chunks[i]);
+	});
+
+	mergeChunks(chunks, cache);
 }
 
 s3d::ElementContainer::Pointer OBJLoader::load(et::RenderInterface::Pointer ren, s3d::Storage& storage, ObjectsCache& cache)
 {
+	ET_PROFILE_SCOPE("OBJLoader::load");
+	MemoryTagScope memoryTag(MemoryTag::Scene);
+
 	storage.flush();
 
 	bool cacheLoaded = false;
@@ -648,16 +646,13 @@ s3d::ElementContainer::Pointer OBJLoader::load(et::RenderInterface::Pointer ren,
 	if (cacheLoaded == false)
 	{
 		uint64_t fileSize = streamSize(inputFile);
-		_sizeEstimate = std::max(1024llu, fileSize / 128);
+		_sizeEstimate = std::max(uint64_t(1024), fileSize / 128);
 		log::info("Loading OBJ, estimated array sizes: %llu", _sizeEstimate);
 
 		_renderer = ren;
 		_groups.reserve(128);
-		_vertices.reserve(_sizeEstimate);
-		_normals.reserve(_sizeEstimate);
-		_texCoords.reserve(_sizeEstimate);
 
-		_sizeEstimate = std::max(128llu, _sizeEstimate / 2048);
+		_sizeEstimate = std::max(uint64_t(128), _sizeEstimate / 2048);
 		log::info("Loading OBJ, estimated face array sizes: %llu", _sizeEstimate);
 
 		uint64_t t1 = queryCurrentTimeInMicroSeconds();
@@ -683,6 +678,8 @@ s3d::ElementContainer::Pointer OBJLoader::load(et::RenderInterface::Pointer ren,
 
 void OBJLoader::loadMaterials(const std::string& fileName, ObjectsCache& cache)
 {
+	ET_PROFILE_SCOPE("OBJLoader::loadMaterials");
+
 	application().pushSearchPath(inputFilePath);
 	std::string filePath = application().resolveFileName(fileName);
 	application().popSearchPaths();
@@ -1051,6 +1048,8 @@ void OBJLoader::loadMaterials(const std::string& fileName, ObjectsCache& cache)
 }
 
 void OBJLoader::processLoadedData() {
+	ET_PROFILE_SCOPE("OBJLoader::processLoadedData");
+
 	uint32_t totalTriangles = 0;
 
 	for (const OBJGroup& group : _groups)
@@ -1195,6 +1194,8 @@ void OBJLoader::processLoadedData() {
 
 s3d::ElementContainer::Pointer OBJLoader::generateVertexBuffers(s3d::Storage& storage)
 {
+	ET_PROFILE_SCOPE("OBJLoader::generateVertexBuffers");
+
 	s3d::ElementContainer::Pointer result = s3d::ElementContainer::Pointer::create(inputFileName, nullptr);
 
 	storage.flush();
@@ -108,9 +108,54 @@ private:
 		}
 	};
 
+	/*
+	 * Part of the file (split at line boundary), parsed independently from other chunks
+	 */
+	struct OBJChunk
+	{
+		struct Command
+		{
+			enum Type : uint32_t
+			{
+				Group,
+				UseMaterial,
+				MaterialLibrary,
+			};
+			Type type = Group;
+			uint32_t firstFace = 0;
+			std::string value;
+		};
+
+		/*
+		 * Negative (relative) index, resolved after all chunks are parsed,
+		 * localIndex is relative to the first element of the chunk and could be negative
+		 */
+		struct RelativeLink
+		{
+			uint32_t face = 0;
+			uint32_t vertex = 0;
+			uint32_t component = 0;
+			int64_t localIndex = 0;
+		};
+
+		const char* begin = nullptr;
+		const char* end = nullptr;
+		std::vector<et::vec3> vertices;
+		std::vector<et::vec3> normals;
+		std::vector<et::vec2> texCoords;
+		std::vector<OBJFace> faces;
+		std::vector<Command> commands;
+		std::vector<RelativeLink> relativeLinks;
+		std::vector<std::pair<uint32_t, std::string>> unsupportedEntries;
+		std::vector<uint32_t> invalidFaces;
+		uint32_t linesCount = 0;
+	};
+
 private:
-	void loadData(ObjectsCache& cache);
 	void load(ObjectsCache& cache);
+	void parseChunk(OBJChunk&);
+	void mergeChunks(std::vector<OBJChunk>&, ObjectsCache&);
+	void appendFaces(const OBJChunk&, uint32_t begin, uint32_t end);
 	
 	bool loadCached(const std::string& fileName);
 	void saveCache(const std::string& fileName);
@@ -147,7 +192,5 @@ private:
 
 	uint32_t _loadOptions = Option_JustLoad;
 	uint64_t _sizeEstimate = 1024;
-	int _lastSmoothGroup = 0;
-	int _lastGroupId = 0;
 };
 }
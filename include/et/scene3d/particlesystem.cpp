@@ -28,9 +28,8 @@ ParticleSystem::ParticleSystem(RenderInterface::Pointer& rc, uint32_t maxSize, c
 	auto clr = vs->accessData<DataType::Vec4>(VertexAttributeUsage::Color, 0);
 	for (uint32_t i = 0; i < pos.size(); ++i)
 	{
-		const auto& p = _emitter.particle(i);
-		pos[i] = p.position;
-		clr[i] = p.color;
+		pos[i] = vec3(0.0f);
+		clr[i] = vec4(0.0f);
 	}
 	ia->linearize(maxSize);
 
@@ -62,15 +61,7 @@ void ParticleSystem::onTimerUpdated(NotifyTimer* timer)
 
 	auto posOffset = _decl.elementForUsage(VertexAttributeUsage::Position).offset();
 	auto clrOffset = _decl.elementForUsage(VertexAttributeUsage::Color).offset();
-	
-	RawDataAcessor<vec3> pos(reinterpret_cast<char*>(bufferData), _capacity, _decl.sizeInBytes(), posOffset);
-	RawDataAcessor<vec4> clr(reinterpret_cast<char*>(bufferData), _capacity + clrOffset, _decl.sizeInBytes(), clrOffset);
-	
-	for (uint32_t i = 0; i < _emitter.activeParticlesCount(); ++i)
-	{
-		const auto& p = _emitter.particle(i);
-		pos[i] = p.position;
-		clr[i] = p.color;
-	}
+
+	_emitter.writeVertices(reinterpret_cast<char*>(bufferData), _decl.sizeInBytes(), posOffset, clrOffset);
 	_vertexStream->vertexBuffer()->unmap();
 }
@@ -47,12 +47,12 @@ public:
 		return _emitter.activeParticlesCount();
 	}
 
-	particles::PointSpriteEmitter& emitter()
+	particles::PointSpriteBatchEmitter& emitter()
 	{
 		return _emitter;
 	}
 
-	const particles::PointSpriteEmitter& emitter() const
+	const particles::PointSpriteBatchEmitter& emitter() const
 	{
 		return _emitter;
 	}
@@ -63,11 +63,17 @@ public:
 		_emitter.setUpdateFunction(func);
 	}
 
+	template <typename F>
+	void setVariationFunction(const F& func)
+	{
+		_emitter.setVariationFunction(func);
+	}
+
 private:
 	void onTimerUpdated(NotifyTimer*);
 
 private:
-	particles::PointSpriteEmitter _emitter;
+	particles::PointSpriteBatchEmitter _emitter;
 	VertexStream::Pointer _vertexStream;
 	VertexDeclaration _decl;
 	NotifyTimer _timer;
@@ -6,6 +6,8 @@
  */
 
 #include <et/app/application.h>
+#include <et/core/parallel.h>
+#include <et/geometry/vector4-simd.h>
 #include <et/rendering/rendercontext.h>
 #include <et/scene3d/scene3d.h>
 #include <et/scene3d/serialization.h>
@@ -73,3 +75,123 @@ void Scene::cleanupGeometry()
 
 	_storage.flush();
 }
+
+void Scene::sampleAll(float time, bool useWorkerThreads)
+{
+	updateFlattenedHierarchy();
+
+	_animatedElements.clear();
+	for (BaseElement* element : _flattened.elements)
+	{
+		if (element->hasAnimations())
+			_animatedElements.push_back(element);
+	}
+
+	uint32_t elementsCount = static_cast<uint32_t>(_animatedElements.size());
+	auto sampleRange = [this, time](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+			_animatedElements[i]->sampleAnimation(time);
+	};
+
+	if (useWorkerThreads)
+		parallel::forRange(elementsCount, parallel::suggestedGrain(elementsCount, 64), sampleRange);
+	else
+		sampleRange(0, elementsCount);
+
+	invalidateTransform();
+}
+
+void Scene::updateFlattenedHierarchy()
+{
+	uint64_t currentVersion = BaseElement::hierarchyVersion();
+	if (_flattened.version == currentVersion)
+		return;
+
+	_flattened.version = currentVersion;
+	_flattened.elements.clear();
+	_flattened.parents.clear();
+	_flattened.elementsOfType.clear();
+
+	// depth-first pre-order, so parent is always stored before its children
+	Vector<std::pair<BaseElement*, int32_t>> stack(1, std::make_pair(this, -1));
+	while (!stack.empty())
+	{
+		BaseElement* element = stack.back().first;
+		int32_t parentIndex = stack.back().second;
+		stack.pop_back();
+
+		int32_t elementIndex = static_cast<int32_t>(_flattened.elements.size());
+		_flattened.elements.push_back(element);
+		_flattened.parents.push_back(parentIndex);
+
+		const BaseElement::List& children = element->children();
+		for (auto i = children.rbegin(), e = children.rend(); i != e; ++i)
+			stack.emplace_back(const_cast<BaseElement*>(i->pointer()), elementIndex);
+	}
+	_flattened.dirty.resize(_flattened.elements.size());
+}
+
+inline void multiplyMatrices(const mat4& l, const mat4& r, mat4& result)
+{
+	vec4simd r0(r[0]);
+	vec4simd r1(r[1]);
+	vec4simd r2(r[2]);
+	vec4simd r3(r[3]);
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		vec4simd row = r0 * l[i].x;
+		row.addMultiplied(r1, l[i].y);
+		row.addMultiplied(r2, l[i].z);
+		row.addMultiplied(r3, l[i].w);
+		row.loadToVec4(result[i]);
+	}
+}
+
+void Scene::updateTransforms()
+{
+	updateFlattenedHierarchy();
+
+	BaseElement** elements = _flattened.elements.data();
+	const int32_t* parents = _flattened.parents.data();
+	uint8_t* dirty = _flattened.dirty.data();
+
+	for (size_t i = 0, e = _flattened.elements.size(); i < e; ++i)
+	{
+		BaseElement* element = elements[i];
+		int32_t parentIndex = parents[i];
+
+		dirty[i] = (!element->_finalTransformValid || ((parentIndex >= 0) && dirty[parentIndex])) ? 1 : 0;
+		if (dirty[i] == 0)
+			continue;
+
+		if (parentIndex < 0)
+		{
+			element->buildTransform();
+		}
+		else
+		{
+			multiplyMatrices(element->localTransform(), elements[parentIndex]->_cachedFinalTransform,
+				element->_cachedFinalTransform);
+			element->_finalTransformValid = true;
+			element->_finalInverseTransformValid = false;
+		}
+	}
+}
+
+const Vector<BaseElement*>& Scene::elementsOfType(ElementType type)
+{
+	updateFlattenedHierarchy();
+
+	auto i = _flattened.elementsOfType.find(type);
+	if (i != _flattened.elementsOfType.end())
+		return i->second;
+
+	Vector<BaseElement*>& result = _flattened.elementsOfType[type];
+	for (size_t j = 1, e = _flattened.elements.size(); j < e; ++j)
+	{
+		if (_flattened.elements[j]->isKindOf(type))
+			result.push_back(_flattened.elements[j]);
+	}
+	return result;
+}
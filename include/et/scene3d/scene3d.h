@@ -53,11 +53,30 @@ public:
 	void setClipCamera(const Camera::Pointer& cam)
 		{ _clipCamera = cam; }
 
+	/*
+	 * Evaluates animations of all elements in one pass (optionally on worker threads)
+	 * and invalidates transforms once, time is used as in setAnimationTimeRecursive
+	 */
+	void sampleAll(float time, bool useWorkerThreads = true);
+
+	/*
+	 * Updates final transforms of all changed elements in one linear pass
+	 * over elements stored in parent-first order
+	 */
+	void updateTransforms();
+
+	/*
+	 * Cached list of elements of given type (excluding scene itself),
+	 * rebuilt only after the hierarchy was changed
+	 */
+	const Vector<BaseElement*>& elementsOfType(ElementType);
+
 public:
 	ET_DECLARE_EVENT1(deserializationFinished, bool);
 
 private:
 	void cleanupGeometry();
+	void updateFlattenedHierarchy();
 
 	BaseElement::Pointer createElementOfType(ElementType, BaseElement*) override;
 	IndexArray::Pointer indexArrayWithName(const std::string&) override;
@@ -71,6 +90,16 @@ private:
 	std::string _serializationBasePath;
 	Camera::Pointer _renderCamera;
 	Camera::Pointer _clipCamera;
+	Vector<BaseElement*> _animatedElements;
+
+	struct FlattenedHierarchy
+	{
+		Vector<BaseElement*> elements;
+		Vector<int32_t> parents;
+		Vector<uint8_t> dirty;
+		Map<ElementType, Vector<BaseElement*>> elementsOfType;
+		uint64_t version = std::numeric_limits<uint64_t>::max();
+	} _flattened;
 };
 }
 }
@@ -0,0 +1,283 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/parallel.h>
+#include <et/geometry/vector4-simd.h>
+#include <et/scene3d/meshdeformer.h>
+#include <et/scene3d/skinning.h>
+
+namespace et {
+namespace s3d {
+namespace skinning {
+
+void matrixToDualQuaternion(const mat4& m, vec4& real, vec4& dual) {
+	// engine matrices transform row vectors, so rotation in column form is transposed upper 3x3
+	vec3 r0 = normalize(m[0].xyz());
+	vec3 r1 = normalize(m[1].xyz());
+	vec3 r2 = normalize(m[2].xyz());
+	float trace = r0.x + r1.y + r2.z;
+
+	if (trace > 0.0f) {
+		float s = 0.5f / std::sqrt(trace + 1.0f);
+		real = vec4((r1.z - r2.y) * s, (r2.x - r0.z) * s, (r0.y - r1.x) * s, 0.25f / s);
+	}
+	else if ((r0.x > r1.y) && (r0.x > r2.z)) {
+		float s = 2.0f * std::sqrt(1.0f + r0.x - r1.y - r2.z);
+		real = vec4(0.25f * s, (r1.x + r0.y) / s, (r2.x + r0.z) / s, (r1.z - r2.y) / s);
+	}
+	else if (r1.y > r2.z) {
+		float s = 2.0f * std::sqrt(1.0f + r1.y - r0.x - r2.z);
+		real = vec4((r1.x + r0.y) / s, 0.25f * s, (r2.y + r1.z) / s, (r2.x - r0.z) / s);
+	}
+	else {
+		float s = 2.0f * std::sqrt(1.0f + r2.z - r0.x - r1.y);
+		real = vec4((r2.x + r0.z) / s, (r2.y + r1.z) / s, 0.25f * s, (r0.y - r1.x) / s);
+	}
+	real /= std::sqrt(real.dotSelf());
+
+	// dual = 0.5 * translation * real
+	vec3 t = m[3].xyz();
+	vec3 q = real.xyz();
+	dual = vec4(0.5f * (real.w * t + cross(t, q)), -0.5f * dot(t, q));
+}
+
+void Palette::build(const Vector<mat4>& boneMatrices, SkinningMethod method) {
+	matrices = boneMatrices;
+
+	if (method == SkinningMethod::DualQuaternion) {
+		dualQuaternions.resize(2 * matrices.size());
+		for (size_t i = 0, e = matrices.size(); i < e; ++i)
+			matrixToDualQuaternion(matrices[i], dualQuaternions[2 * i], dualQuaternions[2 * i + 1]);
+	}
+	else {
+		dualQuaternions.clear();
+	}
+}
+
+void addInfluence(Influence& influence, uint32_t bone, float weight) {
+	uint32_t minIndex = 0;
+	for (uint32_t i = 1; i < MaxInfluences; ++i) {
+		if (influence.weights[i] < influence.weights[minIndex])
+			minIndex = i;
+	}
+
+	if (weight > influence.weights[minIndex]) {
+		influence.bones[minIndex] = static_cast<uint16_t>(bone);
+		influence.weights[minIndex] = weight;
+	}
+}
+
+bool prepare(const VertexStorage& storage, const MeshDeformer* deformer, SourceData& result) {
+	result = SourceData();
+
+	if (!storage.hasAttributeWithType(VertexAttributeUsage::Position, DataType::Vec3))
+		return false;
+
+	uint32_t vertexCount = storage.capacity();
+	result.influences.resize(vertexCount);
+
+	/*
+	 * palette is built from deformer clusters (padded to MaxInfluences matrices),
+	 * influences referencing bones outside of it are rejected here, so deform never reads out of palette
+	 */
+	uint32_t bonesLimit = std::numeric_limits<uint16_t>::max() + 1u;
+	if (deformer != nullptr)
+		bonesLimit = std::max(static_cast<uint32_t>(deformer->clusters().size()), static_cast<uint32_t>(MaxInfluences));
+
+	uint32_t rejectedInfluences = 0;
+
+	if (storage.hasAttributeWithType(VertexAttributeUsage::BlendIndices, DataType::IntVec4) &&
+		storage.hasAttributeWithType(VertexAttributeUsage::BlendWeights, DataType::Vec4)) {
+		auto indices = storage.accessData<DataType::IntVec4>(VertexAttributeUsage::BlendIndices, 0);
+		auto weights = storage.accessData<DataType::Vec4>(VertexAttributeUsage::BlendWeights, 0);
+		for (uint32_t i = 0; i < vertexCount; ++i) {
+			Influence& influence = result.influences[i];
+			for (uint32_t j = 0; j < MaxInfluences; ++j) {
+				int32_t bone = indices[i][j];
+				float weight = weights[i][j];
+				if ((bone < 0) || (weight <= 0.0f))
+					continue;
+
+				if (static_cast<uint32_t>(bone) >= bonesLimit) {
+					++rejectedInfluences;
+					continue;
+				}
+
+				influence.bones[j] = static_cast<uint16_t>(bone);
+				influence.weights[j] = weight;
+				result.bonesCount = std::max(result.bonesCount, static_cast<uint32_t>(bone) + 1);
+			}
+		}
+	}
+	else if ((deformer != nullptr) && !deformer->clusters().empty()) {
+		const auto& clusters = deformer->clusters();
+		for (uint32_t c = 0, ce = static_cast<uint32_t>(clusters.size()); c < ce; ++c) {
+			for (const MeshDeformerCluster::VertexWeight& vw : clusters[c]->weights()) {
+				if (vw.index < vertexCount)
+					addInfluence(result.influences[vw.index], c, vw.weight);
+			}
+		}
+		result.bonesCount = static_cast<uint32_t>(clusters.size());
+	}
+	else {
+		result.influences.clear();
+		return false;
+	}
+
+	if (rejectedInfluences > 0)
+		log::warning("Skinning: %u influences reference bones out of %u bones, ignored", rejectedInfluences, bonesLimit);
+
+	for (Influence& influence : result.influences) {
+		float totalWeight = 0.0f;
+		for (uint32_t j = 0; j < MaxInfluences; ++j)
+			totalWeight += influence.weights[j];
+
+		if (totalWeight > 0.0f) {
+			for (uint32_t j = 0; j < MaxInfluences; ++j)
+				influence.weights[j] /= totalWeight;
+		}
+		else {
+			influence = Influence();
+			influence.weights[0] = 1.0f;
+		}
+	}
+	result.bonesCount = std::max(result.bonesCount, 1u);
+
+	auto positions = storage.accessData<DataType::Vec3>(VertexAttributeUsage::Position, 0);
+	result.positions.resize(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; ++i)
+		result.positions[i] = vec4(positions[i], 1.0f);
+
+	if (storage.hasAttributeWithType(VertexAttributeUsage::Normal, DataType::Vec3)) {
+		auto normals = storage.accessData<DataType::Vec3>(VertexAttributeUsage::Normal, 0);
+		result.normals.resize(vertexCount);
+		for (uint32_t i = 0; i < vertexCount; ++i)
+			result.normals[i] = vec4(normals[i], 0.0f);
+	}
+
+	return true;
+}
+
+inline void storeVector3(const vec4simd& v, vec3& dst) {
+	ET_ALIGNED(16) float values[4];
+	v.loadToFloats(values);
+	dst.x = values[0];
+	dst.y = values[1];
+	dst.z = values[2];
+}
+
+void deformLinearBlend(const SourceData& source, const Palette& palette, uint32_t begin, uint32_t end,
+	vec3* outPositions, vec3* outNormals) {
+	const mat4* matrices = palette.matrices.data();
+	bool writeNormals = source.hasNormals() && (outNormals != nullptr);
+
+	for (uint32_t i = begin; i < end; ++i) {
+		const Influence& influence = source.influences[i];
+
+		// blend matrices first, so vertex is transformed once
+		vec4simd r0(0.0f);
+		vec4simd r1(0.0f);
+		vec4simd r2(0.0f);
+		vec4simd r3(0.0f);
+		for (uint32_t j = 0; j < MaxInfluences; ++j) {
+			const mat4& m = matrices[influence.bones[j]];
+			float w = influence.weights[j];
+			r0.addMultiplied(vec4simd(m[0]), w);
+			r1.addMultiplied(vec4simd(m[1]), w);
+			r2.addMultiplied(vec4simd(m[2]), w);
+			r3.addMultiplied(vec4simd(m[3]), w);
+		}
+
+		const vec4& p = source.positions[i];
+		vec4simd position(r3);
+		position.addMultiplied(r0, p.x);
+		position.addMultiplied(r1, p.y);
+		position.addMultiplied(r2, p.z);
+		storeVector3(position, outPositions[i]);
+
+		if (writeNormals) {
+			const vec4& n = source.normals[i];
+			vec4simd normal = r0 * n.x;
+			normal.addMultiplied(r1, n.y);
+			normal.addMultiplied(r2, n.z);
+			if (normal.dotSelf() > std::numeric_limits<float>::epsilon())
+				normal.normalize();
+			storeVector3(normal, outNormals[i]);
+		}
+	}
+}
+
+inline vec4simd rotateVector(const vec4simd& q, const vec4simd& qw, const vec4simd& v) {
+	// v + 2 * cross(q, cross(q, v) + w * v), w component of cross product is zero
+	return v + q.crossXYZ(q.crossXYZ(v) + qw * v) * 2.0f;
+}
+
+void deformDualQuaternion(const SourceData& source, const Palette& palette, uint32_t begin, uint32_t end,
+	vec3* outPositions, vec3* outNormals) {
+	const vec4* dualQuaternions = palette.dualQuaternions.data();
+	bool writeNormals = source.hasNormals() && (outNormals != nullptr);
+
+	for (uint32_t i = begin; i < end; ++i) {
+		const Influence& influence = source.influences[i];
+
+		vec4simd pivot(dualQuaternions[2 * influence.bones[0]]);
+		vec4simd real(0.0f);
+		vec4simd dual(0.0f);
+		for (uint32_t j = 0; j < MaxInfluences; ++j) {
+			uint32_t bone = influence.bones[j];
+			vec4simd boneReal(dualQuaternions[2 * bone]);
+			vec4simd boneDual(dualQuaternions[2 * bone + 1]);
+
+			// keep all quaternions in the same hemisphere as the first one
+			float w = (pivot.dot(boneReal) < 0.0f) ? -influence.weights[j] : influence.weights[j];
+			real.addMultiplied(boneReal, w);
+			dual.addMultiplied(boneDual, w);
+		}
+
+		float length = real.length();
+		real /= length;
+		dual /= length;
+
+		vec4simd qw = real.shuffle<3, 3, 3, 3>();
+		vec4simd dw = dual.shuffle<3, 3, 3, 3>();
+		vec4simd translation = (dual * qw - real * dw + real.crossXYZ(dual)) * 2.0f;
+
+		const vec4& p = source.positions[i];
+		vec4simd position = rotateVector(real, qw, vec4simd(p.x, p.y, p.z, 0.0f)) + translation;
+		storeVector3(position, outPositions[i]);
+
+		if (writeNormals) {
+			const vec4& n = source.normals[i];
+			storeVector3(rotateVector(real, qw, vec4simd(n.x, n.y, n.z, 0.0f)), outNormals[i]);
+		}
+	}
+}
+
+void deform(const SourceData& source, const Palette& palette, SkinningMethod method, uint32_t begin, uint32_t end,
+	vec3* outPositions, vec3* outNormals) {
+	ET_ASSERT(palette.bonesCount() >= source.bonesCount);
+	ET_ASSERT(end <= source.vertexCount());
+
+	if (method == SkinningMethod::DualQuaternion) {
+		ET_ASSERT(palette.dualQuaternions.size() == 2 * palette.matrices.size());
+		deformDualQuaternion(source, palette, begin, end, outPositions, outNormals);
+	}
+	else {
+		deformLinearBlend(source, palette, begin, end, outPositions, outNormals);
+	}
+}
+
+void deform(const SourceData& source, const Palette& palette, SkinningMethod method, vec3* outPositions, vec3* outNormals) {
+	uint32_t vertexCount = source.vertexCount();
+	parallel::forRange(vertexCount, parallel::suggestedGrain(vertexCount, 1024), [&](uint32_t begin, uint32_t end) {
+		deform(source, palette, method, begin, end, outPositions, outNormals);
+	});
+}
+
+}
+}
+}
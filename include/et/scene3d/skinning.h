@@ -0,0 +1,98 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/rendering/base/vertexstorage.h>
+
+namespace et {
+namespace s3d {
+
+class MeshDeformer;
+
+enum class SkinningMethod : uint32_t
+{
+	LinearBlend,
+
+	/*
+	 * Bone transforms are expected to be rigid (rotation and translation only),
+	 * scale is ignored
+	 */
+	DualQuaternion,
+};
+
+namespace skinning {
+
+enum : uint32_t
+{
+	MaxInfluences = 4,
+};
+
+/*
+ * Packed per-vertex influences, weights are normalized, unused slots have zero weight
+ */
+struct Influence
+{
+	uint16_t bones[MaxInfluences] = { };
+	float weights[MaxInfluences] = { };
+};
+
+/*
+ * Undeformed vertices and influences, prepared once per vertex storage
+ */
+struct SourceData
+{
+	Vector<vec4> positions;
+	Vector<vec4> normals;
+	Vector<Influence> influences;
+	uint32_t bonesCount = 0;
+
+	uint32_t vertexCount() const {
+		return static_cast<uint32_t>(positions.size());
+	}
+
+	bool hasNormals() const {
+		return !normals.empty();
+	}
+};
+
+/*
+ * Bone transforms for one frame, dual quaternions are stored
+ * as pairs of (real, dual) vec4 with (x, y, z, w) layout
+ */
+struct Palette
+{
+	Vector<mat4> matrices;
+	Vector<vec4> dualQuaternions;
+
+	void build(const Vector<mat4>& boneMatrices, SkinningMethod method);
+
+	uint32_t bonesCount() const {
+		return static_cast<uint32_t>(matrices.size());
+	}
+};
+
+/*
+ * Takes influences from BlendIndices / BlendWeights attributes if storage has them,
+ * otherwise gathers four largest weights per vertex from deformer clusters
+ */
+bool prepare(const VertexStorage&, const MeshDeformer*, SourceData&);
+
+/*
+ * Deforms vertices [begin, end), normals are written only if source has them
+ */
+void deform(const SourceData&, const Palette&, SkinningMethod, uint32_t begin, uint32_t end,
+	vec3* outPositions, vec3* outNormals);
+
+/*
+ * Deforms all vertices in parallel chunks
+ */
+void deform(const SourceData&, const Palette&, SkinningMethod, vec3* outPositions, vec3* outNormals);
+
+}
+}
+}
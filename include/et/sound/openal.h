@@ -13,6 +13,9 @@
 #elif (ET_PLATFORM_WIN)
 #	include <external\oal\al.h>
 #	include <external\oal\alc.h>
+#elif (ET_PLATFORM_LINUX)
+#	include <AL/al.h>
+#	include <AL/alc.h>
 #else
 #	error Unknown platform
 #endif
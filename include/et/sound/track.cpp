@@ -100,7 +100,7 @@ Track::Track(const std::string& fileName)
 	
 	_private->owner = this;
 		
-	_private->stream = InputStream::Pointer::create(fileName, StreamMode_Binary);
+	_private->stream = InputStream::Pointer::create(fileName, StreamMode_Mapped);
 	if (_private->stream->invalid())
 	{
 		log::error("Unable to load file %s", fileName.c_str());
@@ -0,0 +1,251 @@
+#include <et/app/application.h>
+#include <et/core/parallel.h>
+#include <et/imaging/blockcompression.h>
+
+const et::vec2i imageSize(2048, 2048);
+
+// lowest acceptable quality of decoded output for the test image, broken encoders are far below
+const double bc1MinimalPSNR = 32.0;
+const double bc3MinimalPSNR = 32.0;
+const double bc5MinimalPSNR = 45.0;
+const double bc7MinimalPSNR = 34.0;
+
+/*
+ * Reference block decoders, used to validate encoder output
+ */
+void decodeColor565(uint16_t c, uint32_t* rgb)
+{
+	uint32_t r = (c >> 11) & 31;
+	uint32_t g = (c >> 5) & 63;
+	uint32_t b = c & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+void decodeColorBlock(const uint8_t* block, bool allowThreeColors, et::vec4ub* pixels)
+{
+	uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+	uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+
+	uint32_t palette[4][3] = { };
+	decodeColor565(c0, palette[0]);
+	decodeColor565(c1, palette[1]);
+	bool fourColors = (c0 > c1) || !allowThreeColors;
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		if (fourColors)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+
+	uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const uint32_t* color = palette[(indices >> (2 * i)) & 3];
+		pixels[i].x = static_cast<uint8_t>(color[0]);
+		pixels[i].y = static_cast<uint8_t>(color[1]);
+		pixels[i].z = static_cast<uint8_t>(color[2]);
+	}
+}
+
+void decodeAlphaBlock(const uint8_t* block, et::vec4ub* pixels, uint32_t channel)
+{
+	uint32_t a0 = block[0];
+	uint32_t a1 = block[1];
+	uint32_t palette[8] = { a0, a1 };
+	if (a0 > a1)
+	{
+		for (uint32_t i = 1; i < 7; ++i)
+			palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+	}
+	else
+	{
+		for (uint32_t i = 1; i < 5; ++i)
+			palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	uint64_t indices = 0;
+	for (uint32_t i = 0; i < 6; ++i)
+		indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+
+	for (uint32_t i = 0; i < 16; ++i)
+		pixels[i][channel] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+}
+
+uint32_t readBits(const uint8_t* block, uint32_t& position, uint32_t count)
+{
+	uint32_t result = 0;
+	for (uint32_t i = 0; i < count; ++i, ++position)
+		result |= ((block[position / 8] >> (position % 8)) & 1) << i;
+	return result;
+}
+
+/*
+ * Only mode 6 is produced by the encoder, other modes are reported as failure
+ */
+bool decodeBC7Block(const uint8_t* block, et::vec4ub* pixels)
+{
+	static const uint32_t weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	uint32_t position = 0;
+	if (readBits(block, position, 7) != (1u << 6))
+		return false;
+
+	uint32_t endpoints[2][4] = { };
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		endpoints[0][c] = readBits(block, position, 7) << 1;
+		endpoints[1][c] = readBits(block, position, 7) << 1;
+	}
+	uint32_t p0 = readBits(block, position, 1);
+	uint32_t p1 = readBits(block, position, 1);
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		endpoints[0][c] |= p0;
+		endpoints[1][c] |= p1;
+	}
+
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		uint32_t w = weights[readBits(block, position, (i == 0) ? 3 : 4)];
+		for (uint32_t c = 0; c < 4; ++c)
+			pixels[i][c] = static_cast<uint8_t>(((64 - w) * endpoints[0][c] + w * endpoints[1][c] + 32) >> 6);
+	}
+	return true;
+}
+
+/*
+ * Decodes whole image and returns PSNR of the compared channels, or zero if data could not be decoded
+ */
+double measurePSNR(const et::TextureDescription& source, const et::TextureDescription& compressed,
+	et::TextureFormat format, uint32_t channels)
+{
+	uint32_t blockSize = et::bc::blockDataSize(format);
+	uint32_t blocksX = static_cast<uint32_t>(imageSize.x) / 4;
+	uint32_t blocksY = static_cast<uint32_t>(imageSize.y) / 4;
+	if (compressed.data.size() < static_cast<size_t>(blocksX) * blocksY * blockSize)
+		return 0.0;
+
+	double squaredError = 0.0;
+	for (uint32_t by = 0; by < blocksY; ++by)
+	{
+		for (uint32_t bx = 0; bx < blocksX; ++bx)
+		{
+			const uint8_t* block = compressed.data.data() + (by * blocksX + bx) * blockSize;
+
+			et::vec4ub pixels[16];
+			switch (format)
+			{
+			case et::TextureFormat::DXT1_RGB:
+				decodeColorBlock(block, true, pixels);
+				break;
+			case et::TextureFormat::DXT5:
+				decodeAlphaBlock(block, pixels, 3);
+				decodeColorBlock(block + 8, false, pixels);
+				break;
+			case et::TextureFormat::RGTC2:
+				decodeAlphaBlock(block, pixels, 0);
+				decodeAlphaBlock(block + 8, pixels, 1);
+				break;
+			case et::TextureFormat::BC7:
+				if (!decodeBC7Block(block, pixels))
+					return 0.0;
+				break;
+			default:
+				return 0.0;
+			}
+
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				uint32_t x = 4 * bx + i % 4;
+				uint32_t y = 4 * by + i / 4;
+				const uint8_t* original = source.data.data() + 4 * (y * static_cast<uint32_t>(imageSize.x) + x);
+				for (uint32_t c = 0; c < channels; ++c)
+				{
+					double difference = static_cast<double>(original[c]) - static_cast<double>(pixels[i][c]);
+					squaredError += difference * difference;
+				}
+			}
+		}
+	}
+
+	double meanSquaredError = squaredError / (static_cast<double>(imageSize.square()) * channels);
+	return 10.0 * std::log10(255.0 * 255.0 / std::max(meanSquaredError, 1.0e-10));
+}
+
+bool runTest(const char* name, const et::TextureDescription& source, et::TextureFormat format, et::BlockCompressionQuality quality,
+	uint32_t channels, double minimalPSNR)
+{
+	et::BlockCompressionOptions options;
+	options.format = format;
+	options.quality = quality;
+	options.generateMipLevels = false;
+
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+	et::TextureDescription::Pointer result = et::bc::compress(source, options);
+	uint64_t totalTime = std::max(uint64_t(1), et::queryCurrentTimeInMicroSeconds() - startTime);
+
+	static const char* qualityNames[] = { "fast", "normal", "best" };
+	double megaPixels = static_cast<double>(imageSize.square()) / 1000000.0;
+	double psnr = result.valid() ? measurePSNR(source, result.reference(), format, channels) : 0.0;
+	et::log::info("%8s (%6s) : %8llu.%03llu ms | %10.2f MP/s | %zu bytes | %6.2f dB", name, qualityNames[static_cast<uint32_t>(quality)],
+		static_cast<unsigned long long>(totalTime / 1000), static_cast<unsigned long long>(totalTime % 1000),
+		megaPixels / (static_cast<double>(totalTime) / 1000000.0), result.valid() ? result->data.size() : size_t(0), psnr);
+
+	if (psnr < minimalPSNR)
+	{
+		et::log::error("%s output does not match source: %.2f dB, expected at least %.2f dB", name, psnr, minimalPSNR);
+		return false;
+	}
+	return true;
+}
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+	et::log::info("Starting test (%d x %d, %u workers)...", imageSize.x, imageSize.y, et::parallel::workersCount());
+
+	// smooth gradients with noise, close to what real textures contain
+	et::TextureDescription source;
+	source.size = imageSize;
+	source.format = et::TextureFormat::RGBA8;
+	source.data.resize(static_cast<uint32_t>(imageSize.square()) * 4);
+	for (int y = 0; y < imageSize.y; ++y)
+	{
+		for (int x = 0; x < imageSize.x; ++x)
+		{
+			uint8_t* p = source.data.data() + 4 * (y * imageSize.x + x);
+			p[0] = static_cast<uint8_t>((x / 8 + rand() % 8) & 0xff);
+			p[1] = static_cast<uint8_t>((y / 8 + rand() % 8) & 0xff);
+			p[2] = static_cast<uint8_t>(((x + y) / 16 + rand() % 8) & 0xff);
+			p[3] = static_cast<uint8_t>(((x * y) / 4096) & 0xff);
+		}
+	}
+
+	const et::BlockCompressionQuality qualities[] = { et::BlockCompressionQuality::Fast,
+		et::BlockCompressionQuality::Normal, et::BlockCompressionQuality::Best };
+
+	bool succeeded = true;
+	for (et::BlockCompressionQuality quality : qualities)
+	{
+		succeeded &= runTest("BC1", source, et::TextureFormat::DXT1_RGB, quality, 3, bc1MinimalPSNR);
+		succeeded &= runTest("BC3", source, et::TextureFormat::DXT5, quality, 4, bc3MinimalPSNR);
+		succeeded &= runTest("BC5", source, et::TextureFormat::RGTC2, quality, 2, bc5MinimalPSNR);
+		succeeded &= runTest("BC7", source, et::TextureFormat::BC7, quality, 4, bc7MinimalPSNR);
+	}
+
+	system("pause");
+	return succeeded ? 0 : 1;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
@@ -0,0 +1,273 @@
+#include <et/app/application.h>
+#include <et/geometry/collision.h>
+#include <et/geometry/broadphase.h>
+
+const uint32_t elementsCount = 4096;
+const uint32_t queriesCount = 1024;
+const uint32_t movingBoxesCount = 16384;
+const uint32_t iterations = 8;
+
+template <class F>
+void runTest(const char* name, uint64_t testsPerIteration, F func)
+{
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+	for (uint32_t i = 0; i < iterations; ++i)
+		func();
+	uint64_t totalTime = std::max(uint64_t(1), et::queryCurrentTimeInMicroSeconds() - startTime);
+
+	double tests = static_cast<double>(iterations) * static_cast<double>(testsPerIteration);
+	double testsPerSecond = tests / (static_cast<double>(totalTime) / 1000000.0);
+
+	et::log::info("%32s : %8llu.%03llu ms | %10.2f M tests/s", name, static_cast<unsigned long long>(totalTime / 1000),
+		static_cast<unsigned long long>(totalTime % 1000), testsPerSecond / 1000000.0);
+}
+
+et::vec3 randomVector(float range)
+{
+	return et::vec3(et::randomFloat(-range, range), et::randomFloat(-range, range), et::randomFloat(-range, range));
+}
+
+template <class T>
+bool sameElements(et::Vector<T> a, et::Vector<T> b)
+{
+	std::sort(a.begin(), a.end());
+	std::sort(b.begin(), b.end());
+	return a == b;
+}
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+	et::log::info("Starting test (%u elements, %u queries, %u iterations)...", elementsCount, queriesCount, iterations);
+
+	et::Vector<et::triangle> triangles;
+	et::Vector<et::BoundingBox> boxes;
+	et::Vector<et::Sphere> spheres;
+	et::TriangleBatch triangleBatch;
+	et::BoundingBoxBatch boxBatch;
+	et::SphereBatch sphereBatch;
+	for (uint32_t i = 0; i < elementsCount; ++i)
+	{
+		et::vec3 p = randomVector(100.0f);
+		triangles.emplace_back(p, p + randomVector(2.0f), p + randomVector(2.0f));
+		boxes.emplace_back(randomVector(100.0f), et::vec3(et::randomFloat(0.5f, 2.0f)));
+		spheres.emplace_back(randomVector(100.0f), et::randomFloat(0.5f, 2.0f));
+		triangleBatch.push_back(triangles.back());
+		boxBatch.push_back(boxes.back());
+		sphereBatch.push_back(spheres.back());
+	}
+
+	et::Vector<et::ray3d> rays;
+	et::Vector<et::Sphere> querySpheres;
+	for (uint32_t i = 0; i < queriesCount; ++i)
+	{
+		rays.emplace_back(randomVector(100.0f), et::normalize(randomVector(1.0f)));
+		querySpheres.emplace_back(randomVector(100.0f), et::randomFloat(1.0f, 10.0f));
+	}
+
+	/*
+	 * batch queries should give the same results as scalar ones
+	 */
+	auto validateQueries = [&]() -> bool
+	{
+		for (uint32_t q = 0; q < queriesCount; ++q)
+		{
+			const et::ray3d& r = rays[q];
+			float scalarDistance = std::numeric_limits<float>::max();
+			for (const et::triangle& t : triangles)
+			{
+				et::vec3 point;
+				if (et::intersect::rayTriangleTwoSided(r, t, &point))
+					scalarDistance = std::min(scalarDistance, (point - r.origin).length());
+			}
+
+			float batchDistance = std::numeric_limits<float>::max();
+			bool batchHit = et::intersect::rayTriangles(r, triangleBatch, batchDistance) != et::intersect::InvalidIndex;
+			bool scalarHit = scalarDistance < std::numeric_limits<float>::max();
+			if ((batchHit != scalarHit) || (batchHit && (std::abs(batchDistance - scalarDistance) > 1.0e-3f * scalarDistance)))
+			{
+				et::log::error("ray-triangles mismatch for ray %u: scalar %.4f, batch %.4f", q, scalarDistance, batchDistance);
+				return false;
+			}
+
+			const et::Sphere& s = querySpheres[q];
+			et::Vector<uint32_t> scalarIndices;
+			et::Vector<uint32_t> batchIndices;
+			for (uint32_t i = 0; i < elementsCount; ++i)
+			{
+				if (et::intersect::sphereBoundingBox(s, boxes[i]))
+					scalarIndices.emplace_back(i);
+			}
+			et::intersect::sphereBoundingBoxes(s, boxBatch, batchIndices);
+			if (!sameElements(scalarIndices, batchIndices))
+			{
+				et::log::error("sphere-boxes mismatch for sphere %u: scalar %zu, batch %zu hits", q, scalarIndices.size(), batchIndices.size());
+				return false;
+			}
+
+			scalarIndices.clear();
+			batchIndices.clear();
+			for (uint32_t i = 0; i < elementsCount; ++i)
+			{
+				if (et::intersect::sphereSphere(s, spheres[i], nullptr))
+					scalarIndices.emplace_back(i);
+			}
+			et::intersect::sphereSpheres(s, sphereBatch, batchIndices);
+			if (!sameElements(scalarIndices, batchIndices))
+			{
+				et::log::error("sphere-spheres mismatch for sphere %u: scalar %zu, batch %zu hits", q, scalarIndices.size(), batchIndices.size());
+				return false;
+			}
+		}
+		return true;
+	};
+
+	if (!validateQueries())
+	{
+		system("pause");
+		return 1;
+	}
+	et::log::info("Batch queries validation passed");
+
+	uint64_t testsCount = static_cast<uint64_t>(elementsCount) * queriesCount;
+	volatile uint32_t hits = 0;
+	et::Vector<uint32_t> indices;
+	indices.reserve(elementsCount);
+
+	runTest("ray-triangles (scalar)", testsCount, [&]() {
+		for (const et::ray3d& r : rays)
+		{
+			float distance = std::numeric_limits<float>::max();
+			for (const et::triangle& t : triangles)
+			{
+				et::vec3 point;
+				if (et::intersect::rayTriangleTwoSided(r, t, &point))
+					distance = std::min(distance, (point - r.origin).length());
+			}
+			hits = hits + (distance < std::numeric_limits<float>::max() ? 1 : 0);
+		}
+	});
+	runTest("ray-triangles (batch)", testsCount, [&]() {
+		for (const et::ray3d& r : rays)
+		{
+			float distance = std::numeric_limits<float>::max();
+			hits = hits + (et::intersect::rayTriangles(r, triangleBatch, distance) != et::intersect::InvalidIndex ? 1 : 0);
+		}
+	});
+	runTest("sphere-boxes (scalar)", testsCount, [&]() {
+		for (const et::Sphere& s : querySpheres)
+		{
+			indices.clear();
+			for (uint32_t i = 0; i < elementsCount; ++i)
+			{
+				if (et::intersect::sphereBoundingBox(s, boxes[i]))
+					indices.emplace_back(i);
+			}
+			hits = hits + static_cast<uint32_t>(indices.size());
+		}
+	});
+	runTest("sphere-boxes (batch)", testsCount, [&]() {
+		for (const et::Sphere& s : querySpheres)
+		{
+			indices.clear();
+			hits = hits + et::intersect::sphereBoundingBoxes(s, boxBatch, indices);
+		}
+	});
+	runTest("sphere-spheres (scalar)", testsCount, [&]() {
+		for (const et::Sphere& s : querySpheres)
+		{
+			indices.clear();
+			for (uint32_t i = 0; i < elementsCount; ++i)
+			{
+				if (et::intersect::sphereSphere(s, spheres[i], nullptr))
+					indices.emplace_back(i);
+			}
+			hits = hits + static_cast<uint32_t>(indices.size());
+		}
+	});
+	runTest("sphere-spheres (batch)", testsCount, [&]() {
+		for (const et::Sphere& s : querySpheres)
+		{
+			indices.clear();
+			hits = hits + et::intersect::sphereSpheres(s, sphereBatch, indices);
+		}
+	});
+
+	/*
+	 * broadphase for the set of slightly moving boxes
+	 */
+	et::Vector<et::BoundingBox> movingBoxes;
+	et::BoundingBoxBatch movingBatch;
+	for (uint32_t i = 0; i < movingBoxesCount; ++i)
+	{
+		movingBoxes.emplace_back(randomVector(500.0f), et::vec3(et::randomFloat(0.5f, 4.0f)));
+		movingBatch.push_back(movingBoxes.back());
+	}
+
+	auto moveBoxes = [&]()
+	{
+		for (uint32_t i = 0; i < movingBoxesCount; ++i)
+		{
+			movingBoxes[i].center += randomVector(0.5f);
+			movingBatch.set(i, movingBoxes[i]);
+		}
+	};
+
+	uint64_t pairsCount = static_cast<uint64_t>(movingBoxesCount) * (movingBoxesCount - 1) / 2;
+	et::Vector<et::SweepAndPrune::Pair> pairs;
+	auto findAllPairs = [&]()
+	{
+		pairs.clear();
+		for (uint32_t i = 0; i < movingBoxesCount; ++i)
+		{
+			et::vec3 minI = movingBoxes[i].minVertex();
+			et::vec3 maxI = movingBoxes[i].maxVertex();
+			for (uint32_t j = i + 1; j < movingBoxesCount; ++j)
+			{
+				et::vec3 minJ = movingBoxes[j].minVertex();
+				et::vec3 maxJ = movingBoxes[j].maxVertex();
+				if ((minI.x <= maxJ.x) && (minJ.x <= maxI.x) && (minI.y <= maxJ.y) &&
+					(minJ.y <= maxI.y) && (minI.z <= maxJ.z) && (minJ.z <= maxI.z))
+				{
+					pairs.emplace_back(i, j);
+				}
+			}
+		}
+	};
+
+	/*
+	 * sweep and prune should find exactly the same pairs as brute force, also after boxes moved
+	 */
+	et::SweepAndPrune sweepAndPrune;
+	for (uint32_t step = 0; step < 2; ++step)
+	{
+		findAllPairs();
+		et::Vector<et::SweepAndPrune::Pair> expectedPairs = pairs;
+		sweepAndPrune.findPairs(movingBatch, pairs);
+		if (!sameElements(expectedPairs, pairs))
+		{
+			et::log::error("sweep and prune mismatch: scalar %zu, batch %zu pairs", expectedPairs.size(), pairs.size());
+			system("pause");
+			return 1;
+		}
+		moveBoxes();
+	}
+	et::log::info("Sweep and prune validation passed");
+
+	runTest("all pairs (scalar)", pairsCount, [&]() {
+		moveBoxes();
+		findAllPairs();
+		hits = hits + static_cast<uint32_t>(pairs.size());
+	});
+
+	runTest("sweep and prune", pairsCount, [&]() {
+		moveBoxes();
+		sweepAndPrune.findPairs(movingBatch, pairs);
+		hits = hits + static_cast<uint32_t>(pairs.size());
+	});
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
@@ -0,0 +1,141 @@
+#include <et/app/application.h>
+
+const uint32_t dispatchesCount = 1000000;
+const uint32_t postsCount = 100000;
+const uint32_t postsBatchSize = 256;
+
+struct Receiver : public et::EventReceiver
+{
+	uint64_t counter = 0;
+
+	void onEvent(uint32_t value)
+	{
+		counter += value;
+	}
+};
+
+template <class F>
+bool runTest(const char* name, uint32_t receiversCount, uint32_t operations, uint64_t expected, F func)
+{
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+	uint64_t checksum = func();
+	uint64_t totalTime = std::max(uint64_t(1), et::queryCurrentTimeInMicroSeconds() - startTime);
+
+	et::log::info("%24s (% 5u receivers) : % 8llu.%03llu ms | % 8.2f ns per operation | %llu", name, receiversCount,
+		totalTime / 1000, totalTime % 1000, 1000.0 * static_cast<double>(totalTime) / static_cast<double>(operations),
+		static_cast<unsigned long long>(checksum));
+
+	if (checksum != expected)
+	{
+		et::log::error("%s (%u receivers): checksum mismatch, expected %llu, got %llu", name, receiversCount,
+			static_cast<unsigned long long>(expected), static_cast<unsigned long long>(checksum));
+		return false;
+	}
+	return true;
+}
+
+bool allReceiversCalled(const et::Vector<Receiver>& receivers, uint64_t expected)
+{
+	for (const Receiver& r : receivers)
+	{
+		if (r.counter != expected)
+		{
+			et::log::error("receiver was called %llu times instead of %llu",
+				static_cast<unsigned long long>(r.counter), static_cast<unsigned long long>(expected));
+			return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+	et::log::info("Starting test (%u receiver calls per case)...", dispatchesCount);
+
+	et::RunLoop runLoop;
+	et::RunLoopScope runLoopScope(runLoop);
+
+	for (uint32_t receiversCount : { 1u, 10u, 100u, 1000u })
+	{
+		uint32_t invocations = dispatchesCount / receiversCount;
+
+		et::Vector<Receiver> receivers(receiversCount);
+		et::Event1<uint32_t> methodEvent;
+		for (Receiver& r : receivers)
+			methodEvent.connect(&r, &Receiver::onEvent);
+
+		bool passed = runTest("invoke (method)", receiversCount, dispatchesCount, invocations, [&]() {
+			for (uint32_t i = 0; i < invocations; ++i)
+				methodEvent.invoke(1);
+			return receivers.front().counter;
+		});
+		if (!passed || !allReceiversCalled(receivers, invocations))
+			return 1;
+
+		uint64_t lambdaCounter = 0;
+		et::Event1<uint32_t> lambdaEvent;
+		for (uint32_t i = 0; i < receiversCount; ++i)
+			lambdaEvent.connect([&lambdaCounter](uint32_t value) { lambdaCounter += value; });
+
+		passed = runTest("invoke (lambda)", receiversCount, dispatchesCount, uint64_t(invocations) * receiversCount, [&]() {
+			for (uint32_t i = 0; i < invocations; ++i)
+				lambdaEvent.invoke(1);
+			return lambdaCounter;
+		});
+		if (!passed)
+			return 1;
+
+		et::Vector<et::EventConnection> connections(receiversCount);
+		passed = runTest("connect / disconnect", receiversCount, 2 * invocations * receiversCount, receiversCount, [&]() {
+			for (uint32_t i = 0; i < invocations; ++i)
+			{
+				for (et::EventConnection& c : connections)
+					c = lambdaEvent.connect([&lambdaCounter](uint32_t value) { lambdaCounter += value; });
+
+				for (const et::EventConnection& c : connections)
+					lambdaEvent.disconnect(c);
+			}
+			return lambdaEvent.connectionsCount();
+		});
+		if (!passed)
+			return 1;
+
+		/*
+		 * each post is a single message with all connected receivers,
+		 * producer thread posts batches and main thread delivers them on update
+		 */
+		uint32_t posts = std::max(1u, postsCount / receiversCount);
+		uint64_t postTime = 0;
+		uint64_t deliverTime = 0;
+		uint64_t counterBefore = receivers.front().counter;
+		for (uint32_t posted = 0; posted < posts; posted += postsBatchSize)
+		{
+			uint32_t batchSize = std::min(postsBatchSize, posts - posted);
+
+			std::thread producer([&methodEvent, &runLoop, &postTime, batchSize]() {
+				uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+				for (uint32_t i = 0; i < batchSize; ++i)
+					methodEvent.invokeInRunLoop(runLoop, 0.0f, 1);
+				postTime += et::queryCurrentTimeInMicroSeconds() - startTime;
+			});
+			producer.join();
+
+			uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+			runLoop.update(runLoop.timeMSec() + 1);
+			deliverTime += et::queryCurrentTimeInMicroSeconds() - startTime;
+		}
+		et::log::info("%24s (% 5u receivers) : % 8.2f ns per post, % 8.2f ns per delivery | %llu", "post from thread",
+			receiversCount, 1000.0 * static_cast<double>(postTime) / static_cast<double>(posts),
+			1000.0 * static_cast<double>(deliverTime) / static_cast<double>(posts * receiversCount),
+			static_cast<unsigned long long>(receivers.front().counter - counterBefore));
+
+		if (!allReceiversCalled(receivers, counterBefore + posts))
+			return 1;
+	}
+
+	et::log::info("All checksums match");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
@@ -0,0 +1,297 @@
+#include <et/app/application.h>
+#include <et/core/parallel.h>
+#include <et/imaging/imageoperations.h>
+
+const et::vec2i imageSize(2048, 2048);
+const int imageComponents = 4;
+const uint32_t iterations = 8;
+
+/*
+ * Scalar reference implementations (straightforward per-pixel versions),
+ * used to validate optimized operations before timing them
+ */
+namespace reference
+{
+
+int indexForCoord(const et::vec2i& coord, const et::vec2i& size)
+{
+	int xVal = et::clamp(coord.x, 0, size.x - 1);
+	int yVal = et::clamp(coord.y, 0, size.y - 1);
+	return yVal * size.x + xVal;
+}
+
+void blur(et::BinaryDataStorage& data, const et::vec2i& size, int components, const et::vec2i& direction, int radius)
+{
+	et::BinaryDataStorage source(data);
+	for (int y = 0; y < size.y; ++y)
+	{
+		for (int x = 0; x < size.x; ++x)
+		{
+			int i0 = components * indexForCoord(et::vec2i(x, y), size);
+			for (int c = 0; c < components; ++c)
+			{
+				int sum = source[i0 + c];
+				for (int r = 1; r <= radius; ++r)
+				{
+					sum += source[components * indexForCoord(et::vec2i(x, y) + direction * r, size) + c];
+					sum += source[components * indexForCoord(et::vec2i(x, y) - direction * r, size) + c];
+				}
+				data[i0 + c] = static_cast<uint8_t>(sum / (2 * radius + 1));
+			}
+		}
+	}
+}
+
+void median(et::BinaryDataStorage& data, const et::vec2i& size, int components, int radius)
+{
+	auto luminance = [components](const uint8_t* p)
+	{
+		int g = (components > 1) ? p[1] : 0;
+		int b = (components > 2) ? p[2] : 0;
+		return 76 * p[0] + 150 * g + 29 * b;
+	};
+
+	et::BinaryDataStorage source(data);
+	std::vector<const uint8_t*> window;
+	for (int y = 0; y < size.y; ++y)
+	{
+		for (int x = 0; x < size.x; ++x)
+		{
+			window.clear();
+			for (int v = -radius; v <= radius; ++v)
+			{
+				for (int u = -radius; u <= radius; ++u)
+					window.emplace_back(source.data() + components * indexForCoord(et::vec2i(x + u, y + v), size));
+			}
+
+			// choice between pixels of equal luminance is unspecified, lower address is taken
+			std::sort(window.begin(), window.end(), [&luminance](const uint8_t* l, const uint8_t* r)
+			{
+				int lumL = luminance(l);
+				int lumR = luminance(r);
+				return (lumL < lumR) || ((lumL == lumR) && (l < r));
+			});
+
+			const uint8_t* middle = window.at(window.size() / 2);
+			int i0 = components * indexForCoord(et::vec2i(x, y), size);
+			for (int c = 0; c < components; ++c)
+				data[i0 + c] = middle[c];
+		}
+	}
+}
+
+void applyMatrixFilter(et::BinaryDataStorage& data, const et::vec2i& size, int components, const et::mat3i& m)
+{
+	et::BinaryDataStorage source(data);
+	for (int y = 0; y < size.y; ++y)
+	{
+		for (int x = 0; x < size.x; ++x)
+		{
+			int i0 = components * indexForCoord(et::vec2i(x, y), size);
+			for (int c = 0; c < components; ++c)
+			{
+				int result = 0;
+				int cSum = 0;
+				for (int dy = -1; dy <= 1; ++dy)
+				{
+					for (int dx = -1; dx <= 1; ++dx)
+					{
+						int index = components * indexForCoord(et::vec2i(x + dx, y + dy), size);
+						result += source[index + c] * m[dy + 1][dx + 1];
+						cSum += m[dy + 1][dx + 1];
+					}
+				}
+				if (cSum)
+					result /= cSum;
+				data[i0 + c] = static_cast<uint8_t>(et::clamp(result, 0, 255));
+			}
+		}
+	}
+}
+
+void normalMapFilter(et::BinaryDataStorage& data, const et::vec2i& size, int components, const et::vec2& scale)
+{
+	et::vec2 fScale = scale / 255.0f;
+	et::BinaryDataStorage source(data);
+	for (int y = 0; y < size.y; ++y)
+	{
+		bool halfY = y < size.y / 2;
+		for (int x = 0; x < size.x; ++x)
+		{
+			bool halfX = x < size.x / 2;
+			int c00 = components * indexForCoord(et::vec2i(x, y), size);
+			int c01 = components * indexForCoord(et::vec2i(x + (halfX ? 1 : -1), y), size);
+			int c10 = components * indexForCoord(et::vec2i(x, y + (halfY ? 1 : -1)), size);
+
+			short h00 = source[c00];
+			short h01 = source[c01];
+			short h10 = source[c10];
+
+			float dx = static_cast<float>(halfX ? h01 - h00 : h00 - h01) * fScale.x;
+			float dy = static_cast<float>(halfY ? h10 - h00 : h00 - h10) * fScale.y;
+			et::vec3 produce = et::normalize(et::cross(et::vec3(1.0f, 0.0f, dx), et::vec3(0.0f, 1.0f, dy)));
+
+			data[c00+0] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.x));
+			data[c00+1] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.y));
+			data[c00+2] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.z));
+		}
+	}
+}
+
+}
+
+struct ValidationCase
+{
+	const char* name;
+	std::function<void(et::BinaryDataStorage&, const et::vec2i&, int)> optimized;
+	std::function<void(et::BinaryDataStorage&, const et::vec2i&, int)> reference;
+};
+
+bool validateOperations()
+{
+	using et::ImageOperations;
+
+	std::vector<ValidationCase> cases = 
+	{
+		{ "blur (horizontal, r = 4)",
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { ImageOperations::blur(d, s, c, et::vec2i(1, 0), 4, et::ImageBlurType_Average); },
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { reference::blur(d, s, c, et::vec2i(1, 0), 4); } },
+		{ "blur (horizontal, r = 32)",
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { ImageOperations::blur(d, s, c, et::vec2i(-1, 0), 32, et::ImageBlurType_Average); },
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { reference::blur(d, s, c, et::vec2i(-1, 0), 32); } },
+		{ "blur (vertical, r = 4)",
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { ImageOperations::blur(d, s, c, et::vec2i(0, 1), 4, et::ImageBlurType_Average); },
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { reference::blur(d, s, c, et::vec2i(0, 1), 4); } },
+		{ "blur (vertical, r = 32)",
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { ImageOperations::blur(d, s, c, et::vec2i(0, -1), 32, et::ImageBlurType_Average); },
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { reference::blur(d, s, c, et::vec2i(0, -1), 32); } },
+		{ "blur (diagonal, r = 4)",
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { ImageOperations::blur(d, s, c, et::vec2i(1, 1), 4, et::ImageBlurType_Average); },
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { reference::blur(d, s, c, et::vec2i(1, 1), 4); } },
+		{ "median (r = 1)",
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { ImageOperations::median(d, s, c, 1); },
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { reference::median(d, s, c, 1); } },
+		{ "median (r = 2)",
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { ImageOperations::median(d, s, c, 2); },
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { reference::median(d, s, c, 2); } },
+		{ "matrix filter (blur)",
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { ImageOperations::applyMatrixFilter(d, s, c, ImageOperations::matrixFilterBlur); },
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { reference::applyMatrixFilter(d, s, c, ImageOperations::matrixFilterBlur); } },
+		{ "matrix filter (sharpen)",
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { ImageOperations::applyMatrixFilter(d, s, c, ImageOperations::matrixFilterSharpen); },
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { reference::applyMatrixFilter(d, s, c, ImageOperations::matrixFilterSharpen); } },
+		{ "normal map filter",
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { ImageOperations::normalMapFilter(d, s, c, et::vec2(1.0f)); },
+			[](et::BinaryDataStorage& d, const et::vec2i& s, int c) { reference::normalMapFilter(d, s, c, et::vec2(1.0f)); } },
+	};
+
+	/*
+	 * Odd and degenerate sizes cover clamped edges and partial strips,
+	 * low-contrast data produces many equal luminance keys for median
+	 */
+	const et::vec2i sizes[] = { et::vec2i(131, 97), et::vec2i(1, 45), et::vec2i(70, 1) };
+	const int componentsVariants[] = { imageComponents, 3 };
+	const uint8_t valueMasks[] = { 0xff, 0x03 };
+
+	for (const et::vec2i& size : sizes)
+	{
+		for (int components : componentsVariants)
+		{
+			for (uint8_t mask : valueMasks)
+			{
+				et::BinaryDataStorage source(size.square() * components, 0);
+				for (uint8_t& b : source)
+					b = static_cast<uint8_t>(rand() & mask);
+
+				for (const ValidationCase& test : cases)
+				{
+					et::BinaryDataStorage optimized(source);
+					et::BinaryDataStorage expected(source);
+					test.optimized(optimized, size, components);
+					test.reference(expected, size, components);
+
+					for (uint32_t i = 0; i < expected.size(); ++i)
+					{
+						if (optimized[i] != expected[i])
+						{
+							int pixel = static_cast<int>(i) / components;
+							et::log::error("%s mismatch (%d x %d x %d, mask %02x) at pixel (%d, %d), component %d: expected %u, got %u",
+								test.name, size.x, size.y, components, mask, pixel % size.x, pixel / size.x, 
+								static_cast<int>(i) % components, expected[i], optimized[i]);
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+template <class F>
+void runTest(const char* name, const et::BinaryDataStorage& source, F func)
+{
+	et::BinaryDataStorage data(source);
+
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+	for (uint32_t i = 0; i < iterations; ++i)
+		func(data);
+	uint64_t totalTime = std::max(uint64_t(1), et::queryCurrentTimeInMicroSeconds() - startTime);
+
+	double megaPixels = static_cast<double>(iterations) * static_cast<double>(imageSize.square()) / 1000000.0;
+	double megaPixelsPerSecond = megaPixels / (static_cast<double>(totalTime) / 1000000.0);
+
+	et::log::info("%32s : % 8llu.%03llu ms | % 10.2f MP/s", name, 
+		totalTime / 1000, totalTime % 1000, megaPixelsPerSecond);
+}
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+	et::log::info("Starting test (%d x %d x %d, %u iterations, %u workers)...", 
+		imageSize.x, imageSize.y, imageComponents, iterations, et::parallel::workersCount());
+
+	et::BinaryDataStorage source(imageSize.square() * imageComponents, 0);
+	for (uint8_t& b : source)
+		b = static_cast<uint8_t>(rand() & 0xff);
+
+	if (!validateOperations())
+	{
+		system("pause");
+		return 1;
+	}
+	et::log::info("Image operations validation passed");
+
+	runTest("blur (horizontal, r = 4)", source, [](et::BinaryDataStorage& data) {
+		et::ImageOperations::blur(data, imageSize, imageComponents, et::vec2i(1, 0), 4, et::ImageBlurType_Average);
+	});
+	runTest("blur (vertical, r = 4)", source, [](et::BinaryDataStorage& data) {
+		et::ImageOperations::blur(data, imageSize, imageComponents, et::vec2i(0, 1), 4, et::ImageBlurType_Average);
+	});
+	runTest("blur (vertical, r = 32)", source, [](et::BinaryDataStorage& data) {
+		et::ImageOperations::blur(data, imageSize, imageComponents, et::vec2i(0, 1), 32, et::ImageBlurType_Average);
+	});
+	runTest("blur (diagonal, r = 4)", source, [](et::BinaryDataStorage& data) {
+		et::ImageOperations::blur(data, imageSize, imageComponents, et::vec2i(1, 1), 4, et::ImageBlurType_Average);
+	});
+	runTest("median (r = 1)", source, [](et::BinaryDataStorage& data) {
+		et::ImageOperations::median(data, imageSize, imageComponents, 1);
+	});
+	runTest("median (r = 2)", source, [](et::BinaryDataStorage& data) {
+		et::ImageOperations::median(data, imageSize, imageComponents, 2);
+	});
+	runTest("matrix filter (blur)", source, [](et::BinaryDataStorage& data) {
+		et::ImageOperations::applyMatrixFilter(data, imageSize, imageComponents, et::ImageOperations::matrixFilterBlur);
+	});
+	runTest("matrix filter (sharpen)", source, [](et::BinaryDataStorage& data) {
+		et::ImageOperations::applyMatrixFilter(data, imageSize, imageComponents, et::ImageOperations::matrixFilterSharpen);
+	});
+	runTest("normal map filter", source, [](et::BinaryDataStorage& data) {
+		et::ImageOperations::normalMapFilter(data, imageSize, imageComponents, et::vec2(1.0f));
+	});
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
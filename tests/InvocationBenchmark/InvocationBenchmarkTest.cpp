@@ -0,0 +1,100 @@
+#include <et/app/application.h>
+
+const uint32_t postsCount = 1000000;
+const uint32_t delayedPostsCount = 100000;
+const uint32_t framesCount = 600;
+
+template <class F>
+void runTest(const char* name, uint32_t parameter, uint32_t operations, F func)
+{
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+	uint64_t checksum = func();
+	uint64_t totalTime = std::max(uint64_t(1), et::queryCurrentTimeInMicroSeconds() - startTime);
+
+	et::log::info("%32s % 7u : % 8llu.%03llu ms | % 8.2f ns per post | %llu", name, parameter,
+		totalTime / 1000, totalTime % 1000, 1000.0 * static_cast<double>(totalTime) / static_cast<double>(operations),
+		static_cast<unsigned long long>(checksum));
+}
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+	et::log::info("Starting test (%u posts per case)...", postsCount);
+
+	et::RunLoop runLoop;
+	uint64_t time = 0;
+
+	std::atomic<uint64_t> counter{ 0 };
+	auto increment = [&counter]() { counter.fetch_add(1, std::memory_order_relaxed); };
+
+	/*
+	 * batches smaller than queue capacity are posted without allocations,
+	 * larger ones overflow into the list of messages
+	 */
+	for (uint32_t batchSize : { 16u, 128u, 1024u })
+	{
+		counter = 0;
+		runTest("queue, batch of", batchSize, postsCount, [&]() {
+			for (uint32_t posted = 0; posted < postsCount; posted += batchSize)
+			{
+				for (uint32_t i = 0; i < batchSize; ++i)
+					et::Invocation(increment).invokeInRunLoop(runLoop);
+				runLoop.update(++time);
+			}
+			return counter.load();
+		});
+
+		counter = 0;
+		runTest("allocated tasks, batch of", batchSize, postsCount, [&]() {
+			for (uint32_t posted = 0; posted < postsCount; posted += batchSize)
+			{
+				for (uint32_t i = 0; i < batchSize; ++i)
+					runLoop.addTask(et::etCreateObject<et::InvocationTask>(increment), 0.0f);
+				runLoop.update(++time);
+			}
+			return counter.load();
+		});
+	}
+
+	for (uint32_t producersCount : { 1u, 2u, 4u })
+	{
+		counter = 0;
+		uint32_t postsPerProducer = postsCount / producersCount;
+		runTest("queue, producer threads", producersCount, postsCount, [&]() {
+			et::Vector<std::thread> producers;
+			for (uint32_t p = 0; p < producersCount; ++p)
+			{
+				producers.emplace_back([&runLoop, &increment, postsPerProducer]() {
+					for (uint32_t i = 0; i < postsPerProducer; ++i)
+						et::Invocation(increment).invokeInRunLoop(runLoop);
+				});
+			}
+
+			while (counter.load() < postsPerProducer * producersCount)
+				runLoop.update(++time);
+
+			for (std::thread& producer : producers)
+				producer.join();
+
+			return counter.load();
+		});
+	}
+
+	counter = 0;
+	runTest("delayed, posts", delayedPostsCount, delayedPostsCount, [&]() {
+		for (uint32_t i = 0; i < delayedPostsCount; ++i)
+			et::Invocation(increment).invokeInRunLoop(runLoop, et::randomFloat(0.001f, 9.0f));
+
+		for (uint32_t i = 0; i < framesCount; ++i)
+		{
+			time += 1000 / 60;
+			runLoop.update(time);
+		}
+		return counter.load();
+	});
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
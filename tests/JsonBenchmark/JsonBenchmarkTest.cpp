@@ -0,0 +1,357 @@
+#include <et/app/application.h>
+#include <et/core/json.h>
+#include <et/core/binarydictionary.h>
+#include <external/jansson/jansson.h>
+
+const uint32_t iterationsCount = 10;
+
+/*
+ * Previous deserialization path: jansson tree converted to Dictionary
+ */
+et::VariantBase::Pointer convertJanssonValue(json_t* value)
+{
+	if (json_is_object(value))
+	{
+		et::Dictionary result;
+		for (void* i = json_object_iter(value); i != nullptr; i = json_object_iter_next(value, i))
+			result->content[json_object_iter_key(i)] = convertJanssonValue(json_object_iter_value(i));
+		return result;
+	}
+	else if (json_is_array(value))
+	{
+		et::ArrayValue result;
+		result->content.reserve(json_array_size(value));
+		for (size_t i = 0, e = json_array_size(value); i < e; ++i)
+			result->content.emplace_back(convertJanssonValue(json_array_get(value, i)));
+		return result;
+	}
+	else if (json_is_string(value))
+		return et::StringValue(json_string_value(value));
+	else if (json_is_integer(value))
+		return et::IntegerValue(json_integer_value(value));
+	else if (json_is_real(value))
+		return et::FloatValue(static_cast<float>(json_real_value(value)));
+	else if (json_is_true(value) || json_is_false(value))
+		return et::BooleanValue(json_is_true(value) ? 1 : 0);
+
+	return et::Dictionary();
+}
+
+std::string generateDocument(uint32_t objectsCount)
+{
+	et::ArrayValue objects;
+	for (uint32_t i = 0; i < objectsCount; ++i)
+	{
+		et::Dictionary object;
+		object.setStringForKey("name", "material_" + et::intToStr(i));
+		object.setStringForKey("description", "Generated material with \"quoted\" text and unicode \xc3\xa9\xc3\xa8");
+		object.setIntegerForKey("id", i);
+		object.setBooleanForKey("enabled", i % 2);
+		object.setFloatForKey("roughness", et::randomFloat(0.0f, 1.0f));
+
+		et::ArrayValue color;
+		for (uint32_t c = 0; c < 4; ++c)
+			color->content.emplace_back(et::FloatValue(et::randomFloat(0.0f, 1.0f)));
+		object.setArrayForKey("color", color);
+
+		et::Dictionary textures;
+		textures.setStringForKey("albedo", "textures/albedo_" + et::intToStr(i) + ".png");
+		textures.setStringForKey("normal", "textures/normal_" + et::intToStr(i) + ".png");
+		object.setDictionaryForKey("textures", textures);
+
+		objects->content.emplace_back(object);
+	}
+
+	et::Dictionary root;
+	root.setArrayForKey("materials", objects);
+	return et::json::serialize(root, et::json::SerializationFlag_ReadableFormat);
+}
+
+template <class F>
+void runTest(const char* name, const std::string& source, F func)
+{
+	uint64_t values = 0;
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+	for (uint32_t i = 0; i < iterationsCount; ++i)
+		values += func();
+	uint64_t totalTime = std::max(uint64_t(1), et::queryCurrentTimeInMicroSeconds() - startTime);
+
+	double megabytesPerSecond = static_cast<double>(source.size() * iterationsCount) / static_cast<double>(totalTime);
+	et::log::info("%24s : % 8llu.%03llu ms | %7.1f MB/s | %llu values", name, totalTime / 1000, totalTime % 1000,
+		megabytesPerSecond, static_cast<unsigned long long>(values / iterationsCount));
+}
+
+uint64_t countValues(const et::VariantBase::Pointer& value)
+{
+	uint64_t result = 1;
+	if (value->variantClass() == et::VariantClass::Array)
+	{
+		for (const auto& v : et::ArrayValue(value)->content)
+			result += countValues(v);
+	}
+	else if (value->variantClass() == et::VariantClass::Dictionary)
+	{
+		for (const auto& v : et::Dictionary(value)->content)
+			result += countValues(v.second);
+	}
+	return result;
+}
+
+/*
+ * Exact comparison, floats from both parsers are converted from the same double value
+ */
+bool sameValues(const et::VariantBase::Pointer& a, const et::VariantBase::Pointer& b)
+{
+	if (a->variantClass() != b->variantClass())
+		return false;
+
+	switch (a->variantClass())
+	{
+	case et::VariantClass::Float:
+		return et::FloatValue(a)->content == et::FloatValue(b)->content;
+
+	case et::VariantClass::Integer:
+		return et::IntegerValue(a)->content == et::IntegerValue(b)->content;
+
+	case et::VariantClass::Boolean:
+		return et::BooleanValue(a)->content == et::BooleanValue(b)->content;
+
+	case et::VariantClass::String:
+		return et::StringValue(a)->content == et::StringValue(b)->content;
+
+	case et::VariantClass::Array:
+	{
+		const auto& contentA = et::ArrayValue(a)->content;
+		const auto& contentB = et::ArrayValue(b)->content;
+		if (contentA.size() != contentB.size())
+			return false;
+
+		for (size_t i = 0, e = contentA.size(); i < e; ++i)
+		{
+			if (!sameValues(contentA[i], contentB[i]))
+				return false;
+		}
+		return true;
+	}
+
+	case et::VariantClass::Dictionary:
+	{
+		const auto& contentA = et::Dictionary(a)->content;
+		const auto& contentB = et::Dictionary(b)->content;
+		if (contentA.size() != contentB.size())
+			return false;
+
+		for (const auto& v : contentA)
+		{
+			auto other = contentB.find(v.first);
+			if ((other == contentB.end()) || !sameValues(v.second, other->second))
+				return false;
+		}
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
+/*
+ * json::deserialize should build the same tree as the previous jansson path
+ * and reject the same inputs, json::Document should accept the same inputs
+ */
+bool validateDocument(const std::string& source, bool expectValid)
+{
+	json_error_t error = { };
+	json_t* janssonRoot = json_loadb(source.data(), source.size(), 0, &error);
+
+	et::VariantClass vc = et::VariantClass::Invalid;
+	et::VariantBase::Pointer root = et::json::deserialize(source.data(), source.size(), vc, false);
+
+	et::json::Document document;
+	bool documentValid = document.parse(source);
+
+	bool janssonValid = (janssonRoot != nullptr);
+	bool valid = (vc != et::VariantClass::Invalid);
+	bool matches = (janssonValid == expectValid) && (valid == expectValid) && (documentValid == expectValid);
+	if (matches && valid)
+		matches = sameValues(convertJanssonValue(janssonRoot), root);
+
+	if (janssonRoot != nullptr)
+		json_decref(janssonRoot);
+
+	if (!matches)
+	{
+		et::log::error("JSON validation failed for `%s`: jansson %s, json::deserialize %s, json::Document %s (%s)",
+			(source.size() < 256) ? source.c_str() : "<generated document>", janssonValid ? "valid" : error.text,
+			valid ? "valid" : "invalid", documentValid ? "valid" : "invalid", document.error().c_str());
+	}
+	return matches;
+}
+
+bool validateEdgeCases()
+{
+	const char* validInputs[] =
+	{
+		" \t\r\n{ } \n",
+		"[]",
+		"{\"nested\":[[[{}]],[]],\"t\":true,\"f\":false,\"n\":null}",
+		"{\"a\":1,\"a\":2}",
+		"[\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"]",
+		"[\"\\u0041\\u00e9\\u4e2d\\ud83d\\ude00\"]",
+		"[\"caf\xc3\xa9\", \"\xf0\x9f\x98\x80\", \"\xe4\xb8\xad\", \"\xf4\x8f\xbf\xbf\"]",
+		"[\"long string without escapes to cover vectorized scanning, \xc3\xa9 and escapes \\n after it\"]",
+		"[0, -0, 1, -1, 9223372036854775807, -9223372036854775808]",
+		"[0.5, -0.0, 1e10, 1E-10, 2.5e+3, 0.1, 3.14159265358979323846, 1e-400]",
+		"[123456789012345678901234567890.5, 0.00000000000000000000000012345, 3.4028234e38]",
+	};
+
+	const char* invalidInputs[] =
+	{
+		"",
+		"\"string\"",
+		"42",
+		"{\"a\":1,}",
+		"[1,]",
+		"[1] x",
+		"{\"a\" 1}",
+		"{1:1}",
+		"[tru]",
+		"[01]",
+		"[1.]",
+		"[.5]",
+		"[1e]",
+		"[-]",
+		"[1e400]",
+		"[\"abc",
+		"[\"\x01\"]",
+		"[\"\\q\"]",
+		"[\"\\u12g4\"]",
+		"[\"\\u0000\"]",
+		"[\"\\ud800\"]",
+		"[\"\\udc00\"]",
+		"[\"\\ud800\\u0041\"]",
+		"[\"\xff\"]",
+		"[\"\xc0\xaf\"]",
+		"[\"\xe0\x80\xaf\"]",
+		"[\"\xed\xa0\x80\"]",
+		"[\"\xf4\x90\x80\x80\"]",
+		"[\"\xc3\"]",
+		"[\"escaped \\n and invalid \xc3\x28\"]",
+		"{\"\xfe\":1}",
+	};
+
+	bool result = true;
+	for (const char* input : validInputs)
+		result &= validateDocument(input, true);
+
+	for (const char* input : invalidInputs)
+		result &= validateDocument(input, false);
+
+	/*
+	 * known difference: jansson rejects integers which do not fit int64_t, they are parsed as floats now
+	 */
+	et::VariantClass vc = et::VariantClass::Invalid;
+	et::ArrayValue bigInteger = et::json::deserialize("[9223372036854775808]", vc, false);
+	if ((vc != et::VariantClass::Array) || (bigInteger->content.size() != 1) ||
+		(bigInteger->content.front()->variantClass() != et::VariantClass::Float))
+	{
+		et::log::error("JSON validation failed: integer overflow should produce float value");
+		result = false;
+	}
+
+	return result;
+}
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+
+	if (!validateEdgeCases())
+	{
+		system("pause");
+		return 1;
+	}
+	et::log::info("JSON edge cases validation passed");
+
+	for (uint32_t objectsCount : { 100u, 10000u, 100000u })
+	{
+		std::string source = generateDocument(objectsCount);
+		et::log::info("Document with %u objects (%llu bytes):", objectsCount, static_cast<unsigned long long>(source.size()));
+
+		if (!validateDocument(source, true))
+		{
+			system("pause");
+			return 1;
+		}
+
+		runTest("jansson", source, [&source]() {
+			json_error_t error = { };
+			json_t* root = json_loadb(source.data(), source.size(), 0, &error);
+			json_decref(root);
+			return 0;
+		});
+
+		runTest("jansson + Dictionary", source, [&source]() {
+			json_error_t error = { };
+			json_t* root = json_loadb(source.data(), source.size(), 0, &error);
+			uint64_t result = countValues(convertJanssonValue(root));
+			json_decref(root);
+			return result;
+		});
+
+		runTest("json::deserialize", source, [&source]() {
+			et::VariantClass vc = et::VariantClass::Invalid;
+			return countValues(et::json::deserialize(source, vc));
+		});
+
+		et::json::Document document;
+		runTest("json::Document", source, [&source, &document]() {
+			document.parse(source);
+			return document.valuesCount();
+		});
+
+		/*
+		 * Binary encoding of the same document, throughput is reported relative to JSON size
+		 */
+		et::VariantClass sourceClass = et::VariantClass::Invalid;
+		et::Dictionary sourceDictionary(et::json::deserialize(source, sourceClass));
+		for (size_t flags : { size_t(0), size_t(et::binary::SerializationFlag_Compress) })
+		{
+			et::BinaryDataStorage encoded = et::binary::serialize(sourceDictionary, flags);
+			et::log::info("Binary encoding%s: %llu bytes", flags ? " (compressed)" : "", static_cast<unsigned long long>(encoded.size()));
+
+			/*
+			 * both eager and lazy decoding should give back the source dictionary
+			 */
+			et::VariantClass decodedClass = et::VariantClass::Invalid;
+			et::VariantBase::Pointer decoded = et::binary::deserialize(encoded, decodedClass, false);
+
+			et::binary::Document validationDocument;
+			bool documentOpened = validationDocument.open(encoded.data(), encoded.size());
+
+			if ((decodedClass != et::VariantClass::Dictionary) || !sameValues(sourceDictionary, decoded) ||
+				!documentOpened || !sameValues(sourceDictionary, validationDocument.root().toVariant()))
+			{
+				et::log::error("Binary round trip%s does not match source dictionary", flags ? " (compressed)" : "");
+				system("pause");
+				return 1;
+			}
+
+			runTest("binary::deserialize", source, [&encoded]() {
+				et::VariantClass vc = et::VariantClass::Invalid;
+				return countValues(et::binary::deserialize(encoded, vc));
+			});
+
+			et::binary::Document binaryDocument;
+			runTest("binary::Document", source, [&encoded, &binaryDocument]() {
+				binaryDocument.open(encoded.data(), encoded.size());
+				return binaryDocument.root()["materials"].size();
+			});
+		}
+	}
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
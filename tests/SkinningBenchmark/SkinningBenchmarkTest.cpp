@@ -0,0 +1,204 @@
+#include <et/app/application.h>
+#include <et/core/parallel.h>
+#include <et/scene3d/skinning.h>
+
+const uint32_t vertexCount = 1024 * 1024;
+const uint32_t bonesCount = 64;
+const uint32_t iterations = 16;
+const uint32_t paletteUpdates = 1024;
+
+template <class F>
+void runTest(const char* name, uint32_t itemsPerIteration, const char* items, F func)
+{
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+	for (uint32_t i = 0; i < iterations; ++i)
+		func();
+	uint64_t totalTime = std::max(uint64_t(1), et::queryCurrentTimeInMicroSeconds() - startTime);
+
+	double processed = static_cast<double>(iterations) * static_cast<double>(itemsPerIteration);
+	double processedPerSecond = processed / (static_cast<double>(totalTime) / 1000000.0);
+
+	et::log::info("%32s : %8llu.%03llu ms | %10.2f M %s/s", name, static_cast<unsigned long long>(totalTime / 1000),
+		static_cast<unsigned long long>(totalTime % 1000), processedPerSecond / 1000000.0, items);
+}
+
+bool nearlyEqual(const et::vec3& a, const et::vec3& b)
+{
+	const float tolerance = 1.0e-3f;
+	return (std::abs(a.x - b.x) < tolerance) && (std::abs(a.y - b.y) < tolerance) && (std::abs(a.z - b.z) < tolerance);
+}
+
+/*
+ * Reference linear blend skinning, done with plain mat4 math
+ */
+void deformReference(const et::s3d::skinning::SourceData& source, const et::Vector<et::mat4>& bones, uint32_t i,
+	et::vec3& position, et::vec3& normal)
+{
+	const et::s3d::skinning::Influence& influence = source.influences[i];
+
+	et::vec4 p(0.0f);
+	et::vec3 n(0.0f);
+	for (uint32_t j = 0; j < et::s3d::skinning::MaxInfluences; ++j)
+	{
+		const et::mat4& m = bones[influence.bones[j]];
+		p += influence.weights[j] * (m * source.positions[i]);
+		n += influence.weights[j] * m.rotationMultiply(source.normals[i].xyz());
+	}
+	position = p.xyz();
+	normal = et::normalize(n);
+}
+
+bool validate(const et::s3d::skinning::SourceData& source, const et::Vector<et::mat4>& bones)
+{
+	const uint32_t samplesCount = 1024;
+
+	et::s3d::skinning::Palette linearPalette;
+	linearPalette.build(bones, et::s3d::SkinningMethod::LinearBlend);
+
+	et::s3d::skinning::Palette dualQuaternionPalette;
+	dualQuaternionPalette.build(bones, et::s3d::SkinningMethod::DualQuaternion);
+
+	/*
+	 * Linear blend with several influences should match scalar path
+	 */
+	et::Vector<et::vec3> positions(samplesCount);
+	et::Vector<et::vec3> normals(samplesCount);
+	et::s3d::skinning::deform(source, linearPalette, et::s3d::SkinningMethod::LinearBlend, 0, samplesCount,
+		positions.data(), normals.data());
+
+	for (uint32_t i = 0; i < samplesCount; i += 97)
+	{
+		et::vec3 position;
+		et::vec3 normal;
+		deformReference(source, bones, i, position, normal);
+		if (!nearlyEqual(positions[i], position) || !nearlyEqual(normals[i], normal))
+		{
+			et::log::error("Linear blend skinning differs from mat4 path at vertex %u", i);
+			return false;
+		}
+	}
+
+	/*
+	 * Both methods should give the same result for vertices attached to single rigid bone
+	 */
+	et::s3d::skinning::SourceData rigid;
+	rigid.bonesCount = source.bonesCount;
+	rigid.positions.assign(source.positions.begin(), source.positions.begin() + samplesCount);
+	rigid.normals.assign(source.normals.begin(), source.normals.begin() + samplesCount);
+	rigid.influences.resize(samplesCount);
+	for (uint32_t i = 0; i < samplesCount; ++i)
+	{
+		et::s3d::skinning::Influence& influence = rigid.influences[i];
+		for (uint16_t& bone : influence.bones)
+			bone = static_cast<uint16_t>(i % source.bonesCount);
+		influence.weights[0] = 1.0f;
+	}
+
+	et::Vector<et::vec3> dqPositions(samplesCount);
+	et::Vector<et::vec3> dqNormals(samplesCount);
+	et::s3d::skinning::deform(rigid, linearPalette, et::s3d::SkinningMethod::LinearBlend, 0, samplesCount,
+		positions.data(), normals.data());
+	et::s3d::skinning::deform(rigid, dualQuaternionPalette, et::s3d::SkinningMethod::DualQuaternion, 0, samplesCount,
+		dqPositions.data(), dqNormals.data());
+
+	for (uint32_t i = 0; i < samplesCount; ++i)
+	{
+		if (!nearlyEqual(positions[i], dqPositions[i]) || !nearlyEqual(normals[i], dqNormals[i]))
+		{
+			et::log::error("Dual quaternion skinning differs from linear blend at rigid vertex %u", i);
+			return false;
+		}
+
+		if ((i % 97) == 0)
+		{
+			et::vec3 position;
+			et::vec3 normal;
+			deformReference(rigid, bones, i, position, normal);
+			if (!nearlyEqual(dqPositions[i], position) || !nearlyEqual(dqNormals[i], normal))
+			{
+				et::log::error("Dual quaternion skinning differs from mat4 path at rigid vertex %u", i);
+				return false;
+			}
+		}
+	}
+
+	et::log::info("Validation passed");
+	return true;
+}
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+	et::log::info("Starting test (%u vertices, %u bones, %u iterations, %u workers)...",
+		vertexCount, bonesCount, iterations, et::parallel::workersCount());
+
+	et::s3d::skinning::SourceData source;
+	source.bonesCount = bonesCount;
+	source.positions.resize(vertexCount);
+	source.normals.resize(vertexCount);
+	source.influences.resize(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; ++i)
+	{
+		source.positions[i] = et::vec4(et::randomFloat(-1.0f, 1.0f), et::randomFloat(-1.0f, 1.0f), et::randomFloat(-1.0f, 1.0f), 1.0f);
+		source.normals[i] = et::vec4(et::normalize(source.positions[i].xyz()), 0.0f);
+
+		float totalWeight = 0.0f;
+		et::s3d::skinning::Influence& influence = source.influences[i];
+		for (uint32_t j = 0; j < et::s3d::skinning::MaxInfluences; ++j)
+		{
+			influence.bones[j] = static_cast<uint16_t>(rand() % bonesCount);
+			influence.weights[j] = et::randomFloat(0.1f, 1.0f);
+			totalWeight += influence.weights[j];
+		}
+		for (float& w : influence.weights)
+			w /= totalWeight;
+	}
+
+	et::Vector<et::mat4> bones(bonesCount);
+	for (et::mat4& m : bones)
+	{
+		m = et::quaternion(et::randomFloat(-3.0f, 3.0f), et::normalize(et::vec3(et::randomFloat(-1.0f, 1.0f), 1.0f, 0.5f))).toMatrix();
+		m[3] = et::vec4(et::randomFloat(-1.0f, 1.0f), et::randomFloat(-1.0f, 1.0f), et::randomFloat(-1.0f, 1.0f), 1.0f);
+	}
+
+	if (!validate(source, bones))
+	{
+		system("pause");
+		return 1;
+	}
+
+	et::s3d::skinning::Palette linearPalette;
+	linearPalette.build(bones, et::s3d::SkinningMethod::LinearBlend);
+
+	et::s3d::skinning::Palette dualQuaternionPalette;
+	dualQuaternionPalette.build(bones, et::s3d::SkinningMethod::DualQuaternion);
+
+	et::Vector<et::vec3> positions(vertexCount);
+	et::Vector<et::vec3> normals(vertexCount);
+
+	runTest("linear blend (single thread)", vertexCount, "vertices", [&]() {
+		et::s3d::skinning::deform(source, linearPalette, et::s3d::SkinningMethod::LinearBlend, 0, vertexCount,
+			positions.data(), normals.data());
+	});
+	runTest("linear blend (parallel)", vertexCount, "vertices", [&]() {
+		et::s3d::skinning::deform(source, linearPalette, et::s3d::SkinningMethod::LinearBlend,
+			positions.data(), normals.data());
+	});
+	runTest("dual quaternion (single thread)", vertexCount, "vertices", [&]() {
+		et::s3d::skinning::deform(source, dualQuaternionPalette, et::s3d::SkinningMethod::DualQuaternion, 0, vertexCount,
+			positions.data(), normals.data());
+	});
+	runTest("dual quaternion (parallel)", vertexCount, "vertices", [&]() {
+		et::s3d::skinning::deform(source, dualQuaternionPalette, et::s3d::SkinningMethod::DualQuaternion,
+			positions.data(), normals.data());
+	});
+	runTest("palette update", paletteUpdates * bonesCount, "bones", [&]() {
+		for (uint32_t i = 0; i < paletteUpdates; ++i)
+			dualQuaternionPalette.build(bones, et::s3d::SkinningMethod::DualQuaternion);
+	});
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
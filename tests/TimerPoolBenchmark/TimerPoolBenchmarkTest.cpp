@@ -0,0 +1,72 @@
+#include <et/app/application.h>
+#include <et/core/notifytimer.h>
+
+const uint32_t framesCount = 600;
+const float frameDuration = 1.0f / 60.0f;
+
+template <class F>
+void runTest(const char* name, uint32_t timersCount, F func)
+{
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+	uint64_t fired = func();
+	uint64_t totalTime = std::max(uint64_t(1), et::queryCurrentTimeInMicroSeconds() - startTime);
+
+	et::log::info("%24s (% 7u timers) : % 8llu.%03llu ms | %llu expired", name, timersCount,
+		totalTime / 1000, totalTime % 1000, static_cast<unsigned long long>(fired));
+}
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+	et::log::info("Starting test (%u frames)...", framesCount);
+
+	et::RunLoop runLoop;
+	et::TimerPool::Pointer pool = runLoop.mainTimerPool();
+
+	for (uint32_t timersCount : { 1000u, 10000u, 100000u })
+	{
+		et::Vector<et::NotifyTimer> timers(timersCount);
+		uint64_t fired = 0;
+		for (et::NotifyTimer& timer : timers)
+			timer.expired.connect([&fired](et::NotifyTimer*) { ++fired; });
+
+		runTest("start", timersCount, [&]() {
+			for (et::NotifyTimer& timer : timers)
+				timer.start(pool, et::randomFloat(1.0f, 60.0f), et::NotifyTimer::RepeatForever);
+			return 0;
+		});
+
+		/*
+		 * frame time should depend on the number of expiring timers only
+		 */
+		runTest("update", timersCount, [&]() {
+			float t = runLoop.time();
+			for (uint32_t i = 0; i < framesCount; ++i)
+			{
+				t += frameDuration;
+				pool->update(t);
+			}
+			return fired;
+		});
+
+		runTest("restart", timersCount, [&]() {
+			for (et::NotifyTimer& timer : timers)
+			{
+				timer.cancelUpdates();
+				timer.start(pool, et::randomFloat(1.0f, 60.0f), et::NotifyTimer::RepeatForever);
+			}
+			return 0;
+		});
+
+		runTest("cancel", timersCount, [&]() {
+			for (et::NotifyTimer& timer : timers)
+				timer.cancelUpdates();
+			return 0;
+		});
+	}
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };